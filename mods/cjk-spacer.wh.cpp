@@ -2,7 +2,7 @@
 // @id              cjk-spacer
 // @name            CJK Spacer
 // @description     Add spaces between CJK characters and letters or digits in Explorer context menus and tooltips; modern XAML UI is opt-in and best-effort because it may conflict with other XAML Diagnostics mods
-// @version         0.1.28
+// @version         0.1.29
 // @author          aenerv7
 // @github          https://github.com/aenerv7
 // @license         GPL-3.0
@@ -157,6 +157,7 @@ also need compatible DC targets to keep sizing consistent; disable
 
 #include <windhawk_utils.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <cstdio>
@@ -227,11 +228,11 @@ uint32_t DecodeCodePoint(std::wstring_view text,
     return first;
 }
 
-bool IsInRange(uint32_t codePoint, uint32_t first, uint32_t last) {
+constexpr bool IsInRange(uint32_t codePoint, uint32_t first, uint32_t last) {
     return codePoint >= first && codePoint <= last;
 }
 
-bool IsCjkCodePoint(uint32_t codePoint) {
+constexpr bool IsCjkCodePoint(uint32_t codePoint) {
     // Hangul Jamo.
     if (IsInRange(codePoint, 0x1100, 0x11FF)) {
         return true;
@@ -287,7 +288,7 @@ bool IsCjkCodePoint(uint32_t codePoint) {
            IsInRange(codePoint, 0x30000, 0x323AF);
 }
 
-bool IsExtendingCodePoint(uint32_t codePoint) {
+constexpr bool IsExtendingCodePoint(uint32_t codePoint) {
     // Combining marks and variation selectors stay attached to the preceding
     // base character and don't interrupt a CJK/word boundary.
     return IsInRange(codePoint, 0x0300, 0x036F) ||
@@ -300,7 +301,7 @@ bool IsExtendingCodePoint(uint32_t codePoint) {
            IsInRange(codePoint, 0xE0100, 0xE01EF);
 }
 
-bool IsAsciiLetterOrDigit(uint32_t codePoint) {
+constexpr bool IsAsciiLetterOrDigit(uint32_t codePoint) {
     return (codePoint >= L'0' && codePoint <= L'9') ||
            (codePoint >= L'A' && codePoint <= L'Z') ||
            (codePoint >= L'a' && codePoint <= L'z');
@@ -351,7 +352,184 @@ bool IsUnicodeLetterOrDigit(uint32_t codePoint) {
     return false;
 }
 
+// BMP code points are classified with a two-level table generated at compile
+// time from the ranges below, which mirror IsExtendingCodePoint,
+// IsCjkCodePoint and IsUnicodeLetterOrDigit. Code points not covered by a
+// range are Other if ASCII and MaybeWord otherwise. MaybeWord is resolved with
+// a bitmap of GetStringTypeW results, built once on first use.
+enum class BmpClass : uint8_t {
+    Other,
+    Cjk,
+    Word,
+    Extend,
+    MaybeWord,
+};
+
+struct BmpClassRange {
+    uint16_t first;
+    uint16_t last;
+    BmpClass kind;
+};
+
+constexpr BmpClassRange kBmpClassRanges[] = {
+    {0x0030, 0x0039, BmpClass::Word},
+    {0x0041, 0x005A, BmpClass::Word},
+    {0x0061, 0x007A, BmpClass::Word},
+    {0x0300, 0x036F, BmpClass::Extend},
+    {0x1100, 0x11FF, BmpClass::Cjk},
+    {0x1AB0, 0x1AFF, BmpClass::Extend},
+    {0x1DC0, 0x1DFF, BmpClass::Extend},
+    {0x20D0, 0x20FF, BmpClass::Extend},
+    {0x2E80, 0x2FDF, BmpClass::Cjk},
+    {0x3005, 0x3005, BmpClass::Cjk},
+    {0x3007, 0x3007, BmpClass::Cjk},
+    {0x3040, 0x309F, BmpClass::Cjk},
+    {0x30A1, 0x30FA, BmpClass::Cjk},
+    {0x30FC, 0x30FF, BmpClass::Cjk},
+    {0x3100, 0x318F, BmpClass::Cjk},
+    {0x31A0, 0x31FF, BmpClass::Cjk},
+    {0x3400, 0x4DBF, BmpClass::Cjk},
+    {0x4E00, 0x9FFF, BmpClass::Cjk},
+    {0xA960, 0xA97F, BmpClass::Cjk},
+    {0xAC00, 0xD7FF, BmpClass::Cjk},
+    {0xF900, 0xFAFF, BmpClass::Cjk},
+    {0xFE00, 0xFE0F, BmpClass::Extend},
+    {0xFE20, 0xFE2F, BmpClass::Extend},
+    {0xFF10, 0xFF19, BmpClass::Other},
+    {0xFF21, 0xFF3A, BmpClass::Other},
+    {0xFF41, 0xFF5A, BmpClass::Other},
+    {0xFF66, 0xFF9D, BmpClass::Cjk},
+    {0xFF9E, 0xFF9F, BmpClass::Extend},
+};
+
+// Blocks of 256 code points which are covered by a single class are stored
+// directly in the first level. Only the few blocks with a range boundary
+// inside get a 256-entry second level block.
+struct BmpClassTable {
+    static constexpr uint8_t kMixed = 0x80;
+    static constexpr size_t kMaxMixedBlocks = 32;
+
+    uint8_t blocks[256] = {};
+    uint8_t mixed[kMaxMixedBlocks][256] = {};
+};
+
+constexpr BmpClass DefaultBmpClass(uint32_t codePoint) {
+    return codePoint < 0x80 ? BmpClass::Other : BmpClass::MaybeWord;
+}
+
+constexpr BmpClassTable BuildBmpClassTable() {
+    BmpClassTable table;
+    size_t mixedCount = 0;
+
+    for (uint32_t block = 0; block < 256; block++) {
+        const uint32_t blockFirst = block << 8;
+        const uint32_t blockLast = blockFirst + 0xFF;
+
+        bool isMixed = blockFirst < 0x80;
+        BmpClass uniformKind = DefaultBmpClass(blockFirst);
+        for (const auto& range : kBmpClassRanges) {
+            if (range.last < blockFirst || range.first > blockLast) {
+                continue;
+            }
+            if (range.first <= blockFirst && range.last >= blockLast) {
+                uniformKind = range.kind;
+            } else {
+                isMixed = true;
+            }
+        }
+
+        if (!isMixed) {
+            table.blocks[block] = static_cast<uint8_t>(uniformKind);
+            continue;
+        }
+
+        uint8_t* entries = table.mixed[mixedCount];
+        for (uint32_t i = 0; i < 256; i++) {
+            entries[i] = static_cast<uint8_t>(DefaultBmpClass(blockFirst + i));
+        }
+        for (const auto& range : kBmpClassRanges) {
+            const uint32_t first = std::max<uint32_t>(range.first, blockFirst);
+            const uint32_t last = std::min<uint32_t>(range.last, blockLast);
+            for (uint32_t c = first; c <= last && first <= last; c++) {
+                entries[c - blockFirst] = static_cast<uint8_t>(range.kind);
+            }
+        }
+
+        table.blocks[block] =
+            static_cast<uint8_t>(BmpClassTable::kMixed | mixedCount);
+        mixedCount++;
+    }
+
+    return table;
+}
+
+constexpr BmpClassTable kBmpClassTable = BuildBmpClassTable();
+
+BmpClass LookupBmpClass(uint32_t codePoint) {
+    const uint8_t block = kBmpClassTable.blocks[codePoint >> 8];
+    if (!(block & BmpClassTable::kMixed)) {
+        return static_cast<BmpClass>(block);
+    }
+    return static_cast<BmpClass>(
+        kBmpClassTable.mixed[block & ~BmpClassTable::kMixed][codePoint & 0xFF]);
+}
+
+// One bit per BMP code unit: whether GetStringTypeW reports it as a letter or
+// a digit. The surrogate ranges are queried separately so that no surrogate
+// pairs are formed.
+uint32_t g_bmpLetterOrDigitBits[0x10000 / 32];
+std::once_flag g_bmpLetterOrDigitBitsOnce;
+
+void BuildBmpLetterOrDigitBits() {
+    std::vector<wchar_t> codeUnits(0x10000);
+    std::vector<WORD> characterTypes(0x10000);
+    for (uint32_t i = 0; i < 0x10000; i++) {
+        codeUnits[i] = static_cast<wchar_t>(i);
+    }
+
+    constexpr uint32_t kChunks[][2] = {
+        {0x0000, 0xDC00},
+        {0xDC00, 0x10000},
+    };
+    for (const auto& [first, last] : kChunks) {
+        if (!GetStringTypeW(CT_CTYPE1, &codeUnits[first], last - first,
+                            &characterTypes[first])) {
+            return;
+        }
+    }
+
+    for (uint32_t i = 0; i < 0x10000; i++) {
+        if (characterTypes[i] & (C1_ALPHA | C1_DIGIT)) {
+            g_bmpLetterOrDigitBits[i / 32] |= 1u << (i % 32);
+        }
+    }
+}
+
+bool IsBmpUnicodeLetterOrDigit(uint32_t codePoint) {
+    std::call_once(g_bmpLetterOrDigitBitsOnce, BuildBmpLetterOrDigitBits);
+    return g_bmpLetterOrDigitBits[codePoint / 32] & (1u << (codePoint % 32));
+}
+
 CharacterKind ClassifyCodePoint(uint32_t codePoint) {
+    if (codePoint <= 0xFFFF) {
+        switch (LookupBmpClass(codePoint)) {
+            case BmpClass::Other:
+                return CharacterKind::Other;
+            case BmpClass::Cjk:
+                return CharacterKind::Cjk;
+            case BmpClass::Word:
+                return CharacterKind::Word;
+            case BmpClass::Extend:
+                return CharacterKind::Extend;
+            case BmpClass::MaybeWord:
+                return g_unicodeLettersAndDigits.load(
+                           std::memory_order_relaxed) &&
+                               IsBmpUnicodeLetterOrDigit(codePoint)
+                           ? CharacterKind::Word
+                           : CharacterKind::Other;
+        }
+    }
+
     if (IsExtendingCodePoint(codePoint)) {
         return CharacterKind::Extend;
     }
@@ -375,6 +553,13 @@ bool NeedsSpace(CharacterKind left, CharacterKind right) {
 bool ContainsCjkCodePoint(std::wstring_view text) {
     size_t offset = 0;
     while (offset < text.size()) {
+        // Fast path: nothing below Hangul Jamo is CJK, which skips ASCII and
+        // most other Latin text without decoding.
+        if (static_cast<uint16_t>(text[offset]) < 0x1100) {
+            ++offset;
+            continue;
+        }
+
         size_t codeUnitCount;
         const uint32_t codePoint =
             DecodeCodePoint(text, offset, &codeUnitCount);
@@ -423,11 +608,14 @@ std::wstring AddCjkSpacing(std::wstring_view text,
         offset += codeUnitCount;
 
         // Attach combining characters and variation selectors to this token.
-        while (offset < text.size()) {
+        // ASCII is never extending, so it ends the token without decoding.
+        while (offset < text.size() && text[offset] >= 0x80) {
             size_t extensionLength;
             const uint32_t extension =
                 DecodeCodePoint(text, offset, &extensionLength);
-            if (!IsExtendingCodePoint(extension)) {
+            if (extension <= 0xFFFF
+                    ? LookupBmpClass(extension) != BmpClass::Extend
+                    : !IsExtendingCodePoint(extension)) {
                 break;
             }
             offset += extensionLength;
@@ -1442,6 +1630,47 @@ bool IsClassicTooltipTextPart(int partId) {
            partId == TTP_BALLOONTITLE;
 }
 
+// Tooltip text is measured and drawn repeatedly, so recent results are kept
+// in a small direct-mapped cache indexed by the text hash.
+struct SpacedTextCacheEntry {
+    std::wstring original;
+    std::wstring spaced;
+    bool preserveMnemonics = false;
+    bool unicodeLettersAndDigits = false;
+};
+
+constexpr size_t kSpacedTextCacheSize = 64;
+
+std::mutex g_spacedTextCacheMutex;
+SpacedTextCacheEntry g_spacedTextCache[kSpacedTextCacheSize];
+
+std::wstring AddCjkSpacingCached(std::wstring_view text,
+                                 bool preserveMnemonics) {
+    const bool unicodeLettersAndDigits =
+        g_unicodeLettersAndDigits.load(std::memory_order_relaxed);
+    SpacedTextCacheEntry& entry =
+        g_spacedTextCache[std::hash<std::wstring_view>{}(text) %
+                          kSpacedTextCacheSize];
+
+    {
+        std::lock_guard<std::mutex> guard(g_spacedTextCacheMutex);
+        if (!entry.original.empty() && entry.original == text &&
+            entry.preserveMnemonics == preserveMnemonics &&
+            entry.unicodeLettersAndDigits == unicodeLettersAndDigits) {
+            return entry.spaced;
+        }
+    }
+
+    std::wstring spaced = AddCjkSpacing(text, preserveMnemonics);
+
+    std::lock_guard<std::mutex> guard(g_spacedTextCacheMutex);
+    entry.original.assign(text);
+    entry.spaced = spaced;
+    entry.preserveMnemonics = preserveMnemonics;
+    entry.unicodeLettersAndDigits = unicodeLettersAndDigits;
+    return spaced;
+}
+
 bool BuildSpacedClassicTooltipText(LPCWSTR text,
                                    int textLength,
                                    DWORD textFlags,
@@ -1463,7 +1692,7 @@ bool BuildSpacedClassicTooltipText(LPCWSTR text,
     }
 
     const bool preserveMnemonics = !(textFlags & DT_NOPREFIX);
-    *spaced = AddCjkSpacing(original, preserveMnemonics);
+    *spaced = AddCjkSpacingCached(original, preserveMnemonics);
     return spaced->size() != original.size();
 }
 
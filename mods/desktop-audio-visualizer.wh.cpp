@@ -3,7 +3,7 @@
 // @name               Desktop Audio Visualizer
 // @description        Real-time audio visualizer on your Windows desktop with customizable appearance
 // @description:ru-RU  Аудиовизуализатор в реальном времени на рабочем столе Windows с настраиваемым внешним видом
-// @version            1.0.0
+// @version            1.0.1
 // @author             Salyts
 // @github             https://github.com/Salyts
 // @include            explorer.exe
@@ -51,7 +51,7 @@ A real-time audio spectrum visualizer that displays on your Windows desktop. Cap
 
 ### Audio Processing
 * **WASAPI Loopback Capture**: Captures all system audio output in real time
-* **Real-time FFT**: 7-band frequency spectrum with Hann windowing
+* **Real-time FFT**: 7-band frequency spectrum with Hann windowing, using an SSE real-input FFT
 * **6 EQ Presets**: Balanced, Bass, Rock, Pop, Jazz, Electronic
 * **Adjustable Sensitivity**: 0–300 range
 
@@ -267,6 +267,8 @@ A real-time audio spectrum visualizer that displays on your Windows desktop. Cap
 #include <wrl/client.h>
 #include <wincodec.h>
 
+#include <immintrin.h>
+
 #include <algorithm>
 #include <atomic>
 #include <cmath>
@@ -337,6 +339,7 @@ constexpr int VIZ_BARS_MAX = 1000;
 constexpr int VIZ_FFT_SIZE = 1024;
 constexpr int VIZ_NUM_BANDS = 7;
 constexpr float VIZ_PI = 3.14159265f;
+constexpr double VIZ_PI_D = 3.14159265358979323846;
 
 Settings g_settings;
 
@@ -381,9 +384,25 @@ std::thread* g_renderThread = nullptr;
 std::atomic<bool> g_renderThreadRunning{false};
 std::atomic<bool> g_renderTickPending{false};
 
+constexpr int VIZ_FFT_HALF = VIZ_FFT_SIZE / 2;
+
+// State of the real-input FFT: VIZ_FFT_SIZE real samples are packed as
+// VIZ_FFT_HALF complex values (even samples as the real part, odd samples as
+// the imaginary part), transformed, and split back into the real spectrum.
+struct alignas(16) VizRealFFT {
+    float re[VIZ_FFT_HALF];
+    float im[VIZ_FFT_HALF];
+    // Twiddles of the stage with half-length h are at [h - 1, 2h - 1).
+    float stageTwRe[VIZ_FFT_HALF];
+    float stageTwIm[VIZ_FFT_HALF];
+    // exp(-2*pi*i*k/VIZ_FFT_SIZE), used to split the half-size transform.
+    float splitTwRe[VIZ_FFT_HALF];
+    float splitTwIm[VIZ_FFT_HALF];
+    uint16_t bitRev[VIZ_FFT_HALF];
+};
+
 float g_hannWindow[VIZ_FFT_SIZE] = {};
-float g_twiddleRe[VIZ_FFT_SIZE / 2] = {};
-float g_twiddleIm[VIZ_FFT_SIZE / 2] = {};
+VizRealFFT g_vizFFT;
 int g_logBinStart[VIZ_NUM_BANDS + 1] = {};
 
 float g_vizPeak[VIZ_BARS_MAX] = {};
@@ -914,11 +933,28 @@ void BuildHannWindow() {
         g_hannWindow[i] = 0.5f * (1.f - cosf(2.f * VIZ_PI * i / (VIZ_FFT_SIZE - 1)));
 }
 
-void BuildTwiddleFactors() {
-    for (int i = 0; i < VIZ_FFT_SIZE / 2; i++) {
-        float ang = -2.0f * VIZ_PI * i / VIZ_FFT_SIZE;
-        g_twiddleRe[i] = cosf(ang);
-        g_twiddleIm[i] = sinf(ang);
+void BuildFFTTables() {
+    int bits = 0;
+    while ((1 << bits) < VIZ_FFT_HALF) bits++;
+    for (int i = 0; i < VIZ_FFT_HALF; i++) {
+        int rev = 0;
+        for (int b = 0; b < bits; b++)
+            if (i & (1 << b)) rev |= 1 << (bits - 1 - b);
+        g_vizFFT.bitRev[i] = (uint16_t)rev;
+    }
+
+    for (int h = 1; h < VIZ_FFT_HALF; h <<= 1) {
+        for (int j = 0; j < h; j++) {
+            double ang = -VIZ_PI_D * j / h;
+            g_vizFFT.stageTwRe[h - 1 + j] = (float)cos(ang);
+            g_vizFFT.stageTwIm[h - 1 + j] = (float)sin(ang);
+        }
+    }
+
+    for (int k = 0; k < VIZ_FFT_HALF; k++) {
+        double ang = -2.0 * VIZ_PI_D * k / VIZ_FFT_SIZE;
+        g_vizFFT.splitTwRe[k] = (float)cos(ang);
+        g_vizFFT.splitTwIm[k] = (float)sin(ang);
     }
 }
 
@@ -931,36 +967,98 @@ void BuildLogBins(UINT32 sampleRate) {
     }
 }
 
-void VizFFT(std::vector<float>& re, std::vector<float>& im) {
-    int n = (int)re.size();
-    for (int i = 1, j = 0; i < n; i++) {
-        int bit = n >> 1;
-        for (; j & bit; bit >>= 1) j ^= bit;
-        j ^= bit;
-        if (i < j) {
-            std::swap(re[i], re[j]);
-            std::swap(im[i], im[j]);
-        }
+// Loads VIZ_FFT_SIZE samples starting at `start` in the ring buffer, applies
+// the Hann window, and stores them packed in bit-reversed order.
+void VizFFTLoadWindowed(const float* ring, int ringCap, int start) {
+    VizRealFFT& f = g_vizFFT;
+    int idx = start;
+    for (int n = 0; n < VIZ_FFT_HALF; n++) {
+        float even = ring[idx] * g_hannWindow[2 * n];
+        if (++idx == ringCap) idx = 0;
+        float odd = ring[idx] * g_hannWindow[2 * n + 1];
+        if (++idx == ringCap) idx = 0;
+        int r = f.bitRev[n];
+        f.re[r] = even;
+        f.im[r] = odd;
     }
-    for (int len = 2; len <= n; len <<= 1) {
-        int halfLen = len / 2;
-        int stride = n / len;
-        for (int i = 0; i < n; i += len) {
-            for (int j = 0; j < halfLen; j++) {
-                float wRe = g_twiddleRe[j * stride];
-                float wIm = g_twiddleIm[j * stride];
-                float uRe = re[i + j], uIm = im[i + j];
-                float vRe = re[i + j + halfLen] * wRe - im[i + j + halfLen] * wIm;
-                float vIm = re[i + j + halfLen] * wIm + im[i + j + halfLen] * wRe;
-                re[i + j] = uRe + vRe;
-                im[i + j] = uIm + vIm;
-                re[i + j + halfLen] = uRe - vRe;
-                im[i + j + halfLen] = uIm - vIm;
+}
+
+// In-place radix-2 transform of the packed data. The first two stages have
+// trivial twiddles; the rest process four butterflies per step with SSE.
+void VizFFTTransform() {
+    VizRealFFT& f = g_vizFFT;
+    float* re = f.re;
+    float* im = f.im;
+
+    for (int i = 0; i < VIZ_FFT_HALF; i += 4) {
+        float r0 = re[i] + re[i + 1], i0 = im[i] + im[i + 1];
+        float r1 = re[i] - re[i + 1], i1 = im[i] - im[i + 1];
+        float r2 = re[i + 2] + re[i + 3], i2 = im[i + 2] + im[i + 3];
+        float r3 = re[i + 2] - re[i + 3], i3 = im[i + 2] - im[i + 3];
+        // Second stage: twiddles 1 and -i.
+        re[i] = r0 + r2;
+        im[i] = i0 + i2;
+        re[i + 2] = r0 - r2;
+        im[i + 2] = i0 - i2;
+        re[i + 1] = r1 + i3;
+        im[i + 1] = i1 - r3;
+        re[i + 3] = r1 - i3;
+        im[i + 3] = i1 + r3;
+    }
+
+    for (int h = 4; h < VIZ_FFT_HALF; h <<= 1) {
+        const float* twRe = f.stageTwRe + h - 1;
+        const float* twIm = f.stageTwIm + h - 1;
+        for (int i = 0; i < VIZ_FFT_HALF; i += 2 * h) {
+            for (int j = 0; j < h; j += 4) {
+                __m128 wRe = _mm_loadu_ps(twRe + j);
+                __m128 wIm = _mm_loadu_ps(twIm + j);
+                __m128 uRe = _mm_load_ps(re + i + j);
+                __m128 uIm = _mm_load_ps(im + i + j);
+                __m128 xRe = _mm_load_ps(re + i + j + h);
+                __m128 xIm = _mm_load_ps(im + i + j + h);
+                __m128 vRe = _mm_sub_ps(_mm_mul_ps(xRe, wRe), _mm_mul_ps(xIm, wIm));
+                __m128 vIm = _mm_add_ps(_mm_mul_ps(xRe, wIm), _mm_mul_ps(xIm, wRe));
+                _mm_store_ps(re + i + j, _mm_add_ps(uRe, vRe));
+                _mm_store_ps(im + i + j, _mm_add_ps(uIm, vIm));
+                _mm_store_ps(re + i + j + h, _mm_sub_ps(uRe, vRe));
+                _mm_store_ps(im + i + j + h, _mm_sub_ps(uIm, vIm));
             }
         }
     }
 }
 
+// Splits the half-size transform into the spectrum of the real input and sums
+// |X[k]|^2 for k in [g_logBinStart[b], g_logBinStart[b + 1]) into each band,
+// computing only the bins which are used.
+void VizFFTBandPower(float (&sumSq)[VIZ_NUM_BANDS], int (&count)[VIZ_NUM_BANDS]) {
+    const VizRealFFT& f = g_vizFFT;
+    for (int b = 0; b < VIZ_NUM_BANDS; b++) {
+        int bStart = g_logBinStart[b];
+        int bEnd = g_logBinStart[b + 1];
+        if (bEnd <= bStart) bEnd = bStart + 1;
+
+        float sum = 0.f;
+        for (int k = bStart; k < bEnd; k++) {
+            int m = (VIZ_FFT_HALF - k) & (VIZ_FFT_HALF - 1);
+            float zkRe = f.re[k], zkIm = f.im[k];
+            float zmRe = f.re[m], zmIm = f.im[m];
+            // Even part: (Z[k] + conj(Z[N/2-k])) / 2.
+            float eRe = 0.5f * (zkRe + zmRe);
+            float eIm = 0.5f * (zkIm - zmIm);
+            // Odd part: (Z[k] - conj(Z[N/2-k])) / 2i.
+            float oRe = 0.5f * (zkIm + zmIm);
+            float oIm = -0.5f * (zkRe - zmRe);
+            float wRe = f.splitTwRe[k], wIm = f.splitTwIm[k];
+            float xRe = eRe + oRe * wRe - oIm * wIm;
+            float xIm = eIm + oRe * wIm + oIm * wRe;
+            sum += xRe * xRe + xIm * xIm;
+        }
+        sumSq[b] = sum;
+        count[b] = bEnd - bStart;
+    }
+}
+
 struct VizEQMul { float low, mid, high; };
 VizEQMul GetVizEQMultipliers(VizEQ eq) {
     switch (eq) {
@@ -1064,7 +1162,7 @@ bool VizInitAudioClient(IMMDeviceEnumerator* pEnum, ComPtr<IAudioClient>& pClien
 void VizCaptureThreadProc() {
     CoInitializeEx(nullptr, COINIT_MULTITHREADED);
     BuildHannWindow();
-    BuildTwiddleFactors();
+    BuildFFTTables();
     BuildVizSeeds();
 
     ComPtr<IMMDeviceEnumerator> pEnum;
@@ -1091,7 +1189,6 @@ void VizCaptureThreadProc() {
     static constexpr int RING_CAP = VIZ_FFT_SIZE * 4;
     std::vector<float> ringBuf(RING_CAP, 0.f);
     int ringHead = 0, ringCount = 0;
-    std::vector<float> re(VIZ_FFT_SIZE), im(VIZ_FFT_SIZE);
 
     float bandEnv[VIZ_NUM_BANDS] = {};
     static constexpr float GRAVITY[VIZ_NUM_BANDS] = {0.018f, 0.020f, 0.022f, 0.025f,
@@ -1184,12 +1281,13 @@ void VizCaptureThreadProc() {
 
         while (ringCount >= VIZ_FFT_SIZE) {
             int readStart = (ringHead - ringCount + RING_CAP) % RING_CAP;
-            for (int i = 0; i < VIZ_FFT_SIZE; i++) {
-                re[i] = ringBuf[(readStart + i) % RING_CAP] * g_hannWindow[i];
-                im[i] = 0.f;
-            }
+            VizFFTLoadWindowed(ringBuf.data(), RING_CAP, readStart);
             ringCount -= VIZ_FFT_SIZE / 2;
-            VizFFT(re, im);
+            VizFFTTransform();
+
+            float bandSumSq[VIZ_NUM_BANDS];
+            int bandCount[VIZ_NUM_BANDS];
+            VizFFTBandPower(bandSumSq, bandCount);
 
             float t_sens = g_settings.sensitivity / 100.0f;
             float sliderGain = (t_sens <= 1.0f) ? 0.25f + t_sens * t_sens * 2.75f
@@ -1202,16 +1300,8 @@ void VizCaptureThreadProc() {
 
             float maxMag = 0.f;
             for (int b = 0; b < VIZ_NUM_BANDS; b++) {
-                int bStart = g_logBinStart[b];
-                int bEnd = g_logBinStart[b + 1];
-                if (bEnd <= bStart) bEnd = bStart + 1;
-
-                float sumSq = 0.f;
-                int count = 0;
-                for (int k = bStart; k < bEnd; k++) {
-                    sumSq += re[k] * re[k] + im[k] * im[k];
-                    count++;
-                }
+                float sumSq = bandSumSq[b];
+                int count = bandCount[b];
                 float rms = (count > 0) ? sqrtf(sumSq / (float)count) : 0.f;
                 float eqM = (BAND_EQ_ZONE[b] == 0)   ? eq.low
                             : (BAND_EQ_ZONE[b] == 1) ? eq.mid
@@ -2,7 +2,7 @@
 // @id              explorer-details-better-file-sizes
 // @name            Better file sizes in Explorer details
 // @description     Enhances file size display in Explorer details with folder sizes, human-readable units (MB/GB), and optional IEC notation (KiB/MiB)
-// @version         1.5.1
+// @version         1.6.1
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -80,6 +80,10 @@ have them calculated manually. Since calculating folder sizes can be slow, it's
 not enabled by default, and there's an option to enable it only while holding
 the Shift key.
 
+Subfolders are calculated concurrently by several background threads. The
+results can optionally be cached on disk, so that revisiting a folder is much
+faster. Only NTFS and ReFS drives are cached.
+
 ## Mix files and folders when sorting by size
 
 When sorting by size, files end up in one separate chunk, and folders in
@@ -122,6 +126,15 @@ KiB?](https://devblogs.microsoft.com/oldnewthing/20090611-00/?p=17933).
   - everything: Enabled via "Everything" integration
   - always: Enabled, calculated manually (can be slow)
   - withShiftKey: Enabled, calculated manually while holding the Shift key
+- cacheFolderSizes: false
+  $name: Cache calculated folder sizes
+  $description: >-
+    Only relevant when folder sizes are calculated manually. Sizes are kept in
+    a cache which is saved to disk, so that revisiting a folder is instant.
+    Changes to folder contents are detected by folder timestamps, which aren't
+    updated when an existing file grows or shrinks, so the size of a folder
+    with such a file can be outdated until a file is added, removed or renamed
+    in the same folder. For this reason, the cache is disabled by default.
 - sortSizesMixFolders: true
   $name: Mix files and folders when sorting by size
   $description: >-
@@ -141,12 +154,17 @@ KiB?](https://devblogs.microsoft.com/oldnewthing/20090611-00/?p=17933).
 
 #include <algorithm>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 using namespace std::string_view_literals;
@@ -170,6 +188,7 @@ enum class CalculateFolderSizes {
 
 struct {
     CalculateFolderSizes calculateFolderSizes;
+    bool cacheFolderSizes;
     bool sortSizesMixFolders;
     bool disableKbOnlySizes;
     bool useIecTerms;
@@ -1710,6 +1729,875 @@ std::wstring GetFolderPathFromIShellFolder(IShellFolder2* shellFolder) {
     return path;
 }
 
+// Manual folder size calculation. Instead of walking each folder serially with
+// INamespaceWalk, file system folders are walked by a small pool of worker
+// threads. Each directory is a separate task, workers pop tasks from their own
+// queue and steal from others when idle, so one large folder is spread across
+// all workers, and all subfolders of the current folder can be sized at once.
+//
+// Per-directory results (the size of the files directly in the directory and
+// the names of its subdirectories) are kept in a cache which is persisted in
+// the mod storage folder. A record is only used if the directory's last write
+// time didn't change, which is the case as long as no entries were added,
+// removed or renamed. Only NTFS and ReFS volumes are cached, since other file
+// systems don't reliably update directory timestamps.
+//
+// Several Explorer processes can use the cache at once. Each one only writes
+// the records it changed: the file is re-read and merged under a named mutex,
+// and the newest record of each directory wins. When the cache is full, the
+// least recently used records are evicted.
+
+constexpr size_t kFolderSizeCacheMaxRecords = 200000;
+constexpr size_t kFolderSizeCacheRecordsAfterEviction =
+    kFolderSizeCacheMaxRecords * 9 / 10;
+constexpr DWORD kFolderSizeCacheSaveIntervalMs = 60 * 1000;
+constexpr DWORD kFolderSizeCacheSaveMutexTimeoutMs = 5 * 1000;
+constexpr DWORD kFolderSizeCacheFileMagic = 0x43534657;  // "WFSC"
+constexpr DWORD kFolderSizeCacheFileVersion = 2;
+// The last used time of a record is only refreshed once a day, so that
+// revisiting a folder doesn't mark its whole tree for saving.
+constexpr ULONGLONG kFolderSizeCacheTouchInterval =
+    24ULL * 60 * 60 * 10000000;  // 100-nanosecond units
+
+struct FolderSizeDirRecord {
+    ULONGLONG lastWriteTime;
+    ULONGLONG filesSize;
+    std::vector<std::wstring> subdirs;
+    ULONGLONG lastUsedTime = 0;
+};
+
+class FolderSizeCache {
+   public:
+    bool Lookup(const std::wstring& path,
+                ULONGLONG lastWriteTime,
+                ULONGLONG* filesSize,
+                std::vector<std::wstring>* subdirs) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        LoadIfNeeded();
+
+        auto it = m_records.find(path);
+        if (it == m_records.end() ||
+            it->second.lastWriteTime != lastWriteTime) {
+            return false;
+        }
+
+        ULONGLONG now = GetCurrentFileTime();
+        if (now - it->second.lastUsedTime > kFolderSizeCacheTouchInterval) {
+            it->second.lastUsedTime = now;
+            m_changedPaths.insert(path);
+        }
+
+        *filesSize = it->second.filesSize;
+        *subdirs = it->second.subdirs;
+        return true;
+    }
+
+    void Store(const std::wstring& path, FolderSizeDirRecord record) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        LoadIfNeeded();
+
+        if (m_records.size() >= kFolderSizeCacheMaxRecords &&
+            !m_records.contains(path)) {
+            EvictLeastRecentlyUsed(&m_records,
+                                   kFolderSizeCacheRecordsAfterEviction);
+        }
+
+        record.lastUsedTime = GetCurrentFileTime();
+        m_records.insert_or_assign(path, std::move(record));
+        m_changedPaths.insert(path);
+    }
+
+    // Saves the cache if it was modified. Unless `force` is set, saving is
+    // skipped if the cache was saved recently.
+    void Save(bool force) {
+        // One save at a time, so that the records merged by an older save
+        // never replace the ones of a newer save.
+        std::unique_lock<std::mutex> saveLock(m_saveMutex, std::defer_lock);
+        if (force) {
+            saveLock.lock();
+        } else if (!saveLock.try_lock()) {
+            return;
+        }
+
+        Records changes;
+
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            if (m_changedPaths.empty() ||
+                (!force && GetTickCount() - m_lastSaveTickCount <
+                               kFolderSizeCacheSaveIntervalMs)) {
+                return;
+            }
+
+            for (const auto& path : m_changedPaths) {
+                if (auto it = m_records.find(path); it != m_records.end()) {
+                    changes.insert(*it);
+                }
+            }
+
+            m_changedPaths.clear();
+            m_lastSaveTickCount = GetTickCount();
+        }
+
+        std::wstring filePath = GetCacheFilePath();
+        if (filePath.empty()) {
+            return;
+        }
+
+        Records records;
+        if (!MergeIntoFile(filePath, changes, &records)) {
+            // Keep the changes for the next attempt, unless they were evicted
+            // meanwhile.
+            std::lock_guard<std::mutex> guard(m_mutex);
+            for (const auto& [path, record] : changes) {
+                if (m_records.contains(path)) {
+                    m_changedPaths.insert(path);
+                }
+            }
+            return;
+        }
+
+        // Adopt the merged records, which include the changes of other
+        // processes, except for records which changed while saving.
+        std::lock_guard<std::mutex> guard(m_mutex);
+        for (const auto& path : m_changedPaths) {
+            if (auto it = m_records.find(path); it != m_records.end()) {
+                records.insert_or_assign(path, std::move(it->second));
+            }
+        }
+
+        m_records = std::move(records);
+    }
+
+   private:
+    using Records = std::unordered_map<std::wstring, FolderSizeDirRecord>;
+
+    static ULONGLONG GetCurrentFileTime() {
+        FILETIME fileTime;
+        GetSystemTimeAsFileTime(&fileTime);
+        return ((ULONGLONG)fileTime.dwHighDateTime << 32) |
+               fileTime.dwLowDateTime;
+    }
+
+    // Keeps the `count` most recently used records.
+    static void EvictLeastRecentlyUsed(Records* records, size_t count) {
+        if (records->size() <= count) {
+            return;
+        }
+
+        std::vector<ULONGLONG> lastUsedTimes;
+        lastUsedTimes.reserve(records->size());
+        for (const auto& [path, record] : *records) {
+            lastUsedTimes.push_back(record.lastUsedTime);
+        }
+
+        size_t excess = records->size() - count;
+        std::nth_element(lastUsedTimes.begin(),
+                         lastUsedTimes.begin() + excess, lastUsedTimes.end());
+        ULONGLONG threshold = lastUsedTimes[excess];
+
+        // Older records are evicted first, then records which were last used
+        // exactly at the threshold time, until enough were evicted.
+        excess -= std::erase_if(*records, [threshold](const auto& item) {
+            return item.second.lastUsedTime < threshold;
+        });
+        for (auto it = records->begin(); it != records->end() && excess > 0;) {
+            if (it->second.lastUsedTime == threshold) {
+                it = records->erase(it);
+                excess--;
+            } else {
+                ++it;
+            }
+        }
+
+        Wh_Log(L"Evicted folder size cache records, %zu left",
+               records->size());
+    }
+
+    static std::wstring GetCacheFilePath() {
+        WCHAR storagePath[MAX_PATH];
+        size_t len = Wh_GetModStoragePath(storagePath, ARRAYSIZE(storagePath));
+        if (len == 0 || len >= ARRAYSIZE(storagePath)) {
+            return {};
+        }
+
+        CreateDirectory(storagePath, nullptr);
+
+        std::wstring filePath = storagePath;
+        filePath += L"\\folder-size-cache.bin";
+        return filePath;
+    }
+
+    // Re-reads the cache file, applies `changes` and writes it back, all while
+    // holding a mutex shared by all processes, so that the changes of other
+    // processes aren't lost. The merged records are returned in `records`.
+    static bool MergeIntoFile(const std::wstring& filePath,
+                              const Records& changes,
+                              Records* records) {
+        HANDLE mutex = CreateMutex(nullptr, FALSE,
+                                   L"windhawk-folder-size-cache_" WH_MOD_ID);
+        if (!mutex) {
+            Wh_Log(L"CreateMutex failed: %u", GetLastError());
+            return false;
+        }
+
+        DWORD waitResult =
+            WaitForSingleObject(mutex, kFolderSizeCacheSaveMutexTimeoutMs);
+        if (waitResult != WAIT_OBJECT_0 && waitResult != WAIT_ABANDONED) {
+            Wh_Log(L"Timed out waiting for the folder size cache");
+            CloseHandle(mutex);
+            return false;
+        }
+
+        ReadCacheFile(filePath, records);
+
+        for (const auto& [path, record] : changes) {
+            auto it = records->find(path);
+            if (it == records->end()) {
+                records->emplace(path, record);
+            } else if (it->second.lastUsedTime <= record.lastUsedTime) {
+                it->second = record;
+            }
+        }
+
+        if (records->size() > kFolderSizeCacheMaxRecords) {
+            EvictLeastRecentlyUsed(records,
+                                   kFolderSizeCacheRecordsAfterEviction);
+        }
+
+        std::vector<BYTE> data;
+        Serialize(*records, &data);
+        bool succeeded = WriteCacheFile(filePath, data);
+
+        ReleaseMutex(mutex);
+        CloseHandle(mutex);
+        return succeeded;
+    }
+
+    static bool WriteCacheFile(const std::wstring& filePath,
+                               const std::vector<BYTE>& data) {
+        // Write to a temporary file first, so that other processes never see
+        // a partially written cache.
+        std::wstring tempFilePath =
+            filePath + L"." + std::to_wstring(GetCurrentProcessId()) + L".tmp";
+
+        HANDLE file = CreateFile(tempFilePath.c_str(), GENERIC_WRITE, 0,
+                                 nullptr, CREATE_ALWAYS,
+                                 FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            Wh_Log(L"Failed to create %s: %u", tempFilePath.c_str(),
+                   GetLastError());
+            return false;
+        }
+
+        DWORD written = 0;
+        bool succeeded =
+            WriteFile(file, data.data(), (DWORD)data.size(), &written,
+                      nullptr) &&
+            written == data.size();
+        CloseHandle(file);
+
+        if (!succeeded ||
+            !MoveFileEx(tempFilePath.c_str(), filePath.c_str(),
+                        MOVEFILE_REPLACE_EXISTING)) {
+            Wh_Log(L"Failed to save folder size cache: %u", GetLastError());
+            DeleteFile(tempFilePath.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    static void ReadCacheFile(const std::wstring& filePath, Records* records) {
+        HANDLE file = CreateFile(filePath.c_str(), GENERIC_READ,
+                                 FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                                 OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return;
+        }
+
+        std::vector<BYTE> data;
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0 &&
+            fileSize.QuadPart < 256 * 1024 * 1024) {
+            data.resize((size_t)fileSize.QuadPart);
+            DWORD read = 0;
+            if (!ReadFile(file, data.data(), (DWORD)data.size(), &read,
+                          nullptr) ||
+                read != data.size()) {
+                data.clear();
+            }
+        }
+
+        CloseHandle(file);
+
+        if (!data.empty() && !Deserialize(data, records)) {
+            Wh_Log(L"Ignoring invalid or outdated folder size cache");
+            records->clear();
+        }
+    }
+
+    // File layout (little endian): magic, version, record count, then per
+    // record: path, last write time, files size, last used time, subdir count,
+    // subdir names. Strings are stored as a DWORD length followed by the
+    // characters.
+    static void Serialize(const Records& records, std::vector<BYTE>* data) {
+        auto write = [data](const void* p, size_t size) {
+            data->insert(data->end(), (const BYTE*)p, (const BYTE*)p + size);
+        };
+        auto writeDword = [&write](DWORD value) {
+            write(&value, sizeof(value));
+        };
+        auto writeString = [&write, &writeDword](const std::wstring& str) {
+            writeDword((DWORD)str.size());
+            write(str.data(), str.size() * sizeof(WCHAR));
+        };
+
+        writeDword(kFolderSizeCacheFileMagic);
+        writeDword(kFolderSizeCacheFileVersion);
+        writeDword((DWORD)records.size());
+        for (const auto& [path, record] : records) {
+            writeString(path);
+            write(&record.lastWriteTime, sizeof(record.lastWriteTime));
+            write(&record.filesSize, sizeof(record.filesSize));
+            write(&record.lastUsedTime, sizeof(record.lastUsedTime));
+            writeDword((DWORD)record.subdirs.size());
+            for (const auto& subdir : record.subdirs) {
+                writeString(subdir);
+            }
+        }
+    }
+
+    static bool Deserialize(const std::vector<BYTE>& data, Records* records) {
+        size_t offset = 0;
+        auto read = [&data, &offset](void* p, size_t size) {
+            if (size > data.size() - offset) {
+                return false;
+            }
+            memcpy(p, data.data() + offset, size);
+            offset += size;
+            return true;
+        };
+        auto readDword = [&read](DWORD* value) {
+            return read(value, sizeof(*value));
+        };
+        auto readString = [&data, &offset, &readDword](std::wstring* str) {
+            DWORD length;
+            if (!readDword(&length) ||
+                length > (data.size() - offset) / sizeof(WCHAR)) {
+                return false;
+            }
+            str->assign((const WCHAR*)(data.data() + offset), length);
+            offset += length * sizeof(WCHAR);
+            return true;
+        };
+
+        DWORD magic, version, count;
+        if (!readDword(&magic) || magic != kFolderSizeCacheFileMagic ||
+            !readDword(&version) || version != kFolderSizeCacheFileVersion ||
+            !readDword(&count) || count > kFolderSizeCacheMaxRecords) {
+            return false;
+        }
+
+        records->reserve(count);
+        for (DWORD i = 0; i < count; i++) {
+            std::wstring path;
+            FolderSizeDirRecord record;
+            DWORD subdirCount;
+            if (!readString(&path) ||
+                !read(&record.lastWriteTime, sizeof(record.lastWriteTime)) ||
+                !read(&record.filesSize, sizeof(record.filesSize)) ||
+                !read(&record.lastUsedTime, sizeof(record.lastUsedTime)) ||
+                !readDword(&subdirCount)) {
+                return false;
+            }
+
+            record.subdirs.reserve(std::min<DWORD>(subdirCount, 4096));
+            for (DWORD j = 0; j < subdirCount; j++) {
+                std::wstring subdir;
+                if (!readString(&subdir)) {
+                    return false;
+                }
+                record.subdirs.push_back(std::move(subdir));
+            }
+
+            records->emplace(std::move(path), std::move(record));
+        }
+
+        return true;
+    }
+
+    void LoadIfNeeded() {
+        if (m_loaded) {
+            return;
+        }
+
+        m_loaded = true;
+        m_lastSaveTickCount = GetTickCount();
+
+        std::wstring filePath = GetCacheFilePath();
+        if (filePath.empty()) {
+            return;
+        }
+
+        ReadCacheFile(filePath, &m_records);
+
+        Wh_Log(L"Loaded %zu folder size cache records", m_records.size());
+    }
+
+    std::mutex m_saveMutex;
+    std::mutex m_mutex;
+    Records m_records;
+    std::unordered_set<std::wstring> m_changedPaths;
+    bool m_loaded = false;
+    DWORD m_lastSaveTickCount = 0;
+};
+
+FolderSizeCache g_folderSizeCache;
+
+// Explorer doesn't notify when a view navigates away or is closed, but it then
+// stops asking for the sizes of the folder it listed. A listing which nobody
+// waits on and which wasn't queried for a while is considered gone, and the
+// remaining walks of its jobs are dropped.
+constexpr DWORD kFolderSizeListingIdleTimeoutMs = 5 * 1000;
+
+struct FolderSizeListing {
+    std::atomic<DWORD> lastQueryTickCount = GetTickCount();
+    std::atomic<int> waiters = 0;
+    std::atomic<bool> cancelled = false;
+
+    bool IsAbandoned() {
+        if (!cancelled && waiters == 0 &&
+            GetTickCount() - lastQueryTickCount >
+                kFolderSizeListingIdleTimeoutMs &&
+            !cancelled.exchange(true)) {
+            Wh_Log(L"Dropping folder size jobs of an idle listing");
+        }
+
+        return cancelled;
+    }
+};
+
+class FolderSizeWalker {
+   public:
+    struct Job {
+        std::atomic<ULONGLONG> totalSize = 0;
+        std::atomic<int> pendingDirs = 0;
+        std::atomic<bool> failed = false;
+        bool useCache = false;
+        std::shared_ptr<FolderSizeListing> listing;
+    };
+
+    std::shared_ptr<Job> Submit(std::wstring path,
+                                bool useCache,
+                                std::shared_ptr<FolderSizeListing> listing) {
+        auto job = std::make_shared<Job>();
+        job->useCache = useCache;
+        job->listing = std::move(listing);
+
+        std::lock_guard<std::mutex> guard(m_startMutex);
+        if (m_stopping) {
+            job->failed = true;
+            return job;
+        }
+
+        if (m_workers.empty()) {
+            Start();
+        }
+
+        job->pendingDirs = 1;
+        PushTask(nullptr, Task{job, std::move(path), true});
+        return job;
+    }
+
+    std::optional<ULONGLONG> Wait(const std::shared_ptr<Job>& job) {
+        FolderSizeListing& listing = *job->listing;
+        listing.waiters++;
+
+        {
+            std::unique_lock<std::mutex> lock(m_doneMutex);
+            m_doneCondition.wait(lock, [&job, this] {
+                return job->pendingDirs == 0 || m_stopping;
+            });
+        }
+
+        listing.lastQueryTickCount = GetTickCount();
+        listing.waiters--;
+
+        if (job->pendingDirs != 0 || job->failed || listing.cancelled) {
+            return std::nullopt;
+        }
+
+        return job->totalSize.load();
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> guard(m_startMutex);
+            m_stopping = true;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(m_wakeMutex);
+        }
+        m_wakeCondition.notify_all();
+
+        {
+            std::lock_guard<std::mutex> guard(m_doneMutex);
+        }
+        m_doneCondition.notify_all();
+
+        for (auto& worker : m_workers) {
+            worker->thread.join();
+        }
+
+        m_workers.clear();
+        m_rootTasks.clear();
+    }
+
+   private:
+    struct Task {
+        std::shared_ptr<Job> job;
+        std::wstring path;
+        bool isRoot;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void Start() {
+        unsigned threadCount =
+            std::clamp(std::thread::hardware_concurrency(), 2u, 6u);
+
+        for (unsigned i = 0; i < threadCount; i++) {
+            m_workers.push_back(std::make_unique<Worker>());
+        }
+
+        for (size_t i = 0; i < m_workers.size(); i++) {
+            m_workers[i]->thread = std::thread(&FolderSizeWalker::WorkerThread,
+                                               this, i);
+        }
+    }
+
+    // Pushes to the worker's own queue, or to the shared queue of root tasks
+    // if `worker` is null. The task is counted before it's queued, so that the
+    // count never drops below the number of queued tasks when a worker pops it
+    // right away.
+    void PushTask(Worker* worker, Task task) {
+        {
+            std::lock_guard<std::mutex> guard(m_wakeMutex);
+            m_queuedTasks++;
+        }
+
+        if (worker) {
+            std::lock_guard<std::mutex> guard(worker->mutex);
+            worker->tasks.push_back(std::move(task));
+        } else {
+            std::lock_guard<std::mutex> guard(m_rootTasksMutex);
+            m_rootTasks.push_back(std::move(task));
+        }
+
+        m_wakeCondition.notify_one();
+    }
+
+    // Pops the newest task of the worker's own queue (depth first, keeps the
+    // queue small), or steals the oldest task of another worker (breadth
+    // first, takes a large chunk of work). New folders are only started when
+    // there's nothing to steal, so that all workers help finish the folders
+    // in the order they were submitted, which is the order Explorer asks for
+    // them.
+    bool PopTask(size_t workerIndex, Task* task) {
+        bool found = false;
+
+        for (size_t i = 0; i < m_workers.size() && !found; i++) {
+            Worker& worker = *m_workers[(workerIndex + i) % m_workers.size()];
+            std::lock_guard<std::mutex> guard(worker.mutex);
+            if (worker.tasks.empty()) {
+                continue;
+            }
+
+            if (i == 0) {
+                *task = std::move(worker.tasks.back());
+                worker.tasks.pop_back();
+            } else {
+                *task = std::move(worker.tasks.front());
+                worker.tasks.pop_front();
+            }
+
+            found = true;
+        }
+
+        if (!found) {
+            std::lock_guard<std::mutex> guard(m_rootTasksMutex);
+            if (!m_rootTasks.empty()) {
+                *task = std::move(m_rootTasks.front());
+                m_rootTasks.pop_front();
+                found = true;
+            }
+        }
+
+        if (found) {
+            std::lock_guard<std::mutex> guard(m_wakeMutex);
+            m_queuedTasks--;
+        }
+
+        return found;
+    }
+
+    void WorkerThread(size_t workerIndex) {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(m_wakeMutex);
+                m_wakeCondition.wait(
+                    lock, [this] { return m_queuedTasks > 0 || m_stopping; });
+                if (m_stopping) {
+                    break;
+                }
+            }
+
+            Task task;
+            while (PopTask(workerIndex, &task)) {
+                if (!m_stopping && !task.job->listing->IsAbandoned()) {
+                    ProcessTask(workerIndex, task);
+                }
+
+                if (--task.job->pendingDirs == 0) {
+                    {
+                        std::lock_guard<std::mutex> guard(m_doneMutex);
+                    }
+                    m_doneCondition.notify_all();
+
+                    if (task.job->useCache) {
+                        g_folderSizeCache.Save(/*force=*/false);
+                    }
+                }
+            }
+        }
+    }
+
+    void ProcessTask(size_t workerIndex, const Task& task) {
+        Job& job = *task.job;
+
+        WIN32_FILE_ATTRIBUTE_DATA fad;
+        if (!GetFileAttributesEx(LongPath(task.path).c_str(),
+                                 GetFileExInfoStandard, &fad)) {
+            if (task.isRoot) {
+                job.failed = true;
+            }
+            return;
+        }
+
+        ULONGLONG lastWriteTime =
+            ((ULONGLONG)fad.ftLastWriteTime.dwHighDateTime << 32) |
+            fad.ftLastWriteTime.dwLowDateTime;
+
+        ULONGLONG filesSize = 0;
+        std::vector<std::wstring> subdirs;
+        if (!job.useCache ||
+            !g_folderSizeCache.Lookup(task.path, lastWriteTime, &filesSize,
+                                      &subdirs)) {
+            if (!EnumerateDirectory(task.path, &filesSize, &subdirs)) {
+                if (task.isRoot) {
+                    job.failed = true;
+                }
+                return;
+            }
+
+            if (job.useCache) {
+                g_folderSizeCache.Store(
+                    task.path,
+                    FolderSizeDirRecord{lastWriteTime, filesSize, subdirs});
+            }
+        }
+
+        job.totalSize += filesSize;
+
+        job.pendingDirs += (int)subdirs.size();
+        for (const auto& subdir : subdirs) {
+            std::wstring subdirPath = task.path;
+            if (subdirPath.back() != L'\\') {
+                subdirPath += L'\\';
+            }
+            subdirPath += subdir;
+            PushTask(m_workers[workerIndex].get(),
+                     Task{task.job, std::move(subdirPath), false});
+        }
+    }
+
+    // Lists the directory, summing the sizes of the files in it and collecting
+    // the names of its subdirectories. Directory reparse points (junctions,
+    // symbolic links) aren't followed, both to avoid cycles and to avoid
+    // counting the same data twice.
+    static bool EnumerateDirectory(const std::wstring& path,
+                                   ULONGLONG* filesSize,
+                                   std::vector<std::wstring>* subdirs) {
+        std::wstring searchPath = LongPath(path);
+        if (searchPath.back() != L'\\') {
+            searchPath += L'\\';
+        }
+        searchPath += L'*';
+
+        WIN32_FIND_DATA findData;
+        HANDLE findHandle = FindFirstFileEx(
+            searchPath.c_str(), FindExInfoBasic, &findData,
+            FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+        if (findHandle == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        do {
+            if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                if (wcscmp(findData.cFileName, L".") == 0 ||
+                    wcscmp(findData.cFileName, L"..") == 0 ||
+                    (findData.dwFileAttributes &
+                     FILE_ATTRIBUTE_REPARSE_POINT)) {
+                    continue;
+                }
+
+                subdirs->push_back(findData.cFileName);
+            } else {
+                *filesSize += ((ULONGLONG)findData.nFileSizeHigh << 32) |
+                              findData.nFileSizeLow;
+            }
+        } while (FindNextFile(findHandle, &findData));
+
+        FindClose(findHandle);
+        return true;
+    }
+
+    static std::wstring LongPath(const std::wstring& path) {
+        if (path.size() < MAX_PATH - 12 || path.starts_with(L"\\\\?\\")) {
+            return path;
+        }
+
+        if (path.starts_with(L"\\\\")) {
+            return L"\\\\?\\UNC\\" + path.substr(2);
+        }
+
+        return L"\\\\?\\" + path;
+    }
+
+    std::mutex m_startMutex;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<bool> m_stopping = false;
+
+    std::mutex m_rootTasksMutex;
+    std::deque<Task> m_rootTasks;
+
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;
+    size_t m_queuedTasks = 0;
+
+    std::mutex m_doneMutex;
+    std::condition_variable m_doneCondition;
+};
+
+FolderSizeWalker g_folderSizeWalker;
+
+// Directory timestamps are only reliable for the cache on local NTFS and ReFS
+// volumes.
+bool CanCacheFolderSizes(PCWSTR folderPath) {
+    if (!g_settings.cacheFolderSizes || IsNetworkPath(folderPath)) {
+        return false;
+    }
+
+    WCHAR volumePath[MAX_PATH];
+    WCHAR fileSystemName[MAX_PATH];
+    if (!GetVolumePathName(folderPath, volumePath, ARRAYSIZE(volumePath)) ||
+        !GetVolumeInformation(volumePath, nullptr, 0, nullptr, nullptr,
+                              nullptr, fileSystemName,
+                              ARRAYSIZE(fileSystemName))) {
+        return false;
+    }
+
+    return _wcsicmp(fileSystemName, L"NTFS") == 0 ||
+           _wcsicmp(fileSystemName, L"ReFS") == 0;
+}
+
+// Folder size jobs of the folder currently being listed, keyed by path. All
+// subfolders are submitted when the listing starts, so that they're calculated
+// concurrently while Explorer queries them one by one.
+thread_local std::shared_ptr<FolderSizeListing> g_folderSizeListing;
+thread_local std::unordered_map<std::wstring,
+                                std::shared_ptr<FolderSizeWalker::Job>>
+    g_folderSizeJobs;
+
+void CancelFolderSizeJobs() {
+    if (g_folderSizeListing) {
+        g_folderSizeListing->cancelled = true;
+        g_folderSizeListing.reset();
+    }
+
+    g_folderSizeJobs.clear();
+}
+
+// Returns the listing of the current thread, starting a new one if there's
+// none, or if it was dropped after being idle, e.g. when Explorer only asked
+// for the visible items and the rest were scrolled into view later.
+FolderSizeListing& GetFolderSizeListing() {
+    if (!g_folderSizeListing || g_folderSizeListing->cancelled) {
+        g_folderSizeListing = std::make_shared<FolderSizeListing>();
+        g_folderSizeJobs.clear();
+    }
+
+    g_folderSizeListing->lastQueryTickCount = GetTickCount();
+    return *g_folderSizeListing;
+}
+
+void SubmitSubfolderSizeJobs(const std::wstring& folderPath) {
+    bool useCache = CanCacheFolderSizes(folderPath.c_str());
+    GetFolderSizeListing();
+
+    std::wstring searchPath = folderPath;
+    if (searchPath.back() != L'\\') {
+        searchPath += L'\\';
+    }
+    searchPath += L'*';
+
+    WIN32_FIND_DATA findData;
+    HANDLE findHandle = FindFirstFileEx(searchPath.c_str(), FindExInfoBasic,
+                                        &findData, FindExSearchNameMatch,
+                                        nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (findHandle == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    do {
+        if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ||
+            wcscmp(findData.cFileName, L".") == 0 ||
+            wcscmp(findData.cFileName, L"..") == 0) {
+            continue;
+        }
+
+        std::wstring path = searchPath.substr(0, searchPath.size() - 1);
+        path += findData.cFileName;
+        auto job =
+            g_folderSizeWalker.Submit(path, useCache, g_folderSizeListing);
+        g_folderSizeJobs.try_emplace(std::move(path), std::move(job));
+    } while (FindNextFile(findHandle, &findData));
+
+    FindClose(findHandle);
+}
+
+std::optional<ULONGLONG> CalculateFileSystemFolderSize(
+    const std::wstring& path) {
+    GetFolderSizeListing();
+
+    std::shared_ptr<FolderSizeWalker::Job> job;
+    if (auto it = g_folderSizeJobs.find(path); it != g_folderSizeJobs.end()) {
+        job = it->second;
+    } else {
+        job = g_folderSizeWalker.Submit(
+            path, CanCacheFolderSizes(path.c_str()), g_folderSizeListing);
+        g_folderSizeJobs.try_emplace(path, job);
+    }
+
+    return g_folderSizeWalker.Wait(job);
+}
+
 using CFSFolder__GetSize_t = HRESULT(WINAPI*)(void* pCFSFolder,
                                               const ITEMID_CHILD* itemidChild,
                                               const void* idFolder,
@@ -1761,6 +2649,16 @@ HRESULT WINAPI CFSFolder__GetSize_Hook(void* pCFSFolder,
         GetTickCount() - g_cacheShellFolderLastUsedTickCount > 1000) {
         Wh_Log(L"Clearing cache");
         g_cacheShellFolderSizes.clear();
+        CancelFolderSizeJobs();
+
+        if (g_settings.calculateFolderSizes !=
+            CalculateFolderSizes::everything) {
+            const auto folderPath =
+                GetFolderPathFromIShellFolder(shellFolder2.get());
+            if (!folderPath.empty()) {
+                SubmitSubfolderSizeJobs(folderPath);
+            }
+        }
     }
 
     g_cacheShellFolder = std::move(shellFolder2Vector);
@@ -1828,7 +2726,13 @@ HRESULT WINAPI CFSFolder__GetSize_Hook(void* pCFSFolder,
                 Wh_Log(L"Failed to get path");
             }
         } else {
-            cacheIt->second = CalculateFolderSize(childFolder.get());
+            // Folders without a file system path are walked via the shell.
+            const auto path = GetFolderPathFromIShellFolder(childFolder.get());
+            if (!path.empty()) {
+                cacheIt->second = CalculateFileSystemFolderSize(path);
+            } else {
+                cacheIt->second = CalculateFolderSize(childFolder.get());
+            }
         }
     } else {
         Wh_Log(L"Using cached size");
@@ -2857,6 +3761,8 @@ void LoadSettings() {
     }
     Wh_FreeStringSetting(calculateFolderSizes);
 
+    g_settings.cacheFolderSizes = Wh_GetIntSetting(L"cacheFolderSizes");
+
     g_settings.sortSizesMixFolders = Wh_GetIntSetting(L"sortSizesMixFolders");
     g_settings.disableKbOnlySizes = Wh_GetIntSetting(L"disableKbOnlySizes");
     g_settings.useIecTerms = Wh_GetIntSetting(L"useIecTerms");
@@ -2990,6 +3896,9 @@ void Wh_ModUninit() {
         WaitForSingleObject(thread, INFINITE);
         CloseHandle(thread);
     }
+
+    g_folderSizeWalker.Stop();
+    g_folderSizeCache.Save(/*force=*/true);
 }
 
 BOOL Wh_ModSettingsChanged(BOOL* bReload) {
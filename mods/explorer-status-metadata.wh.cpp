@@ -2,7 +2,7 @@
 // @id              explorer-status-metadata
 // @name            Explorer Status Bar Metadata
 // @description     Appends rich metadata (dimensions, date, type, duration, bitrate, fps) to Explorer's status bar. Zero polling — purely reactive, path-keyed cache.
-// @version         1.4.0
+// @version         1.5.1
 // @author          VitalS
 // @github          https://github.com/VitalSkib
 // @include         explorer.exe
@@ -27,22 +27,22 @@
 - cacheEvictCount: 10
   $name: Cache eviction count
   $description: >
-    When the cache reaches 1000 entries, this many of the oldest entries
-    are removed. Range: 1-50. Lower values preserve more history;
+    When the cache reaches 1000 entries, this many of the least recently
+    used entries are removed. Range: 1-50. Lower values preserve more history;
     higher values free more memory at once.
 */
 // ==/WindhawkModSettings==
 
 // ==WindhawkModReadme==
 /*
-# Explorer Status Bar Metadata — v1.4.0
+# Explorer Status Bar Metadata — v1.5.1
 
 Appends file metadata to the Windows Explorer status bar when a single file
 is selected: dimensions, modification date, file type, duration, bitrate, fps.
 
 ## How it works
 - No timers, no polling. Metadata is computed only when the selected file changes.
-- Path-keyed LRU-style cache (1000 entries). Same file = instant return, zero COM calls.
+- Path-keyed LRU cache (1000 entries, 1 MB). Same file = instant return, zero COM calls.
 - Hooks `PSFormatForDisplayAlloc` in propsys.dll — the exact function Explorer calls
   to format the file size for the status bar. Language-independent, no text matching.
 - Filter: `key == System.Size` AND `SHELL32.dll` appears in the first 5 call stack
@@ -50,7 +50,8 @@ is selected: dimensions, modification date, file type, duration, bitrate, fps.
 - Compatible with "Better file sizes in Explorer details" — multi-frame stack scan
   handles chained hooks transparently.
 - Custom binary parsers for formats the Windows Property System does not index:
-  SVG, HDR, EXR, TIFF/TX (LE+BE), TGA, PSD/PSB, WebM/MKV (EBML).
+  SVG, HDR, EXR, TIFF/TX (LE+BE), TGA, PSD/PSB, WebM/MKV (EBML). The file header
+  is read once and the parser is picked by its magic bytes.
 
 ## Settings
 - **Network drives** — disabled by default. Can freeze Explorer on slow networks.
@@ -58,6 +59,18 @@ is selected: dimensions, modification date, file type, duration, bitrate, fps.
 - **Cache evict count** — how many old entries to drop when the 1000-entry limit is hit.
 
 ## Changelog
+### v1.5.1
+- A TIFF whose IFD offset is within 2 bytes of 4 GB is skipped instead of
+  having its tags read from the start of the file
+
+### v1.5.0
+- Custom parsers share a single header read and are selected by magic bytes
+  (extension is only a hint), so a mislabeled file is still parsed correctly
+- TIFF IFD is fetched with one read instead of one read per tag; big-endian
+  SHORT width/height values are now decoded correctly
+- Cache is a true LRU with O(1) lookup, promotion and eviction, bounded by
+  entry count and a 1 MB byte budget
+
 ### v1.4.0
 - Replaced DrawTextW/GetTextExtentPoint32W hooks with PSFormatForDisplayAlloc hook
   (language-independent, no text matching, no "selected"-string false positives)
@@ -97,6 +110,9 @@ is selected: dimensions, modification date, file type, duration, bitrate, fps.
 #include <propkey.h>
 #include <string>
 #include <algorithm>
+#include <list>
+#include <memory>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -122,11 +138,20 @@ static bool   g_allowRemovableDrives = true;
 static size_t g_cacheEvictCount      = 10;
 
 // ─── Metadata cache ──────────────────────────────────────────────────────────
-// unordered_map for O(1) lookup + vector to track insertion order for eviction.
+// list in recency order (front = most recent) + unordered_map of list iterators,
+// so lookup, promotion and eviction are all O(1). Bounded by entry count and
+// by the total size of the cached strings.
+struct MetaCacheEntry {
+    std::wstring path;
+    std::wstring suffix;
+};
 static CRITICAL_SECTION g_cs;
-static std::unordered_map<std::wstring, std::wstring> g_metaCache;
-static std::vector<std::wstring>                      g_cacheOrder;
-static const size_t MAX_CACHE_SIZE = 1000;
+static std::list<MetaCacheEntry> g_metaCacheList;
+static std::unordered_map<std::wstring_view,
+                          std::list<MetaCacheEntry>::iterator> g_metaCache;
+static size_t g_metaCacheBytes = 0;
+static const size_t MAX_CACHE_SIZE  = 1000;
+static const size_t MAX_CACHE_BYTES = 1024 * 1024;
 
 // ─── Binary structures for TIFF/TX parser ────────────────────────────────────
 #pragma pack(push, 1)
@@ -137,7 +162,9 @@ struct TiffTag    { WORD tagId; WORD tagType; DWORD count; DWORD valueOffset; };
 // ═══════════════════════════════════════════════════════════════════════════════
 // BLOCK 1: Custom format binary parsers
 //   Covers formats the Windows Property System does not index natively:
-//   WebM/MKV (EBML), TIFF/TX (LE+BE), SVG, HDR, EXR, TGA, PSD/PSB, AI.
+//   WebM/MKV (EBML), TIFF/TX (LE+BE), SVG, HDR, EXR, TGA, PSD/PSB.
+//   Each format registers a magic-byte sniffer and a parser working on a
+//   shared header view, so a file is opened and read only once.
 // ═══════════════════════════════════════════════════════════════════════════════
 
 struct CustomMeta {
@@ -146,310 +173,425 @@ struct CustomMeta {
     double fps    = 0.0;
 };
 
-static CustomMeta ParseCustomFormatMetadata(const std::wstring& filePath, const std::wstring& ext)
-{
-    CustomMeta meta;
+// The first bytes of a file, read with a single ReadFile call and shared by all
+// format parsers. Data past the view (e.g. a TIFF IFD at the end of the file)
+// is fetched with ReadAt, which serves from the view when it can.
+struct FileHeaderView {
+    static const size_t kSize = 16384;
 
-    HANDLE hFile = CreateFileW(
-        filePath.c_str(), GENERIC_READ,
-        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
-        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    HANDLE        hFile = INVALID_HANDLE_VALUE;
+    unsigned char data[kSize];
+    size_t        size  = 0;
 
-    if (hFile == INVALID_HANDLE_VALUE)
-        return meta;
+    bool StartsWith(const void* magic, size_t len) const {
+        return size >= len && memcmp(data, magic, len) == 0;
+    }
 
-    DWORD bytesRead = 0;
+    bool ReadAt(DWORD offset, void* buf, DWORD len) const {
+        if (offset <= size && len <= size - offset) {
+            memcpy(buf, data + offset, len);
+            return true;
+        }
+        OVERLAPPED ov = {};
+        ov.Offset = offset;
+        DWORD bytesRead = 0;
+        return ReadFile(hFile, buf, len, &bytesRead, &ov) && bytesRead == len;
+    }
+};
 
-    // ── WebM / MKV (EBML/Matroska) ───────────────────────────────────────────
-    // Flat streaming parse: containers (Segment, Info, Tracks, TrackEntry, Video)
-    // are entered by letting the loop continue into their bodies without skipping.
-    // Leaf elements (PixelWidth, PixelHeight, DefaultDuration) are read directly.
-    if (ext == L"webm" || ext == L"mkv") {
-        unsigned char buf[16384];
-        if (ReadFile(hFile, buf, sizeof(buf), &bytesRead, nullptr) && bytesRead > 16) {
-            const unsigned char* p   = buf;
-            const unsigned char* end = buf + bytesRead;
-
-            // Reads a variable-length EBML ID (1–4 bytes, leading 1-bit signals length)
-            auto readID = [&]() -> uint32_t {
-                if (p >= end) return 0;
-                uint8_t first = *p;
-                if (first == 0) return 0;
-                int     len  = 1;
-                uint8_t mask = 0x80;
-                while (!(first & mask) && len <= 4) { mask >>= 1; len++; }
-                if (p + len > end) return 0;
-                uint32_t val = 0;
-                for (int i = 0; i < len; ++i) val = (val << 8) | *p++;
-                return val;
-            };
-
-            // Reads a variable-length EBML data size (1–8 bytes).
-            // Returns (uint64_t)-1 for "unknown size" (all data bits set).
-            auto readSize = [&]() -> uint64_t {
-                if (p >= end) return 0;
-                uint8_t first = *p;
-                if (first == 0) return 0;
-                int     len  = 1;
-                uint8_t mask = 0x80;
-                while (!(first & mask) && len <= 8) { mask >>= 1; len++; }
-                if (p + len > end) return 0;
-                uint64_t val         = (*p++) & ~mask;
-                for (int i = 1; i < len; ++i) val = (val << 8) | *p++;
-                uint64_t unknownSize = (1ULL << (7 * len)) - 1;
-                if (val == unknownSize) return (uint64_t)-1;
-                return val;
-            };
-
-            // Reads an unsigned integer from the next `size` bytes (big-endian)
-            auto readUint = [&](uint64_t size) -> uint64_t {
-                if (size > 8 || p + size > end) return 0;
-                uint64_t val = 0;
-                for (uint64_t i = 0; i < size; ++i) val = (val << 8) | *p++;
-                return val;
-            };
-
-            while (p < end) {
-                uint32_t id   = readID();
-                if (id == 0) break;
-                uint64_t size = readSize();
-
-                // Handle unknown-size and truncated-in-buffer containers
-                if (size == (uint64_t)-1) {
-                    if (id == 0x18538067 /*Segment*/) size = (uint64_t)(end - p);
-                    else break;
-                } else if (p + size > end) {
-                    // Container body extends past our read buffer — clamp and enter anyway
-                    if (id == 0x18538067 /*Segment*/  || id == 0x1549A966 /*Info*/    ||
-                        id == 0x1654AE6B /*Tracks*/   || id == 0xAE /*TrackEntry*/    ||
-                        id == 0xE0       /*Video*/)
-                        size = (uint64_t)(end - p);
-                    else
-                        break;
-                }
+// ── WebM / MKV (EBML/Matroska) ───────────────────────────────────────────────
+// Flat streaming parse: containers (Segment, Info, Tracks, TrackEntry, Video)
+// are entered by letting the loop continue into their bodies without skipping.
+// Leaf elements (PixelWidth, PixelHeight, DefaultDuration) are read directly.
+static bool SniffEbml(const FileHeaderView& v)
+{
+    static const unsigned char magic[] = { 0x1A, 0x45, 0xDF, 0xA3 };
+    return v.size > 16 && v.StartsWith(magic, sizeof(magic));
+}
 
-                if (id == 0x18538067 || id == 0x1549A966 || id == 0x1654AE6B ||
-                    id == 0xAE        || id == 0xE0) {
-                    // Container: do not skip, let the loop parse the body directly
-                    continue;
-                } else if (id == 0xB0) {           // PixelWidth
-                    meta.width  = (int)readUint(size);
-                } else if (id == 0xBA) {           // PixelHeight
-                    meta.height = (int)readUint(size);
-                } else if (id == 0x23E383) {       // DefaultDuration (nanoseconds)
-                    uint64_t defDur = readUint(size);
-                    if (defDur > 0) meta.fps = 1000000000.0 / (double)defDur;
-                } else {
-                    // Guard: size == 0 means empty element body.
-                    // Without this break, p would not advance → infinite loop.
-                    if (size == 0) break;
-                    p += size;
-                }
+static void ParseEbml(const FileHeaderView& v, CustomMeta& meta)
+{
+    const unsigned char* p   = v.data;
+    const unsigned char* end = v.data + v.size;
+
+    // Reads a variable-length EBML ID (1–4 bytes, leading 1-bit signals length)
+    auto readID = [&]() -> uint32_t {
+        if (p >= end) return 0;
+        uint8_t first = *p;
+        if (first == 0) return 0;
+        int     len  = 1;
+        uint8_t mask = 0x80;
+        while (!(first & mask) && len <= 4) { mask >>= 1; len++; }
+        if (p + len > end) return 0;
+        uint32_t val = 0;
+        for (int i = 0; i < len; ++i) val = (val << 8) | *p++;
+        return val;
+    };
+
+    // Reads a variable-length EBML data size (1–8 bytes).
+    // Returns (uint64_t)-1 for "unknown size" (all data bits set).
+    auto readSize = [&]() -> uint64_t {
+        if (p >= end) return 0;
+        uint8_t first = *p;
+        if (first == 0) return 0;
+        int     len  = 1;
+        uint8_t mask = 0x80;
+        while (!(first & mask) && len <= 8) { mask >>= 1; len++; }
+        if (p + len > end) return 0;
+        uint64_t val         = (*p++) & ~mask;
+        for (int i = 1; i < len; ++i) val = (val << 8) | *p++;
+        uint64_t unknownSize = (1ULL << (7 * len)) - 1;
+        if (val == unknownSize) return (uint64_t)-1;
+        return val;
+    };
+
+    // Reads an unsigned integer from the next `size` bytes (big-endian)
+    auto readUint = [&](uint64_t size) -> uint64_t {
+        if (size > 8 || p + size > end) return 0;
+        uint64_t val = 0;
+        for (uint64_t i = 0; i < size; ++i) val = (val << 8) | *p++;
+        return val;
+    };
+
+    while (p < end) {
+        uint32_t id   = readID();
+        if (id == 0) break;
+        uint64_t size = readSize();
+
+        // Handle unknown-size and truncated-in-buffer containers
+        if (size == (uint64_t)-1) {
+            if (id == 0x18538067 /*Segment*/) size = (uint64_t)(end - p);
+            else break;
+        } else if (size > (uint64_t)(end - p)) {
+            // Container body extends past our read buffer — clamp and enter anyway
+            if (id == 0x18538067 /*Segment*/  || id == 0x1549A966 /*Info*/    ||
+                id == 0x1654AE6B /*Tracks*/   || id == 0xAE /*TrackEntry*/    ||
+                id == 0xE0       /*Video*/)
+                size = (uint64_t)(end - p);
+            else
+                break;
+        }
 
-                if (meta.width > 0 && meta.height > 0 && meta.fps > 0.0) break;
-            }
+        if (id == 0x18538067 || id == 0x1549A966 || id == 0x1654AE6B ||
+            id == 0xAE        || id == 0xE0) {
+            // Container: do not skip, let the loop parse the body directly
+            continue;
+        } else if (id == 0xB0) {           // PixelWidth
+            meta.width  = (int)readUint(size);
+        } else if (id == 0xBA) {           // PixelHeight
+            meta.height = (int)readUint(size);
+        } else if (id == 0x23E383) {       // DefaultDuration (nanoseconds)
+            uint64_t defDur = readUint(size);
+            if (defDur > 0) meta.fps = 1000000000.0 / (double)defDur;
+        } else {
+            // Guard: size == 0 means empty element body.
+            // Without this break, p would not advance → infinite loop.
+            if (size == 0) break;
+            p += size;
         }
+
+        if (meta.width > 0 && meta.height > 0 && meta.fps > 0.0) break;
     }
-    // ── TIFF / TX ─────────────────────────────────────────────────────────────
-    // Supports both Little-Endian (II, magic=42) and Big-Endian (MM, magic=42 BE).
-    else if (ext == L"tx" || ext == L"tif" || ext == L"tiff") {
-        TiffHeader head;
-        if (ReadFile(hFile, &head, sizeof(head), &bytesRead, nullptr)
-            && bytesRead == sizeof(head))
-        {
-            bool isLE = (head.magic == 0x4949 && head.version == 42);
-            bool isBE = (head.magic == 0x4D4D && head.version == 0x2A00);
-
-            if (isLE || isBE) {
-                DWORD ifdOffset = isLE ? head.ifdOffset : _byteswap_ulong(head.ifdOffset);
-                if (SetFilePointer(hFile, ifdOffset, nullptr, FILE_BEGIN)
-                    != INVALID_SET_FILE_POINTER)
-                {
-                    WORD numTagsRaw = 0;
-                    ReadFile(hFile, &numTagsRaw, sizeof(numTagsRaw), &bytesRead, nullptr);
-                    WORD numTags = isLE ? numTagsRaw : _byteswap_ushort(numTagsRaw);
-
-                    int width = 0, height = 0;
-                    for (WORD i = 0; i < numTags && !(width && height); ++i) {
-                        TiffTag tag;
-                        if (!ReadFile(hFile, &tag, sizeof(tag), &bytesRead, nullptr)) break;
-
-                        WORD  tagId   = isLE ? tag.tagId       : _byteswap_ushort(tag.tagId);
-                        WORD  tagType = isLE ? tag.tagType     : _byteswap_ushort(tag.tagType);
-                        DWORD valOff  = isLE ? tag.valueOffset : _byteswap_ulong(tag.valueOffset);
-
-                        if      (tagId == 0x0100) width  = (tagType == 3) ? (int)(valOff & 0xFFFF) : (int)valOff;
-                        else if (tagId == 0x0101) height = (tagType == 3) ? (int)(valOff & 0xFFFF) : (int)valOff;
-                    }
-                    if (width > 0 && height > 0) { meta.width = width; meta.height = height; }
-                }
-            }
-        }
+}
+
+// ── TIFF / TX ─────────────────────────────────────────────────────────────────
+// Supports both Little-Endian (II, magic=42) and Big-Endian (MM, magic=42 BE).
+// The whole IFD is fetched with one read instead of one read per tag.
+static bool SniffTiff(const FileHeaderView& v)
+{
+    return v.StartsWith("II\x2A\x00", 4) || v.StartsWith("MM\x00\x2A", 4);
+}
+
+static void ParseTiff(const FileHeaderView& v, CustomMeta& meta)
+{
+    TiffHeader head;
+    if (!v.ReadAt(0, &head, sizeof(head))) return;
+
+    bool  isLE      = head.magic == 0x4949;
+    DWORD ifdOffset = isLE ? head.ifdOffset : _byteswap_ulong(head.ifdOffset);
+    // The tags follow the count; don't let that DWORD sum wrap to the start of
+    // the file.
+    if (ifdOffset > MAXDWORD - sizeof(WORD)) return;
+
+    WORD numTagsRaw = 0;
+    if (!v.ReadAt(ifdOffset, &numTagsRaw, sizeof(numTagsRaw))) return;
+    WORD numTags = isLE ? numTagsRaw : _byteswap_ushort(numTagsRaw);
+    numTags = std::min<WORD>(numTags, 512);
+    if (numTags == 0) return;
+
+    std::vector<TiffTag> tags(numTags);
+    if (!v.ReadAt(ifdOffset + sizeof(numTagsRaw), tags.data(),
+                  (DWORD)(tags.size() * sizeof(TiffTag))))
+        return;
+
+    int width = 0, height = 0;
+    for (const TiffTag& tag : tags) {
+        WORD  tagId   = isLE ? tag.tagId       : _byteswap_ushort(tag.tagId);
+        WORD  tagType = isLE ? tag.tagType     : _byteswap_ushort(tag.tagType);
+        DWORD valOff  = isLE ? tag.valueOffset : _byteswap_ulong(tag.valueOffset);
+
+        // SHORT values are left-justified in the value field, so in
+        // big-endian files they end up in the high word after the swap.
+        WORD  shortVal = (WORD)(isLE ? (valOff & 0xFFFF) : (valOff >> 16));
+
+        if      (tagId == 0x0100) width  = (tagType == 3) ? (int)shortVal : (int)valOff;
+        else if (tagId == 0x0101) height = (tagType == 3) ? (int)shortVal : (int)valOff;
+        if (width && height) break;
     }
-    // ── SVG ───────────────────────────────────────────────────────────────────
-    // Priority: viewBox (logical canvas size). Fallback: explicit width/height
-    // on the root <svg> tag only.
-    //
-    // ExtractAttribute handles whitespace around '=' and both quote styles,
-    // so `viewBox = "..."`, `width='100px'`, etc. all parse correctly.
-    // Search is anchored inside the opening <svg ... > tag to avoid false
-    // matches on nested elements such as <symbol width=...>.
-    else if (ext == L"svg") {
-        char buf[2048] = {0};
-        if (ReadFile(hFile, buf, sizeof(buf) - 1, &bytesRead, nullptr) && bytesRead > 0) {
-            std::string content(buf, bytesRead);
-
-            // Locate the root <svg tag and its closing '>'
-            size_t svgTagPos = content.find("<svg");
-            if (svgTagPos == std::string::npos) svgTagPos = 0;
-            size_t svgTagEnd = content.find('>', svgTagPos);
-            if (svgTagEnd == std::string::npos) svgTagEnd = content.size();
-
-            // Helper: find attribute NAME inside [svgTagPos, svgTagEnd),
-            // return its value string regardless of whitespace or quote style.
-            // Returns empty string if not found.
-            auto ExtractAttribute = [&](const std::string& attrName) -> std::string {
-                size_t pos = svgTagPos;
-                while (pos < svgTagEnd) {
-                    size_t found = content.find(attrName, pos);
-                    if (found == std::string::npos || found >= svgTagEnd) break;
-                    // Skip whitespace after attribute name
-                    size_t eq = found + attrName.size();
-                    while (eq < svgTagEnd && content[eq] == ' ') ++eq;
-                    if (eq >= svgTagEnd || content[eq] != '=') { pos = found + 1; continue; }
-                    ++eq; // skip '='
-                    while (eq < svgTagEnd && content[eq] == ' ') ++eq;
-                    if (eq >= svgTagEnd) break;
-                    char q = content[eq];
-                    if (q != '"' && q != '\'') { pos = found + 1; continue; }
-                    ++eq; // skip opening quote
-                    size_t qEnd = content.find(q, eq);
-                    if (qEnd == std::string::npos) break;
-                    return content.substr(eq, qEnd - eq);
-                }
-                return "";
-            };
-
-            // 1. viewBox="minX minY width height"
-            std::string vb = ExtractAttribute("viewBox");
-            if (!vb.empty()) {
-                float x, y, w, h;
-                if (sscanf_s(vb.c_str(), "%f %f %f %f", &x, &y, &w, &h) == 4
-                    && w > 0 && h > 0) {
-                    meta.width  = (int)w;
-                    meta.height = (int)h;
-                }
-            }
-            // 2. Fallback: explicit width / height (ignore unit suffixes: px, pt, %)
-            if (meta.width == 0) {
-                std::string ws = ExtractAttribute("width");
-                std::string hs = ExtractAttribute("height");
-                float w = 0, h = 0;
-                if (!ws.empty()) sscanf_s(ws.c_str(), "%f", &w);
-                if (!hs.empty()) sscanf_s(hs.c_str(), "%f", &h);
-                if (w > 0 && h > 0) {
-                    meta.width  = (int)w;
-                    meta.height = (int)h;
-                }
-            }
+    if (width > 0 && height > 0) { meta.width = width; meta.height = height; }
+}
+
+// ── SVG ───────────────────────────────────────────────────────────────────────
+// Priority: viewBox (logical canvas size). Fallback: explicit width/height
+// on the root <svg> tag only.
+//
+// ExtractAttribute handles whitespace around '=' and both quote styles,
+// so `viewBox = "..."`, `width='100px'`, etc. all parse correctly.
+// Search is anchored inside the opening <svg ... > tag to avoid false
+// matches on nested elements such as <symbol width=...>.
+static bool SniffSvg(const FileHeaderView& v)
+{
+    size_t i = 0;
+    if (v.StartsWith("\xEF\xBB\xBF", 3)) i = 3;
+    while (i < v.size && (v.data[i] == ' ' || v.data[i] == '\t' ||
+                          v.data[i] == '\r' || v.data[i] == '\n'))
+        ++i;
+    if (i >= v.size || v.data[i] != '<') return false;
+    std::string_view content((const char*)v.data, v.size);
+    return content.find("<svg") != std::string_view::npos;
+}
+
+static void ParseSvg(const FileHeaderView& v, CustomMeta& meta)
+{
+    std::string content((const char*)v.data, v.size);
+
+    // Locate the root <svg tag and its closing '>'
+    size_t svgTagPos = content.find("<svg");
+    if (svgTagPos == std::string::npos) svgTagPos = 0;
+    size_t svgTagEnd = content.find('>', svgTagPos);
+    if (svgTagEnd == std::string::npos) svgTagEnd = content.size();
+
+    // Helper: find attribute NAME inside [svgTagPos, svgTagEnd),
+    // return its value string regardless of whitespace or quote style.
+    // Returns empty string if not found.
+    auto ExtractAttribute = [&](const std::string& attrName) -> std::string {
+        size_t pos = svgTagPos;
+        while (pos < svgTagEnd) {
+            size_t found = content.find(attrName, pos);
+            if (found == std::string::npos || found >= svgTagEnd) break;
+            // Skip whitespace after attribute name
+            size_t eq = found + attrName.size();
+            while (eq < svgTagEnd && content[eq] == ' ') ++eq;
+            if (eq >= svgTagEnd || content[eq] != '=') { pos = found + 1; continue; }
+            ++eq; // skip '='
+            while (eq < svgTagEnd && content[eq] == ' ') ++eq;
+            if (eq >= svgTagEnd) break;
+            char q = content[eq];
+            if (q != '"' && q != '\'') { pos = found + 1; continue; }
+            ++eq; // skip opening quote
+            size_t qEnd = content.find(q, eq);
+            if (qEnd == std::string::npos) break;
+            return content.substr(eq, qEnd - eq);
         }
-    }
-    // ── HDR (Radiance RGBE) ───────────────────────────────────────────────────
-    // Resolution line format: "-Y <height> +X <width>"
-    else if (ext == L"hdr") {
-        char buf[1024] = {0};
-        if (ReadFile(hFile, buf, sizeof(buf) - 1, &bytesRead, nullptr) && bytesRead > 0) {
-            std::string content(buf, bytesRead);
-            size_t marker = content.find("-Y");
-            if (marker != std::string::npos) {
-                size_t lineEnd = content.find('\n', marker);
-                if (lineEnd != std::string::npos) {
-                    int w = 0, h = 0;
-                    if (sscanf_s(content.substr(marker, lineEnd - marker).c_str(),
-                                 "-Y %d +X %d", &h, &w) == 2) {
-                        meta.width = w; meta.height = h;
-                    }
-                }
-            }
+        return "";
+    };
+
+    // 1. viewBox="minX minY width height"
+    std::string vb = ExtractAttribute("viewBox");
+    if (!vb.empty()) {
+        float x, y, w, h;
+        if (sscanf_s(vb.c_str(), "%f %f %f %f", &x, &y, &w, &h) == 4
+            && w > 0 && h > 0) {
+            meta.width  = (int)w;
+            meta.height = (int)h;
         }
     }
-    // ── EXR (OpenEXR) ─────────────────────────────────────────────────────────
-    // Scans attribute list for "dataWindow" (type box2i: xMin,yMin,xMax,yMax).
-    // Width  = xMax - xMin + 1
-    // Height = yMax - yMin + 1
-    // Uses memcpy to avoid undefined behaviour from unaligned int* cast.
-    else if (ext == L"exr") {
-        unsigned char head[512] = {0};
-        if (ReadFile(hFile, head, sizeof(head), &bytesRead, nullptr) && bytesRead >= 4
-            && head[0] == 0x76 && head[1] == 0x2f && head[2] == 0x31 && head[3] == 0x01)
-        {
-            for (DWORD i = 4; i + 32 < bytesRead; ++i) {
-                if (memcmp(head + i, "dataWindow", 10) == 0) {
-                    size_t off = i + 11; // skip "dataWindow\0"
-                    // Layout: type "box2i\0" (6) + size DWORD (4) + xMin,yMin,xMax,yMax (16)
-                    if (off + 26 <= (size_t)bytesRead
-                        && memcmp(head + off, "box2i", 5) == 0)
-                    {
-                        int box[4];
-                        memcpy(box, head + off + 10, sizeof(box)); // safe unaligned read
-                        int w = box[2] - box[0] + 1;
-                        int h = box[3] - box[1] + 1;
-                        if (w > 0 && h > 0 && w < 65535 && h < 65535) {
-                            meta.width = w; meta.height = h;
-                        }
-                    }
-                    break;
-                }
-            }
+    // 2. Fallback: explicit width / height (ignore unit suffixes: px, pt, %)
+    if (meta.width == 0) {
+        std::string ws = ExtractAttribute("width");
+        std::string hs = ExtractAttribute("height");
+        float w = 0, h = 0;
+        if (!ws.empty()) sscanf_s(ws.c_str(), "%f", &w);
+        if (!hs.empty()) sscanf_s(hs.c_str(), "%f", &h);
+        if (w > 0 && h > 0) {
+            meta.width  = (int)w;
+            meta.height = (int)h;
         }
     }
-    // ── TGA (Truevision TARGA) ────────────────────────────────────────────────
-    // Fixed 18-byte header. Width/height at bytes 12–15 (little-endian WORD each).
-    // Supported image types: 1=CM, 2=RGB, 3=BW (raw) and 9,10,11 (RLE variants).
-    else if (ext == L"tga") {
-        unsigned char hdr[18] = {0};
-        if (ReadFile(hFile, hdr, sizeof(hdr), &bytesRead, nullptr)
-            && bytesRead == sizeof(hdr))
-        {
-            BYTE imgType = hdr[2];
-            if (imgType == 1 || imgType == 2  || imgType == 3  ||
-                imgType == 9 || imgType == 10 || imgType == 11)
+}
+
+// ── HDR (Radiance RGBE) ───────────────────────────────────────────────────────
+// Resolution line format: "-Y <height> +X <width>"
+static bool SniffHdr(const FileHeaderView& v)
+{
+    return v.StartsWith("#?", 2);
+}
+
+static void ParseHdr(const FileHeaderView& v, CustomMeta& meta)
+{
+    std::string_view content((const char*)v.data, v.size);
+    size_t marker = content.find("-Y");
+    if (marker == std::string_view::npos) return;
+    size_t lineEnd = content.find('\n', marker);
+    if (lineEnd == std::string_view::npos) return;
+    std::string line(content.substr(marker, lineEnd - marker));
+    int w = 0, h = 0;
+    if (sscanf_s(line.c_str(), "-Y %d +X %d", &h, &w) == 2) {
+        meta.width = w; meta.height = h;
+    }
+}
+
+// ── EXR (OpenEXR) ─────────────────────────────────────────────────────────────
+// Scans attribute list for "dataWindow" (type box2i: xMin,yMin,xMax,yMax).
+// Width  = xMax - xMin + 1
+// Height = yMax - yMin + 1
+// Uses memcpy to avoid undefined behaviour from unaligned int* cast.
+static bool SniffExr(const FileHeaderView& v)
+{
+    return v.StartsWith("\x76\x2F\x31\x01", 4);
+}
+
+static void ParseExr(const FileHeaderView& v, CustomMeta& meta)
+{
+    const unsigned char* head = v.data;
+    size_t bytesRead = v.size;
+    for (size_t i = 4; i + 32 < bytesRead; ++i) {
+        if (memcmp(head + i, "dataWindow", 10) == 0) {
+            size_t off = i + 11; // skip "dataWindow\0"
+            // Layout: type "box2i\0" (6) + size DWORD (4) + xMin,yMin,xMax,yMax (16)
+            if (off + 26 <= bytesRead
+                && memcmp(head + off, "box2i", 5) == 0)
             {
-                int w = (int)(hdr[12] | (hdr[13] << 8));
-                int h = (int)(hdr[14] | (hdr[15] << 8));
+                int box[4];
+                memcpy(box, head + off + 10, sizeof(box)); // safe unaligned read
+                int w = box[2] - box[0] + 1;
+                int h = box[3] - box[1] + 1;
                 if (w > 0 && h > 0 && w < 65535 && h < 65535) {
                     meta.width = w; meta.height = h;
                 }
             }
+            break;
         }
     }
-    // ── PSD (Adobe Photoshop) ─────────────────────────────────────────────────
-    // Fixed 26-byte header:
-    //   Bytes 0–3:  signature "8BPS"
-    //   Bytes 4–5:  version (1 = PSD, 2 = PSB)
-    //   Bytes 6–11: reserved (must be zero)
-    //   Bytes 12–13: channels (1–56)
-    //   Bytes 14–17: height (rows), big-endian DWORD
-    //   Bytes 18–21: width (columns), big-endian DWORD
-    else if (ext == L"psd" || ext == L"psb") {
-        unsigned char hdr[26] = {0};
-        if (ReadFile(hFile, hdr, sizeof(hdr), &bytesRead, nullptr)
-            && bytesRead == sizeof(hdr)
-            && hdr[0] == '8' && hdr[1] == 'B' && hdr[2] == 'P' && hdr[3] == 'S'
-            && (hdr[4] == 0 && (hdr[5] == 1 || hdr[5] == 2))) // version 1=PSD, 2=PSB
-        {
-            DWORD h = ((DWORD)hdr[14] << 24) | ((DWORD)hdr[15] << 16)
-                    | ((DWORD)hdr[16] <<  8) |  (DWORD)hdr[17];
-            DWORD w = ((DWORD)hdr[18] << 24) | ((DWORD)hdr[19] << 16)
-                    | ((DWORD)hdr[20] <<  8) |  (DWORD)hdr[21];
-            if (w > 0 && h > 0 && w <= 300000 && h <= 300000) {
-                meta.width  = (int)w;
-                meta.height = (int)h;
-            }
+}
+
+// ── PSD (Adobe Photoshop) ─────────────────────────────────────────────────────
+// Fixed 26-byte header:
+//   Bytes 0–3:  signature "8BPS"
+//   Bytes 4–5:  version (1 = PSD, 2 = PSB)
+//   Bytes 6–11: reserved (must be zero)
+//   Bytes 12–13: channels (1–56)
+//   Bytes 14–17: height (rows), big-endian DWORD
+//   Bytes 18–21: width (columns), big-endian DWORD
+static bool SniffPsd(const FileHeaderView& v)
+{
+    return v.size >= 26 && v.StartsWith("8BPS", 4)
+        && v.data[4] == 0 && (v.data[5] == 1 || v.data[5] == 2); // 1=PSD, 2=PSB
+}
+
+static void ParsePsd(const FileHeaderView& v, CustomMeta& meta)
+{
+    const unsigned char* hdr = v.data;
+    DWORD h = ((DWORD)hdr[14] << 24) | ((DWORD)hdr[15] << 16)
+            | ((DWORD)hdr[16] <<  8) |  (DWORD)hdr[17];
+    DWORD w = ((DWORD)hdr[18] << 24) | ((DWORD)hdr[19] << 16)
+            | ((DWORD)hdr[20] <<  8) |  (DWORD)hdr[21];
+    if (w > 0 && h > 0 && w <= 300000 && h <= 300000) {
+        meta.width  = (int)w;
+        meta.height = (int)h;
+    }
+}
+
+// ── TGA (Truevision TARGA) ────────────────────────────────────────────────────
+// Fixed 18-byte header. Width/height at bytes 12–15 (little-endian WORD each).
+// Supported image types: 1=CM, 2=RGB, 3=BW (raw) and 9,10,11 (RLE variants).
+// TGA has no signature, so it is only tried by extension, after all sniffers.
+static void ParseTga(const FileHeaderView& v, CustomMeta& meta)
+{
+    if (v.size < 18) return;
+    const unsigned char* hdr = v.data;
+    BYTE imgType = hdr[2];
+    if (imgType == 1 || imgType == 2  || imgType == 3  ||
+        imgType == 9 || imgType == 10 || imgType == 11)
+    {
+        int w = (int)(hdr[12] | (hdr[13] << 8));
+        int h = (int)(hdr[14] | (hdr[15] << 8));
+        if (w > 0 && h > 0 && w < 65535 && h < 65535) {
+            meta.width = w; meta.height = h;
         }
     }
+}
+
+// ── Parser registry ───────────────────────────────────────────────────────────
+// `extensions` decides which files are worth opening at all; the parser that
+// runs is chosen by magic bytes, so mislabeled files are still parsed by the
+// right parser. Parsers without a sniffer only run for their own extensions.
+struct FormatParser {
+    const wchar_t* const* extensions;
+    bool (*sniff)(const FileHeaderView&);
+    void (*parse)(const FileHeaderView&, CustomMeta&);
+};
+
+static const wchar_t* const kEbmlExts[] = { L"webm", L"mkv", nullptr };
+static const wchar_t* const kTiffExts[] = { L"tx", L"tif", L"tiff", nullptr };
+static const wchar_t* const kSvgExts[]  = { L"svg", nullptr };
+static const wchar_t* const kHdrExts[]  = { L"hdr", nullptr };
+static const wchar_t* const kExrExts[]  = { L"exr", nullptr };
+static const wchar_t* const kPsdExts[]  = { L"psd", L"psb", nullptr };
+static const wchar_t* const kTgaExts[]  = { L"tga", nullptr };
+
+static const FormatParser kFormatParsers[] = {
+    { kEbmlExts, SniffEbml, ParseEbml },
+    { kTiffExts, SniffTiff, ParseTiff },
+    { kPsdExts,  SniffPsd,  ParsePsd  },
+    { kExrExts,  SniffExr,  ParseExr  },
+    { kHdrExts,  SniffHdr,  ParseHdr  },
+    { kSvgExts,  SniffSvg,  ParseSvg  },
+    { kTgaExts,  nullptr,   ParseTga  },
+};
+
+static const FormatParser* FindParserForExtension(const std::wstring& ext)
+{
+    for (const auto& parser : kFormatParsers)
+        for (auto* e = parser.extensions; *e; ++e)
+            if (ext == *e) return &parser;
+    return nullptr;
+}
 
-    CloseHandle(hFile);
+static bool HasCustomFormatParser(const std::wstring& ext)
+{
+    return FindParserForExtension(ext) != nullptr;
+}
+
+static CustomMeta ParseCustomFormatMetadata(const std::wstring& filePath, const std::wstring& ext)
+{
+    CustomMeta meta;
+
+    auto view = std::make_unique<FileHeaderView>();
+    view->hFile = CreateFileW(
+        filePath.c_str(), GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (view->hFile == INVALID_HANDLE_VALUE)
+        return meta;
+
+    DWORD bytesRead = 0;
+    if (ReadFile(view->hFile, view->data, (DWORD)FileHeaderView::kSize, &bytesRead, nullptr)) {
+        view->size = bytesRead;
+
+        const FormatParser* chosen = nullptr;
+        for (const auto& parser : kFormatParsers) {
+            if (parser.sniff && parser.sniff(*view)) { chosen = &parser; break; }
+        }
+        if (!chosen) {
+            const FormatParser* byExt = FindParserForExtension(ext);
+            if (byExt && !byExt->sniff) chosen = byExt;
+        }
+        if (chosen) chosen->parse(*view, meta);
+    }
+
+    CloseHandle(view->hFile);
     return meta;
 }
 
@@ -652,14 +794,56 @@ static std::wstring GetSelectedFilePath()
 // BLOCK 4: Cache helpers
 // ═══════════════════════════════════════════════════════════════════════════════
 
-// Removes the N oldest cache entries (by insertion order).
+static size_t CacheEntryBytes(const MetaCacheEntry& e)
+{
+    return (e.path.size() + e.suffix.size()) * sizeof(WCHAR) + sizeof(MetaCacheEntry);
+}
+
+// Removes the N least recently used cache entries.
 // Must be called with g_cs held.
 static void EvictOldestEntries(size_t n)
 {
-    n = std::min(n, g_cacheOrder.size());
-    for (size_t i = 0; i < n; ++i)
-        g_metaCache.erase(g_cacheOrder[i]);
-    g_cacheOrder.erase(g_cacheOrder.begin(), g_cacheOrder.begin() + (ptrdiff_t)n);
+    while (n-- > 0 && !g_metaCacheList.empty()) {
+        const MetaCacheEntry& e = g_metaCacheList.back();
+        g_metaCacheBytes -= CacheEntryBytes(e);
+        g_metaCache.erase(e.path);
+        g_metaCacheList.pop_back();
+    }
+}
+
+// Looks up `path` and marks it as most recently used.
+// Must be called with g_cs held.
+static bool CacheLookup(const std::wstring& path, std::wstring* suffix)
+{
+    auto it = g_metaCache.find(path);
+    if (it == g_metaCache.end()) return false;
+    g_metaCacheList.splice(g_metaCacheList.begin(), g_metaCacheList, it->second);
+    *suffix = it->second->suffix;
+    return true;
+}
+
+// Inserts a new entry unless another call already did, then trims the cache
+// back into its entry and byte budgets. Must be called with g_cs held.
+static void CacheInsert(const std::wstring& path, const std::wstring& suffix)
+{
+    if (g_metaCache.find(path) != g_metaCache.end()) return;
+
+    if (g_metaCache.size() >= MAX_CACHE_SIZE)
+        EvictOldestEntries(g_cacheEvictCount);
+
+    g_metaCacheList.push_front({ path, suffix });
+    g_metaCache.emplace(g_metaCacheList.front().path, g_metaCacheList.begin());
+    g_metaCacheBytes += CacheEntryBytes(g_metaCacheList.front());
+
+    while (g_metaCacheBytes > MAX_CACHE_BYTES && g_metaCacheList.size() > 1)
+        EvictOldestEntries(1);
+}
+
+static void CacheClear()
+{
+    g_metaCache.clear();
+    g_metaCacheList.clear();
+    g_metaCacheBytes = 0;
 }
 
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -696,11 +880,7 @@ static std::wstring BuildMetadataSuffix(const std::wstring& filePath)
 
     // Run custom parser for formats not covered by the Windows Property System
     CustomMeta customMeta;
-    if (ext == L"webm" || ext == L"mkv"  ||
-        ext == L"tx"   || ext == L"tif"  || ext == L"tiff" ||
-        ext == L"svg"  || ext == L"hdr"  || ext == L"exr"  ||
-        ext == L"tga"  || ext == L"psd"  || ext == L"psb")
-    {
+    if (HasCustomFormatParser(ext)) {
         customMeta = ParseCustomFormatMetadata(filePath, ext);
     }
 
@@ -889,15 +1069,8 @@ HRESULT WINAPI Hook_PSF(REFPROPERTYKEY key, REFPROPVARIANT propvar,
 
     // ── Cache lookup ─────────────────────────────────────────────────────────
     EnterCriticalSection(&g_cs);
-    auto it = g_metaCache.find(path);
-    if (it != g_metaCache.end()) {
-        std::wstring cached = it->second;
-        // LRU: move this entry to the back so it is evicted last
-        auto oit = std::find(g_cacheOrder.begin(), g_cacheOrder.end(), path);
-        if (oit != g_cacheOrder.end()) {
-            g_cacheOrder.erase(oit);
-            g_cacheOrder.push_back(path);
-        }
+    std::wstring cached;
+    if (CacheLookup(path, &cached)) {
         LeaveCriticalSection(&g_cs);
         if (cached.empty()) return hr;
         std::wstring full = std::wstring(*ppszDisplay) + cached;
@@ -909,19 +1082,14 @@ HRESULT WINAPI Hook_PSF(REFPROPERTYKEY key, REFPROPVARIANT propvar,
         return hr;
     }
 
-    // Cache miss — evict if full, then compute
-    if (g_metaCache.size() >= MAX_CACHE_SIZE)
-        EvictOldestEntries(g_cacheEvictCount);
+    // Cache miss — compute outside the lock
     LeaveCriticalSection(&g_cs);
 
     std::wstring suffix = BuildMetadataSuffix(path);
 
     EnterCriticalSection(&g_cs);
-    // Double-check: another call may have inserted the entry while we computed
-    if (g_metaCache.find(path) == g_metaCache.end()) {
-        g_metaCache[path] = suffix;
-        g_cacheOrder.push_back(path);
-    }
+    // Another call may have inserted the entry while we computed
+    CacheInsert(path, suffix);
     LeaveCriticalSection(&g_cs);
 
     if (suffix.empty()) return hr;
@@ -972,8 +1140,7 @@ void Wh_ModSettingsChanged()
     // Clear the cache so settings changes (network/removable drives) take
     // effect immediately without requiring an Explorer restart.
     EnterCriticalSection(&g_cs);
-    g_metaCache.clear();
-    g_cacheOrder.clear();
+    CacheClear();
     LeaveCriticalSection(&g_cs);
 }
 
@@ -981,8 +1148,7 @@ void Wh_ModUninit()
 {
     Wh_Log(L"Wh_ModUninit: unloading");
     EnterCriticalSection(&g_cs);
-    g_metaCache.clear();
-    g_cacheOrder.clear();
+    CacheClear();
     LeaveCriticalSection(&g_cs);
     DeleteCriticalSection(&g_cs);
 }
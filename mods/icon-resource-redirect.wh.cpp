@@ -2,7 +2,7 @@
 // @id              icon-resource-redirect
 // @name            Resource Redirect
 // @description     Define alternative files for loading various resources (e.g. icons in imageres.dll) for simple theming without having to modify system files
-// @version         1.3
+// @version         1.3.1
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -343,7 +343,9 @@ The resource lookup order then becomes:
 #include <shlobj.h>
 #include <winrt/base.h>
 
+#include <algorithm>
 #include <atomic>
+#include <deque>
 #include <filesystem>
 #include <functional>
 #include <mutex>
@@ -352,6 +354,7 @@ The resource lookup order then becomes:
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 using namespace std::string_view_literals;
@@ -380,10 +383,16 @@ std::unordered_map<std::wstring, std::vector<std::wstring>>
     g_redirectionResourcePaths;
 std::unordered_map<std::string, std::vector<std::string>>
     g_redirectionResourcePathsA;
-std::vector<std::pair<std::wstring, std::wstring>>
-    g_redirectionResourcePathPatterns;
-std::vector<std::pair<std::string, std::string>>
-    g_redirectionResourcePathPatternsA;
+// File names for which no redirection is configured, to skip the uppercase
+// conversion and the lookups for modules which aren't themed. The entries are
+// views into the stable storage of `names`.
+struct {
+    std::shared_mutex mutex;
+    std::unordered_set<std::wstring_view> set;
+    std::deque<std::wstring> names;
+} g_unredirectedFileNames;
+
+constexpr size_t kUnredirectedFileNamesMax = 1024;
 
 std::shared_mutex g_redirectionResourceModulesMutex;
 std::unordered_map<std::wstring, HMODULE> g_redirectionResourceModules;
@@ -474,6 +483,195 @@ bool strmatch(const T* pat, size_t plen, const T* str, size_t slen) {
     return slen == 0 && plen == 0;
 }
 
+// A set of wildcard patterns compiled when the settings are loaded. Patterns
+// are indexed by their literal prefix (the part before the first wildcard) in
+// a trie, so that a lookup walks the file name once, and `strmatch` only runs
+// for patterns whose prefix and literal suffix both match.
+template <typename T>
+class PathPatternSet {
+   public:
+    PathPatternSet() = default;
+
+    // Patterns are in priority order.
+    explicit PathPatternSet(
+        std::vector<std::pair<std::basic_string<T>, std::basic_string<T>>>
+            patterns) {
+        m_nodes.push_back({});
+        std::vector<std::vector<Edge>> children(1);
+        std::vector<std::vector<uint32_t>> nodePatterns(1);
+
+        for (auto& [pattern, redirect] : patterns) {
+            Pattern item{};
+            item.prefixLen = pattern.find_first_of(kWildcards);
+            if (item.prefixLen == pattern.npos) {
+                item.prefixLen = pattern.size();
+            }
+
+            size_t lastWildcard = pattern.find_last_of(kWildcards);
+            item.suffixLen = lastWildcard == pattern.npos
+                                 ? 0
+                                 : pattern.size() - lastWildcard - 1;
+
+            for (T ch : pattern) {
+                if (ch != '*') {
+                    item.minLen++;
+                }
+            }
+
+            uint32_t node = 0;
+            for (size_t i = 0; i < item.prefixLen; i++) {
+                T ch = pattern[i];
+                uint32_t next = 0;
+                for (const auto& edge : children[node]) {
+                    if (edge.ch == ch) {
+                        next = edge.next;
+                        break;
+                    }
+                }
+
+                if (!next) {
+                    next = static_cast<uint32_t>(m_nodes.size());
+                    m_nodes.push_back({});
+                    children.emplace_back();
+                    nodePatterns.emplace_back();
+                    children[node].push_back({ch, next});
+                }
+
+                node = next;
+            }
+
+            nodePatterns[node].push_back(
+                static_cast<uint32_t>(m_patterns.size()));
+
+            item.pattern = std::move(pattern);
+            item.redirect = std::move(redirect);
+            m_patterns.push_back(std::move(item));
+        }
+
+        for (size_t i = 0; i < m_nodes.size(); i++) {
+            auto& nodeChildren = children[i];
+            std::sort(
+                nodeChildren.begin(), nodeChildren.end(),
+                [](const Edge& a, const Edge& b) { return a.ch < b.ch; });
+            m_nodes[i].edgesBegin = static_cast<uint32_t>(m_edges.size());
+            m_nodes[i].edgesCount = static_cast<uint32_t>(nodeChildren.size());
+            m_edges.insert(m_edges.end(), nodeChildren.begin(),
+                           nodeChildren.end());
+
+            m_nodes[i].patternsBegin =
+                static_cast<uint32_t>(m_patternIndexes.size());
+            m_nodes[i].patternsCount =
+                static_cast<uint32_t>(nodePatterns[i].size());
+            m_patternIndexes.insert(m_patternIndexes.end(),
+                                    nodePatterns[i].begin(),
+                                    nodePatterns[i].end());
+        }
+    }
+
+    bool empty() const { return m_patterns.empty(); }
+
+    // Returns the redirects of all patterns matching `str`, in priority order.
+    // Doesn't allocate if nothing matches.
+    std::vector<const std::basic_string<T>*> Match(const T* str,
+                                                   size_t len) const {
+        std::vector<uint32_t> matches;
+
+        uint32_t node = 0;
+        size_t depth = 0;
+        while (!m_nodes.empty()) {
+            const Node& n = m_nodes[node];
+            for (uint32_t i = 0; i < n.patternsCount; i++) {
+                uint32_t index = m_patternIndexes[n.patternsBegin + i];
+                if (PatternMatches(m_patterns[index], str, len)) {
+                    matches.push_back(index);
+                }
+            }
+
+            if (depth == len) {
+                break;
+            }
+
+            node = FindChild(n, str[depth]);
+            if (!node) {
+                break;
+            }
+
+            depth++;
+        }
+
+        std::sort(matches.begin(), matches.end());
+
+        std::vector<const std::basic_string<T>*> result;
+        result.reserve(matches.size());
+        for (uint32_t index : matches) {
+            result.push_back(&m_patterns[index].redirect);
+        }
+
+        return result;
+    }
+
+   private:
+    static constexpr T kWildcards[] = {'*', '?', '\0'};
+
+    struct Pattern {
+        std::basic_string<T> pattern;
+        std::basic_string<T> redirect;
+        size_t prefixLen;
+        size_t suffixLen;
+        size_t minLen;
+    };
+
+    struct Node {
+        uint32_t edgesBegin = 0;
+        uint32_t edgesCount = 0;
+        uint32_t patternsBegin = 0;
+        uint32_t patternsCount = 0;
+    };
+
+    struct Edge {
+        T ch;
+        uint32_t next;
+    };
+
+    static bool PatternMatches(const Pattern& item, const T* str, size_t len) {
+        // The prefix was already matched by walking the trie.
+        const auto& pattern = item.pattern;
+        if (len < item.minLen) {
+            return false;
+        }
+
+        if (item.prefixLen == pattern.size()) {
+            return len == pattern.size();
+        }
+
+        if (std::char_traits<T>::compare(
+                pattern.data() + pattern.size() - item.suffixLen,
+                str + len - item.suffixLen, item.suffixLen) != 0) {
+            return false;
+        }
+
+        return strmatch(pattern.data() + item.prefixLen,
+                        pattern.size() - item.prefixLen, str + item.prefixLen,
+                        len - item.prefixLen);
+    }
+
+    uint32_t FindChild(const Node& n, T ch) const {
+        const Edge* begin = m_edges.data() + n.edgesBegin;
+        const Edge* end = begin + n.edgesCount;
+        const Edge* edge = std::lower_bound(
+            begin, end, ch, [](const Edge& a, T b) { return a.ch < b; });
+        return edge != end && edge->ch == ch ? edge->next : 0;
+    }
+
+    std::vector<Pattern> m_patterns;
+    std::vector<Node> m_nodes;
+    std::vector<Edge> m_edges;
+    std::vector<uint32_t> m_patternIndexes;
+};
+
+PathPatternSet<WCHAR> g_redirectionResourcePathPatterns;
+PathPatternSet<char> g_redirectionResourcePathPatternsA;
+
 // chooseAW<char> returns OptionA.
 // chooseAW<WCHAR> returns OptionW.
 template <typename T, auto OptionA, auto OptionW>
@@ -631,6 +829,30 @@ void FreeAndClearRedirectedModules() {
     }
 }
 
+bool IsUnredirectedFileName(std::wstring_view fileName) {
+    std::shared_lock lock{g_unredirectedFileNames.mutex};
+    return g_unredirectedFileNames.set.contains(fileName);
+}
+
+// Must be called while holding the redirection paths lock, so that a stale
+// entry can't be added after the settings were reloaded.
+void AddUnredirectedFileName(std::wstring_view fileName) {
+    std::unique_lock lock{g_unredirectedFileNames.mutex};
+    if (g_unredirectedFileNames.set.size() >= kUnredirectedFileNamesMax) {
+        g_unredirectedFileNames.set.clear();
+        g_unredirectedFileNames.names.clear();
+    }
+
+    g_unredirectedFileNames.names.emplace_back(fileName);
+    g_unredirectedFileNames.set.insert(g_unredirectedFileNames.names.back());
+}
+
+void ClearUnredirectedFileNames() {
+    std::unique_lock lock{g_unredirectedFileNames.mutex};
+    g_unredirectedFileNames.set.clear();
+    g_unredirectedFileNames.names.clear();
+}
+
 template <typename T>
 bool RedirectFileName(DWORD c,
                       const T* fileName,
@@ -641,6 +863,12 @@ bool RedirectFileName(DWORD c,
         return false;
     }
 
+    if constexpr (std::is_same_v<T, WCHAR>) {
+        if (IsUnredirectedFileName(fileName)) {
+            return false;
+        }
+    }
+
     std::basic_string<T> fileNameUpper{fileName};
     (chooseAW<T, LCMapStringA, LCMapStringW>())(
         LOCALE_USER_DEFAULT, LCMAP_UPPERCASE, &fileNameUpper[0],
@@ -675,24 +903,25 @@ bool RedirectFileName(DWORD c,
         const auto& redirectionResourcePathPatterns =
             *(chooseAW<T, &g_redirectionResourcePathPatternsA,
                        &g_redirectionResourcePathPatterns>());
-        for (const auto& [pattern, redirect] :
-             redirectionResourcePathPatterns) {
-            if (!strmatch(pattern.data(), pattern.size(), fileNameUpper.data(),
-                          fileNameUpper.size())) {
-                continue;
-            }
-
+        for (const auto* redirect : redirectionResourcePathPatterns.Match(
+                 fileNameUpper.data(), fileNameUpper.size())) {
             if (!triedRedirection) {
                 beforeFirstRedirectionFunction();
                 triedRedirection = true;
             }
 
-            Wh_Log(L"[%u] Trying %s", c, StrToW(redirect.c_str()).p);
+            Wh_Log(L"[%u] Trying %s", c, StrToW(redirect->c_str()).p);
 
-            if (redirectFunction(redirect.c_str())) {
+            if (redirectFunction(redirect->c_str())) {
                 return true;
             }
         }
+
+        if constexpr (std::is_same_v<T, WCHAR>) {
+            if (!triedRedirection) {
+                AddUnredirectedFileName(fileName);
+            }
+        }
     }
 
     if (triedRedirection) {
@@ -746,16 +975,21 @@ bool RedirectModule(DWORD c,
 
     Wh_Log(L"[%u] Module: %s", c, szFileName);
 
-    LCMapStringEx(LOCALE_NAME_USER_DEFAULT, LCMAP_UPPERCASE, &szFileName[0],
-                  fileNameLen, &szFileName[0], fileNameLen, nullptr, nullptr,
-                  0);
+    if (IsUnredirectedFileName({szFileName, fileNameLen})) {
+        return false;
+    }
+
+    WCHAR szFileNameUpper[MAX_PATH];
+    LCMapStringEx(LOCALE_NAME_USER_DEFAULT, LCMAP_UPPERCASE, szFileName,
+                  fileNameLen + 1, szFileNameUpper, ARRAYSIZE(szFileNameUpper),
+                  nullptr, nullptr, 0);
 
     bool triedRedirection = false;
 
     {
         auto lock{RedirectionResourcePathsMutexSharedLock()};
 
-        if (const auto it = g_redirectionResourcePaths.find(szFileName);
+        if (const auto it = g_redirectionResourcePaths.find(szFileNameUpper);
             it != g_redirectionResourcePaths.end()) {
             const auto& redirects = it->second;
             for (const auto& redirect : redirects) {
@@ -778,21 +1012,16 @@ bool RedirectModule(DWORD c,
             }
         }
 
-        for (const auto& [pattern, redirect] :
-             g_redirectionResourcePathPatterns) {
-            if (!strmatch(pattern.data(), pattern.size(), szFileName,
-                          fileNameLen)) {
-                continue;
-            }
-
+        for (const auto* redirect : g_redirectionResourcePathPatterns.Match(
+                 szFileNameUpper, fileNameLen)) {
             if (!triedRedirection) {
                 beforeFirstRedirectionFunction();
                 triedRedirection = true;
             }
 
-            Wh_Log(L"[%u] Trying %s", c, redirect.c_str());
+            Wh_Log(L"[%u] Trying %s", c, redirect->c_str());
 
-            HINSTANCE hInstanceRedirect = GetRedirectedModule(redirect);
+            HINSTANCE hInstanceRedirect = GetRedirectedModule(*redirect);
             if (!hInstanceRedirect) {
                 Wh_Log(L"[%u] GetRedirectedModule failed", c);
                 continue;
@@ -802,6 +1031,10 @@ bool RedirectModule(DWORD c,
                 return true;
             }
         }
+
+        if (!triedRedirection) {
+            AddUnredirectedFileName({szFileName, fileNameLen});
+        }
     }
 
     if (triedRedirection) {
@@ -2925,11 +3158,15 @@ void LoadSettings() {
     std::reverse(pathPatterns.begin(), pathPatterns.end());
     std::reverse(pathPatternsA.begin(), pathPatternsA.end());
 
+    PathPatternSet<WCHAR> pathPatternSet{std::move(pathPatterns)};
+    PathPatternSet<char> pathPatternSetA{std::move(pathPatternsA)};
+
     std::unique_lock lock{g_redirectionResourcePathsMutex};
     g_redirectionResourcePaths = std::move(paths);
     g_redirectionResourcePathsA = std::move(pathsA);
-    g_redirectionResourcePathPatterns = std::move(pathPatterns);
-    g_redirectionResourcePathPatternsA = std::move(pathPatternsA);
+    g_redirectionResourcePathPatterns = std::move(pathPatternSet);
+    g_redirectionResourcePathPatternsA = std::move(pathPatternSetA);
+    ClearUnredirectedFileNames();
 }
 
 BOOL Wh_ModInit() {
@@ -2,7 +2,7 @@
 // @id              macos-minimize-animation
 // @name            MacOS Minimize Animation
 // @description     Smooth macOS-style genie minimize and restore (open) animations for every window.
-// @version         3.1.4
+// @version         3.2.1
 // @author          Abdullah Masood
 // @github          https://github.com/Abdullah-Masood-05
 // @include         *
@@ -94,7 +94,12 @@ style is the mod's original renderer.
 ## Features
 - **Real genie warp.** The window is rendered as a Direct2D mesh whose vertices
   follow the macOS lamp curve, so the whole frame necks down and funnels into the
-  taskbar icon instead of just shrinking.
+  taskbar icon instead of just shrinking. Since v3.2.0 the mesh's vertex grid
+  is laid out once per animation and each frame only recomputes one curve point
+  per row. Since v3.2.1 the triangle shape every tile is drawn from is also
+  prepared once per animation (as a Direct2D geometry realization on Windows
+  8.1 and later) instead of once per tile and frame. Each animation writes its
+  average and worst frame render time to the mod log.
 - **Actually smooth.** Progress is driven by real elapsed time, and frames are
   paced at twice the display's refresh rate (via a high-resolution timer), so the
   compositor always has a fresh frame ready at each vsync. No system animation
@@ -103,7 +108,9 @@ style is the mod's original renderer.
   bounding box around the window and dock target, which removed a large per-frame
   `UpdateLayeredWindow` cost that made the modern style stutter on AMD GPUs
   (reported on a 6900 XT and a Vega 8 iGPU; the classic style was already using
-  the tight canvas).
+  the tight canvas). Each animation writes one timing line to the Windhawk log
+  (frames, render time, longest gap between frames against the refresh period,
+  and how many frames were late), so a stutter report can say which it was.
 - **Smoothstep easing** instead of a linear ramp, so it eases in and out.
 - **Accurate targeting.** The mod locates the app's actual taskbar button via UI
   Automation and aims the genie at it (with a per-process fallback cache), instead
@@ -227,6 +234,7 @@ Check out the documentation
 #include <windows.h>
 #include <dwmapi.h>
 #include <d2d1.h>
+#include <d2d1_2.h>
 #include <math.h>
 #include <atomic>
 #include <unordered_map>
@@ -514,27 +522,6 @@ static bool MacGenieIsLaunchWindow(HWND hWnd) {
 // genie engine (github.com/Potassiumuncher).
 // -------------------------------------------------------------------------
 
-// Ported from Potassiumuncher's genie engine (github.com/Potassiumuncher).
-static ID2D1PathGeometry* CreateQuadGeo(
-    ID2D1Factory* factory,
-    D2D1_POINT_2F p0, D2D1_POINT_2F p1,
-    D2D1_POINT_2F p2, D2D1_POINT_2F p3)
-{
-    ID2D1PathGeometry* geo = nullptr;
-    factory->CreatePathGeometry(&geo);
-    if (!geo) return nullptr;
-    ID2D1GeometrySink* sink = nullptr;
-    geo->Open(&sink);
-    sink->BeginFigure(p0, D2D1_FIGURE_BEGIN_FILLED);
-    sink->AddLine(p1);
-    sink->AddLine(p2);
-    sink->AddLine(p3);
-    sink->EndFigure(D2D1_FIGURE_END_CLOSED);
-    sink->Close();
-    sink->Release();
-    return geo;
-}
-
 // Ported from Potassiumuncher's genie engine (github.com/Potassiumuncher).
 static D2D1_POINT_2F BloatPoint(D2D1_POINT_2F p, D2D1_POINT_2F c, float amount = 0.5f) {
     float dx = p.x - c.x; float dy = p.y - c.y;
@@ -728,10 +715,35 @@ int GetTaskbarButtonX(HWND hWndApp, int fallbackX, HMONITOR hMon) {
     return targetX;
 }
 
+// The modern engine's mesh: a fixed (xTiles+1) x (yTiles+1) vertex grid laid
+// out once per animation; a frame only moves the vertices.
+struct GenieMesh {
+    int xTiles = 0;
+    int yTiles = 0;
+    std::vector<float> tx;      // column parameters, xTiles + 1
+    std::vector<float> rowY;    // per row, yTiles + 1 (rows stay horizontal)
+    std::vector<float> xs;      // vertex X, (yTiles + 1) * (xTiles + 1), row-major
+    float left = 0.0f, top = 0.0f, right = 0.0f, bottom = 0.0f;   // last frame's bounds
+};
+
+static void InitGenieMesh(GenieMesh& mesh, int xTiles, int yTiles) {
+    mesh.xTiles = xTiles;
+    mesh.yTiles = yTiles;
+    mesh.tx.resize(xTiles + 1);
+    for (int x = 0; x <= xTiles; x++) mesh.tx[x] = (float)x / xTiles;
+    mesh.rowY.resize(yTiles + 1);
+    mesh.xs.resize((size_t)(yTiles + 1) * (xTiles + 1));
+}
+
 // Ported from Potassiumuncher's genie engine (github.com/Potassiumuncher).
-// The macOS "lamp" curve: maps a mesh vertex (tx,ty in 0..1) at progress p to its
-// warped screen position, given the window rect w and the taskbar icon rect i.
-static void CalculateLampVertexMacOS(float tx, float ty, float p, const Geometry& w, const Geometry& i, float *outX, float *outY) {
+// The macOS "lamp" curve: a vertex (tx,ty in 0..1) at progress p, given the
+// window rect w and the taskbar icon rect i. Along a mesh row the curve is
+// affine in tx (y, offsetY and the sinf sway depend on ty alone), so each row
+// is stored as x = x0 + dx * tx at height rowY: one sinf per row instead
+// of per vertex, and the vertex pass is a multiply-add the compiler
+// vectorizes. (originX, originY) is the canvas origin in screen coordinates.
+static void UpdateGenieMesh(GenieMesh& mesh, float p, const Geometry& w, const Geometry& i,
+                            float originX, float originY) {
     float split = 0.3f;
     float k = (p <= split) ? (p / split) : 1.0f;
     float j = (p > split) ? ((p - split) / (1.0f - split)) : 0.0f;
@@ -739,17 +751,115 @@ static void CalculateLampVertexMacOS(float tx, float ty, float p, const Geometry
     float expandHeight = (i.y - w.y - w.height);
     float fullHeight = (i.y - w.y) - (expandHeight * (1.0f - k));
     float height = fullHeight - (j * fullHeight);
+    float offsetY = i.y - w.y - height - (expandHeight * (1.0f - k));
+    float widthDelta = w.width - i.width;
+
+    const int cols = mesh.xTiles + 1;
+    mesh.left = mesh.top = 1e30f;
+    mesh.right = mesh.bottom = -1e30f;
+    for (int r = 0; r <= mesh.yTiles; r++) {
+        float ty = (float)r / mesh.yTiles;
+        float y = ty * height;
+        float offsetX = (i.x - w.x) * (y / (fullHeight + 0.1f)) * k + (i.x - w.x) * j;
+        float sway = sinf(((height - y) / fullHeight) * 2.0f * PI + PI) / 7.0f * k;
+        float x0 = w.x + offsetX + sway * (w.x - i.x) - originX;
+        float dx = i.width + widthDelta * (1.0f - j) * (1.0f - ty) +
+                   widthDelta * (1.0f - k) * ty + sway * widthDelta;
+        float rowY = w.y + y + offsetY - originY;
+        mesh.rowY[r] = rowY;
+
+        float* xs = &mesh.xs[(size_t)r * cols];
+        const float* tx = mesh.tx.data();
+        for (int c = 0; c < cols; c++) xs[c] = x0 + dx * tx[c];
+
+        // A row is a straight segment, so its ends bound it.
+        mesh.left   = fminf(mesh.left,   fminf(x0, x0 + dx));
+        mesh.right  = fmaxf(mesh.right,  fmaxf(x0, x0 + dx));
+        mesh.top    = fminf(mesh.top,    rowY);
+        mesh.bottom = fmaxf(mesh.bottom, rowY);
+    }
+}
 
-    float y = ty * height;
-    float x = tx * (i.width) + tx * (w.width - i.width) * (1.0f - j) * (1.0f - ty) + tx * (w.width - i.width) * (1.0f - k) * ty;
+// Affine map from snapshot pixels to canvas for one mesh triangle: the texel
+// corner (qx, qy) lands on p0, a step of du along x on p1, and dv along y on p2.
+static D2D1::Matrix3x2F GenieTexelToCanvas(D2D1_POINT_2F p0, D2D1_POINT_2F p1, D2D1_POINT_2F p2,
+                                           float qx, float qy, float du, float dv) {
+    float m11 = (p1.x - p0.x) / du;
+    float m12 = (p1.y - p0.y) / du;
+    float m21 = (p2.x - p0.x) / dv;
+    float m22 = (p2.y - p0.y) / dv;
+    return D2D1::Matrix3x2F(m11, m12, m21, m22,
+                            p0.x - qx * m11 - qy * m21,
+                            p0.y - qx * m12 - qy * m22);
+}
 
-    float offsetX = (i.x - w.x) * (y / (fullHeight + 0.1f)) * k + (i.x - w.x) * j;
-    float offsetY = i.y - w.y - height - (expandHeight * (1.0f - k));
+// Per-animation frame timing for both engines, logged once at the end. A frame
+// is late when more than one refresh period passed since the previous present,
+// i.e. the compositor had to show a stale frame at a vsync.
+struct GenieFrameStats {
+    double qpcToMs = 0.0;
+    double refreshMs = 0.0;
+    LONGLONG startQpc = 0;
+    LONGLONG lastPresentQpc = 0;
+    int frames = 0;
+    int late = 0;
+    double renderTotalMs = 0.0;
+    double renderMaxMs = 0.0;
+    double gapMaxMs = 0.0;
+};
 
-    float effectX = sinf(((height - y) / fullHeight) * 2.0f * PI + PI) * (w.x + w.width * tx - (i.x + i.width * tx)) / 7.0f * k;
+static void GenieFrameStatsBegin(GenieFrameStats& stats, const LARGE_INTEGER& qpcFreq,
+                                 const LARGE_INTEGER& qpcStart, double refreshMs) {
+    stats = GenieFrameStats{};
+    stats.qpcToMs = 1000.0 / (double)qpcFreq.QuadPart;
+    stats.refreshMs = refreshMs;
+    stats.startQpc = qpcStart.QuadPart;
+}
+
+static void GenieFrameStatsPresent(GenieFrameStats& stats, LONGLONG frameStartQpc) {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    double renderMs = (double)(now.QuadPart - frameStartQpc) * stats.qpcToMs;
+    stats.renderTotalMs += renderMs;
+    if (renderMs > stats.renderMaxMs) stats.renderMaxMs = renderMs;
+    if (stats.frames > 0) {
+        double gapMs = (double)(now.QuadPart - stats.lastPresentQpc) * stats.qpcToMs;
+        if (gapMs > stats.gapMaxMs) stats.gapMaxMs = gapMs;
+        if (gapMs > stats.refreshMs) stats.late++;
+    }
+    stats.lastPresentQpc = now.QuadPart;
+    stats.frames++;
+}
 
-    *outX = w.x + x + offsetX + effectX;
-    *outY = w.y + y + offsetY;
+static void GenieFrameStatsLog(const GenieFrameStats& stats, const MacGenieAnimData* data,
+                               PCWSTR engine) {
+    if (!stats.frames) return;
+    Wh_Log(L"%s genie %s %dx%d: %d frames in %.0f ms, render avg %.2f / max %.2f ms, "
+           L"longest gap %.2f ms (refresh %.2f ms), %d late",
+           engine, data->isRising ? L"restore" : L"minimize", data->width, data->height,
+           stats.frames, (double)(stats.lastPresentQpc - stats.startQpc) * stats.qpcToMs,
+           stats.renderTotalMs / stats.frames, stats.renderMaxMs, stats.gapMaxMs,
+           stats.refreshMs, stats.late);
+}
+
+// Classic engine scanline copy: canvas pixels whose centres fall inside
+// [leftCanvas, leftCanvas + width) take source column (xC + 0.5 - leftCanvas) /
+// width * W, stepped in 32.32 fixed point rather than recomputed per pixel.
+static void GenieCopySpan(uint32_t* dst, const uint32_t* src, int W, int boundW,
+                          float leftCanvas, float width) {
+    int xStart = (int)ceilf(leftCanvas - 0.5f);
+    int xEnd = (int)ceilf(leftCanvas + width - 0.5f);
+    if (xStart < 0) xStart = 0;
+    if (xEnd > boundW) xEnd = boundW;
+    if (xStart >= xEnd) return;
+    const double scale = (double)W / (double)width;
+    long long pos = (long long)(((double)xStart + 0.5 - (double)leftCanvas) * scale * 4294967296.0);
+    const long long step = (long long)(scale * 4294967296.0);
+    const long long maxPos = ((long long)W << 32) - 1;
+    for (int xC = xStart; xC < xEnd; ++xC, pos += step) {
+        long long at = pos < 0 ? 0 : (pos > maxPos ? maxPos : pos);
+        dst[xC] = src[at >> 32];
+    }
 }
 
 // Shared by both engines: union of the monitors involved (the window's own
@@ -875,7 +985,7 @@ DWORD WINAPI MacGenieAnimThread(LPVOID lpParam) {
     // the dock target. Rendering over the full virtual desktop wasted CPU on
     // every frame - UpdateLayeredWindow of a whole-screen layered window is slow,
     // most visibly on AMD drivers. A ~W/2 pad alone can't bound the mesh's sway
-    // term in CalculateLampVertexMacOS (its amplitude scales with the
+    // term in UpdateGenieMesh (its amplitude scales with the
     // window-to-dock distance, not the window width), so the horizontal pad is
     // the exact sway bound: max(|w.x-i.x|, |w.right-i.right|)/7.
     const int origLeftB = data->targetRect.left;
@@ -970,7 +1080,45 @@ DWORD WINAPI MacGenieAnimThread(LPVOID lpParam) {
     QueryPerformanceFrequency(&qpcFreq);
     QueryPerformanceCounter(&qpcStart);
 
-    std::vector<std::vector<D2D1_POINT_2F>> grid(yTiles + 1, std::vector<D2D1_POINT_2F>(xTiles + 1));
+    // Fixed mesh: the vertex grid is laid out once and a frame only moves the
+    // vertices. A tile is a trapezoid, which no affine map of one shape fits, so
+    // it's drawn as two instances of one unit triangle, (0,0) (1,0) (0,1), each
+    // placed by its own world transform. The triangle is built once here and,
+    // where ID2D1DeviceContext1 is available (Windows 8.1+), realized once as
+    // well, so drawing a tile doesn't tessellate anything. Without it, each fill
+    // of the shared path geometry is tessellated by D2D.
+    GenieMesh mesh;
+    InitGenieMesh(mesh, xTiles, yTiles);
+    ID2D1PathGeometry* unitTriGeo = nullptr;
+    ID2D1DeviceContext1* dc1 = nullptr;
+    ID2D1GeometryRealization* unitTriRealization = nullptr;
+    if (d2dOk) {
+        g_d2dFactory->CreatePathGeometry(&unitTriGeo);
+        if (unitTriGeo) {
+            ID2D1GeometrySink* sink = nullptr;
+            if (SUCCEEDED(unitTriGeo->Open(&sink))) {
+                sink->BeginFigure(D2D1::Point2F(0.0f, 0.0f), D2D1_FIGURE_BEGIN_FILLED);
+                sink->AddLine(D2D1::Point2F(1.0f, 0.0f));
+                sink->AddLine(D2D1::Point2F(0.0f, 1.0f));
+                sink->EndFigure(D2D1_FIGURE_END_CLOSED);
+                sink->Close();
+                sink->Release();
+            }
+        }
+        if (!unitTriGeo) d2dOk = false;
+    }
+    if (d2dOk && SUCCEEDED(rt->QueryInterface(__uuidof(ID2D1DeviceContext1),
+                                              reinterpret_cast<void**>(&dc1)))) {
+        // Realized in the aliased mode the tiles are drawn in (the outline mask
+        // supplies the silhouette AA), so scaling the unit triangle up to a
+        // tile doesn't stretch an antialiasing ramp across it.
+        dc1->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+        dc1->CreateFilledGeometryRealization(unitTriGeo, D2D1_DEFAULT_FLATTENING_TOLERANCE,
+                                             &unitTriRealization);
+    }
+    if (d2dOk && !unitTriRealization) {
+        Wh_Log(L"Geometry realizations unavailable, filling tiles from a path geometry");
+    }
 
     ID2D1PathGeometry* cachedOutlineGeo = nullptr;
     float cachedLeft = -1e9f, cachedRight = -1e9f, cachedTop = -1e9f, cachedBottom = -1e9f;
@@ -997,6 +1145,8 @@ DWORD WINAPI MacGenieAnimThread(LPVOID lpParam) {
         hFrameTimer = CreateWaitableTimerExW(nullptr, nullptr, 0,
                                              TIMER_MODIFY_STATE | SYNCHRONIZE);
     }
+    GenieFrameStats frameStats;
+    GenieFrameStatsBegin(frameStats, qpcFreq, qpcStart, frameIntervalMs * 2.0);
 
     if (d2dOk) {
         for (;;) {
@@ -1016,36 +1166,19 @@ DWORD WINAPI MacGenieAnimThread(LPVOID lpParam) {
             rt->Clear(D2D1::ColorF(0, 0, 0, 0));
             rt->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
 
-            for (int y = 0; y <= yTiles; y++) {
-                for (int x = 0; x <= xTiles; x++) {
-                    float tx = (float)x / xTiles, ty = (float)y / yTiles;
-                    float px, py;
-                    // Warp this mesh vertex. CalculateLampVertexMacOS returns SCREEN
-                    // (virtual-desktop) coordinates - wGeom / iGeom are both
-                    // screen-space (targetRect, targetDockX, taskbar-top Y are all
-                    // virtual-screen). The ONLY conversion to the ghost's
-                    // bounding-box canvas is the (px - vLeft, py - vTop)
-                    // subtraction below - vLeft/vTop are negative on monitors left of
-                    // / above the primary. Every mesh coordinate passes through here
-                    // exactly once; nothing downstream re-offsets.
-                    CalculateLampVertexMacOS(tx, ty, t, wGeom, iGeom, &px, &py);
-                    grid[y][x] = D2D1::Point2F(px - vLeft, py - vTop);
-                }
-            }
+            // Warp the mesh. wGeom / iGeom are screen (virtual-desktop)
+            // coordinates - targetRect, targetDockX and the taskbar-top Y are all
+            // virtual-screen - and the ONLY conversion to the ghost's
+            // bounding-box canvas is the (vLeft, vTop) origin passed here, which
+            // is negative on monitors left of / above the primary. Nothing
+            // downstream re-offsets.
+            UpdateGenieMesh(mesh, t, wGeom, iGeom, (float)vLeft, (float)vTop);
 
             bool degenerate = false;
             ID2D1PathGeometry* outlineGeo = nullptr;
             {
-                float left   = grid[0][0].x, right  = grid[0][0].x;
-                float top    = grid[0][0].y, bottom = grid[0][0].y;
-                for (int gy = 0; gy <= yTiles; gy++) {
-                    for (int gx = 0; gx <= xTiles; gx++) {
-                        left   = fminf(left,   grid[gy][gx].x);
-                        right  = fmaxf(right,  grid[gy][gx].x);
-                        top    = fminf(top,    grid[gy][gx].y);
-                        bottom = fmaxf(bottom, grid[gy][gx].y);
-                    }
-                }
+                float left = mesh.left, right = mesh.right;
+                float top = mesh.top, bottom = mesh.bottom;
 
                 // Belt-and-suspenders guard: if the warped mesh has collapsed to a
                 // near-zero-width/height box, don't present it - that is what would
@@ -1118,12 +1251,19 @@ DWORD WINAPI MacGenieAnimThread(LPVOID lpParam) {
                 // ID2D1Layer create/release on every frame.
                 rt->PushLayer(&layerParams, nullptr);
 
+                const float sw = wGeom.width / xTiles;
+                const float sh = wGeom.height / yTiles;
+                const int cols = xTiles + 1;
                 for (int y = 0; y < yTiles; y++) {
+                    const float* row0 = &mesh.xs[(size_t)y * cols];
+                    const float* row1 = row0 + cols;
+                    const float y0 = mesh.rowY[y], y1 = mesh.rowY[y + 1];
+                    const float sy = ((float)y / yTiles) * wGeom.height;
                     for (int x = 0; x < xTiles; x++) {
-                        D2D1_POINT_2F p1 = grid[y][x];
-                        D2D1_POINT_2F p2 = grid[y][x+1];
-                        D2D1_POINT_2F p3 = grid[y+1][x];
-                        D2D1_POINT_2F p4 = grid[y+1][x+1];
+                        D2D1_POINT_2F p1 = D2D1::Point2F(row0[x], y0);
+                        D2D1_POINT_2F p2 = D2D1::Point2F(row0[x + 1], y0);
+                        D2D1_POINT_2F p3 = D2D1::Point2F(row1[x], y1);
+                        D2D1_POINT_2F p4 = D2D1::Point2F(row1[x + 1], y1);
 
                         D2D1_POINT_2F c = D2D1::Point2F((p1.x+p2.x+p3.x+p4.x)/4.0f, (p1.y+p2.y+p3.y+p4.y)/4.0f);
 
@@ -1134,29 +1274,40 @@ DWORD WINAPI MacGenieAnimThread(LPVOID lpParam) {
                         float bloatAmt = fminf(quadW, quadH) * 0.05f;
                         bloatAmt = fmaxf(0.20f, fminf(0.40f, bloatAmt));
 
-                        ID2D1PathGeometry* quadGeo = CreateQuadGeo(g_d2dFactory,
-                            BloatPoint(p1, c, bloatAmt), BloatPoint(p2, c, bloatAmt),
-                            BloatPoint(p4, c, bloatAmt), BloatPoint(p3, c, bloatAmt));
-
-                        if (quadGeo) {
-                            float sx = ((float)x / xTiles) * wGeom.width;
-                            float sy = ((float)y / yTiles) * wGeom.height;
-                            float sw = wGeom.width / xTiles;
-                            float sh = wGeom.height / yTiles;
-
-                            float m11 = (p2.x - p1.x) / sw;
-                            float m12 = (p2.y - p1.y) / sw;
-                            float m21 = (p3.x - p1.x) / sh;
-                            float m22 = (p3.y - p1.y) / sh;
-                            float m31 = p1.x - sx * m11 - sy * m21;
-                            float m32 = p1.y - sx * m12 - sy * m22;
-
-                            bmpBrush->SetTransform(D2D1::Matrix3x2F(m11, m12, m21, m22, m31, m32));
-                            rt->FillGeometry(quadGeo, bmpBrush);
-                            quadGeo->Release();
+                        const float sx = ((float)x / xTiles) * wGeom.width;
+                        // Upper-left triangle (p1, p2, p3) and lower-right (p4, p3,
+                        // p2), each with its own affine texel mapping. The brush is
+                        // given in the unit triangle's space, so the texel->canvas
+                        // map is composed with the inverse of the triangle's world
+                        // transform; the bloat only moves the edges, not the
+                        // texture.
+                        const D2D1_POINT_2F tri[2][3] = { { p1, p2, p3 }, { p4, p3, p2 } };
+                        const float triQx[2] = { sx, sx + sw };
+                        const float triQy[2] = { sy, sy + sh };
+                        const float triDu[2] = { sw, -sw };
+                        const float triDv[2] = { sh, -sh };
+                        for (int k = 0; k < 2; k++) {
+                            D2D1_POINT_2F b0 = BloatPoint(tri[k][0], c, bloatAmt);
+                            D2D1_POINT_2F b1 = BloatPoint(tri[k][1], c, bloatAmt);
+                            D2D1_POINT_2F b2 = BloatPoint(tri[k][2], c, bloatAmt);
+                            D2D1::Matrix3x2F world(b1.x - b0.x, b1.y - b0.y,
+                                                   b2.x - b0.x, b2.y - b0.y, b0.x, b0.y);
+                            D2D1::Matrix3x2F worldInv = world;
+                            // Collapsed triangle (mesh edge pinched to a point).
+                            if (fabsf(world.Determinant()) < 1e-6f || !worldInv.Invert()) continue;
+                            bmpBrush->SetTransform(
+                                GenieTexelToCanvas(tri[k][0], tri[k][1], tri[k][2],
+                                                   triQx[k], triQy[k], triDu[k], triDv[k]) * worldInv);
+                            rt->SetTransform(world);
+                            if (unitTriRealization) {
+                                dc1->DrawGeometryRealization(unitTriRealization, bmpBrush);
+                            } else {
+                                rt->FillGeometry(unitTriGeo, bmpBrush);
+                            }
                         }
                     }
                 }
+                rt->SetTransform(D2D1::Matrix3x2F::Identity());
                 rt->PopLayer();
             }
             rt->EndDraw();
@@ -1171,6 +1322,7 @@ DWORD WINAPI MacGenieAnimThread(LPVOID lpParam) {
                 POINT ptSrc = { 0, 0 };
                 BLENDFUNCTION bf = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
                 UpdateLayeredWindow(hGhost, hScreenDC, &ptDst, &sz, hMemDC, &ptSrc, 0, &bf, ULW_ALPHA);
+                GenieFrameStatsPresent(frameStats, qpcFrameStart.QuadPart);
 
                 if (firstFrame) {
                     ShowWindow(hGhost, SW_SHOWNOACTIVATE);
@@ -1194,6 +1346,10 @@ DWORD WINAPI MacGenieAnimThread(LPVOID lpParam) {
                 DwmFlush();
                 firstFrame = FALSE;
                 if (data->hFirstFrameShown) SetEvent(data->hFirstFrameShown);
+                // The handoff flush isn't a render stall; don't count it as a gap.
+                LARGE_INTEGER qpcFlushed;
+                QueryPerformanceCounter(&qpcFlushed);
+                frameStats.lastPresentQpc = qpcFlushed.QuadPart;
             }
 
             // Rate-limit to ~2x refresh so we never busy-spin. The deadline is
@@ -1223,6 +1379,10 @@ DWORD WINAPI MacGenieAnimThread(LPVOID lpParam) {
 
     if (hFrameTimer) { CloseHandle(hFrameTimer); hFrameTimer = nullptr; }
     if (cachedOutlineGeo) { cachedOutlineGeo->Release(); cachedOutlineGeo = nullptr; }
+    if (unitTriRealization) { unitTriRealization->Release(); unitTriRealization = nullptr; }
+    if (dc1) { dc1->Release(); dc1 = nullptr; }
+    if (unitTriGeo) { unitTriGeo->Release(); unitTriGeo = nullptr; }
+    GenieFrameStatsLog(frameStats, data, L"Modern");
 
     // -------------------- COMMON TEARDOWN --------------------
     if (data->isRising) {
@@ -1454,7 +1614,17 @@ DWORD WINAPI MacGenieAnimThreadClassic(LPVOID lpParam) {
         return m * m * (3.0f - 2.0f * m);
     };
 
+    // Fixed row grid, laid out once: each source row boundary's rest position
+    // and its morph spread parameter (v, flipped when the dock is above). A
+    // frame only moves the boundaries in yb.
     float* yb = new float[H + 1];
+    float* rowRestY = new float[H + 1];
+    float* rowSpread = new float[H + 1];
+    for (int k = 0; k <= H; ++k) {
+        float v = (float)k / (float)H;
+        rowRestY[k] = (float)origTop + (float)H * v;
+        rowSpread[k] = dockAbove ? (1.0f - v) : v;
+    }
 
     // Time-based progress; frames paced at 2x refresh below (no per-frame
     // DwmFlush, same as the modern engine, so the classic warp hits the same
@@ -1480,6 +1650,9 @@ DWORD WINAPI MacGenieAnimThreadClassic(LPVOID lpParam) {
                                              TIMER_MODIFY_STATE | SYNCHRONIZE);
     }
 
+    GenieFrameStats frameStats;
+    GenieFrameStatsBegin(frameStats, qpcFreq, qpcStart, frameIntervalMs * 2.0);
+
     BOOL firstFrame = TRUE;
     for (;;) {
         QueryPerformanceCounter(&qpcNow);
@@ -1503,10 +1676,8 @@ DWORD WINAPI MacGenieAnimThreadClassic(LPVOID lpParam) {
         // below the window, top-first when it's above), so the spread v is
         // flipped accordingly.
         for (int k = 0; k <= H; ++k) {
-            float v = (float)k / (float)H;
-            float e = morphAt(dockAbove ? (1.0f - v) : v, tt);
-            float idY = (float)origTop + (float)H * v;
-            yb[k] = idY + (dockY - idY) * e;
+            float e = morphAt(rowSpread[k], tt);
+            yb[k] = rowRestY[k] + (dockY - rowRestY[k]) * e;
         }
 
         int kSeg = 0;
@@ -1528,32 +1699,13 @@ DWORD WINAPI MacGenieAnimThreadClassic(LPVOID lpParam) {
             int srcRow = (int)(v * (float)H);
             if (srcRow < 0) srcRow = 0;
             if (srcRow > H - 1) srcRow = H - 1;
-            const BYTE* srcRowPtr = srcBits + (size_t)srcRow * srcStride;
-            BYTE* dstRowPtr = pBits + (size_t)yC * canvasStride;
-
-            int xStart = (int)leftCanvas;
-            int xEnd   = (int)(leftCanvas + width) + 1;
-            if (xStart < 0) xStart = 0;
-            if (xEnd > boundW) xEnd = boundW;
-
-            float invW = 1.0f / width;
-            for (int xC = xStart; xC < xEnd; ++xC) {
-                float u = ((float)xC + 0.5f - leftCanvas) * invW;
-                if (u < 0.0f || u >= 1.0f) continue;
-                int srcX = (int)(u * (float)W);
-                if (srcX < 0) srcX = 0;
-                if (srcX > W - 1) srcX = W - 1;
-                const BYTE* sp = srcRowPtr + (size_t)srcX * 4;
-                BYTE* dp = dstRowPtr + (size_t)xC * 4;
-                // Snapshots carry premultiplied per-pixel alpha since the v1.5
-                // capture fix (translucent regions have a<255); propagate it so
-                // acrylic areas stay see-through in the classic style too. The
-                // constant alpha below still applies the global fade on top.
-                dp[0] = sp[0];
-                dp[1] = sp[1];
-                dp[2] = sp[2];
-                dp[3] = sp[3];
-            }
+            // Snapshots carry premultiplied per-pixel alpha since the v1.5
+            // capture fix (translucent regions have a<255); whole BGRA pixels are
+            // copied so acrylic areas stay see-through in the classic style too.
+            // The constant alpha below still applies the global fade on top.
+            GenieCopySpan((uint32_t*)(pBits + (size_t)yC * canvasStride),
+                          (const uint32_t*)(srcBits + (size_t)srcRow * srcStride),
+                          W, boundW, leftCanvas, width);
         }
 
         POINT ptDst = { boundLeft, boundTop };
@@ -1565,6 +1717,7 @@ DWORD WINAPI MacGenieAnimThreadClassic(LPVOID lpParam) {
         bf.SourceConstantAlpha = (BYTE)(255.0f * fade);
         bf.AlphaFormat = AC_SRC_ALPHA;
         UpdateLayeredWindow(hGhost, hScreenDC, &ptDst, &sz, hCanvasDC, &ptSrc, 0, &bf, ULW_ALPHA);
+        GenieFrameStatsPresent(frameStats, qpcFrameStart.QuadPart);
 
         if (firstFrame) {
             ShowWindow(hGhost, SW_SHOWNOACTIVATE);
@@ -1580,6 +1733,9 @@ DWORD WINAPI MacGenieAnimThreadClassic(LPVOID lpParam) {
             DwmFlush();
             firstFrame = FALSE;
             if (data->hFirstFrameShown) SetEvent(data->hFirstFrameShown);
+            LARGE_INTEGER qpcFlushed;
+            QueryPerformanceCounter(&qpcFlushed);
+            frameStats.lastPresentQpc = qpcFlushed.QuadPart;
         }
 
         // Rate-limit to ~2x refresh so we never busy-spin. The deadline is
@@ -1607,6 +1763,7 @@ DWORD WINAPI MacGenieAnimThreadClassic(LPVOID lpParam) {
     }
 
     if (hFrameTimer) { CloseHandle(hFrameTimer); hFrameTimer = nullptr; }
+    GenieFrameStatsLog(frameStats, data, L"Classic");
 
     // -------------------- COMMON TEARDOWN (identical to the modern engine) -----
     if (data->isRising) {
@@ -1628,6 +1785,8 @@ DWORD WINAPI MacGenieAnimThreadClassic(LPVOID lpParam) {
     }
 
     delete[] yb;
+    delete[] rowRestY;
+    delete[] rowSpread;
     SelectObject(hCanvasDC, hOldCanvas);
     SelectObject(hSrcDibDC, hOldSrcDib);
     SelectObject(hSrcDC, hOldSrc);
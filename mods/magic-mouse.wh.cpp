@@ -2,7 +2,7 @@
 // @id              magic-mouse
 // @name            Magic Mouse
 // @description     Draw custom mouse gestures to trigger actions like launching apps, toggling desktop icons, fullscreen, and more. Record gestures via an on-screen canvas, then replay them with a configurable modifier key.
-// @version         1.0.1
+// @version         1.1.0
 // @author          iMAboud
 // @github          https://github.com/iMAboud
 // @include         windhawk.exe
@@ -97,6 +97,7 @@ You can trigger Gesture Mode simply by shaking (wiggling) your mouse rapidly lef
 * **Armed Timeout (ms)**: How long Gesture Mode stays active after being armed by a Wiggle or Toggle (in milliseconds). Set to `0` to disable the timeout.
 * **Wiggle Strength (10-200)**: How far you must physically move the mouse to register a single wiggle stroke. Lower numbers mean you don't have to shake as far.
 * **Allow in Fullscreen Apps**: If disabled, the mod will automatically ignore gestures while playing fullscreen games or using fullscreen apps to prevent accidental triggers.
+* **Log Hook Latency**: Writes mouse hook timing (p50/p99/max time spent inside the hook, and how long events wait before the mod handles them) to the Windhawk log every 30 seconds and when the mod unloads. Useful when diagnosing cursor lag.
 
 ## Example Setups
 
@@ -207,6 +208,9 @@ You can trigger Gesture Mode simply by shaking (wiggling) your mouse rapidly lef
 - SearchEngineUrl: "https://www.google.com/search?q="
   $name: Search Engine URL
   $description: "URL template for Search Selection. The selected text will be appended. Example: https://duckduckgo.com/?q="
+- LogHookLatency: false
+  $name: Log Hook Latency
+  $description: Periodically writes mouse hook timing statistics (p50/p99/max) to the Windhawk log.
 
 
 - Gestures:
@@ -376,6 +380,11 @@ You can trigger Gesture Mode simply by shaking (wiggling) your mouse rapidly lef
 #define WM_HOOK_STOP_PICKER (WM_APP + 118)
 #define WM_HOOK_MOUSE_PICKER (WM_APP + 119)
 #define WM_HOOK_MOUSE_DRAW (WM_APP + 120)
+#define WM_HOOK_DRAIN (WM_APP + 121)
+// Ring-only events; never posted as window messages.
+#define HOOK_EVT_INPUT (WM_APP + 130)
+#define HOOK_EVT_MOVE (WM_APP + 131)
+#define HOOK_EVT_DRAW_MOVE (WM_APP + 132)
 static const int MAX_HEX_CODE = 512;
 
 static const int MAX_GESTURES = 64;
@@ -491,6 +500,7 @@ struct Settings {
     double matchThreshold;
     int minGestureDistance;
     wchar_t searchEngineUrl[512];
+    bool logHookLatency;
     GestureConfig gestures[MAX_GESTURES];
     int gestureCount;
 };
@@ -545,11 +555,11 @@ static const int FADE_DURATION_MS = 150;
 // Modifier Toggle State
 static std::atomic<BOOL> g_modifierToggleArmed{FALSE};
 static BOOL g_modifierWasActive = FALSE;
-static DWORD g_modifierToggleArmTime = 0;
+static std::atomic<DWORD> g_modifierToggleArmTime{0};
 
 // Wiggle State
 static std::atomic<BOOL> g_wiggleArmed{FALSE};
-static DWORD g_wiggleArmTime = 0;
+static std::atomic<DWORD> g_wiggleArmTime{0};
 static HWND g_auraWnd = nullptr;
 static int g_wiggleCount = 0;
 static DWORD g_lastWiggleTime = 0;
@@ -648,6 +658,9 @@ void DestroyOverlay();
 void UpdateOverlay();
 void UpdateOverlayFade();
 void UpdateParticles();
+void DrainHookEvents();
+void LogHookLatency();
+void ResetHookPipeline();
 void ShowCanvas();
 void HideCanvas();
 void ShowToast(const wchar_t* text, BOOL isSuccess, POINT pt);
@@ -1235,35 +1248,135 @@ bool ParseGestureHex(const wchar_t* hex, PointD* outPts) {
     return true;
 }
 
-double AveragePointDistance(const PointD* pts1, const PointD* pts2) {
+// Gesture templates are decoded from their hex strings once per settings load.
+// Each template also keeps the distance of every point from the centroid,
+// which is unchanged by rotation and gives a cheap lower bound for pruning.
+struct GestureTemplate {
+    bool valid;
+    PointD pts[NUM_RESAMPLE_POINTS];
+    double radii[NUM_RESAMPLE_POINTS];
+};
+
+static GestureTemplate g_gestureTemplates[MAX_GESTURES];
+
+// Drawn gestures may be slightly tilted, so templates are also compared at
+// small rotations. The range is kept narrow so that e.g. "up" and "right"
+// strokes stay distinct.
+#define GESTURE_ROTATION_RANGE (15.0 * 3.14159265358979323846 / 180.0)
+#define GESTURE_ROTATION_PRECISION (2.0 * 3.14159265358979323846 / 180.0)
+#define GOLDEN_RATIO_INV 0.6180339887498949
+
+void ComputeRadii(const PointD* pts, double* radii) {
+    for (int i = 0; i < NUM_RESAMPLE_POINTS; i++) {
+        radii[i] = sqrt(pts[i].x * pts[i].x + pts[i].y * pts[i].y);
+    }
+}
+
+void CompileGestureTemplates() {
+    for (int i = 0; i < g_settings.gestureCount; i++) {
+        GestureTemplate& t = g_gestureTemplates[i];
+        t.valid = g_settings.gestures[i].directionSequence[0] != 0 &&
+                  g_settings.gestures[i].action != ACTION_NONE &&
+                  ParseGestureHex(g_settings.gestures[i].directionSequence, t.pts);
+        if (t.valid) ComputeRadii(t.pts, t.radii);
+    }
+}
+
+// Since |a - b| >= ||a| - |b||, the average difference of the radii is a lower
+// bound of the average point distance at any rotation.
+double RadiiLowerBound(const double* radii1, const double* radii2) {
+    double dist = 0;
+    for (int i = 0; i < NUM_RESAMPLE_POINTS; i++) {
+        dist += fabs(radii1[i] - radii2[i]);
+    }
+    return dist / NUM_RESAMPLE_POINTS;
+}
+
+// Average point distance with the drawn points rotated by `angle` around the
+// centroid. Stops early and returns a value above `abandonAt` as soon as the
+// result can't be below it.
+double AveragePointDistanceAtAngle(const PointD* pts1, const PointD* pts2,
+                                   double angle, double abandonAt) {
+    double c = cos(angle), s = sin(angle);
+    double limit = abandonAt * NUM_RESAMPLE_POINTS;
     double dist = 0;
     for (int i = 0; i < NUM_RESAMPLE_POINTS; i++) {
-        double dx = pts1[i].x - pts2[i].x;
-        double dy = pts1[i].y - pts2[i].y;
+        double x = pts1[i].x * c - pts1[i].y * s;
+        double y = pts1[i].x * s + pts1[i].y * c;
+        double dx = x - pts2[i].x;
+        double dy = y - pts2[i].y;
         dist += sqrt(dx * dx + dy * dy);
+        if (dist > limit) return dist / NUM_RESAMPLE_POINTS;
     }
     return dist / NUM_RESAMPLE_POINTS;
 }
 
-int MatchGesture(const PointD* drawnPts) {
-    int bestIdx = -1;
-    double bestDist = 999999.0;
+// Golden-section search for the rotation with the smallest distance.
+double DistanceAtBestAngle(const PointD* pts1, const PointD* pts2, double abandonAt) {
+    double a = -GESTURE_ROTATION_RANGE, b = GESTURE_ROTATION_RANGE;
+    double x1 = b - GOLDEN_RATIO_INV * (b - a);
+    double x2 = a + GOLDEN_RATIO_INV * (b - a);
+    double f1 = AveragePointDistanceAtAngle(pts1, pts2, x1, abandonAt);
+    double f2 = AveragePointDistanceAtAngle(pts1, pts2, x2, abandonAt);
+    double best = fmin(AveragePointDistanceAtAngle(pts1, pts2, 0, abandonAt), fmin(f1, f2));
+
+    while (b - a > GESTURE_ROTATION_PRECISION) {
+        // Both probes abandoned: this template can't beat the current best.
+        if (f1 > abandonAt && f2 > abandonAt) break;
+        if (f1 < f2) {
+            b = x2; x2 = x1; f2 = f1;
+            x1 = b - GOLDEN_RATIO_INV * (b - a);
+            f1 = AveragePointDistanceAtAngle(pts1, pts2, x1, abandonAt);
+            best = fmin(best, f1);
+        } else {
+            a = x1; x1 = x2; f1 = f2;
+            x2 = a + GOLDEN_RATIO_INV * (b - a);
+            f2 = AveragePointDistanceAtAngle(pts1, pts2, x2, abandonAt);
+            best = fmin(best, f2);
+        }
+    }
+    return best;
+}
+
+struct GestureMatch {
+    int index;
+    double distance;
+    // Distance of the runner-up minus the distance of the match. Small values
+    // mean the gesture was ambiguous.
+    double margin;
+};
+
+GestureMatch MatchGesture(const PointD* drawnPts) {
+    double drawnRadii[NUM_RESAMPLE_POINTS];
+    ComputeRadii(drawnPts, drawnRadii);
+
+    // Only the runner-up's distance is needed for the margin, and it only
+    // matters up to twice the threshold, so anything beyond is abandoned.
     double threshold = g_settings.matchThreshold;
+    double bestDist = threshold * 2;
+    double secondDist = threshold * 2;
+    int bestIdx = -1;
 
     for (int i = 0; i < g_settings.gestureCount; i++) {
-        if (g_settings.gestures[i].directionSequence[0] == 0) continue;
-        if (g_settings.gestures[i].action == ACTION_NONE) continue;
+        const GestureTemplate& t = g_gestureTemplates[i];
+        if (!t.valid) continue;
 
-        PointD templatePts[NUM_RESAMPLE_POINTS];
-        if (!ParseGestureHex(g_settings.gestures[i].directionSequence, templatePts)) continue;
+        if (RadiiLowerBound(drawnRadii, t.radii) >= secondDist) continue;
 
-        double dist = AveragePointDistance(drawnPts, templatePts);
-        if (dist <= threshold && dist < bestDist) {
+        double dist = DistanceAtBestAngle(drawnPts, t.pts, secondDist);
+        if (dist < bestDist) {
+            secondDist = bestDist;
             bestDist = dist;
             bestIdx = i;
+        } else if (dist < secondDist) {
+            secondDist = dist;
         }
     }
-    return bestIdx;
+
+    if (bestIdx < 0 || bestDist > threshold) {
+        return { -1, bestDist, 0 };
+    }
+    return { bestIdx, bestDist, secondDist - bestDist };
 }
 
 void ToggleDesktopIcons() {
@@ -3631,6 +3744,10 @@ void HandleDrawMouseWorker(WPARAM wParam, POINT pt) {
 }
 
 LRESULT CALLBACK MsgWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    if (msg == WM_HOOK_DRAIN) {
+        DrainHookEvents();
+        return 0;
+    }
     if (msg == WM_EXECUTE_ACTION) {
         ExecuteAction(wParam, (HWND)lParam);
         return 0;
@@ -4574,9 +4691,11 @@ void EndGesture() {
     PointD normalizedPts[NUM_RESAMPLE_POINTS];
     NormalizeGesture(g_points, g_pointCount, normalizedPts);
 
-    int match = MatchGesture(normalizedPts);
+    GestureMatch result = MatchGesture(normalizedPts);
+    int match = result.index;
     if (match >= 0) {
-        Wh_Log(L"Matched gesture: %s", g_settings.gestures[match].name);
+        Wh_Log(L"Matched gesture: %s (distance %.1f, margin %.1f)",
+            g_settings.gestures[match].name, result.distance, result.margin);
         HWND target = GetAncestor(g_gestureTarget, GA_ROOT);
         if (!target) target = g_gestureTarget;
         PostMessage(g_msgWnd, WM_EXECUTE_ACTION, match, (LPARAM)target);
@@ -4630,285 +4749,546 @@ void UpdateModifierToggle() {
     BOOL active = IsModifierActive();
     if (active && !g_modifierWasActive && (now - lastToggleTime > 500)) {
         lastToggleTime = now;
-        g_modifierToggleArmed = !g_modifierToggleArmed;
-        if (g_modifierToggleArmed) {
+        // Stamp before arming so the hook never sees the flag with a stale time.
+        BOOL armed = !g_modifierToggleArmed;
+        if (armed) {
             g_modifierToggleArmTime = now;
         }
+        g_modifierToggleArmed = armed;
         if (g_settings.enableWiggle == WIGGLE_NEVER) {
             if (g_modifierToggleArmed) {
                 POINT pt; GetCursorPos(&pt);
                 if (g_settings.showAura) {
-                    if (g_msgWnd) {
-                        PostMessage(g_msgWnd, WM_HOOK_SHOW_AURA, 0, MAKELPARAM(pt.x, pt.y));
-                    }
+                    MsgWndProc(g_msgWnd, WM_HOOK_SHOW_AURA, 0, MAKELPARAM(pt.x, pt.y));
                 }
             } else {
-                if (g_msgWnd) {
-                    PostMessage(g_msgWnd, WM_HOOK_HIDE_AURA, 0, 0);
-                }
+                MsgWndProc(g_msgWnd, WM_HOOK_HIDE_AURA, 0, 0);
             }
         }
     }
     g_modifierWasActive = active;
 }
 
-LRESULT CALLBACK LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam) {
-    if (nCode == HC_ACTION) {
-        UpdateModifierToggle();
-        
-        if (g_settings.armTimeout > 0) {
-            DWORD now = GetTickCount();
-            if (g_wiggleArmed && (now - g_wiggleArmTime > (DWORD)g_settings.armTimeout)) {
-                g_wiggleArmed = FALSE;
-                if (g_msgWnd) PostMessage(g_msgWnd, WM_HOOK_HIDE_AURA, 0, 0);
-            }
-            if (g_settings.modifierBehavior == MOD_BEHAVIOR_TOGGLE && g_modifierToggleArmed) {
-                if (now - g_modifierToggleArmTime > (DWORD)g_settings.armTimeout) {
-                    g_modifierToggleArmed = FALSE;
-                    if (g_msgWnd) PostMessage(g_msgWnd, WM_HOOK_HIDE_AURA, 0, 0);
-                }
-            }
-        }
-        
-        MSLLHOOKSTRUCT* ms = (MSLLHOOKSTRUCT*)lParam;
+// Clears whichever armed state has outlived ArmTimeout. Safe to call from both
+// the hook and the worker: it only ever stores FALSE into the atomics.
+BOOL DisarmExpired() {
+    if (g_settings.armTimeout <= 0) return FALSE;
 
-        if (ms->dwExtraInfo == 0x1337) {
-            return CallNextHookEx(g_mouseHook, nCode, wParam, lParam);
+    BOOL disarmed = FALSE;
+    DWORD now = GetTickCount();
+    if (g_wiggleArmed && (now - g_wiggleArmTime > (DWORD)g_settings.armTimeout)) {
+        g_wiggleArmed = FALSE;
+        disarmed = TRUE;
+    }
+    if (g_settings.modifierBehavior == MOD_BEHAVIOR_TOGGLE && g_modifierToggleArmed) {
+        if (now - g_modifierToggleArmTime > (DWORD)g_settings.armTimeout) {
+            g_modifierToggleArmed = FALSE;
+            disarmed = TRUE;
         }
+    }
+    return disarmed;
+}
 
-        if (g_noteCreationMode) {
-            POINT pt = ms->pt;
-            if (g_msgWnd) {
-                PostMessage(g_msgWnd, WM_HOOK_MOUSE_NOTE, wParam, MAKELPARAM(pt.x, pt.y));
-            }
-            if (wParam == WM_LBUTTONUP) {
-                g_noteCreationMode = FALSE;
-            }
-            if (wParam == WM_MOUSEMOVE) {
-                return CallNextHookEx(g_mouseHook, nCode, wParam, lParam);
-            }
-            return 1;
+// Horizontal shake detector. Returns TRUE on the move that completes the sixth
+// direction reversal of at least wiggleStrength * 3 pixels within 250ms gaps.
+BOOL DetectWiggle(POINT pt, DWORD now) {
+    if (now - g_lastWiggleTime > 250) {
+        g_wiggleCount = 0;
+        g_wiggleSign = 0; // 0 = uninitialized
+    }
+
+    int currentX = pt.x;
+    int requiredDist = g_settings.wiggleStrength * 3;
+
+    if (g_wiggleSign == 0) {
+        if (currentX != g_lastWigglePt.x) {
+            g_wiggleAccum = currentX; // Use accum as extremeX
+            g_wiggleSign = (currentX > g_lastWigglePt.x) ? 1 : -1;
+            g_lastWiggleTime = now;
+        }
+    } else if (g_wiggleSign == 1) { // Moving Right
+        if (currentX > g_wiggleAccum) {
+            g_wiggleAccum = currentX;
+        } else if (currentX < g_wiggleAccum - requiredDist) {
+            g_wiggleCount++;
+            g_wiggleSign = -1;
+            g_wiggleAccum = currentX;
+            g_lastWiggleTime = now;
+        }
+    } else if (g_wiggleSign == -1) { // Moving Left
+        if (currentX < g_wiggleAccum) {
+            g_wiggleAccum = currentX;
+        } else if (currentX > g_wiggleAccum + requiredDist) {
+            g_wiggleCount++;
+            g_wiggleSign = 1;
+            g_wiggleAccum = currentX;
+            g_lastWiggleTime = now;
+        }
+    }
+    g_lastWigglePt = pt;
+
+    if (g_wiggleCount >= 6) {
+        g_wiggleCount = 0;
+        g_wiggleSign = 0;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+// Worker side of an idle mouse move: aura tracking and wiggle arming.
+void HandleIdleMoveWorker(POINT pt) {
+    if (g_settings.enableWiggle == WIGGLE_NEVER) return;
+
+    BOOL modActive = TRUE;
+    if (g_settings.enableWiggle == WIGGLE_MODIFIER) {
+        if (g_settings.modifierFlags == 0) {
+            modActive = FALSE;
+        } else {
+            modActive = (g_settings.modifierBehavior == MOD_BEHAVIOR_TOGGLE) ? (BOOL)g_modifierToggleArmed : IsModifierActive();
         }
+    }
 
-        if (wParam == WM_MOUSEMOVE && !g_gestureActive && !g_pickerActive && !g_drawModeActive) {
-            if (g_settings.enableWiggle != WIGGLE_NEVER) {
-                BOOL modActive = TRUE;
-                if (g_settings.enableWiggle == WIGGLE_MODIFIER) {
-                    if (g_settings.modifierFlags == 0) {
-                        modActive = FALSE;
-                    } else {
-                        modActive = (g_settings.modifierBehavior == MOD_BEHAVIOR_TOGGLE) ? (BOOL)g_modifierToggleArmed : IsModifierActive();
-                    }
-                }
+    if (!modActive) {
+        g_wiggleCount = 0;
+        g_wiggleSign = 0;
+        g_lastWigglePt = pt;
+        return;
+    }
 
-                if (modActive) {
-                    DWORD now = GetTickCount();
-                    if (g_wiggleArmed) {
-                        if (g_msgWnd) PostMessage(g_msgWnd, WM_HOOK_UPDATE_AURA, 0, MAKELPARAM(ms->pt.x, ms->pt.y));
-                    } else {
-                        if (now - g_lastWiggleTime > 250) {
-                            g_wiggleCount = 0;
-                            g_wiggleSign = 0; // 0 = uninitialized
-                        }
-                        
-                        int currentX = ms->pt.x;
-                        int requiredDist = g_settings.wiggleStrength * 3;
-                        
-                        if (g_wiggleSign == 0) {
-                            if (currentX != g_lastWigglePt.x) {
-                                g_wiggleAccum = currentX; // Use accum as extremeX
-                                g_wiggleSign = (currentX > g_lastWigglePt.x) ? 1 : -1;
-                                g_lastWiggleTime = now;
-                            }
-                        } else if (g_wiggleSign == 1) { // Moving Right
-                            if (currentX > g_wiggleAccum) {
-                                g_wiggleAccum = currentX;
-                            } else if (currentX < g_wiggleAccum - requiredDist) {
-                                g_wiggleCount++;
-                                g_wiggleSign = -1;
-                                g_wiggleAccum = currentX;
-                                g_lastWiggleTime = now;
-                            }
-                        } else if (g_wiggleSign == -1) { // Moving Left
-                            if (currentX < g_wiggleAccum) {
-                                g_wiggleAccum = currentX;
-                            } else if (currentX > g_wiggleAccum + requiredDist) {
-                                g_wiggleCount++;
-                                g_wiggleSign = 1;
-                                g_wiggleAccum = currentX;
-                                g_lastWiggleTime = now;
-                            }
-                        }
+    if (g_wiggleArmed) {
+        MsgWndProc(g_msgWnd, WM_HOOK_UPDATE_AURA, 0, MAKELPARAM(pt.x, pt.y));
+        return;
+    }
 
-                        if (g_wiggleCount >= 6) {
-                            if (IsFullscreenAppActive()) {
-                                g_wiggleCount = 0;
-                                g_wiggleSign = 0;
-                            } else {
-                                g_wiggleArmed = TRUE;
-                                g_wiggleArmTime = now;
-                                g_wiggleCount = 0;
-                                g_wiggleSign = 0;
-                                if (g_msgWnd) {
-                                    PostMessage(g_msgWnd, WM_HOOK_SHOW_AURA, 0, MAKELPARAM(ms->pt.x, ms->pt.y));
-                                }
-                            }
-                        }
-                        
-                        g_lastWigglePt = ms->pt;
-                    }
-                } else {
-                    g_wiggleCount = 0;
-                    g_wiggleSign = 0;
-                    g_lastWigglePt = ms->pt;
-                }
-            }
-            return CallNextHookEx(g_mouseHook, nCode, wParam, lParam);
+    DWORD now = GetTickCount();
+    if (DetectWiggle(pt, now) && !IsFullscreenAppActive()) {
+        g_wiggleArmTime = now;
+        g_wiggleArmed = TRUE;
+        MsgWndProc(g_msgWnd, WM_HOOK_SHOW_AURA, 0, MAKELPARAM(pt.x, pt.y));
+    }
+}
+
+BOOL IsOverDrawModeControls(POINT pt) {
+    if (g_drawDrawing) return FALSE;
+
+    if (g_stopwatchWnd && IsWindowVisible(g_stopwatchWnd)) {
+        RECT rcStopwatch;
+        if (GetWindowRect(g_stopwatchWnd, &rcStopwatch) && PtInRect(&rcStopwatch, pt)) {
+            return TRUE;
+        }
+    }
+    if (g_timerWnd && IsWindowVisible(g_timerWnd)) {
+        RECT rcTimer;
+        if (GetWindowRect(g_timerWnd, &rcTimer) && PtInRect(&rcTimer, pt)) {
+            return TRUE;
+        }
+    }
+    if (g_paletteY > -60.0f) {
+        HMONITOR hMonitor = MonitorFromPoint(pt, MONITOR_DEFAULTTONEAREST);
+        MONITORINFO mi = { sizeof(mi) };
+        GetMonitorInfo(hMonitor, &mi);
+        int monitorWidth = mi.rcMonitor.right - mi.rcMonitor.left;
+        int pW = 500;
+        int pH = 50;
+        int px = mi.rcMonitor.left + (monitorWidth - pW) / 2;
+        int py = mi.rcMonitor.top + (int)g_paletteY;
+        RECT paletteRect = { px, py, px + pW, py + pH };
+        if (PtInRect(&paletteRect, pt)) {
+            return TRUE;
         }
+    }
+    return FALSE;
+}
 
-        if (g_gestureActive) {
-            if (wParam == WM_MOUSEMOVE) {
-                if (g_msgWnd) PostMessage(g_msgWnd, WM_HOOK_ADD_GESTURE_POINT, 0, MAKELPARAM(ms->pt.x, ms->pt.y));
-                return CallNextHookEx(g_mouseHook, nCode, wParam, lParam);
-            }
-            if (IsDrawButtonUp(wParam, ms)) {
-                g_gestureActive = FALSE;
-                if (g_msgWnd) PostMessage(g_msgWnd, WM_HOOK_END_GESTURE, 0, MAKELPARAM(ms->pt.x, ms->pt.y));
-                return 1;
-            }
-            if (wParam == WM_LBUTTONDOWN || wParam == WM_LBUTTONUP ||
-                wParam == WM_RBUTTONDOWN || wParam == WM_RBUTTONUP ||
-                wParam == WM_MBUTTONDOWN || wParam == WM_MBUTTONUP ||
-                wParam == WM_XBUTTONDOWN || wParam == WM_XBUTTONUP) {
-                return 1;
-            }
+////////////////////////////////////////////////////////////////////////////////
+// Hook event pipeline
+//
+// The low-level hooks run on a thread Windows will time out (and eventually
+// unhook) if it stalls, so they only decide whether an event is swallowed.
+// Everything else is stamped into a single-producer/single-consumer ring and
+// handled on the worker thread. The worker is woken by one WM_HOOK_DRAIN per
+// batch rather than one posted message per event; because the wake is a window
+// message, the ring keeps draining inside modal loops too.
+
+struct HookEvent {
+    UINT msg;
+    WPARAM wParam;
+    LPARAM lParam;
+    LONGLONG stamp; // QPC ticks at hook entry
+};
+
+#define HOOK_RING_SIZE 4096 // Must be a power of two
+
+static HookEvent g_hookRing[HOOK_RING_SIZE];
+alignas(64) static std::atomic<UINT> g_hookRingHead{0}; // Written by the hook thread
+alignas(64) static std::atomic<UINT> g_hookRingTail{0}; // Written by the worker thread
+alignas(64) static std::atomic<BOOL> g_hookDrainIdle{TRUE};
+static std::atomic<DWORD> g_hookEventsDropped{0};
+static LONGLONG g_hookStamp = 0; // Hook thread only
+static double g_qpcToNs = 0.0;
+
+// 256 linear 250ns buckets cover 0-64us, then 16 doubling buckets up to ~4s.
+#define LATENCY_LINEAR_BUCKETS 256
+#define LATENCY_LINEAR_STEP_NS 250
+#define LATENCY_LOG_BUCKETS 16
+#define LATENCY_BUCKETS (LATENCY_LINEAR_BUCKETS + LATENCY_LOG_BUCKETS)
+
+// One writer per histogram; the logger reads it from the worker thread, so the
+// counters are relaxed atomics and plain load/store on the writer side.
+struct LatencyHistogram {
+    std::atomic<DWORD> buckets[LATENCY_BUCKETS];
+    std::atomic<DWORD> count;
+    std::atomic<DWORD> maxNs;
+};
+
+static LatencyHistogram g_hookLatency;     // Time spent inside LowLevelMouseProc
+static LatencyHistogram g_dispatchLatency; // Hook entry to worker dispatch
+static DWORD g_lastLatencyLog = 0;
+
+void RecordLatency(LatencyHistogram& h, LONGLONG ticks) {
+    ULONGLONG ns = ticks > 0 ? (ULONGLONG)((double)ticks * g_qpcToNs) : 0;
+
+    int bucket;
+    if (ns < (ULONGLONG)LATENCY_LINEAR_BUCKETS * LATENCY_LINEAR_STEP_NS) {
+        bucket = (int)(ns / LATENCY_LINEAR_STEP_NS);
+    } else {
+        bucket = LATENCY_LINEAR_BUCKETS;
+        ULONGLONG edge = (ULONGLONG)LATENCY_LINEAR_BUCKETS * LATENCY_LINEAR_STEP_NS * 2;
+        while (ns >= edge && bucket < LATENCY_BUCKETS - 1) {
+            edge <<= 1;
+            bucket++;
         }
+    }
 
-        BOOL modifierValid = FALSE;
-        if (g_settings.modifierFlags == 0) {
-            modifierValid = TRUE;
+    h.buckets[bucket].store(h.buckets[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    h.count.store(h.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    DWORD clamped = ns > MAXDWORD ? MAXDWORD : (DWORD)ns;
+    if (clamped > h.maxNs.load(std::memory_order_relaxed)) {
+        h.maxNs.store(clamped, std::memory_order_relaxed);
+    }
+}
+
+// Upper edge of the bucket holding the given percentile, capped at the max.
+double LatencyPercentileUs(const LatencyHistogram& h, double percentile) {
+    DWORD counts[LATENCY_BUCKETS];
+    ULONGLONG total = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        counts[i] = h.buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) return 0.0;
+
+    ULONGLONG rank = (ULONGLONG)ceil(percentile * (double)total);
+    if (rank < 1) rank = 1;
+
+    ULONGLONG seen = 0;
+    double edgeNs = 0.0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += counts[i];
+        if (i < LATENCY_LINEAR_BUCKETS) {
+            edgeNs = (double)(i + 1) * LATENCY_LINEAR_STEP_NS;
         } else {
-            modifierValid = (g_settings.modifierBehavior == MOD_BEHAVIOR_TOGGLE) ? (BOOL)g_modifierToggleArmed : IsModifierActive();
+            edgeNs = (double)LATENCY_LINEAR_BUCKETS * LATENCY_LINEAR_STEP_NS * (double)(2ULL << (i - LATENCY_LINEAR_BUCKETS));
         }
+        if (seen >= rank) break;
+    }
+
+    double maxNs = (double)h.maxNs.load(std::memory_order_relaxed);
+    return (edgeNs < maxNs ? edgeNs : maxNs) / 1000.0;
+}
+
+void LogHookLatency() {
+    Wh_Log(L"Mouse hook: %u events, p50 %.2f us, p99 %.2f us, max %.2f us",
+        g_hookLatency.count.load(std::memory_order_relaxed),
+        LatencyPercentileUs(g_hookLatency, 0.50),
+        LatencyPercentileUs(g_hookLatency, 0.99),
+        g_hookLatency.maxNs.load(std::memory_order_relaxed) / 1000.0);
+    Wh_Log(L"Hook to worker: %u events, p50 %.2f us, p99 %.2f us, max %.2f us, %u dropped",
+        g_dispatchLatency.count.load(std::memory_order_relaxed),
+        LatencyPercentileUs(g_dispatchLatency, 0.50),
+        LatencyPercentileUs(g_dispatchLatency, 0.99),
+        g_dispatchLatency.maxNs.load(std::memory_order_relaxed) / 1000.0,
+        g_hookEventsDropped.load(std::memory_order_relaxed));
+}
+
+void ResetHookPipeline() {
+    g_hookRingHead = 0;
+    g_hookRingTail = 0;
+    g_hookDrainIdle = TRUE;
+    g_hookEventsDropped = 0;
+    for (LatencyHistogram* h : { &g_hookLatency, &g_dispatchLatency }) {
+        for (auto& bucket : h->buckets) bucket = 0;
+        h->count = 0;
+        h->maxNs = 0;
+    }
+
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    g_qpcToNs = 1e9 / (double)freq.QuadPart;
+    g_lastLatencyLog = GetTickCount();
+}
+
+BOOL PushHookEvent(UINT msg, WPARAM wParam, LPARAM lParam) {
+    UINT head = g_hookRingHead.load(std::memory_order_relaxed);
+    if (head - g_hookRingTail.load(std::memory_order_acquire) >= HOOK_RING_SIZE) {
+        return FALSE;
+    }
+    g_hookRing[head & (HOOK_RING_SIZE - 1)] = { msg, wParam, lParam, g_hookStamp };
+    // seq_cst pairs with the idle handshake in DrainHookEvents.
+    g_hookRingHead.store(head + 1, std::memory_order_seq_cst);
+    return TRUE;
+}
+
+// Hook-thread replacement for PostMessage(g_msgWnd, ...). If the worker is so
+// far behind that the ring is full, moves are dropped and anything else falls
+// back to a plain posted message.
+void PostHookEvent(UINT msg, WPARAM wParam, LPARAM lParam) {
+    if (!g_msgWnd) return;
 
-        BOOL isReady = FALSE;
-        if (g_settings.enableWiggle == WIGGLE_ALWAYS || g_settings.enableWiggle == WIGGLE_MODIFIER) {
-            isReady = g_wiggleArmed;
+    if (!PushHookEvent(msg, wParam, lParam)) {
+        if (msg == HOOK_EVT_INPUT || msg == HOOK_EVT_MOVE || msg == HOOK_EVT_DRAW_MOVE) {
+            g_hookEventsDropped++;
         } else {
-            isReady = modifierValid;
+            PostMessage(g_msgWnd, msg, wParam, lParam);
         }
+        return;
+    }
 
-        if (!g_recording && IsDrawButtonDown(wParam, ms) && isReady) {
-            BOOL conflict = FALSE;
-            if (g_pickerActive) {
-                BOOL gestureUsesLeftOrRight = (g_settings.drawButton == DRAW_LEFT || g_settings.drawButton == DRAW_RIGHT);
-                if (gestureUsesLeftOrRight && (g_settings.modifierFlags == 0)) {
-                    conflict = TRUE;
-                }
+    if (g_hookDrainIdle.exchange(FALSE)) {
+        if (!PostMessage(g_msgWnd, WM_HOOK_DRAIN, 0, 0)) {
+            g_hookDrainIdle = TRUE;
+        }
+    }
+}
+
+void DispatchHookEvent(const HookEvent& ev) {
+    POINT pt = { (short)LOWORD(ev.lParam), (short)HIWORD(ev.lParam) };
+    switch (ev.msg) {
+        case HOOK_EVT_INPUT:
+            // Only queued so that the batch runs the modifier/timeout checks.
+            break;
+        case HOOK_EVT_MOVE:
+            HandleIdleMoveWorker(pt);
+            break;
+        case HOOK_EVT_DRAW_MOVE:
+            if (!IsOverDrawModeControls(pt)) {
+                HandleDrawMouseWorker(WM_MOUSEMOVE, pt);
             }
-            if (g_drawModeActive) {
-                BOOL gestureUsesLeft = (g_settings.drawButton == DRAW_LEFT);
-                if (gestureUsesLeft && (g_settings.modifierFlags == 0)) {
-                    conflict = TRUE;
-                }
+            break;
+        default:
+            MsgWndProc(g_msgWnd, ev.msg, ev.wParam, ev.lParam);
+            break;
+    }
+}
+
+// Runs on the worker for WM_HOOK_DRAIN. Reentrant: a handler that pumps
+// messages may dispatch a nested drain, so the tail is re-read per event.
+void DrainHookEvents() {
+    UINT batchEnd = g_hookRingTail.load(std::memory_order_relaxed);
+    for (;;) {
+        UINT tail = g_hookRingTail.load(std::memory_order_relaxed);
+        UINT head = g_hookRingHead.load(std::memory_order_acquire);
+        if (tail == head) {
+            // Go idle, then look once more: either we see an event pushed in
+            // the meantime, or its producer sees the idle flag and posts a new
+            // WM_HOOK_DRAIN. If it already claimed the flag, leave it to that.
+            g_hookDrainIdle = TRUE;
+            if (g_hookRingHead.load() == tail || !g_hookDrainIdle.exchange(FALSE)) {
+                break;
             }
+            continue;
+        }
 
-            if (!conflict) {
-                g_wiggleArmed = FALSE;
-                g_modifierToggleArmed = FALSE;
-                g_gestureActive = TRUE;
-                if (g_msgWnd) {
-                    PostMessage(g_msgWnd, WM_HOOK_HIDE_AURA, 0, 0);
-                    PostMessage(g_msgWnd, WM_HOOK_START_GESTURE, 0, MAKELPARAM(ms->pt.x, ms->pt.y));
-                }
-                return 1;
+        if ((int)(tail - batchEnd) >= 0) {
+            batchEnd = head;
+            UpdateModifierToggle();
+            if (DisarmExpired()) {
+                MsgWndProc(g_msgWnd, WM_HOOK_HIDE_AURA, 0, 0);
             }
         }
 
+        HookEvent ev = g_hookRing[tail & (HOOK_RING_SIZE - 1)];
+        g_hookRingTail.store(tail + 1, std::memory_order_release);
+
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        RecordLatency(g_dispatchLatency, now.QuadPart - ev.stamp);
+
+        DispatchHookEvent(ev);
+    }
+
+    if (g_settings.logHookLatency && GetTickCount() - g_lastLatencyLog >= 30000) {
+        g_lastLatencyLog = GetTickCount();
+        LogHookLatency();
+    }
+}
+
+// Returns TRUE to swallow the event.
+BOOL HandleMouseHookEvent(WPARAM wParam, MSLLHOOKSTRUCT* ms) {
+    if (wParam != WM_MOUSEMOVE) {
+        // Button events must see an expired arm before deciding to start a
+        // gesture; moves leave the check to the worker.
+        if (DisarmExpired()) {
+            PostHookEvent(WM_HOOK_HIDE_AURA, 0, 0);
+        }
+        if (g_settings.modifierBehavior == MOD_BEHAVIOR_TOGGLE && g_settings.modifierFlags != 0) {
+            PostHookEvent(HOOK_EVT_INPUT, 0, 0);
+        }
+    }
+
+    if (ms->dwExtraInfo == 0x1337) {
+        return FALSE;
+    }
+
+    if (g_noteCreationMode) {
+        POINT pt = ms->pt;
+        PostHookEvent(WM_HOOK_MOUSE_NOTE, wParam, MAKELPARAM(pt.x, pt.y));
+        if (wParam == WM_LBUTTONUP) {
+            g_noteCreationMode = FALSE;
+        }
+        if (wParam == WM_MOUSEMOVE) {
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    if (wParam == WM_MOUSEMOVE && !g_gestureActive && !g_pickerActive && !g_drawModeActive) {
+        if (g_settings.enableWiggle != WIGGLE_NEVER ||
+            (g_settings.modifierBehavior == MOD_BEHAVIOR_TOGGLE && g_settings.modifierFlags != 0) ||
+            (g_settings.armTimeout > 0 && (g_wiggleArmed || g_modifierToggleArmed))) {
+            PostHookEvent(HOOK_EVT_MOVE, 0, MAKELPARAM(ms->pt.x, ms->pt.y));
+        }
+        return FALSE;
+    }
+
+    if (g_gestureActive) {
+        if (wParam == WM_MOUSEMOVE) {
+            PostHookEvent(WM_HOOK_ADD_GESTURE_POINT, 0, MAKELPARAM(ms->pt.x, ms->pt.y));
+            return FALSE;
+        }
+        if (IsDrawButtonUp(wParam, ms)) {
+            g_gestureActive = FALSE;
+            PostHookEvent(WM_HOOK_END_GESTURE, 0, MAKELPARAM(ms->pt.x, ms->pt.y));
+            return TRUE;
+        }
+        if (wParam == WM_LBUTTONDOWN || wParam == WM_LBUTTONUP ||
+            wParam == WM_RBUTTONDOWN || wParam == WM_RBUTTONUP ||
+            wParam == WM_MBUTTONDOWN || wParam == WM_MBUTTONUP ||
+            wParam == WM_XBUTTONDOWN || wParam == WM_XBUTTONUP) {
+            return TRUE;
+        }
+    }
+
+    BOOL modifierValid = FALSE;
+    if (g_settings.modifierFlags == 0) {
+        modifierValid = TRUE;
+    } else {
+        modifierValid = (g_settings.modifierBehavior == MOD_BEHAVIOR_TOGGLE) ? (BOOL)g_modifierToggleArmed : IsModifierActive();
+    }
+
+    BOOL isReady = FALSE;
+    if (g_settings.enableWiggle == WIGGLE_ALWAYS || g_settings.enableWiggle == WIGGLE_MODIFIER) {
+        isReady = g_wiggleArmed;
+    } else {
+        isReady = modifierValid;
+    }
+
+    if (!g_recording && IsDrawButtonDown(wParam, ms) && isReady) {
+        BOOL conflict = FALSE;
         if (g_pickerActive) {
-            POINT pt = ms->pt;
-            if (wParam == WM_LBUTTONDOWN || wParam == WM_RBUTTONUP) {
-                g_pickerActive = FALSE;
-                if (g_msgWnd) PostMessage(g_msgWnd, WM_HOOK_MOUSE_PICKER, wParam, MAKELPARAM(pt.x, pt.y));
-                return 1;
-            }
-            if (wParam == WM_RBUTTONDOWN) {
-                return 1;
-            }
-            if (wParam == WM_MOUSEMOVE) {
-                if (g_msgWnd) PostMessage(g_msgWnd, WM_HOOK_MOUSE_PICKER, wParam, MAKELPARAM(pt.x, pt.y));
-                return CallNextHookEx(g_mouseHook, nCode, wParam, lParam);
+            BOOL gestureUsesLeftOrRight = (g_settings.drawButton == DRAW_LEFT || g_settings.drawButton == DRAW_RIGHT);
+            if (gestureUsesLeftOrRight && (g_settings.modifierFlags == 0)) {
+                conflict = TRUE;
             }
-            return 1; // Swallow all other mouse inputs during color pick
         }
-
         if (g_drawModeActive) {
-            POINT pt = ms->pt;
-            BOOL overStopwatch = FALSE;
-            if (!g_drawDrawing && g_stopwatchWnd && IsWindowVisible(g_stopwatchWnd)) {
-                RECT rcStopwatch;
-                if (GetWindowRect(g_stopwatchWnd, &rcStopwatch)) {
-                    if (PtInRect(&rcStopwatch, pt)) {
-                        overStopwatch = TRUE;
-                    }
-                }
-            }
-            BOOL overTimer = FALSE;
-            if (!g_drawDrawing && g_timerWnd && IsWindowVisible(g_timerWnd)) {
-                RECT rcTimer;
-                if (GetWindowRect(g_timerWnd, &rcTimer)) {
-                    if (PtInRect(&rcTimer, pt)) {
-                        overTimer = TRUE;
-                    }
-                }
-            }
-            BOOL overPalette = FALSE;
-            if (!g_drawDrawing && g_paletteY > -60.0f) {
-                HMONITOR hMonitor = MonitorFromPoint(pt, MONITOR_DEFAULTTONEAREST);
-                MONITORINFO mi = { sizeof(mi) };
-                GetMonitorInfo(hMonitor, &mi);
-                int monitorWidth = mi.rcMonitor.right - mi.rcMonitor.left;
-                int pW = 500;
-                int pH = 50;
-                int px = mi.rcMonitor.left + (monitorWidth - pW) / 2;
-                int py = mi.rcMonitor.top + (int)g_paletteY;
-                RECT paletteRect = { px, py, px + pW, py + pH };
-                if (PtInRect(&paletteRect, pt)) {
-                    overPalette = TRUE;
-                }
+            BOOL gestureUsesLeft = (g_settings.drawButton == DRAW_LEFT);
+            if (gestureUsesLeft && (g_settings.modifierFlags == 0)) {
+                conflict = TRUE;
             }
-            if (overStopwatch || overTimer || overPalette) {
-                return CallNextHookEx(g_mouseHook, nCode, wParam, lParam);
-            }
-            if (wParam == WM_MOUSEMOVE) {
-                if (g_msgWnd) PostMessage(g_msgWnd, WM_HOOK_MOUSE_DRAW, wParam, MAKELPARAM(pt.x, pt.y));
-                return CallNextHookEx(g_mouseHook, nCode, wParam, lParam);
-            }
-            if (wParam == WM_RBUTTONUP) {
-                g_drawModeActive = FALSE;
-                if (g_msgWnd) PostMessage(g_msgWnd, WM_HOOK_MOUSE_DRAW, wParam, MAKELPARAM(pt.x, pt.y));
-                return 1;
-            }
-            if (wParam == WM_LBUTTONDOWN || wParam == WM_MBUTTONDOWN || 
-                wParam == WM_LBUTTONUP || wParam == WM_MBUTTONUP ||
-                wParam == WM_RBUTTONDOWN) {
-                if (g_msgWnd) PostMessage(g_msgWnd, WM_HOOK_MOUSE_DRAW, wParam, MAKELPARAM(pt.x, pt.y));
-                return 1;
-            }
-            return 1;
         }
 
-        if (wParam == WM_XBUTTONUP) {
-            DWORD btn = HIWORD(ms->mouseData);
-            if (btn == XBUTTON1 || btn == XBUTTON2) {
-                if (g_gestureActive) {
-                    g_gestureActive = FALSE;
-                    if (g_msgWnd) PostMessage(g_msgWnd, WM_HOOK_END_GESTURE, 0, MAKELPARAM(ms->pt.x, ms->pt.y));
-                    return 1;
-                }
+        if (!conflict) {
+            g_wiggleArmed = FALSE;
+            g_modifierToggleArmed = FALSE;
+            g_gestureActive = TRUE;
+            PostHookEvent(WM_HOOK_HIDE_AURA, 0, 0);
+            PostHookEvent(WM_HOOK_START_GESTURE, 0, MAKELPARAM(ms->pt.x, ms->pt.y));
+            return TRUE;
+        }
+    }
+
+    if (g_pickerActive) {
+        POINT pt = ms->pt;
+        if (wParam == WM_LBUTTONDOWN || wParam == WM_RBUTTONUP) {
+            g_pickerActive = FALSE;
+            PostHookEvent(WM_HOOK_MOUSE_PICKER, wParam, MAKELPARAM(pt.x, pt.y));
+            return TRUE;
+        }
+        if (wParam == WM_RBUTTONDOWN) {
+            return TRUE;
+        }
+        if (wParam == WM_MOUSEMOVE) {
+            PostHookEvent(WM_HOOK_MOUSE_PICKER, wParam, MAKELPARAM(pt.x, pt.y));
+            return FALSE;
+        }
+        return TRUE; // Swallow all other mouse inputs during color pick
+    }
+
+    if (g_drawModeActive) {
+        POINT pt = ms->pt;
+        if (wParam == WM_MOUSEMOVE) {
+            // Moves are never swallowed, so the over-controls test can wait
+            // for the worker.
+            PostHookEvent(HOOK_EVT_DRAW_MOVE, wParam, MAKELPARAM(pt.x, pt.y));
+            return FALSE;
+        }
+        if (IsOverDrawModeControls(pt)) {
+            return FALSE;
+        }
+        if (wParam == WM_RBUTTONUP) {
+            g_drawModeActive = FALSE;
+            PostHookEvent(WM_HOOK_MOUSE_DRAW, wParam, MAKELPARAM(pt.x, pt.y));
+            return TRUE;
+        }
+        if (wParam == WM_LBUTTONDOWN || wParam == WM_MBUTTONDOWN || 
+            wParam == WM_LBUTTONUP || wParam == WM_MBUTTONUP ||
+            wParam == WM_RBUTTONDOWN) {
+            PostHookEvent(WM_HOOK_MOUSE_DRAW, wParam, MAKELPARAM(pt.x, pt.y));
+            return TRUE;
+        }
+        return TRUE;
+    }
+
+    if (wParam == WM_XBUTTONUP) {
+        DWORD btn = HIWORD(ms->mouseData);
+        if (btn == XBUTTON1 || btn == XBUTTON2) {
+            if (g_gestureActive) {
+                g_gestureActive = FALSE;
+                PostHookEvent(WM_HOOK_END_GESTURE, 0, MAKELPARAM(ms->pt.x, ms->pt.y));
+                return TRUE;
             }
         }
     }
+    return FALSE;
+}
+
+LRESULT CALLBACK LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam) {
+    if (nCode == HC_ACTION) {
+        LARGE_INTEGER start;
+        QueryPerformanceCounter(&start);
+        g_hookStamp = start.QuadPart;
+
+        BOOL swallow = HandleMouseHookEvent(wParam, (MSLLHOOKSTRUCT*)lParam);
+
+        LARGE_INTEGER end;
+        QueryPerformanceCounter(&end);
+        RecordLatency(g_hookLatency, end.QuadPart - start.QuadPart);
+
+        if (swallow) {
+            return 1;
+        }
+    }
     return CallNextHookEx(g_mouseHook, nCode, wParam, lParam);
 }
 
@@ -5464,7 +5844,13 @@ LRESULT CALLBACK ColorPickerProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPar
 
 LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
     if (nCode == HC_ACTION && (wParam == WM_KEYDOWN || wParam == WM_KEYUP || wParam == WM_SYSKEYDOWN || wParam == WM_SYSKEYUP)) {
-        UpdateModifierToggle();
+        LARGE_INTEGER stamp;
+        QueryPerformanceCounter(&stamp);
+        g_hookStamp = stamp.QuadPart;
+
+        if (g_settings.modifierBehavior == MOD_BEHAVIOR_TOGGLE && g_settings.modifierFlags != 0) {
+            PostHookEvent(HOOK_EVT_INPUT, 0, 0);
+        }
 
         if (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN) {
             KBDLLHOOKSTRUCT* kb = (KBDLLHOOKSTRUCT*)lParam;
@@ -5476,9 +5862,7 @@ LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
         if (g_timerEditMode) {
             if (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN) {
                 KBDLLHOOKSTRUCT* kb = (KBDLLHOOKSTRUCT*)lParam;
-                if (g_msgWnd) {
-                    PostMessage(g_msgWnd, WM_HOOK_KEY_TIMER_EDIT, kb->vkCode, 0);
-                }
+                PostHookEvent(WM_HOOK_KEY_TIMER_EDIT, kb->vkCode, 0);
             }
             return 1;
         }
@@ -5487,21 +5871,19 @@ LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
             KBDLLHOOKSTRUCT* kb = (KBDLLHOOKSTRUCT*)lParam;
 
             if (g_flashWnd && IsWindowVisible(g_flashWnd)) {
-                if (g_msgWnd) {
-                    PostMessage(g_msgWnd, WM_HOOK_TOGGLE_FLASH, 0, 0);
-                }
+                PostHookEvent(WM_HOOK_TOGGLE_FLASH, 0, 0);
                 return 1;
             }
 
             if (kb->vkCode == VK_ESCAPE) {
                 if (g_pickerActive) {
                     g_pickerActive = FALSE;
-                    if (g_msgWnd) PostMessage(g_msgWnd, WM_HOOK_STOP_PICKER, 0, 0);
+                    PostHookEvent(WM_HOOK_STOP_PICKER, 0, 0);
                     return 1;
                 }
                 if (g_drawModeActive) {
                     g_drawModeActive = FALSE;
-                    if (g_msgWnd) PostMessage(g_msgWnd, WM_HOOK_TOGGLE_DRAW, 0, 0);
+                    PostHookEvent(WM_HOOK_TOGGLE_DRAW, 0, 0);
                     return 1;
                 }
             }
@@ -5516,7 +5898,7 @@ LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
                     modOk = modOk && (GetAsyncKeyState(VK_MENU) & 0x8000);
 
                 if (modOk) {
-                    if (g_msgWnd) PostMessage(g_msgWnd, WM_HOOK_RECORD_CANVAS, 0, 0);
+                    PostHookEvent(WM_HOOK_RECORD_CANVAS, 0, 0);
                     return 1;
                 }
             }
@@ -5799,6 +6181,10 @@ DWORD WINAPI WorkerThreadProc(LPVOID lpParam) {
         DispatchMessage(&msg);
     }
 
+    if (g_settings.logHookLatency) {
+        LogHookLatency();
+    }
+
     if (g_msgWnd) {
         DestroyWindow(g_msgWnd);
         g_msgWnd = nullptr;
@@ -5905,6 +6291,7 @@ void LoadSettings() {
     if (g_settings.armTimeout < 0) g_settings.armTimeout = 0;
 
     g_settings.showAura = Wh_GetIntSetting(L"ShowAura");
+    g_settings.logHookLatency = Wh_GetIntSetting(L"LogHookLatency");
 
     PCWSTR modBehaviorStr = Wh_GetStringSetting(L"ModifierBehavior");
     if (modBehaviorStr && wcscmp(modBehaviorStr, L"toggle") == 0) {
@@ -6003,6 +6390,8 @@ void LoadSettings() {
         g_settings.gestureCount++;
     }
 
+    CompileGestureTemplates();
+
     Wh_Log(L"Settings loaded: %d gestures, modifier=0x%x",
         g_settings.gestureCount, g_settings.modifierFlags);
 }
@@ -6016,6 +6405,7 @@ BOOL WhTool_ModInit() {
     LaunchNotesProcess();
 
     g_running.store(true);
+    ResetHookPipeline();
 
     g_workerThread = CreateThread(NULL, 0, WorkerThreadProc, NULL, 0, &g_workerThreadId);
     if (!g_workerThread) {
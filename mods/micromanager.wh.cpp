@@ -2,7 +2,7 @@
 // @id              micromanager
 // @name            MicroManager
 // @description     Mini task manager tray icon showing CPU, GPU and RAM usage with top consumers.
-// @version         1.1.0
+// @version         1.2.1
 // @author          BlackPaw
 // @github          https://github.com/BlackPaw21
 // @donateUrl       https://ko-fi.com/blackpaw21
@@ -32,9 +32,15 @@ and RAM usage, plus the single top-consuming process for each.
 ## Configuration
 
 Right-click the tray icon to change the refresh rate (0.3s / 0.5s / 1s / 3s).
+The chosen rate applies while the popup is open; while it's closed, the tooltip
+refreshes every 3 seconds at most.
 
 ## Changelog
 
+# 1.2.0
+- **Improved:** While the popup is closed, stats refresh every 3 seconds at most and skip the per-process work; opening the popup refreshes immediately at the chosen rate.
+- **Improved:** Processes are tracked in a persistent table updated in place, and query buffers are reused, making each refresh much cheaper on systems with many processes.
+
 # 1.1.0
 - **Fixed:** Tooltip now displays correctly when hovering the tray icon.
 - **Fixed:** Ghost window prevention — popup no longer flickers on rapid open/close.
@@ -91,8 +97,15 @@ Right-click the tray icon to change the refresh rate (0.3s / 0.5s / 1s / 3s).
 #define POPUP_HEIGHT        112
 #define POPUP_ROWS          3
 
-#define MAX_PROCESSES       1024
+#define MAX_PROCESSES       2048
 #define PROCESS_BUF_SIZE    (512 * 1024)
+// Open-addressing table for per-process state. A power of two at least twice
+// MAX_PROCESSES keeps linear probe runs short.
+#define PROC_TABLE_SIZE     (MAX_PROCESSES * 2)
+
+// While only the tray tooltip is visible, refresh at most this often and skip
+// the per-process work that only the popup shows.
+#define HEARTBEAT_MS        3000
 
 // Re-attempt GPU (PDH) initialization roughly every this many ticks if it fails,
 // instead of disabling GPU stats permanently for the session.
@@ -195,6 +208,12 @@ static int                 g_gpuRetryIn   = 0;     // ticks until next init atte
 // Cached NtQuerySystemInformation pointer (resolved once)
 static NtQuerySystemInformation_t g_ntQuery = nullptr;
 
+// Reused query buffers (tray thread only), grown geometrically on demand
+static BYTE*               g_procBuf      = nullptr;
+static ULONG               g_procBufSize  = 0;
+static PDH_FMT_COUNTERVALUE_ITEM_W* g_gpuItems = nullptr;
+static DWORD               g_gpuItemsSize = 0;
+
 // Per-PID GPU aggregation scratch (tray thread only — hoisted off the stack)
 struct GpuProc { DWORD pid; double total; };
 static GpuProc             g_gpuProcs[MAX_PROCESSES];
@@ -203,14 +222,28 @@ static GpuProc             g_gpuProcs[MAX_PROCESSES];
 static FILETIME            g_prevIdle     = {};
 static FILETIME            g_prevKernel   = {};
 static FILETIME            g_prevUser     = {};
-static struct {
-    DWORD  pid;
-    LONGLONG time;
-    WCHAR  name[64];
-} g_prevProcs[MAX_PROCESSES], g_curProcs[MAX_PROCESSES];
-static int                 g_prevProcCount = 0;
 static BOOL                g_hasPrevSample = FALSE;
 
+// Per-process state, keyed by PID and updated in place on every process walk.
+// PID 0 (the idle process) is never stored, so it marks an empty slot.
+struct ProcEntry {
+    DWORD    pid;
+    DWORD    generation;  // walk that last saw the process
+    LONGLONG createTime;  // tells a reused PID apart from the old process
+    LONGLONG time;        // kernel + user time at that walk
+    WCHAR    name[64];
+};
+static ProcEntry           g_procTable[PROC_TABLE_SIZE];
+static int                 g_procCount      = 0;
+static DWORD               g_procGeneration = 0;
+// System CPU time (kernel + user) at the last walk, which isn't necessarily
+// the previous tick — walks are skipped while the popup is hidden.
+static ULONGLONG           g_walkPrevTotal  = 0;
+static BOOL                g_hasWalkBaseline = FALSE;
+
+// Whether the popup is open and the timer runs at the user's refresh rate
+static BOOL                g_fastRefresh  = FALSE;
+
 static HICON               g_iconEnabled  = nullptr;
 static HFONT               g_hPopupFont   = nullptr;
 static int                 g_fontDpi      = 0;
@@ -245,31 +278,153 @@ static NtQuerySystemInformation_t GetNtQuery() {
     return g_ntQuery;
 }
 
-static int CollectProcessInfo(MY_SYSTEM_PROCESS_INFO** outBuf) {
+// Fills the reused process buffer, growing it geometrically (and at least to
+// the size the kernel asked for) until the snapshot fits.
+static MY_SYSTEM_PROCESS_INFO* CollectProcessInfo() {
     NtQuerySystemInformation_t NtQuery = GetNtQuery();
-    if (!NtQuery) return 0;
-
-    *outBuf = nullptr;
+    if (!NtQuery) return nullptr;
 
     for (int retry = 0; retry < 5; retry++) {
-        ULONG bufSize = PROCESS_BUF_SIZE * (retry + 2);
-        MY_SYSTEM_PROCESS_INFO* newBuf = (MY_SYSTEM_PROCESS_INFO*)realloc(*outBuf, bufSize);
-        if (!newBuf) { free(*outBuf); *outBuf = nullptr; return 0; }
-        *outBuf = newBuf;
-        NTSTATUS status = NtQuery(SystemProcessInformation, *outBuf, bufSize, nullptr);
+        if (!g_procBuf) {
+            ULONG size = g_procBufSize ? g_procBufSize : PROCESS_BUF_SIZE;
+            g_procBuf = (BYTE*)malloc(size);
+            if (!g_procBuf) { g_procBufSize = 0; return nullptr; }
+            g_procBufSize = size;
+        }
+
+        ULONG needed = 0;
+        NTSTATUS status = NtQuery(SystemProcessInformation, g_procBuf, g_procBufSize, &needed);
         if (status != STATUS_INFO_LENGTH_MISMATCH) {
-            if (status < 0) {
-                free(*outBuf);
-                *outBuf = nullptr;
-                return 0;
-            }
-            return 1;
+            return status < 0 ? nullptr : (MY_SYSTEM_PROCESS_INFO*)g_procBuf;
         }
+
+        // Processes may start between the calls, so leave headroom.
+        ULONG newSize = g_procBufSize * 2;
+        if (newSize < needed + needed / 4) newSize = needed + needed / 4;
+        free(g_procBuf);
+        g_procBuf = nullptr;
+        g_procBufSize = newSize;
     }
     // All 5 attempts failed with STATUS_INFO_LENGTH_MISMATCH
-    free(*outBuf);
-    *outBuf = nullptr;
-    return 0;
+    return nullptr;
+}
+
+// ─── Process Table ────────────────────────────────────────────────────────────
+
+static inline DWORD ProcHash(DWORD pid) {
+    // PIDs are multiples of 4; drop those bits and mix the rest.
+    return ((pid >> 2) * 2654435761u) & (PROC_TABLE_SIZE - 1);
+}
+
+static ProcEntry* ProcTableFind(DWORD pid) {
+    for (DWORD i = ProcHash(pid); g_procTable[i].pid; i = (i + 1) & (PROC_TABLE_SIZE - 1)) {
+        if (g_procTable[i].pid == pid) return &g_procTable[i];
+    }
+    return nullptr;
+}
+
+// Returns the entry for the PID, claiming an empty slot if it isn't tracked
+// yet (the caller fills it in). Null once MAX_PROCESSES are tracked.
+static ProcEntry* ProcTableFindOrAdd(DWORD pid, BOOL* added) {
+    DWORD i = ProcHash(pid);
+    for (; g_procTable[i].pid; i = (i + 1) & (PROC_TABLE_SIZE - 1)) {
+        if (g_procTable[i].pid == pid) { *added = FALSE; return &g_procTable[i]; }
+    }
+    if (g_procCount >= MAX_PROCESSES) return nullptr;
+    g_procCount++;
+    g_procTable[i].pid = pid;
+    *added = TRUE;
+    return &g_procTable[i];
+}
+
+// Drops processes the last walk didn't see. Uses backward-shift deletion, so
+// no tombstones build up and lookups never need a rebuild.
+static void ProcTableSweep(DWORD generation) {
+    for (DWORD i = 0; i < PROC_TABLE_SIZE; i++) {
+        while (g_procTable[i].pid && g_procTable[i].generation != generation) {
+            DWORD hole = i;
+            for (DWORD j = (hole + 1) & (PROC_TABLE_SIZE - 1); g_procTable[j].pid;
+                 j = (j + 1) & (PROC_TABLE_SIZE - 1)) {
+                // Move the entry back unless its home slot lies cyclically
+                // in (hole, j], where it would become unreachable.
+                DWORD home = ProcHash(g_procTable[j].pid);
+                BOOL homeInRange = hole <= j ? (home > hole && home <= j)
+                                             : (home > hole || home <= j);
+                if (!homeInRange) {
+                    g_procTable[hole] = g_procTable[j];
+                    hole = j;
+                }
+            }
+            g_procTable[hole].pid = 0;
+            g_procCount--;
+        }
+    }
+}
+
+// Walks a fresh process snapshot, updating the table in place. Reports the
+// process with the largest CPU time delta since the previous walk and the one
+// with the largest working set; either output may be null.
+static BOOL WalkProcesses(LONGLONG* outBestTime, WCHAR* outCpuName,
+                          ULONGLONG* outBestWs, WCHAR* outRamName) {
+    MY_SYSTEM_PROCESS_INFO* p = CollectProcessInfo();
+    if (!p) return FALSE;
+
+    DWORD generation = ++g_procGeneration;
+    LONGLONG bestTime = 0;
+    const WCHAR* bestCpuName = nullptr;
+    ULONGLONG bestWs = 0;
+    const WCHAR* bestRamName = nullptr;
+
+    while (true) {
+        DWORD pid = (DWORD)(ULONG_PTR)p->UniqueProcessId;
+        // The idle process has no image name; it isn't a consumer.
+        if (pid != 0 && p->ImageName.Buffer) {
+            LONGLONG curTime = p->KernelTime.QuadPart + p->UserTime.QuadPart;
+            BOOL added = FALSE;
+            ProcEntry* e = ProcTableFindOrAdd(pid, &added);
+            if (e) {
+                if (!added && e->createTime != p->CreateTime.QuadPart) added = TRUE;
+                if (added) {
+                    e->createTime = p->CreateTime.QuadPart;
+                    wcsncpy_s(e->name, p->ImageName.Buffer,
+                        MIN(p->ImageName.Length / sizeof(WCHAR), 63));
+                    e->name[63] = L'\0';
+                }
+
+                // Only count delta for processes seen last walk; new processes
+                // would otherwise show their entire lifetime CPU as one spike.
+                LONGLONG delta = added ? 0 : (curTime - e->time);
+                if (delta > bestTime) {
+                    bestTime = delta;
+                    bestCpuName = e->name;
+                }
+                e->time = curTime;
+                e->generation = generation;
+
+                // Top RAM consumer by working set (absolute — no prior sample needed).
+                if ((ULONGLONG)p->WorkingSetSize > bestWs) {
+                    bestWs = (ULONGLONG)p->WorkingSetSize;
+                    bestRamName = e->name;
+                }
+            }
+        }
+
+        if (p->NextEntryOffset == 0) break;
+        p = (MY_SYSTEM_PROCESS_INFO*)((BYTE*)p + p->NextEntryOffset);
+    }
+
+    // Copy the names out before the sweep can move entries around.
+    if (outBestTime) {
+        *outBestTime = bestTime;
+        wcscpy_s(outCpuName, 64, bestCpuName ? bestCpuName : L"");
+    }
+    if (outBestWs) {
+        *outBestWs = bestWs;
+        wcscpy_s(outRamName, 64, bestRamName ? bestRamName : L"");
+    }
+
+    ProcTableSweep(generation);
+    return TRUE;
 }
 
 // ─── GPU Sampling (PDH) ───────────────────────────────────────────────────────
@@ -300,7 +455,10 @@ static void InitGpuQuery() {
     PdhCollectQueryData(g_gpuQuery);
 }
 
-static void CollectGpuStats(int* outTotal, int* outTopPct, WCHAR* outTopName, int nameLen) {
+// The per-process breakdown is only needed for the popup; without it, only the
+// total is summed up.
+static void CollectGpuStats(BOOL perProcess, int* outTotal, int* outTopPct,
+                            WCHAR* outTopName, int nameLen) {
     *outTotal = -1;
     *outTopPct = 0;
     outTopName[0] = L'\0';
@@ -314,18 +472,26 @@ static void CollectGpuStats(int* outTotal, int* outTopPct, WCHAR* outTopName, in
 
     PdhCollectQueryData(g_gpuQuery);
 
-    DWORD bufSize = 0;
+    // Reuse the item buffer across ticks; grow it geometrically when PDH
+    // reports more data than fits.
+    DWORD bufSize = g_gpuItemsSize;
     DWORD itemCount = 0;
     PDH_STATUS ps = PdhGetFormattedCounterArrayW(g_gpuCounter, PDH_FMT_DOUBLE,
-        &bufSize, &itemCount, nullptr);
-    if (ps != PDH_MORE_DATA || bufSize == 0 || itemCount == 0) return;
-
-    PDH_FMT_COUNTERVALUE_ITEM_W* items = (PDH_FMT_COUNTERVALUE_ITEM_W*)malloc(bufSize);
-    if (!items) return;
-
-    ps = PdhGetFormattedCounterArrayW(g_gpuCounter, PDH_FMT_DOUBLE,
-        &bufSize, &itemCount, items);
-    if (ps != ERROR_SUCCESS) { free(items); return; }
+        &bufSize, &itemCount, g_gpuItems);
+    if (ps == PDH_MORE_DATA) {
+        DWORD newSize = g_gpuItemsSize * 2;
+        if (newSize < bufSize) newSize = bufSize;
+        free(g_gpuItems);
+        g_gpuItems = (PDH_FMT_COUNTERVALUE_ITEM_W*)malloc(newSize);
+        g_gpuItemsSize = g_gpuItems ? newSize : 0;
+        if (!g_gpuItems) return;
+
+        bufSize = g_gpuItemsSize;
+        ps = PdhGetFormattedCounterArrayW(g_gpuCounter, PDH_FMT_DOUBLE,
+            &bufSize, &itemCount, g_gpuItems);
+    }
+    if (ps != ERROR_SUCCESS || itemCount == 0) return;
+    PDH_FMT_COUNTERVALUE_ITEM_W* items = g_gpuItems;
 
     // Aggregate per PID
     int procCount = 0;
@@ -336,6 +502,7 @@ static void CollectGpuStats(int* outTotal, int* outTopPct, WCHAR* outTopName, in
 
         double val = items[i].FmtValue.doubleValue;
         grandTotal += val;
+        if (!perProcess) continue;
 
         // Parse instance: "pid_1234_luid_0x00000000_phys_0_eng_0_enum_1"
         PCWSTR s = items[i].szName;
@@ -344,17 +511,21 @@ static void CollectGpuStats(int* outTotal, int* outTopPct, WCHAR* outTopName, in
         for (s += 4; *s >= L'0' && *s <= L'9'; s++)
             pid = pid * 10 + (*s - L'0');
 
-        int j;
-        for (j = 0; j < procCount; j++) {
-            if (g_gpuProcs[j].pid == pid) { g_gpuProcs[j].total += val; break; }
+        // Engines of one process are listed together, so check the last
+        // entry before scanning.
+        int j = procCount - 1;
+        if (j < 0 || g_gpuProcs[j].pid != pid) {
+            for (j = 0; j < procCount; j++) {
+                if (g_gpuProcs[j].pid == pid) break;
+            }
         }
+        if (j < procCount) g_gpuProcs[j].total += val;
         if (j >= procCount && procCount < MAX_PROCESSES) {
             g_gpuProcs[procCount].pid = pid;
             g_gpuProcs[procCount].total = val;
             procCount++;
         }
     }
-    free(items);
 
     if (grandTotal > 100.0) grandTotal = 100.0;
     *outTotal = (int)(grandTotal + 0.5);
@@ -372,12 +543,8 @@ static void CollectGpuStats(int* outTotal, int* outTopPct, WCHAR* outTopName, in
     if (topIdx >= 0) {
         *outTopPct = (int)(topVal + 0.5);
 
-        for (int i = 0; i < g_prevProcCount; i++) {
-            if (g_prevProcs[i].pid == g_gpuProcs[topIdx].pid) {
-                wcscpy_s(outTopName, nameLen, g_prevProcs[i].name);
-                break;
-            }
-        }
+        ProcEntry* e = ProcTableFind(g_gpuProcs[topIdx].pid);
+        if (e) wcscpy_s(outTopName, nameLen, e->name);
     }
 }
 
@@ -412,67 +579,23 @@ static void RefreshData() {
 
     if (g_hasPrevSample && totalDelta > 0) {
         newTotalCpu = (int)(100.0 - 100.0 * idleDelta / totalDelta + 0.5);
+    }
 
-        MY_SYSTEM_PROCESS_INFO* buf = nullptr;
-        if (CollectProcessInfo(&buf) && buf) {
-            MY_SYSTEM_PROCESS_INFO* p = buf;
-            LONGLONG bestTime = 0;
-            WCHAR bestCpuName[64] = {};
-            ULONGLONG bestWs = 0;
-            WCHAR bestRamName[64] = {};
-            int count = 0;
-
-            while (true) {
-                LONGLONG curTime = p->KernelTime.QuadPart + p->UserTime.QuadPart;
-
-                LONGLONG prevTime = 0;
-                BOOL foundInPrev = FALSE;
-                for (int i = 0; i < g_prevProcCount; i++) {
-                    if (g_prevProcs[i].pid == (DWORD)(ULONG_PTR)p->UniqueProcessId) {
-                        prevTime = g_prevProcs[i].time;
-                        foundInPrev = TRUE;
-                        break;
-                    }
-                }
-                // Only count delta for processes seen last tick; new/overflow processes
-                // would otherwise show their entire boot-time CPU as a single-tick spike.
-                LONGLONG delta = foundInPrev ? (curTime - prevTime) : 0;
-                if (delta > bestTime && p->ImageName.Buffer) {
-                    bestTime = delta;
-                    wcsncpy_s(bestCpuName, p->ImageName.Buffer,
-                        MIN(p->ImageName.Length / sizeof(WCHAR), 63));
-                    bestCpuName[63] = L'\0';
-                }
-
-                // Top RAM consumer by working set (absolute — no prior sample needed).
-                if (p->ImageName.Buffer && (ULONGLONG)p->WorkingSetSize > bestWs) {
-                    bestWs = (ULONGLONG)p->WorkingSetSize;
-                    wcsncpy_s(bestRamName, p->ImageName.Buffer,
-                        MIN(p->ImageName.Length / sizeof(WCHAR), 63));
-                    bestRamName[63] = L'\0';
-                }
-
-                if (count < MAX_PROCESSES) {
-                    g_curProcs[count].pid = (DWORD)(ULONG_PTR)p->UniqueProcessId;
-                    g_curProcs[count].time = curTime;
-                    if (p->ImageName.Buffer) {
-                        wcsncpy_s(g_curProcs[count].name, p->ImageName.Buffer,
-                            MIN(p->ImageName.Length / sizeof(WCHAR), 63));
-                        g_curProcs[count].name[63] = L'\0';
-                    } else {
-                        g_curProcs[count].name[0] = L'\0';
-                    }
-                    count++;
-                }
-
-                if (p->NextEntryOffset == 0) break;
-                p = (MY_SYSTEM_PROCESS_INFO*)((BYTE*)p + p->NextEntryOffset);
-            }
-            memcpy(g_prevProcs, g_curProcs, count * sizeof(g_prevProcs[0]));
-            g_prevProcCount = count;
-
-            if (bestTime > 0) {
-                double pct = 100.0 * (double)bestTime / totalDelta;
+    // Top consumers are only shown in the popup, so the process walk is skipped
+    // while it's hidden. The CPU share is relative to the system time since the
+    // last walk rather than the last tick.
+    if (g_fastRefresh) {
+        ULONGLONG nowTotal = uk.QuadPart + uu.QuadPart;
+        LONGLONG bestTime = 0;
+        WCHAR bestCpuName[64];
+        ULONGLONG bestWs = 0;
+        WCHAR bestRamName[64];
+        if (WalkProcesses(&bestTime, bestCpuName, &bestWs, bestRamName)) {
+            double walkDelta = (double)(nowTotal - g_walkPrevTotal);
+            if (!g_hasWalkBaseline) {
+                newTopCpuPct = -1;  // no interval to measure over yet
+            } else if (bestTime > 0 && walkDelta > 0) {
+                double pct = 100.0 * (double)bestTime / walkDelta;
                 if (pct >= 0.5) {
                     newTopCpuPct = (int)(pct + 0.5);
                     wcscpy_s(newTopCpuName, bestCpuName);
@@ -485,14 +608,15 @@ static void RefreshData() {
                 wcscpy_s(newTopRamName, bestRamName);
             }
 
-            free(buf);
+            g_walkPrevTotal = nowTotal;
+            g_hasWalkBaseline = TRUE;
         }
     }
 
     g_prevIdle = nowIdle; g_prevKernel = nowKernel; g_prevUser = nowUser;
     g_hasPrevSample = TRUE;
 
-    CollectGpuStats(&newTotalGpu, &newTopGpuPct, newTopGpuName, 64);
+    CollectGpuStats(g_fastRefresh, &newTotalGpu, &newTopGpuPct, newTopGpuName, 64);
 
     g_totalCpu = newTotalCpu;
     g_topCpuPct = newTopCpuPct;
@@ -529,6 +653,28 @@ static void RefreshData() {
     }
 }
 
+// ─── Refresh Rate ─────────────────────────────────────────────────────────────
+
+// Runs the timer at the user's refresh rate while the popup is open, and at the
+// slow heartbeat while only the tray tooltip can be seen. Opening the popup
+// refreshes right away so that it doesn't show heartbeat-era data. The last
+// process walk is from mod init or an earlier popup session, so it only serves
+// as a new baseline; the top CPU consumer shows up from the next tick.
+static void UpdateRefreshMode(HWND hTrayWnd, BOOL popupVisible) {
+    if (!hTrayWnd) return;
+
+    BOOL wasFast = g_fastRefresh;
+    g_fastRefresh = popupVisible;
+    if (popupVisible && !wasFast) {
+        g_hasWalkBaseline = FALSE;
+        RefreshData();
+    }
+
+    DWORD ms = g_updateMs;
+    if (!popupVisible && ms < HEARTBEAT_MS) ms = HEARTBEAT_MS;
+    SetTimer(hTrayWnd, WM_TIMER_ID, ms, nullptr);  // replaces the running timer
+}
+
 // ─── Popup Window Procedure ───────────────────────────────────────────────────
 
 static LRESULT CALLBACK PopupWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
@@ -603,6 +749,9 @@ static LRESULT CALLBACK PopupWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM
                     WCHAR lineBuf[256];
                     swprintf_s(lineBuf, L"%s  %d%%", topName, topPctVal);
                     TextOutW(hdc, Sc(130), y, lineBuf, (int)wcslen(lineBuf));
+                } else if (topPctVal < 0) {
+                    PCWSTR noData = L"\x2014";
+                    TextOutW(hdc, Sc(130), y, noData, (int)wcslen(noData));
                 } else if (totalVal >= 0) {
                     TextOutW(hdc, Sc(130), y, kEmptyText[row], (int)wcslen(kEmptyText[row]));
                 } else {
@@ -615,6 +764,14 @@ static LRESULT CALLBACK PopupWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM
             return 0;
         }
 
+        case WM_WINDOWPOSCHANGED: {
+            // Covers every way the popup is shown or hidden.
+            const WINDOWPOS* wp = (const WINDOWPOS*)lParam;
+            if (wp->flags & SWP_SHOWWINDOW) UpdateRefreshMode(g_trayHwnd, TRUE);
+            else if (wp->flags & SWP_HIDEWINDOW) UpdateRefreshMode(g_trayHwnd, FALSE);
+            break;
+        }
+
         case WM_NCHITTEST: {
             LRESULT hit = DefWindowProcW(hWnd, msg, wParam, lParam);
             if (hit == HTCLIENT) return HTCAPTION;
@@ -736,7 +893,7 @@ static LRESULT CALLBACK TrayWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM l
     switch (msg) {
         case WM_CREATE:
             RefreshData();
-            SetTimer(hWnd, WM_TIMER_ID, g_updateMs, nullptr);
+            UpdateRefreshMode(hWnd, FALSE);
             return 0;
 
         case WM_TIMER:
@@ -809,8 +966,7 @@ static LRESULT CALLBACK TrayWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM l
 
                     if (newMs > 0 && newMs != g_updateMs) {
                         g_updateMs = newMs;
-                        KillTimer(hWnd, WM_TIMER_ID);
-                        SetTimer(hWnd, WM_TIMER_ID, newMs, nullptr);
+                        UpdateRefreshMode(hWnd, g_fastRefresh);
                         SaveIntervalMs(newMs);
                     }
                     break;
@@ -974,29 +1130,11 @@ BOOL WhTool_ModInit() {
 
     InitGpuQuery();
 
-    // Baseline CPU sample so the first timer tick has a delta to work from
+    // Baseline CPU sample so the first timer tick has a delta to work from.
+    // The process table is filled too, but per-process deltas wait for the
+    // popup (see UpdateRefreshMode).
     GetSystemTimes(&g_prevIdle, &g_prevKernel, &g_prevUser);
-    MY_SYSTEM_PROCESS_INFO* initBuf = nullptr;
-    if (CollectProcessInfo(&initBuf) && initBuf) {
-        MY_SYSTEM_PROCESS_INFO* p = initBuf;
-        int count = 0;
-        while (count < MAX_PROCESSES) {
-            g_prevProcs[count].pid = (DWORD)(ULONG_PTR)p->UniqueProcessId;
-            g_prevProcs[count].time = p->KernelTime.QuadPart + p->UserTime.QuadPart;
-            if (p->ImageName.Buffer) {
-                wcsncpy_s(g_prevProcs[count].name, p->ImageName.Buffer,
-                    MIN(p->ImageName.Length / sizeof(WCHAR), 63));
-                g_prevProcs[count].name[63] = L'\0';
-            } else {
-                g_prevProcs[count].name[0] = L'\0';
-            }
-            count++;
-            if (p->NextEntryOffset == 0) break;
-            p = (MY_SYSTEM_PROCESS_INFO*)((BYTE*)p + p->NextEntryOffset);
-        }
-        g_prevProcCount = count;
-        free(initBuf);
-    }
+    WalkProcesses(nullptr, nullptr, nullptr, nullptr);
 
     g_trayThread = CreateThread(nullptr, 0, TrayThreadProc, nullptr, 0, nullptr);
     return TRUE;
@@ -1027,6 +1165,13 @@ void WhTool_ModUninit() {
     if (g_iconEnabled) { DestroyIcon(g_iconEnabled); g_iconEnabled = nullptr; }
     if (g_hPopupFont) { DeleteObject(g_hPopupFont); g_hPopupFont = nullptr; }
     if (g_gpuQuery) { PdhCloseQuery(g_gpuQuery); g_gpuQuery = nullptr; g_gpuCounter = nullptr; }
+
+    free(g_procBuf);  g_procBuf = nullptr;  g_procBufSize = 0;
+    free(g_gpuItems); g_gpuItems = nullptr; g_gpuItemsSize = 0;
+    memset(g_procTable, 0, sizeof(g_procTable));
+    g_procCount = 0;
+    g_hasWalkBaseline = FALSE;
+    g_fastRefresh = FALSE;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
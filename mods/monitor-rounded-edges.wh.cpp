@@ -6,7 +6,7 @@
 // @description     Applies smooth, anti-aliased rounded corners to all monitors via Direct2D. Supports circular and squircle (superellipse) styles, with an optional inner accent border and fullscreen awareness.
 // @description:pt  Aplica cantos arredondados suaves em todos os monitores via Direct2D. Suporta estilos circular e squircle (superelipse), com borda interna opcional e suporte a tela cheia.
 // @description:es  Aplica esquinas redondeadas suaves en todos los monitores via Direct2D. Soporta estilos circular y squircle (superelipse), con borde interior opcional y soporte de pantalla completa.
-// @version         1.0
+// @version         1.1
 // @author          crazyboyybs
 // @github          https://github.com/crazyboyybs
 // @include         windhawk.exe
@@ -27,10 +27,14 @@ Applies smooth, anti-aliased rounded corners to all connected monitors using Dir
 - Two corner styles -- Circle (classic arc) and Squircle (smooth superellipse).
 - Inner accent border -- optional outline with configurable thickness and alpha color (#AARRGGBB).
 - Fullscreen awareness -- uses SHQueryUserNotificationState to reliably detect fullscreen games.
-- Minimal CPU overhead -- a continuous polling timer (750 ms) is only active when "Hide in
-  Fullscreen" is enabled. "Dynamic Inner Border" uses a brief transition timer (5 checks over
-  1.5 s) after each foreground change to catch delayed fullscreen detection, then stops
-  automatically. With neither feature active, only a lightweight WinEvent hook runs.
+- Zero CPU at idle -- fullscreen changes are picked up from events instead of a polling timer:
+  the shell's fullscreen-app notification plus location changes of the foreground window. After
+  each such event a brief transition timer (5 checks over 1.5 s) catches delayed fullscreen
+  detection, then stops automatically. With neither fullscreen feature active, only a
+  lightweight foreground WinEvent hook runs.
+- Cached corner masks -- each side is rendered once per radius, style, colors and border
+  thickness and reused; reconnecting a monitor, changing resolution or toggling the dynamic
+  border draws nothing new with Direct2D once a combination has been seen.
 - Multi-monitor support -- each monitor gets its own independent set of corner overlays.
 - Single tool process -- the rendering process is only created once; reopening Windhawk from the
   system tray does not spawn additional instances.
@@ -77,10 +81,14 @@ Aplica cantos arredondados suaves em todos os monitores conectados via Direct2D.
 - Dois estilos de canto -- Circulo (arco classico) e Squircle (superelipse suave).
 - Borda interna de destaque -- contorno opcional com espessura e cor com alpha (#AARRGGBB).
 - Deteccao de tela cheia -- usa SHQueryUserNotificationState para detectar jogos em fullscreen.
-- Overhead minimo de CPU -- o timer de polling continuo (750 ms) so e ativado quando "Ocultar em
-  Tela Cheia" esta ligado. "Borda Interna Dinamica" usa um timer de transicao curto (5 checks em
-  1,5 s) apos cada troca de foco para capturar deteccoes atrasadas, e para automaticamente. Com
-  nenhum recurso ativo, apenas o WinEvent hook leve permanece em execucao.
+- CPU zero em repouso -- mudancas de tela cheia chegam por eventos em vez de um timer de
+  polling: a notificacao de app em tela cheia do shell e as mudancas de posicao da janela em
+  primeiro plano. Apos cada evento, um timer de transicao curto (5 checks em 1,5 s) captura
+  deteccoes atrasadas e para automaticamente. Sem nenhum recurso de tela cheia ativo, apenas o
+  WinEvent hook leve de foco permanece em execucao.
+- Mascaras de canto em cache -- cada lado e renderizado uma vez por raio, estilo, cores e
+  espessura da borda e reutilizado; reconectar um monitor, trocar a resolucao ou alternar a
+  borda dinamica nao desenha nada novo com Direct2D depois que a combinacao ja foi vista.
 - Suporte a multiplos monitores -- cada monitor tem seu proprio conjunto independente de overlays.
 - Processo unico -- o processo de renderizacao e criado uma unica vez; reabrir o Windhawk pela
   bandeja do sistema nao cria instancias adicionais.
@@ -127,11 +135,14 @@ Aplica esquinas redondeadas suaves en todos los monitores conectados via Direct2
 - Dos estilos de esquina -- Circulo (arco clasico) y Squircle (superelipse suave).
 - Borde interior de acento -- contorno opcional con grosor y color con alpha (#AARRGGBB).
 - Deteccion de pantalla completa -- usa SHQueryUserNotificationState para detectar juegos en fullscreen.
-- Overhead minimo de CPU -- el temporizador de polling continuo (750 ms) solo esta activo cuando
-  "Ocultar en Pantalla Completa" esta habilitado. "Borde Interior Dinamico" usa un temporizador de
-  transicion breve (5 verificaciones en 1,5 s) tras cada cambio de foco para detectar cambios
-  tardios, y se detiene automaticamente. Sin ninguna funcion activa, solo el WinEvent hook ligero
-  permanece en ejecucion.
+- CPU cero en reposo -- los cambios de pantalla completa llegan por eventos en lugar de un
+  temporizador de polling: la notificacion de app a pantalla completa del shell y los cambios de
+  posicion de la ventana en primer plano. Tras cada evento, un temporizador de transicion breve
+  (5 verificaciones en 1,5 s) detecta cambios tardios y se detiene automaticamente. Sin ninguna
+  funcion de pantalla completa activa, solo el WinEvent hook ligero de foco permanece en ejecucion.
+- Mascaras de esquina en cache -- cada lado se renderiza una vez por radio, estilo, colores y
+  grosor del borde y se reutiliza; reconectar un monitor, cambiar la resolucion o alternar el
+  borde dinamico no dibuja nada nuevo con Direct2D una vez vista la combinacion.
 - Soporte multi-monitor -- cada monitor tiene su propio conjunto independiente de overlays.
 - Proceso unico -- el proceso de renderizado se crea una sola vez; reabrir Windhawk desde la
   bandeja del sistema no crea instancias adicionales.
@@ -218,9 +229,9 @@ dinamico de forma inesperada.
   $name: Hide in Fullscreen
   $name:pt: Ocultar Mod em Tela Cheia
   $name:es: Ocultar en Pantalla Completa
-  $description: "Hides everything in fullscreen apps and games. The polling timer is only active when this option is enabled. Note: always-on-top layered overlays may cause exclusive (flip-model) fullscreen games to flicker or drop out of exclusive mode; enable this option if that occurs."
-  $description:pt: "Oculta TUDO em jogos e aplicativos em tela cheia. O timer de polling so e ativo quando esta opcao estiver ligada. Aviso: overlays sempre no topo podem causar flickering em jogos fullscreen exclusivo (flip-model); ative esta opcao se isso ocorrer."
-  $description:es: "Oculta todo en aplicaciones y juegos a pantalla completa. El temporizador solo esta activo cuando esta opcion esta habilitada. Nota: los overlays siempre visibles pueden causar parpadeo en juegos fullscreen exclusivo (flip-model); activa esta opcion si ocurre."
+  $description: "Hides everything in fullscreen apps and games. Detection is event-driven (no polling timer). Note: always-on-top layered overlays may cause exclusive (flip-model) fullscreen games to flicker or drop out of exclusive mode; enable this option if that occurs."
+  $description:pt: "Oculta TUDO em jogos e aplicativos em tela cheia. A deteccao e por eventos (sem timer de polling). Aviso: overlays sempre no topo podem causar flickering em jogos fullscreen exclusivo (flip-model); ative esta opcao se isso ocorrer."
+  $description:es: "Oculta todo en aplicaciones y juegos a pantalla completa. La deteccion es por eventos (sin temporizador de polling). Nota: los overlays siempre visibles pueden causar parpadeo en juegos fullscreen exclusivo (flip-model); activa esta opcion si ocurre."
 */
 // ==/WindhawkModSettings==
 
@@ -268,23 +279,58 @@ struct EdgeWindow {
     int     w       = 0;
     int     h       = 0;
     // Cache GDI: criados uma vez em CreateEdge, destruidos em SyncEdges.
-    HDC     hdcMem  = NULL;  // DC em memoria com hBmp permanentemente selecionado
-    HBITMAP hBmp    = NULL;  // DIB 32bpp (w*h*4 bytes) onde o D2D escreve
-    // Cache D2D: geometrias de preenchimento, independentes de bt.
-    // Validas enquanto radius/squircle/dimensoes nao mudam (ou seja, entre SyncEdges).
-    ComPtr<ID2D1PathGeometry> fillGeoLeft;   // canto esquerdo (side 0/1 apenas)
-    ComPtr<ID2D1PathGeometry> fillGeoRight;  // canto direito  (side 0/1 apenas)
+    HDC       hdcMem = NULL;     // DC em memoria com hBmp permanentemente selecionado
+    HBITMAP   hBmp   = NULL;     // DIB 32bpp (w*h*4 bytes) montado a partir da mascara
+    uint32_t* bits   = nullptr;  // pixels do DIB (BGRA premultiplicado, top-down)
+};
+
+/// @brief Tudo o que altera os pixels de um lado renderizado.
+///        O raio ja esta em pixels fisicos (processo per-monitor DPI aware, raio
+///        nao escalado), entao o DPI do monitor nao precisa entrar na chave.
+struct MaskKey {
+    int          side;
+    int          w, h;      // dimensoes do template (ver MaskTemplateSize)
+    int          radius;
+    bool         squircle;
+    float        bt;        // espessura efetiva (0 no dynamicBorder em fullscreen)
+    D2D1_COLOR_F bg;
+    D2D1_COLOR_F border;
+
+    bool operator==(const MaskKey& o) const {
+        auto sameColor = [](const D2D1_COLOR_F& a, const D2D1_COLOR_F& b) {
+            return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+        };
+        return side == o.side && w == o.w && h == o.h && radius == o.radius
+            && squircle == o.squircle && bt == o.bt
+            && sameColor(bg, o.bg) && sameColor(border, o.border);
+    }
+};
+
+/// @brief Template de um lado renderizado pelo D2D uma unica vez.
+struct EdgeMask {
+    MaskKey               key;
+    std::vector<uint32_t> pixels;  // BGRA premultiplicado, key.w * key.h
 };
 
 HWND                    g_hwndMain             = NULL;
 HANDLE                  g_hThread              = NULL;
 HWINEVENTHOOK           g_hHookFG              = NULL;
+HWINEVENTHOOK           g_hHookLocation        = NULL;  // escopo: thread da janela em foco
+DWORD                   g_locationThreadId     = 0;
+HWND                    g_hwndTrackedFG        = NULL;
+bool                    g_appBarRegistered     = false;
 std::atomic<bool>       g_pendingReassert      {false};
+std::atomic<bool>       g_pendingFSCheck       {false};
 std::vector<EdgeWindow> g_edgeWindows;
 bool                    g_isHidden             = false;
 bool                    g_isAppFullscreen      = false;
 int                     g_dynBorderTicks       = 0;
 
+// Cache LRU de mascaras (mais recente no fim). Sobrevive a SyncEdges e a troca
+// de configuracoes, entao voltar a uma combinacao ja vista nao usa o D2D.
+static constexpr size_t k_maxMasks = 16;
+std::vector<EdgeMask>   g_maskCache;
+
 ComPtr<ID2D1Factory>         g_pFactory;
 ComPtr<ID2D1DCRenderTarget>  g_pRT;
 ComPtr<ID2D1SolidColorBrush> g_pBrushBG;
@@ -293,10 +339,11 @@ ComPtr<ID2D1SolidColorBrush> g_pBrushBorder;
 // IDs de mensagem interna
 static constexpr UINT WM_SETTINGS_CHANGED   = WM_APP + 1;
 static constexpr UINT WM_FOREGROUND_CHANGED = WM_APP + 2;
+static constexpr UINT WM_FULLSCREEN_CHECK   = WM_APP + 3;  // location change da janela em foco
+static constexpr UINT WM_APPBAR_NOTIFY      = WM_APP + 4;  // ABN_FULLSCREENAPP do shell
 
 // IDs de timer
-static constexpr UINT TIMER_POLLING    = 1;  // disable_fullscreen: polling continuo 750ms
-static constexpr UINT TIMER_TRANSITION = 2;  // dynamicBorder: curto pos-transicao de foreground
+static constexpr UINT TIMER_TRANSITION = 2;  // curto pos-evento: cobre o delay do shell
 
 // ---------------------------------------------------------------------------
 // Utilitarios
@@ -432,7 +479,7 @@ static D2D1_POINT_2F SqCP2(D2D1_POINT_2F p2, D2D1_POINT_2F pC) {
     return { p2.x + k_squircle * (pC.x - p2.x), p2.y + k_squircle * (pC.y - p2.y) };
 }
 
-/// @brief Constroi a geometria de preenchimento de um canto para armazenar em cache.
+/// @brief Constroi a geometria de preenchimento de um canto.
 ///        Depende apenas de dimensoes fixas e configuracoes estruturais (raio, squircle);
 ///        nao e afetada por bt (border thickness), que varia no dynamicBorder.
 static ComPtr<ID2D1PathGeometry> BuildFillGeometry(
@@ -462,35 +509,28 @@ static ComPtr<ID2D1PathGeometry> BuildFillGeometry(
     return pg;
 }
 
-/// @brief Renderiza e aplica o overlay de borda em uma janela layered.
-///        Usa o DC e o DIB em cache do EdgeWindow; sem alocacoes GDI por chamada.
-static void RenderEdge(EdgeWindow& ew) {
-    if (FAILED(EnsureResources())) return;
-    if (!ew.hdcMem) return;
-
-    RECT rb = {0, 0, ew.w, ew.h};
-    g_pRT->BindDC(ew.hdcMem, &rb);
-    g_pRT->BeginDraw();
+/// @brief Desenha o conteudo de um lado (cantos + borda) no render target ja vinculado.
+///        Usado apenas para renderizar templates em cache (ver GetEdgeMask).
+static void DrawEdgeContent(int side, int w, int h, float bt) {
     g_pRT->Clear(D2D1::ColorF(0.0f, 0.0f, 0.0f, 0.0f));
 
     float r    = (float)g_cfg.radius;
-    float bt   = (g_cfg.dynamicBorder && g_isAppFullscreen) ? 0.0f : g_cfg.borderThickness;
     float half = bt / 2.0f;
 
-    if (ew.side == 0 || ew.side == 1) {
-        bool isTop = (ew.side == 0);
+    if (side == 0 || side == 1) {
+        bool isTop = (side == 0);
 
-        // Preenchimento: geometrias em cache (nao dependem de bt).
-        if (ew.fillGeoLeft)  g_pRT->FillGeometry(ew.fillGeoLeft.Get(),  g_pBrushBG.Get());
-        if (ew.fillGeoRight) g_pRT->FillGeometry(ew.fillGeoRight.Get(), g_pBrushBG.Get());
+        auto fillGeoLeft  = BuildFillGeometry(w, h, r, side, false);
+        auto fillGeoRight = BuildFillGeometry(w, h, r, side, true);
+        if (fillGeoLeft)  g_pRT->FillGeometry(fillGeoLeft.Get(),  g_pBrushBG.Get());
+        if (fillGeoRight) g_pRT->FillGeometry(fillGeoRight.Get(), g_pBrushBG.Get());
 
-        // Borda: recriada a cada render pois depende de bt (dinamico no dynamicBorder).
         if (bt > 0.0f) {
             auto DrawBorderCorner = [&](bool isRight) {
                 // pC necessario para SqCP1/SqCP2 no modo squircle.
-                D2D1_POINT_2F pC = { isRight ? (float)ew.w : 0.0f,  isTop ? 0.0f : r    };
-                D2D1_POINT_2F p1 = { isRight ? (float)ew.w - r : r, isTop ? 0.0f : r    };
-                D2D1_POINT_2F p2 = { isRight ? (float)ew.w : 0.0f,  isTop ? r    : 0.0f };
+                D2D1_POINT_2F pC = { isRight ? (float)w : 0.0f,  isTop ? 0.0f : r    };
+                D2D1_POINT_2F p1 = { isRight ? (float)w - r : r, isTop ? 0.0f : r    };
+                D2D1_POINT_2F p2 = { isRight ? (float)w : 0.0f,  isTop ? r    : 0.0f };
                 D2D1_SWEEP_DIRECTION dir = isTop
                     ? (isRight ? D2D1_SWEEP_DIRECTION_CLOCKWISE         : D2D1_SWEEP_DIRECTION_COUNTER_CLOCKWISE)
                     : (isRight ? D2D1_SWEEP_DIRECTION_COUNTER_CLOCKWISE : D2D1_SWEEP_DIRECTION_CLOCKWISE);
@@ -519,26 +559,146 @@ static void RenderEdge(EdgeWindow& ew) {
             DrawBorderCorner(true);
 
             float ly = isTop ? half : (r - half);
-            g_pRT->DrawLine({r, ly}, {(float)ew.w - r, ly}, g_pBrushBorder.Get(), bt);
+            g_pRT->DrawLine({r, ly}, {(float)w - r, ly}, g_pBrushBorder.Get(), bt);
         }
 
     } else if (bt > 0.0f) {
-        float lx = (ew.side == 2) ? half : (r - half);
-        g_pRT->DrawLine({lx, r}, {lx, (float)ew.h - r}, g_pBrushBorder.Get(), bt);
+        float lx = (side == 2) ? half : (r - half);
+        g_pRT->DrawLine({lx, r}, {lx, (float)h - r}, g_pBrushBorder.Get(), bt);
     }
+}
+
+/// @brief Dimensoes do template de um lado.
+///
+///        Entre os dois cantos, cada faixa e so a linha reta da borda repetida:
+///        topo/rodape variam apenas ao longo de x e esquerda/direita ao longo de y.
+///        O template guarda os cantos (r pixels de cada lado) mais uma unica
+///        coluna/linha central, que ExpandMask replica ate o tamanho do monitor.
+///        Faixas curtas demais para isso usam o tamanho real (copia direta).
+static void MaskTemplateSize(const EdgeWindow& ew, int r, int& tw, int& th) {
+    tw = ew.w;
+    th = ew.h;
+    if ((ew.side == 0 || ew.side == 1) && ew.w > 2 * r + 1) tw = 2 * r + 1;
+    if ((ew.side == 2 || ew.side == 3) && ew.h > 2 * r + 1) th = 2 * r + 1;
+}
 
+/// @brief Renderiza um template com D2D em um DIB temporario e copia os pixels.
+/// @return true se a mascara foi preenchida.
+static bool RenderMask(EdgeMask& mask) {
+    if (FAILED(EnsureResources())) return false;
+
+    const MaskKey& k = mask.key;
+    BITMAPINFO bmi              = {};
+    bmi.bmiHeader.biSize        = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth       = k.w;
+    bmi.bmiHeader.biHeight      = -k.h;  // top-down
+    bmi.bmiHeader.biPlanes      = 1;
+    bmi.bmiHeader.biBitCount    = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    void*   bits = nullptr;
+    HBITMAP hBmp = CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+    if (!hBmp) return false;
+    HDC hdc = CreateCompatibleDC(NULL);
+    if (!hdc) { DeleteObject(hBmp); return false; }
+    HGDIOBJ old = SelectObject(hdc, hBmp);
+
+    RECT rb = {0, 0, k.w, k.h};
+    g_pRT->BindDC(hdc, &rb);
+    g_pRT->BeginDraw();
+    DrawEdgeContent(k.side, k.w, k.h, k.bt);
     HRESULT hr = g_pRT->EndDraw();
     if (hr == D2DERR_RECREATE_TARGET) ReleaseResources();
 
     if (SUCCEEDED(hr)) {
-        SIZE          sz = {ew.w, ew.h};
-        POINT         ps = {0, 0};
-        BLENDFUNCTION bf = {AC_SRC_OVER, 0, 255, AC_SRC_ALPHA};
-        // hdcDst=NULL: usa screen DC interna. pptDst=NULL: janela nao se move.
-        UpdateLayeredWindow(ew.hwnd, NULL, NULL, &sz, ew.hdcMem, &ps, 0, &bf, ULW_ALPHA);
+        GdiFlush();
+        const uint32_t* src = static_cast<const uint32_t*>(bits);
+        mask.pixels.assign(src, src + (size_t)k.w * k.h);
+    }
+
+    SelectObject(hdc, old);
+    DeleteDC(hdc);
+    DeleteObject(hBmp);
+    return SUCCEEDED(hr);
+}
+
+/// @brief Busca a mascara no cache ou a renderiza uma vez.
+/// @return Ponteiro valido ate a proxima chamada, ou nullptr em caso de falha.
+static const EdgeMask* GetEdgeMask(const MaskKey& key) {
+    auto it = std::find_if(g_maskCache.begin(), g_maskCache.end(),
+                           [&](const EdgeMask& m) { return m.key == key; });
+    if (it != g_maskCache.end()) {
+        // LRU: move para o fim.
+        std::rotate(it, it + 1, g_maskCache.end());
+        return &g_maskCache.back();
+    }
+
+    EdgeMask mask;
+    mask.key = key;
+    if (!RenderMask(mask)) return nullptr;
+
+    if (g_maskCache.size() >= k_maxMasks)
+        g_maskCache.erase(g_maskCache.begin());
+    g_maskCache.push_back(std::move(mask));
+    return &g_maskCache.back();
+}
+
+/// @brief Monta os pixels de uma faixa a partir do template (ver MaskTemplateSize).
+static void ExpandMask(const EdgeMask& mask, EdgeWindow& ew) {
+    const int       tw  = mask.key.w;
+    const int       th  = mask.key.h;
+    const uint32_t* src = mask.pixels.data();
+    uint32_t*       dst = ew.bits;
+
+    if (tw == ew.w && th == ew.h) {
+        memcpy(dst, src, (size_t)tw * th * sizeof(uint32_t));
+    } else if (tw != ew.w) {
+        // Topo/rodape: [cantos esq.] [coluna central replicada] [cantos dir.]
+        const int r = (tw - 1) / 2;
+        for (int y = 0; y < ew.h; y++) {
+            const uint32_t* s = src + (size_t)y * tw;
+            uint32_t*       d = dst + (size_t)y * ew.w;
+            memcpy(d, s, r * sizeof(uint32_t));
+            std::fill(d + r, d + ew.w - r, s[r]);
+            memcpy(d + ew.w - r, s + r + 1, r * sizeof(uint32_t));
+        }
+    } else {
+        // Esquerda/direita: [linhas de cima] [linha central replicada] [linhas de baixo]
+        const int    r   = (th - 1) / 2;
+        const size_t row = (size_t)tw * sizeof(uint32_t);
+        memcpy(dst, src, r * row);
+        for (int y = r; y < ew.h - r; y++)
+            memcpy(dst + (size_t)y * tw, src + (size_t)r * tw, row);
+        memcpy(dst + (size_t)(ew.h - r) * tw, src + (size_t)(r + 1) * tw, r * row);
     }
 }
 
+/// @brief Monta e aplica o overlay de borda em uma janela layered.
+///        Usa o DC e o DIB em cache do EdgeWindow; o D2D so e usado quando a
+///        mascara ainda nao esta no cache.
+static void RenderEdge(EdgeWindow& ew) {
+    if (!ew.hdcMem || !ew.bits) return;
+
+    MaskKey key  = {};
+    key.side     = ew.side;
+    key.radius   = g_cfg.radius;
+    key.squircle = g_cfg.squircle;
+    key.bt       = (g_cfg.dynamicBorder && g_isAppFullscreen) ? 0.0f : g_cfg.borderThickness;
+    key.bg       = g_cfg.bgColor;
+    key.border   = g_cfg.borderColor;
+    MaskTemplateSize(ew, g_cfg.radius, key.w, key.h);
+
+    const EdgeMask* mask = GetEdgeMask(key);
+    if (!mask) return;
+    ExpandMask(*mask, ew);
+
+    SIZE          sz = {ew.w, ew.h};
+    POINT         ps = {0, 0};
+    BLENDFUNCTION bf = {AC_SRC_OVER, 0, 255, AC_SRC_ALPHA};
+    // hdcDst=NULL: usa screen DC interna. pptDst=NULL: janela nao se move.
+    UpdateLayeredWindow(ew.hwnd, NULL, NULL, &sz, ew.hdcMem, &ps, 0, &bf, ULW_ALPHA);
+}
+
 // ---------------------------------------------------------------------------
 // Sistema -- Janelas de Borda
 // ---------------------------------------------------------------------------
@@ -557,7 +717,8 @@ static void RefreshEdges() {
 }
 
 /// @brief Destroi e recria todas as janelas de overlay.
-///        Chamada apenas quando configuracoes estruturais mudam (raio, cor, estilo).
+///        Chamada quando configuracoes estruturais mudam (raio, cor, estilo) ou a
+///        topologia de monitores muda. Os pixels vem do cache de mascaras.
 static void SyncEdges() {
     for (auto& ew : g_edgeWindows) {
         if (ew.hdcMem) DeleteDC(ew.hdcMem);
@@ -606,12 +767,7 @@ static void SyncEdges() {
             edgeWin.h      = eh;
             edgeWin.hdcMem = hdcMem;
             edgeWin.hBmp   = hBmp;
-
-            if (side == 0 || side == 1) {
-                float r = (float)g_cfg.radius;
-                edgeWin.fillGeoLeft  = BuildFillGeometry(ew, eh, r, side, false);
-                edgeWin.fillGeoRight = BuildFillGeometry(ew, eh, r, side, true);
-            }
+            edgeWin.bits   = static_cast<uint32_t*>(bits);
 
             RenderEdge(edgeWin);
             if (!g_isHidden) ShowWindow(hwn, SW_SHOWNOACTIVATE);
@@ -674,20 +830,81 @@ static void CALLBACK HookForeground(
         PostMessage(g_hwndMain, WM_FOREGROUND_CHANGED, 0, 0);
 }
 
-/// @brief Instala o WinEvent hook e o timer de polling de acordo com as
-///        configuracoes ativas.
+/// @brief Callback de mudanca de posicao/tamanho.
+///        O hook ja esta limitado a thread da janela em foco; aqui descartamos
+///        cursor, caret e janelas filhas, ficando so com a propria janela.
+static void CALLBACK HookLocation(
+    HWINEVENTHOOK, DWORD, HWND hwnd, LONG idObject, LONG idChild, DWORD, DWORD)
+{
+    if (idObject != OBJID_WINDOW || idChild != CHILDID_SELF || hwnd != g_hwndTrackedFG)
+        return;
+    if (g_hwndMain && !g_pendingFSCheck.exchange(true))
+        PostMessage(g_hwndMain, WM_FULLSCREEN_CHECK, 0, 0);
+}
+
+/// @brief Limita o hook de EVENT_OBJECT_LOCATIONCHANGE a janela em primeiro plano.
+///
+///        Um jogo que entra em tela cheia sem trocar o foreground redimensiona a
+///        propria janela para o monitor inteiro, o que gera um location change.
+///        O hook e reinstalado apenas quando a thread em foco muda; sem
+///        funcionalidades de fullscreen ativas, ele nao existe.
+static void TrackForegroundLocation() {
+    bool  wanted = g_cfg.disableFullscreen || g_cfg.dynamicBorder;
+    HWND  fg     = wanted ? GetForegroundWindow() : NULL;
+    DWORD pid    = 0;
+    DWORD tid    = fg ? GetWindowThreadProcessId(fg, &pid) : 0;
+
+    g_hwndTrackedFG = fg;
+    if (g_hHookLocation && tid == g_locationThreadId) return;
+
+    if (g_hHookLocation) {
+        UnhookWinEvent(g_hHookLocation);
+        g_hHookLocation = NULL;
+    }
+    g_locationThreadId = 0;
+    if (!tid || pid == GetCurrentProcessId()) return;
+
+    g_hHookLocation = SetWinEventHook(
+        EVENT_OBJECT_LOCATIONCHANGE, EVENT_OBJECT_LOCATIONCHANGE,
+        NULL, HookLocation, pid, tid,
+        WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS
+    );
+    if (g_hHookLocation) g_locationThreadId = tid;
+}
+
+/// @brief Registra a janela de mensagens como appbar (sem reservar espaco) para
+///        receber ABN_FULLSCREENAPP, a notificacao do shell quando uma janela
+///        entra ou sai de tela cheia no monitor.
+static void UpdateAppBar(HWND hw) {
+    bool wanted = g_cfg.disableFullscreen || g_cfg.dynamicBorder;
+    if (wanted == g_appBarRegistered) return;
+
+    APPBARDATA abd       = {};
+    abd.cbSize           = sizeof(abd);
+    abd.hWnd             = hw;
+    abd.uCallbackMessage = WM_APPBAR_NOTIFY;
+    if (wanted) {
+        g_appBarRegistered = SHAppBarMessage(ABM_NEW, &abd) != FALSE;
+    } else {
+        SHAppBarMessage(ABM_REMOVE, &abd);
+        g_appBarRegistered = false;
+    }
+}
+
+/// @brief Instala os hooks de eventos de acordo com as configuracoes ativas.
 ///
 ///        Hook (EVENT_SYSTEM_FOREGROUND): SEMPRE ativo.
 ///        - Re-asserta TOPMOST quando outra janela assume o foco.
 ///        - Aciona ApplyFullscreenState quando funcionalidades de fullscreen ativas.
-///        - Custo zero entre eventos (WINEVENT_OUTOFCONTEXT).
 ///
-///        Timer: SOMENTE quando disable_fullscreen = true.
-///        - Detecta jogos que entram em fullscreen sem mudar o foreground.
-///        - Quando inativo: zero overhead periodico.
+///        Com disable_fullscreen ou dynamic_border:
+///        - EVENT_OBJECT_LOCATIONCHANGE da janela em foco (TrackForegroundLocation).
+///        - ABN_FULLSCREENAPP do shell (UpdateAppBar).
+///
+///        Nenhum timer periodico: custo zero entre eventos (WINEVENT_OUTOFCONTEXT).
 ///
 /// @param hw  Handle da janela de mensagens.
-static void UpdateHookAndTimer(HWND hw) {
+static void UpdateHooks(HWND hw) {
     if (!g_hHookFG) {
         g_hHookFG = SetWinEventHook(
             EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND,
@@ -696,11 +913,17 @@ static void UpdateHookAndTimer(HWND hw) {
         );
     }
 
-    if (g_cfg.disableFullscreen) {
-        SetTimer(hw, TIMER_POLLING, 750, NULL);
-    } else {
-        KillTimer(hw, TIMER_POLLING);
-    }
+    TrackForegroundLocation();
+    UpdateAppBar(hw);
+}
+
+/// @brief Reavalia o fullscreen e agenda o timer de transicao curto, que cobre
+///        o delay do SHQueryUserNotificationState apos o evento e depois para.
+static void CheckFullscreenAfterEvent(HWND hw) {
+    if (!g_cfg.disableFullscreen && !g_cfg.dynamicBorder) return;
+    ApplyFullscreenState();
+    g_dynBorderTicks = 5;
+    SetTimer(hw, TIMER_TRANSITION, 300, NULL);
 }
 
 // ---------------------------------------------------------------------------
@@ -723,21 +946,25 @@ static LRESULT CALLBACK MasterWndProc(HWND hw, UINT msg, WPARAM wp, LPARAM lp) {
         g_dynBorderTicks = 0;
         SyncEdges();
         ApplyFullscreenState();
-        UpdateHookAndTimer(hw);
+        UpdateHooks(hw);
         return 0;
 
     case WM_FOREGROUND_CHANGED:
         g_pendingReassert.store(false);
-        if (g_cfg.disableFullscreen || g_cfg.dynamicBorder) {
-            ApplyFullscreenState();
-        }
+        TrackForegroundLocation();
         ReassertTopmost();
-        // Timer de transicao: cobre o delay do SHQueryUserNotificationState apos
-        // troca de foreground, sem polling continuo quando nenhum jogo esta rodando.
-        // Nao necessario quando disableFullscreen ja tem TIMER_POLLING ativo (750ms).
-        if (g_cfg.dynamicBorder && !g_cfg.disableFullscreen) {
-            g_dynBorderTicks = 5;
-            SetTimer(hw, TIMER_TRANSITION, 300, NULL);
+        CheckFullscreenAfterEvent(hw);
+        return 0;
+
+    case WM_FULLSCREEN_CHECK:
+        g_pendingFSCheck.store(false);
+        CheckFullscreenAfterEvent(hw);
+        return 0;
+
+    case WM_APPBAR_NOTIFY:
+        if (wp == ABN_FULLSCREENAPP) {
+            CheckFullscreenAfterEvent(hw);
+            ReassertTopmost();
         }
         return 0;
 
@@ -746,10 +973,6 @@ static LRESULT CALLBACK MasterWndProc(HWND hw, UINT msg, WPARAM wp, LPARAM lp) {
             ApplyFullscreenState();
             ReassertTopmost();
             if (--g_dynBorderTicks <= 0) KillTimer(hw, TIMER_TRANSITION);
-        } else {
-            // TIMER_POLLING: ativo somente quando disable_fullscreen = true.
-            ApplyFullscreenState();
-            ReassertTopmost();
         }
         return 0;
 
@@ -812,7 +1035,7 @@ static DWORD WINAPI ModThread(LPVOID) {
         LoadSettings();
         SyncEdges();
         ApplyFullscreenState();
-        UpdateHookAndTimer(g_hwndMain);
+        UpdateHooks(g_hwndMain);
 
         MSG m = {};
         while (GetMessage(&m, NULL, 0, 0)) DispatchMessage(&m);
@@ -822,7 +1045,17 @@ static DWORD WINAPI ModThread(LPVOID) {
             UnhookWinEvent(g_hHookFG);
             g_hHookFG = NULL;
         }
-        KillTimer(g_hwndMain, TIMER_POLLING);
+        if (g_hHookLocation) {
+            UnhookWinEvent(g_hHookLocation);
+            g_hHookLocation = NULL;
+        }
+        if (g_appBarRegistered) {
+            APPBARDATA abd = {};
+            abd.cbSize     = sizeof(abd);
+            abd.hWnd       = g_hwndMain;
+            SHAppBarMessage(ABM_REMOVE, &abd);
+            g_appBarRegistered = false;
+        }
         KillTimer(g_hwndMain, TIMER_TRANSITION);
         for (auto& ew : g_edgeWindows) {
             if (ew.hdcMem) DeleteDC(ew.hdcMem);
@@ -832,6 +1065,7 @@ static DWORD WINAPI ModThread(LPVOID) {
         g_edgeWindows.clear();
     }
 
+    g_maskCache.clear();
     ReleaseResources();
     g_pFactory.Reset();
     if (SUCCEEDED(hrCom)) CoUninitialize();
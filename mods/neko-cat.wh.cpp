@@ -2,7 +2,7 @@
 // @id              neko-cat
 // @name            Desktop Companions
 // @description     Spawn multiple animated characters (neko cat, sakura, and tomoyo) on your screen that interact with your windows and follow your cursor.
-// @version         1.4.0
+// @version         1.5.0
 // @author          ciizerr
 // @github          https://github.com/ciizerr
 // @include         windhawk.exe
@@ -54,6 +54,10 @@ Companions roam freely across **all your active monitors**! They seamlessly jump
 ## 🔒 Optimization & Assets
 
 *   **Low Footprint**: Written in pure native C++ with direct Win32/GDI+ calls. CPU usage is **virtually 0.0%** at 60 FPS.
+*   **Sprite Atlas**: Each character's spritesheet is decoded and scaled once and shared by every pet using it; frames are plain pixel copies.
+*   **Idle Throttling**: While every pet is sitting still (washing, yawning, sleeping...), the frame timer drops to the 5 Hz behavior tick, and it stops entirely while pets are hidden.
+*   **Single Overlay Renderer** (optional): Draws all pets into one click-through overlay per monitor and only re-uploads the area that changed, instead of one layered window per pet. Worth enabling with many characters.
+*   **Parallel Downloads**: Missing assets for every needed character are fetched concurrently on first launch.
 *   **Secure External Downloads**: All graphic spritesheets and audio files are fetched dynamically on first initialization using Windhawk's secure HTTPS `Wh_GetUrlContent` API.
 *   **Source Location**: Files are served directly from the official GitHub repository:
     *   **Repository Root**: [ciizerr/wh-mods on GitHub](https://github.com/ciizerr/wh-mods)
@@ -134,6 +138,9 @@ Enjoy your new friends!
   - neko_key: "Ctrl+Alt+N"
     $name: Pet Toggle Shortcut
     $description: Keyboard shortcut to quickly hide/unhide your pets. (e.g. Ctrl+Alt+N, Shift+Esc, empty to disable)
+  - shared_overlay: false
+    $name: Single Overlay Renderer
+    $description: "Draw all pets into one click-through overlay per monitor instead of one window per pet. Lighter with many characters."
   $name: Advanced & Shortcuts
 */
 // ==/WindhawkModSettings==
@@ -144,6 +151,7 @@ Enjoy your new friends!
 #include <mmsystem.h>
 #include <string>
 #include <cmath>
+#include <cstdint>
 #include <vector>
 #include <cstdio>
 #include <algorithm>
@@ -200,6 +208,7 @@ bool g_sleepSoundRepeat = true;
 int g_fps = 60;
 int g_catCount = 1;
 bool g_saveBehavior = true;
+bool g_sharedOverlay = false;
 static bool g_modExit = false;
 
 // Forward declaration
@@ -320,38 +329,105 @@ bool EnsureFileExists(const std::wstring& localPath, const std::wstring& remoteU
     return ok;
 }
 
-bool EnsureThemeDownloaded(const std::wstring& themeName) {
-    if (themeName.empty()) return false;
-    std::wstring themePath = g_storagePath + L"\\" + themeName;
-    
-    // Quick check to avoid repeated 404 HTTP requests for themes that lack optional sounds
-    std::wstring spritePath = themePath + L"\\spritesheet.png";
-    if (GetFileAttributesW(spritePath.c_str()) != INVALID_FILE_ATTRIBUTES) {
-        return true; 
-    }
+// Every file a theme may ship, relative to its folder. Only the spritesheet is
+// required; several themes lack some of the sounds.
+const wchar_t* const g_themeAssetManifest[] = {
+    L"spritesheet.png",
+    L"sounds/awake.wav", L"sounds/sleep.wav",
+    L"sounds/idle1.wav", L"sounds/idle2.wav", L"sounds/idle3.wav",
+};
 
-    CreatePath(themePath);
-    CreatePath(themePath + L"\\sounds");
+const int MAX_DOWNLOAD_WORKERS = 4;
 
-    std::wstring baseUrl = L"https://raw.githubusercontent.com/ciizerr/wh-mods/9a7de898a9a149f096417ea74204925c4f930dcf/assets/" + themeName + L"/";
+struct AssetDownload {
+    std::wstring localPath;
+    std::wstring url;
+    bool ok = false;
+};
 
-    bool ok = EnsureFileExists(spritePath, baseUrl + L"spritesheet.png");
-    
-    const wchar_t* audios[] = { L"awake.wav", L"sleep.wav", L"idle1.wav", L"idle2.wav", L"idle3.wav" };
-    for (const wchar_t* au : audios) {
-        std::wstring file(au);
-        if (!EnsureFileExists(themePath + L"\\sounds\\" + file, baseUrl + L"sounds/" + file)) {
-            ok = false;
+struct AssetDownloadQueue {
+    std::vector<AssetDownload>* jobs;
+    LONG next;
+};
+
+DWORD WINAPI AssetDownloadWorker(LPVOID param) {
+    AssetDownloadQueue* queue = (AssetDownloadQueue*)param;
+    for (;;) {
+        LONG i = InterlockedIncrement(&queue->next) - 1;
+        if (i >= (LONG)queue->jobs->size()) break;
+        AssetDownload& job = (*queue->jobs)[i];
+        job.ok = EnsureFileExists(job.localPath, job.url);
+    }
+    return 0;
+}
+
+// Fetches the missing manifest files of all given themes at once, on up to
+// MAX_DOWNLOAD_WORKERS threads, so a first launch with several characters
+// doesn't wait on one HTTP round trip after another. A theme whose
+// spritesheet is already present counts as installed, which avoids retrying
+// the 404s of its optional sounds on every start.
+bool DownloadThemes(const std::vector<std::wstring>& themeNames) {
+    std::vector<std::wstring> themes;
+    for (const auto& name : themeNames) {
+        if (name.empty()) continue;
+        if (std::find(themes.begin(), themes.end(), name) != themes.end()) continue;
+        std::wstring spritePath = g_storagePath + L"\\" + name + L"\\spritesheet.png";
+        if (GetFileAttributesW(spritePath.c_str()) != INVALID_FILE_ATTRIBUTES) continue;
+        themes.push_back(name);
+    }
+    if (themes.empty()) return true;
+
+    std::vector<AssetDownload> jobs;
+    for (const auto& name : themes) {
+        std::wstring themePath = g_storagePath + L"\\" + name;
+        CreatePath(themePath);
+        CreatePath(themePath + L"\\sounds");
+
+        std::wstring baseUrl = L"https://raw.githubusercontent.com/ciizerr/wh-mods/9a7de898a9a149f096417ea74204925c4f930dcf/assets/" + name + L"/";
+        for (const wchar_t* file : g_themeAssetManifest) {
+            std::wstring localPath = themePath + L"\\" + file;
+            std::replace(localPath.begin(), localPath.end(), L'/', L'\\');
+            if (GetFileAttributesW(localPath.c_str()) != INVALID_FILE_ATTRIBUTES) continue;
+            jobs.push_back({ localPath, baseUrl + file });
         }
     }
+
+    ULONGLONG start = GetTickCount64();
+    AssetDownloadQueue queue = { &jobs, 0 };
+    HANDLE workers[MAX_DOWNLOAD_WORKERS];
+    int workerCount = 0;
+    for (int i = 0; i < MAX_DOWNLOAD_WORKERS - 1 && i < (int)jobs.size() - 1; i++) {
+        HANDLE h = CreateThread(nullptr, 0, AssetDownloadWorker, &queue, 0, nullptr);
+        if (h) workers[workerCount++] = h;
+    }
+    AssetDownloadWorker(&queue); // this thread works the queue too
+    if (workerCount) {
+        WaitForMultipleObjects(workerCount, workers, TRUE, INFINITE);
+        for (int i = 0; i < workerCount; i++) CloseHandle(workers[i]);
+    }
+
+    bool ok = true;
+    for (const auto& job : jobs) {
+        if (!job.ok) ok = false;
+    }
+    Wh_Log(L"Fetched %d asset(s) for %d theme(s) on %d thread(s) in %llu ms",
+           (int)jobs.size(), (int)themes.size(), workerCount + 1, GetTickCount64() - start);
     return ok;
 }
 
+// Downloads the default theme (the fallback for every pet) together with
+// whatever the current settings can pick from.
 void DownloadMissingAssets() {
     Wh_Log(L"Checking for missing assets in: %s", g_storagePath.c_str());
-    
-    // Always ensure the default theme is downloaded for fallback
-    EnsureThemeDownloaded(L"neko-cat");
+
+    std::vector<std::wstring> themes = { L"neko-cat" };
+    if (g_randomThemes) {
+        // Random selection needs the whole official pool
+        themes.insert(themes.end(), g_officialThemes.begin(), g_officialThemes.end());
+    } else {
+        for (const auto& pet : g_customPets) themes.push_back(pet.theme);
+    }
+    DownloadThemes(themes);
 }
 
 std::wstring GetRandomAvailableTheme() {
@@ -409,10 +485,224 @@ std::wstring GetThemePathForPet(int index) {
     return g_storagePath + L"\\" + matchedTheme;
 }
 
+// ─────────────────────────────────────────────
+//  Sprite atlas
+// ─────────────────────────────────────────────
+// A theme's spritesheet decoded once into premultiplied BGRA at the current
+// scale: MAX_STATE rows of 2 frames, each cell SPRITE_SIZE * scale square.
+// Pets using the same theme share one atlas, and drawing a frame is a row copy.
+struct SpriteAtlas {
+    std::wstring themePath;   // folder actually loaded (after any fallback)
+    std::wstring requestedPath;
+    int scale = 0;
+    int cell = 0;
+    int stride = 0;           // in pixels
+    std::vector<uint32_t> pixels;
+
+    const uint32_t* Cell(int state, int frame) const {
+        return pixels.data() + (size_t)state * cell * stride + (size_t)frame * cell;
+    }
+};
+
+std::vector<SpriteAtlas*> g_atlases;
+
+static bool DecodeSpritesheet(const std::wstring& themePath, int scale, SpriteAtlas& atlas) {
+    std::wstring path = themePath + L"\\spritesheet.png";
+    Bitmap* sheet = Bitmap::FromFile(path.c_str());
+    if (!sheet || sheet->GetLastStatus() != Ok) {
+        if (sheet) delete sheet;
+        return false;
+    }
+
+    // Cells the sheet doesn't cover stay transparent.
+    int srcW = std::min((int)sheet->GetWidth(), 2 * SPRITE_SIZE);
+    int srcH = std::min((int)sheet->GetHeight(), MAX_STATE * SPRITE_SIZE);
+    BitmapData data;
+    Rect lockRect(0, 0, srcW, srcH);
+    if (srcW <= 0 || srcH <= 0 ||
+        sheet->LockBits(&lockRect, ImageLockModeRead, PixelFormat32bppPARGB, &data) != Ok) {
+        delete sheet;
+        return false;
+    }
+
+    atlas.themePath = themePath;
+    atlas.scale = scale;
+    atlas.cell = SPRITE_SIZE * scale;
+    atlas.stride = 2 * atlas.cell;
+    atlas.pixels.assign((size_t)atlas.stride * MAX_STATE * atlas.cell, 0);
+    // Nearest-neighbour upscale, same as the InterpolationModeNearestNeighbor
+    // draw it replaces.
+    for (int y = 0; y < srcH * scale; y++) {
+        const uint32_t* src = (const uint32_t*)((const BYTE*)data.Scan0 + (size_t)(y / scale) * data.Stride);
+        uint32_t* dst = atlas.pixels.data() + (size_t)y * atlas.stride;
+        for (int x = 0; x < srcW * scale; x++) dst[x] = src[x / scale];
+    }
+    sheet->UnlockBits(&data);
+    delete sheet;
+    return true;
+}
+
+// Returns the shared atlas for a theme folder at the current scale, loading it
+// on first use. Falls back to the default neko-cat sheet like LoadSprites did.
+SpriteAtlas* GetSpriteAtlas(const std::wstring& themePath) {
+    for (SpriteAtlas* atlas : g_atlases) {
+        if (atlas->requestedPath == themePath && atlas->scale == g_scale) return atlas;
+    }
+
+    SpriteAtlas* atlas = new SpriteAtlas();
+    if (!DecodeSpritesheet(themePath, g_scale, *atlas)) {
+        Wh_Log(L"Error loading spritesheet: %s\\spritesheet.png. Falling back to default neko-cat.", themePath.c_str());
+        std::wstring fallbackPath = g_storagePath + L"\\neko-cat";
+        if (!DecodeSpritesheet(fallbackPath, g_scale, *atlas)) {
+            Wh_Log(L"Critical: Fallback spritesheet failed to load: %s\\spritesheet.png", fallbackPath.c_str());
+            delete atlas;
+            return nullptr;
+        }
+    }
+    atlas->requestedPath = themePath;
+    g_atlases.push_back(atlas);
+    Wh_Log(L"Loaded sprite atlas %s (%dx%d)", atlas->themePath.c_str(), atlas->stride, MAX_STATE * atlas->cell);
+    return atlas;
+}
+
+// ─────────────────────────────────────────────
+//  Shared overlay renderer
+// ─────────────────────────────────────────────
+// With "Single Overlay Renderer" on, pets are composited into one click-through
+// layered window per monitor. Each pet keeps its own window, but only as an
+// invisible (alpha 1) input target for clicks, drags and the context menu, so
+// moving it is a plain SetWindowPos without a surface upload. A frame re-uploads
+// just the bounding box of what changed on each monitor.
+struct PetOverlay {
+    HWND hwnd = NULL;
+    RECT rc = {};             // monitor rect, screen coordinates
+    HDC hdc = NULL;
+    HBITMAP hbm = NULL;
+    HBITMAP hbmOld = NULL;
+    uint32_t* bits = nullptr;
+    int width = 0, height = 0;
+    RECT dirty = {};          // screen coordinates, empty if clean
+};
+
+std::vector<PetOverlay> g_petOverlays;
+bool g_petOverlaysStale = false;
+
+LRESULT CALLBACK PetOverlayWndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
+    if (msg == WM_DISPLAYCHANGE || (msg == WM_SETTINGCHANGE && wp == SPI_SETWORKAREA)) {
+        g_petOverlaysStale = true;
+    }
+    return DefWindowProc(hwnd, msg, wp, lp);
+}
+
+static BOOL CALLBACK AddPetOverlayForMonitor(HMONITOR hMon, HDC, LPRECT, LPARAM) {
+    MONITORINFO mi = { sizeof(mi) };
+    if (!GetMonitorInfo(hMon, &mi)) return TRUE;
+
+    PetOverlay ov;
+    ov.rc = mi.rcMonitor;
+    ov.width = mi.rcMonitor.right - mi.rcMonitor.left;
+    ov.height = mi.rcMonitor.bottom - mi.rcMonitor.top;
+
+    HDC hdcScreen = GetDC(NULL);
+    BITMAPINFO bi = {};
+    bi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bi.bmiHeader.biWidth = ov.width;
+    bi.bmiHeader.biHeight = -ov.height;
+    bi.bmiHeader.biPlanes = 1;
+    bi.bmiHeader.biBitCount = 32;
+    bi.bmiHeader.biCompression = BI_RGB;
+    ov.hdc = CreateCompatibleDC(hdcScreen);
+    ov.hbm = CreateDIBSection(ov.hdc, &bi, DIB_RGB_COLORS, (void**)&ov.bits, NULL, 0);
+    if (!ov.hbm) {
+        DeleteDC(ov.hdc);
+        ReleaseDC(NULL, hdcScreen);
+        return TRUE;
+    }
+    ov.hbmOld = (HBITMAP)SelectObject(ov.hdc, ov.hbm);
+
+    ov.hwnd = CreateWindowExW(
+        WS_EX_LAYERED | WS_EX_TRANSPARENT | WS_EX_TOOLWINDOW | WS_EX_TOPMOST | WS_EX_NOACTIVATE,
+        L"NekoCatOverlayWnd", L"Neko Overlay", WS_POPUP,
+        ov.rc.left, ov.rc.top, ov.width, ov.height,
+        NULL, NULL, GetModuleHandle(NULL), NULL);
+
+    // The first upload has to cover the whole surface; later ones pass a dirty rect.
+    POINT ptSrc = { 0, 0 };
+    POINT ptDest = { ov.rc.left, ov.rc.top };
+    SIZE size = { ov.width, ov.height };
+    BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
+    UpdateLayeredWindow(ov.hwnd, hdcScreen, &ptDest, &size, ov.hdc, &ptSrc, 0, &blend, ULW_ALPHA);
+    ReleaseDC(NULL, hdcScreen);
+
+    if (!g_isHidden) ShowWindow(ov.hwnd, SW_SHOWNA);
+    g_petOverlays.push_back(ov);
+    return TRUE;
+}
+
+void CreatePetOverlays() {
+    WNDCLASSW wc = {};
+    wc.lpfnWndProc = PetOverlayWndProc;
+    wc.hInstance = GetModuleHandle(NULL);
+    wc.lpszClassName = L"NekoCatOverlayWnd";
+    RegisterClassW(&wc);
+
+    EnumDisplayMonitors(NULL, NULL, AddPetOverlayForMonitor, 0);
+    g_petOverlaysStale = false;
+    Wh_Log(L"Created %d pet overlay(s)", (int)g_petOverlays.size());
+}
+
+void DestroyPetOverlays() {
+    for (auto& ov : g_petOverlays) {
+        if (ov.hwnd) DestroyWindow(ov.hwnd);
+        SelectObject(ov.hdc, ov.hbmOld);
+        DeleteObject(ov.hbm);
+        DeleteDC(ov.hdc);
+    }
+    g_petOverlays.clear();
+}
+
+// Queues a screen rect for re-composition on every overlay it touches.
+void MarkOverlayDirty(const RECT& r) {
+    for (auto& ov : g_petOverlays) {
+        RECT clip;
+        if (!IntersectRect(&clip, &r, &ov.rc)) continue;
+        if (IsRectEmpty(&ov.dirty)) ov.dirty = clip;
+        else UnionRect(&ov.dirty, &ov.dirty, &clip);
+    }
+}
+
+// Premultiplied "over" of one atlas cell onto an overlay, clipped to clipRect
+// (screen coordinates).
+static void BlendCellIntoOverlay(PetOverlay& ov, const SpriteAtlas* atlas, int state, int frame,
+                                 int destX, int destY, const RECT& clipRect) {
+    RECT cellRect = { destX, destY, destX + atlas->cell, destY + atlas->cell };
+    RECT r;
+    if (!IntersectRect(&r, &cellRect, &clipRect)) return;
+
+    const uint32_t* cell = atlas->Cell(state, frame);
+    for (int y = r.top; y < r.bottom; y++) {
+        const uint32_t* src = cell + (size_t)(y - destY) * atlas->stride + (r.left - destX);
+        uint32_t* dst = ov.bits + (size_t)(y - ov.rc.top) * ov.width + (r.left - ov.rc.left);
+        for (int x = 0; x < r.right - r.left; x++) {
+            uint32_t s = src[x];
+            uint32_t a = s >> 24;
+            if (a == 255) {
+                dst[x] = s;
+            } else if (a != 0) {
+                uint32_t d = dst[x];
+                uint32_t inv = 255 - a;
+                uint32_t rb = ((d & 0x00FF00FF) * inv + 0x00800080) >> 8 & 0x00FF00FF;
+                uint32_t ag = ((d >> 8 & 0x00FF00FF) * inv + 0x00800080) & 0xFF00FF00;
+                dst[x] = s + (rb | ag);
+            }
+        }
+    }
+}
+
 class Neko {
 public:
     HWND hwnd = NULL;
-    Bitmap* sprites[MAX_STATE][2] = {};
+    SpriteAtlas* atlas = nullptr;
     std::wstring assetPath;
 
     // ==========================================
@@ -492,46 +782,14 @@ public:
         }
     }
 
-    // Slices spritesheet PNG into animation frames
+    // Picks up the shared sprite atlas for this pet's theme and scale
     void LoadSprites() {
-        // Free existing sprites if any (prevents memory leak on theme switch)
-        for (int i = 0; i < MAX_STATE; i++) {
-            for (int f = 0; f < 2; f++) {
-                if (sprites[i][f]) {
-                    delete sprites[i][f];
-                    sprites[i][f] = nullptr;
-                }
-            }
+        std::wstring requested = assetPath;
+        atlas = GetSpriteAtlas(requested);
+        if (atlas && atlas->themePath != requested) {
+            assetPath = atlas->themePath; // fell back to neko-cat, sounds included
         }
-
-        std::wstring path = assetPath + L"\\spritesheet.png";
-        Bitmap* sheet = Bitmap::FromFile(path.c_str());
-        if (!sheet || sheet->GetLastStatus() != Ok) {
-            Wh_Log(L"Error loading spritesheet: %s. Falling back to default neko-cat.", path.c_str());
-            if (sheet) delete sheet;
-            
-            // Fallback to default neko-cat
-            std::wstring fallbackPath = g_storagePath + L"\\neko-cat\\spritesheet.png";
-            sheet = Bitmap::FromFile(fallbackPath.c_str());
-            if (!sheet || sheet->GetLastStatus() != Ok) {
-                Wh_Log(L"Critical: Fallback spritesheet failed to load: %s", fallbackPath.c_str());
-                if (sheet) delete sheet;
-                return;
-            }
-            assetPath = g_storagePath + L"\\neko-cat";
-        }
-
-        for (int i = 0; i < MAX_STATE; i++) {
-            for (int f = 0; f < 2; f++) {
-                int srcX = f * SPRITE_SIZE;
-                int srcY = i * SPRITE_SIZE;
-                sprites[i][f] = sheet->Clone(srcX, srcY, SPRITE_SIZE, SPRITE_SIZE, PixelFormat32bppARGB);
-                if (!sprites[i][f] || sprites[i][f]->GetLastStatus() != Ok) {
-                    Wh_Log(L"Error cloning sprite frame %d for state %d", f, i);
-                }
-            }
-        }
-        delete sheet;
+        lastUpdateState = MAX_STATE; // force a redraw with the new sprites
     }
 
     // Plays an audio file from the theme's sounds folder
@@ -641,6 +899,15 @@ public:
         oldTargetX = x; oldTargetY = y;
         
         LoadSprites();
+        CreatePetWindow();
+    }
+
+    // (Re)creates the pet's window for the active renderer: a per-pixel-alpha
+    // layered window that shows the sprite, or, with the shared overlay, an
+    // invisible input target the overlay draws under.
+    void CreatePetWindow() {
+        if (hwnd) DestroyWindow(hwnd);
+        windowIsProxy = g_sharedOverlay;
 
         WNDCLASSW wc = {};
         wc.lpfnWndProc = NekoWndProc;
@@ -653,11 +920,15 @@ public:
             WS_EX_LAYERED | WS_EX_TOOLWINDOW | WS_EX_TOPMOST,
             L"NekoCatLayeredWnd", L"Neko Cat",
             WS_POPUP,
-            0, 0, SPRITE_SIZE * g_scale, SPRITE_SIZE * g_scale,
+            (int)round(x), (int)round(y), SPRITE_SIZE * g_scale, SPRITE_SIZE * g_scale,
             NULL, NULL, wc.hInstance, NULL
         );
         SetWindowLongPtr(hwnd, GWLP_USERDATA, (LONG_PTR)this);
-        ShowWindow(hwnd, SW_SHOWNA);
+        // Alpha 1 rather than 0: a fully transparent layered window would let
+        // clicks fall through.
+        if (windowIsProxy) SetLayeredWindowAttributes(hwnd, 0, 1, LWA_ALPHA);
+        if (!g_isHidden) ShowWindow(hwnd, SW_SHOWNA);
+        lastUpdateState = MAX_STATE;
     }
 
     // Window procedure handling clicks, drags, and context menus
@@ -780,8 +1051,9 @@ public:
     // --- MAIN LOOP & RENDERING ---
     // ==========================================
 
-    // High FPS render loop: interpolates position and resolves collisions
-    void Update() {
+    // High FPS render loop: interpolates position and resolves collisions.
+    // ticksThisFrame is the share of a 5 Hz logic tick one timer period covers.
+    void Update(double ticksThisFrame) {
         POINT pt;
         GetCursorPos(&pt);
         if (pt.x != mouseX || pt.y != mouseY) {
@@ -801,11 +1073,12 @@ public:
             y = rect.top;
             logicX = x; logicY = y;
             prevLogicX = x; prevLogicY = y;
+            // The system moves the proxy; the overlay has to follow it.
+            if (windowIsProxy) UpdateWindowPosition();
             return;
         }
 
-        double originalFPS = 5.0;
-        tickAccumulator += originalFPS / (double)g_fps;
+        tickAccumulator += ticksThisFrame;
 
         while (tickAccumulator >= 1.0) {
             tickAccumulator -= 1.0;
@@ -823,6 +1096,14 @@ public:
         UpdateWindowPosition();
     }
 
+    // True while nothing about the pet changes between logic ticks: not moving
+    // or falling, not being dragged, and interpolation has caught up. The frame
+    // timer drops to the logic rate while every pet is settled.
+    bool IsSettled() const {
+        bool isMoving = (state >= U_MOVE && state <= DR_MOVE) || state == FALL;
+        return !isMoving && !isDragging && logicX == prevLogicX && logicY == prevLogicY;
+    }
+
     // Resolves physics collisions when the character bumps into the active window
     // while in PLAY_WITH_WINDOW or EXHAUSTED_SLEEP modes.
     void ResolveWindowCollisions() {
@@ -1527,6 +1808,19 @@ public:
     NekoState lastUpdateState = MAX_STATE;
     int lastUpdateScale = -1;
 
+    // Per-pet window renderer: one DIB reused across frames
+    HDC hdcMem = NULL;
+    HBITMAP hbmDib = NULL, hbmDibOld = NULL;
+    uint32_t* dibBits = nullptr;
+    int dibSize = 0;
+
+    // Shared overlay renderer: what this pet last queued for composition
+    bool windowIsProxy = false;
+    bool drawnValid = false;
+    RECT drawnRect = {};
+    NekoState drawnState = STOP;
+    int drawnFrame = 0;
+
     void UpdateWindowPosition() {
         if (renderLastX == -9999) {
             renderLastX = x;
@@ -1563,34 +1857,56 @@ public:
         lastUpdateState = state;
         lastUpdateScale = g_scale;
 
-        Bitmap* bmp = sprites[state][frameObj];
-        if (!bmp || bmp->GetLastStatus() != Ok) return;
+        if (!atlas || atlas->scale != g_scale) LoadSprites();
+        if (!atlas) return;
+
+        int outSize = atlas->cell;
+        POINT ptDest = { (LONG)round(x), (LONG)round(y) };
+
+        if (windowIsProxy) {
+            // Queue the old and new sprite rects; ComposePetOverlays redraws them.
+            RECT newRect = { ptDest.x, ptDest.y, ptDest.x + outSize, ptDest.y + outSize };
+            if (drawnValid) MarkOverlayDirty(drawnRect);
+            MarkOverlayDirty(newRect);
+            drawnRect = newRect;
+            drawnValid = true;
+            drawnState = state;
+            drawnFrame = frameObj;
+            if (!isDragging) {
+                SetWindowPos(hwnd, NULL, ptDest.x, ptDest.y, outSize, outSize,
+                             SWP_NOZORDER | SWP_NOACTIVATE | SWP_NOREDRAW);
+            }
+            return;
+        }
 
         HDC hdcScreen = GetDC(NULL);
-        HDC hdcMem = CreateCompatibleDC(hdcScreen);
-        int outSize = SPRITE_SIZE * g_scale;
-
-        HBITMAP hbmMem;
-        BITMAPINFO bi = {};
-        bi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-        bi.bmiHeader.biWidth = outSize;
-        bi.bmiHeader.biHeight = -outSize;
-        bi.bmiHeader.biPlanes = 1;
-        bi.bmiHeader.biBitCount = 32;
-        bi.bmiHeader.biCompression = BI_RGB;
-        void* bits;
-        hbmMem = CreateDIBSection(hdcMem, &bi, DIB_RGB_COLORS, &bits, NULL, 0);
-        
-        HBITMAP hbmOld = (HBITMAP)SelectObject(hdcMem, hbmMem);
+        if (!hdcMem || dibSize != outSize) {
+            FreeDib();
+            BITMAPINFO bi = {};
+            bi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+            bi.bmiHeader.biWidth = outSize;
+            bi.bmiHeader.biHeight = -outSize;
+            bi.bmiHeader.biPlanes = 1;
+            bi.bmiHeader.biBitCount = 32;
+            bi.bmiHeader.biCompression = BI_RGB;
+            hdcMem = CreateCompatibleDC(hdcScreen);
+            hbmDib = CreateDIBSection(hdcMem, &bi, DIB_RGB_COLORS, (void**)&dibBits, NULL, 0);
+            if (!hbmDib) {
+                DeleteDC(hdcMem);
+                hdcMem = NULL;
+                ReleaseDC(NULL, hdcScreen);
+                return;
+            }
+            hbmDibOld = (HBITMAP)SelectObject(hdcMem, hbmDib);
+            dibSize = outSize;
+        }
 
-        Graphics g(hdcMem);
-        g.SetInterpolationMode(InterpolationModeNearestNeighbor);
-        g.SetPixelOffsetMode(PixelOffsetModeHalf);
-        g.Clear(Color(0, 0, 0, 0));
-        g.DrawImage(bmp, Rect(0, 0, outSize, outSize), 0, 0, SPRITE_SIZE, SPRITE_SIZE, UnitPixel);
+        const uint32_t* cell = atlas->Cell(state, frameObj);
+        for (int row = 0; row < outSize; row++) {
+            memcpy(dibBits + (size_t)row * outSize, cell + (size_t)row * atlas->stride, outSize * sizeof(uint32_t));
+        }
 
         POINT ptSrc = {0, 0};
-        POINT ptDest = { (LONG)round(x), (LONG)round(y) };
         SIZE winSize = { outSize, outSize };
         BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
 
@@ -1599,26 +1915,129 @@ public:
         // Re-enforce topmost status to prevent disappearing behind other "Topmost" windows
         SetWindowPos(hwnd, HWND_TOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
 
-        SelectObject(hdcMem, hbmOld);
-        DeleteObject(hbmMem);
-        DeleteDC(hdcMem);
         ReleaseDC(NULL, hdcScreen);
     }
 
+    void FreeDib() {
+        if (!hdcMem) return;
+        SelectObject(hdcMem, hbmDibOld);
+        DeleteObject(hbmDib);
+        DeleteDC(hdcMem);
+        hdcMem = NULL;
+        hbmDib = NULL;
+        dibBits = nullptr;
+        dibSize = 0;
+    }
+
     ~Neko() {
         if (hwnd) DestroyWindow(hwnd);
-        for (int i = 0; i < MAX_STATE; i++) {
-            for (int f = 0; f < 2; f++) {
-                if (sprites[i][f]) delete sprites[i][f];
-            }
-        }
+        FreeDib();
+        if (drawnValid) MarkOverlayDirty(drawnRect);
     }
 };
 
 std::vector<Neko*> g_Nekos;
 
+// Frame timer state. While every pet is settled the timer runs at the 5 Hz
+// logic rate instead of the FPS setting, and it is killed while pets are hidden.
+UINT_PTR g_frameTimerId = 0;
+bool g_frameTimerIdle = false;
+ULONGLONG g_lastTopmostTime = 0;
+
+void CALLBACK UpdateAllCatsTimer(HWND hwnd, UINT uMsg, UINT_PTR idEvent, DWORD dwTime);
+
+void ScheduleFrameTimer(bool idle) {
+    UINT intervalMs = idle ? 1000 / 5 : 1000 / (g_fps > 0 ? g_fps : 60);
+    g_frameTimerId = SetTimer(NULL, g_frameTimerId, intervalMs, UpdateAllCatsTimer);
+    g_frameTimerIdle = idle;
+}
+
+void StopFrameTimer() {
+    if (g_frameTimerId) KillTimer(NULL, g_frameTimerId);
+    g_frameTimerId = 0;
+}
+
+// Redraws the dirty part of each overlay: clear it, composite every pet that
+// overlaps it in spawn order, then upload only that rect.
+void ComposePetOverlays() {
+    HDC hdcScreen = NULL;
+    for (auto& ov : g_petOverlays) {
+        if (IsRectEmpty(&ov.dirty)) continue;
+        RECT d = ov.dirty;
+        ov.dirty = {};
+
+        for (int yy = d.top; yy < d.bottom; yy++) {
+            memset(ov.bits + (size_t)(yy - ov.rc.top) * ov.width + (d.left - ov.rc.left), 0,
+                   (size_t)(d.right - d.left) * sizeof(uint32_t));
+        }
+        for (auto pNeko : g_Nekos) {
+            if (!pNeko->drawnValid || !pNeko->atlas) continue;
+            BlendCellIntoOverlay(ov, pNeko->atlas, pNeko->drawnState, pNeko->drawnFrame,
+                                 pNeko->drawnRect.left, pNeko->drawnRect.top, d);
+        }
+
+        if (!hdcScreen) hdcScreen = GetDC(NULL);
+        POINT ptSrc = { 0, 0 };
+        POINT ptDest = { ov.rc.left, ov.rc.top };
+        SIZE size = { ov.width, ov.height };
+        RECT dirtyLocal = { d.left - ov.rc.left, d.top - ov.rc.top, d.right - ov.rc.left, d.bottom - ov.rc.top };
+        BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
+        UPDATELAYEREDWINDOWINFO info = { sizeof(info) };
+        info.hdcDst = hdcScreen;
+        info.pptDst = &ptDest;
+        info.psize = &size;
+        info.hdcSrc = ov.hdc;
+        info.pptSrc = &ptSrc;
+        info.pblend = &blend;
+        info.dwFlags = ULW_ALPHA;
+        info.prcDirty = &dirtyLocal;
+        UpdateLayeredWindowIndirect(ov.hwnd, &info);
+    }
+    if (hdcScreen) ReleaseDC(NULL, hdcScreen);
+}
+
+// Switches every pet and the overlays to the renderer chosen in the settings.
+void ApplyRendererMode() {
+    if (g_sharedOverlay && (g_petOverlays.empty() || g_petOverlaysStale)) {
+        DestroyPetOverlays();
+        CreatePetOverlays();
+        for (auto pNeko : g_Nekos) {
+            pNeko->drawnValid = false;
+            pNeko->lastUpdateState = MAX_STATE;
+        }
+    } else if (!g_sharedOverlay && !g_petOverlays.empty()) {
+        DestroyPetOverlays();
+    }
+    for (auto pNeko : g_Nekos) {
+        if (pNeko->windowIsProxy != g_sharedOverlay) {
+            pNeko->drawnValid = false;
+            pNeko->FreeDib();
+            pNeko->CreatePetWindow();
+        }
+    }
+    if (!g_Nekos.empty()) g_hwndOverlay = g_Nekos[0]->hwnd;
+}
+
+// Drops atlases no pet uses any more (theme or scale changed).
+void ReleaseUnusedAtlases() {
+    for (size_t i = 0; i < g_atlases.size();) {
+        SpriteAtlas* atlas = g_atlases[i];
+        bool used = false;
+        for (auto pNeko : g_Nekos) {
+            if (pNeko->atlas == atlas) used = true;
+        }
+        if (used) {
+            i++;
+        } else {
+            delete atlas;
+            g_atlases.erase(g_atlases.begin() + i);
+        }
+    }
+}
+
 void CALLBACK UpdateAllCatsTimer(HWND hwnd, UINT uMsg, UINT_PTR idEvent, DWORD dwTime) {
     if (g_isHidden || g_modExit) return;
+    if (g_sharedOverlay && g_petOverlaysStale) ApplyRendererMode();
     for (size_t i = 0; i < g_Nekos.size(); i++) {
         for (size_t j = i + 1; j < g_Nekos.size(); j++) {
             Neko* a = g_Nekos[i];
@@ -1637,9 +2056,30 @@ void CALLBACK UpdateAllCatsTimer(HWND hwnd, UINT uMsg, UINT_PTR idEvent, DWORD d
             }
         }
     }
+    double ticksThisFrame = g_frameTimerIdle ? 1.0 : 5.0 / (double)(g_fps > 0 ? g_fps : 60);
+    bool allSettled = true;
     for (auto pNeko : g_Nekos) {
-        pNeko->Update();
+        pNeko->Update(ticksThisFrame);
+        if (!pNeko->IsSettled()) allSettled = false;
+    }
+
+    if (g_sharedOverlay) {
+        ComposePetOverlays();
+        // The per-pet renderer re-asserts topmost on every redraw; once a second
+        // is plenty for the overlays and their input windows.
+        ULONGLONG now = GetTickCount64();
+        if (now - g_lastTopmostTime >= 1000) {
+            g_lastTopmostTime = now;
+            for (auto& ov : g_petOverlays) {
+                SetWindowPos(ov.hwnd, HWND_TOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+            }
+            for (auto pNeko : g_Nekos) {
+                SetWindowPos(pNeko->hwnd, HWND_TOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+            }
+        }
     }
+
+    if (allSettled != g_frameTimerIdle) ScheduleFrameTimer(allSettled);
 }
 
 DWORD WINAPI NekoProcessThread(LPVOID param) {
@@ -1649,18 +2089,6 @@ DWORD WINAPI NekoProcessThread(LPVOID param) {
 
     DownloadMissingAssets();
 
-    if (g_randomThemes) {
-        // Ensure all official themes are downloaded so random selection has a pool
-        for (const auto& off : g_officialThemes) {
-            EnsureThemeDownloaded(off);
-        }
-    } else {
-        // Ensure custom pet themes are downloaded
-        for (const auto& pet : g_customPets) {
-            EnsureThemeDownloaded(pet.theme);
-        }
-    }
-
     int targetCount = g_catCount;
 
     for (int i = 0; i < targetCount; ++i) {
@@ -1677,8 +2105,7 @@ DWORD WINAPI NekoProcessThread(LPVOID param) {
     
     // Track the overlay HWND for the tool mod
     if (!g_Nekos.empty()) g_hwndOverlay = g_Nekos[0]->hwnd;
-
-    int intervalMs = 1000 / (g_fps > 0 ? g_fps : 60);
+    ApplyRendererMode();
 
     UINT modifiers = 0;
     UINT vk = 0;
@@ -1705,32 +2132,18 @@ DWORD WINAPI NekoProcessThread(LPVOID param) {
     
     RegisterNekoKey();
 
-    UINT_PTR timerId = SetTimer(NULL, 1, intervalMs, UpdateAllCatsTimer);
+    ScheduleFrameTimer(false);
 
     MSG msg;
     while (!g_modExit && GetMessage(&msg, NULL, 0, 0) > 0) {
         if (msg.message == WM_UPDATE_SETTINGS) {
             LoadSettings();
             
-            intervalMs = 1000 / (g_fps > 0 ? g_fps : 60);
-            KillTimer(NULL, timerId);
-            timerId = SetTimer(NULL, 1, intervalMs, UpdateAllCatsTimer);
+            if (!g_isHidden) ScheduleFrameTimer(false);
             RegisterNekoKey();
             
-            // Ensure main theme is downloaded
+            // Ensure the default and all selectable themes are downloaded
             DownloadMissingAssets();
-            
-            if (g_randomThemes) {
-                // Ensure all official themes are downloaded
-                for (const auto& off : g_officialThemes) {
-                    EnsureThemeDownloaded(off);
-                }
-            } else {
-                // Ensure any custom selected themes in the pet list are downloaded
-                for (const auto& pet : g_customPets) {
-                    EnsureThemeDownloaded(pet.theme);
-                }
-            }
 
             int currentTargetCount = g_catCount;
 
@@ -1770,9 +2183,11 @@ DWORD WINAPI NekoProcessThread(LPVOID param) {
                 g_Nekos[i]->virtualY = GetSystemMetrics(SM_YVIRTUALSCREEN);
                 g_Nekos[i]->boundsWidth = GetSystemMetrics(SM_CXVIRTUALSCREEN) - SPRITE_SIZE * g_scale;
                 g_Nekos[i]->boundsHeight = GetSystemMetrics(SM_CYVIRTUALSCREEN) - SPRITE_SIZE * g_scale;
+                if (g_Nekos[i]->atlas && g_Nekos[i]->atlas->scale != g_scale) g_Nekos[i]->LoadSprites();
             }
             
-            if (!g_Nekos.empty()) g_hwndOverlay = g_Nekos[0]->hwnd;
+            ApplyRendererMode();
+            ReleaseUnusedAtlases();
         } else if (msg.message == WM_HOTKEY && msg.wParam == 1) {
             g_isHidden = !g_isHidden;
             for (auto pNeko : g_Nekos) {
@@ -1783,13 +2198,19 @@ DWORD WINAPI NekoProcessThread(LPVOID param) {
                     pNeko->hasMouseMoved = false;
                 }
             }
+            for (auto& ov : g_petOverlays) {
+                ShowWindow(ov.hwnd, g_isHidden ? SW_HIDE : SW_SHOWNA);
+            }
+            // Nothing to animate while hidden: no timer at all until unhidden.
+            if (g_isHidden) StopFrameTimer();
+            else ScheduleFrameTimer(false);
             Wh_Log(L"Pet Key toggled. IsHidden: %d", g_isHidden);
         }
         TranslateMessage(&msg);
         DispatchMessage(&msg);
     }
     
-    if (timerId) KillTimer(NULL, timerId);
+    StopFrameTimer();
     
     if (hotkeyRegistered) {
         UnregisterHotKey(NULL, 1);
@@ -1800,6 +2221,8 @@ DWORD WINAPI NekoProcessThread(LPVOID param) {
         delete pNeko;
     }
     g_Nekos.clear();
+    DestroyPetOverlays();
+    ReleaseUnusedAtlases();
 
     GdiplusShutdown(gdiplusToken);
     return 0;
@@ -1824,6 +2247,7 @@ void LoadSettings() {
     g_fps = Wh_GetIntSetting(L"BehaviorGroup.fps");
     g_catCount = Wh_GetIntSetting(L"AppearanceGroup.character_count");
     if (g_catCount < 1) g_catCount = 1;
+    g_sharedOverlay = Wh_GetIntSetting(L"AdvancedGroup.shared_overlay") != 0;
 
     g_customPets.clear();
     for (int i = 0; i < 100; i++) {
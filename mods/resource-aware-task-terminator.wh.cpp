@@ -2,12 +2,12 @@
 // @id              resource-aware-task-terminator
 // @name            Resource-Aware Task Terminator
 // @description     Terminate the active window process, a top resource offender, or a weighted resource-heavy app group with verified process identity and sortable usage metrics.
-// @version         1.0.1
+// @version         1.0.2
 // @author          Math Shamenson
 // @github          https://github.com/insane66613
 // @license         MIT
 // @include         windhawk.exe
-// @compilerOptions -lpsapi -lgdi32 -lcomctl32 -lshell32
+// @compilerOptions -lpsapi -lgdi32 -lcomctl32 -lshell32 -lntdll
 // ==/WindhawkMod==
 
 // ==WindhawkModReadme==
@@ -52,6 +52,12 @@ Yes/No warning; it does not bypass the chooser.
   It terminates only the PIDs displayed and confirmed; newly spawned processes are not added
   silently.
 
+By default, each hotkey press samples all processes twice, a sample window apart. With
+**Sample in the background** enabled, the mod instead records one system-wide snapshot per
+second and compares a fresh snapshot with the recorded one closest to the sample window, so
+candidates are shown right away. Identity is still verified with a process handle before
+termination. Until enough history is recorded, the regular sampling is used.
+
 ## Permissions
 
 Processes that cannot be queried are treated as protected and omitted. Terminating elevated
@@ -90,6 +96,9 @@ how many processes could not be inspected, and the result dialog reports per-PID
 - sample_ms: 3000
   $name: Sample window (milliseconds)
   $description: Allowed range 500 through 15000.
+- background_sampling: false
+  $name: Sample in the background
+  $description: Keep a low-rate history of process activity, one system snapshot per second, so that resource modes rank candidates as soon as the hotkey is pressed instead of waiting for the sample window.
 - candidate_count: 5
   $name: Candidate count
   $description: Number of ranked targets shown, from 1 through 10.
@@ -141,6 +150,7 @@ how many processes could not be inspected, and the result dialog reports per-PID
 #include <psapi.h>
 #include <shellapi.h>
 #include <tlhelp32.h>
+#include <winternl.h>
 
 #define HOTKEY_ID 1
 #define WM_RELOAD_HOTKEY (WM_APP + 1)
@@ -173,6 +183,7 @@ enum class KillMode {
 
 KillMode g_killMode = KillMode::Foreground;
 DWORD g_sampleMs = 3000;
+bool g_backgroundSampling = false;
 int g_candidateCount = 5;
 bool g_liveUpdateDefault = false;
 DWORD g_livePollMs = 5000;
@@ -358,6 +369,8 @@ static void LoadSettings() {
         ? static_cast<DWORD>(sampleMs)
         : 3000;
 
+    g_backgroundSampling = Wh_GetIntSetting(L"background_sampling") != 0;
+
     int candidateCount = Wh_GetIntSetting(L"candidate_count");
     g_candidateCount = candidateCount >= 1 && candidateCount <= 10
         ? candidateCount
@@ -744,6 +757,394 @@ static SamplePair CaptureSamplePair(DWORD sampleMs, HANDLE cancelEvent) {
     return result;
 }
 
+// ------------------------ Background sampling ------------------------
+
+// The documented SYSTEM_PROCESS_INFORMATION hides the fields used here behind
+// reserved members, so the full layout is declared locally.
+struct SystemProcessInformationEntry {
+    ULONG NextEntryOffset;
+    ULONG NumberOfThreads;
+    LARGE_INTEGER WorkingSetPrivateSize;
+    ULONG HardFaultCount;
+    ULONG NumberOfThreadsHighWatermark;
+    ULONGLONG CycleTime;
+    LARGE_INTEGER CreateTime;
+    LARGE_INTEGER UserTime;
+    LARGE_INTEGER KernelTime;
+    UNICODE_STRING ImageName;
+    LONG BasePriority;
+    HANDLE UniqueProcessId;
+    HANDLE InheritedFromUniqueProcessId;
+    ULONG HandleCount;
+    ULONG SessionId;
+    ULONG_PTR UniqueProcessKey;
+    SIZE_T PeakVirtualSize;
+    SIZE_T VirtualSize;
+    ULONG PageFaultCount;
+    SIZE_T PeakWorkingSetSize;
+    SIZE_T WorkingSetSize;
+    SIZE_T QuotaPeakPagedPoolUsage;
+    SIZE_T QuotaPagedPoolUsage;
+    SIZE_T QuotaPeakNonPagedPoolUsage;
+    SIZE_T QuotaNonPagedPoolUsage;
+    SIZE_T PagefileUsage;
+    SIZE_T PeakPagefileUsage;
+    SIZE_T PrivatePageCount;
+    LARGE_INTEGER ReadOperationCount;
+    LARGE_INTEGER WriteOperationCount;
+    LARGE_INTEGER OtherOperationCount;
+    LARGE_INTEGER ReadTransferCount;
+    LARGE_INTEGER WriteTransferCount;
+    LARGE_INTEGER OtherTransferCount;
+};
+
+constexpr DWORD kBackgroundTickMs = 1000;
+// Covers the longest sample window plus the tick taken when a hotkey fires.
+constexpr size_t kBackgroundHistoryTicks = 15000 / kBackgroundTickMs + 2;
+
+static bool QuerySystemProcesses(std::vector<BYTE>& buffer) {
+    if (buffer.empty()) {
+        buffer.resize(256 * 1024);
+    }
+
+    for (int attempt = 0; attempt < 5; attempt++) {
+        ULONG needed = 0;
+        NTSTATUS status = NtQuerySystemInformation(
+            static_cast<SYSTEM_INFORMATION_CLASS>(5),  // SystemProcessInformation
+            buffer.data(), static_cast<ULONG>(buffer.size()), &needed);
+        if (NT_SUCCESS(status)) {
+            return true;
+        }
+        if (status != static_cast<NTSTATUS>(0xC0000004L)) {  // Length mismatch
+            Wh_Log(L"NtQuerySystemInformation failed (status=0x%08lX).",
+                   static_cast<unsigned long>(status));
+            return false;
+        }
+
+        // Processes may be created between the calls, so leave some slack.
+        buffer.resize(std::max<size_t>(needed, buffer.size()) + 64 * 1024);
+    }
+
+    return false;
+}
+
+// Per-process counters from the recent background ticks, keyed by PID and
+// reused across ticks. The full path, which needs a process handle, is only
+// resolved once per process instance, so a tick costs a single system call.
+class ProcessHistory {
+public:
+    bool Tick();
+    bool BuildSamplePair(DWORD sampleMs, SamplePair& sample);
+
+private:
+    struct Counters {
+        ULONGLONG cpuKernel100ns{};
+        ULONGLONG cpuUser100ns{};
+        ULONGLONG ioReadBytes{};
+        ULONGLONG ioWriteBytes{};
+        SIZE_T workingSetBytes{};
+        DWORD pageFaultCount{};
+    };
+
+    enum class PathState {
+        Unresolved,
+        Resolved,
+        Inaccessible,
+        IdentityFailure,
+    };
+
+    struct TrackedProcess {
+        ProcessIdentity identity;
+        PathState pathState = PathState::Unresolved;
+        ULONGLONG firstTick{};
+        ULONGLONG lastTick{};
+        Counters history[kBackgroundHistoryTicks];
+    };
+
+    struct TickInfo {
+        ULONGLONG timestampMs{};
+        ULONGLONG systemCpu100ns{};
+        bool systemCpuValid{};
+        size_t enumerated{};
+    };
+
+    static void ResolvePath(TrackedProcess& process);
+
+    std::vector<BYTE> m_buffer;
+    std::unordered_map<DWORD, TrackedProcess> m_processes;
+    TickInfo m_ticks[kBackgroundHistoryTicks];
+    ULONGLONG m_tickCount{};
+};
+
+void ProcessHistory::ResolvePath(TrackedProcess& process) {
+    HANDLE handle = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE,
+                                process.identity.pid);
+    if (!handle) {
+        process.pathState = PathState::Inaccessible;
+        return;
+    }
+
+    if (QueryProcessPathFromHandle(handle, process.identity.processPath)) {
+        process.identity.exeName = ExeNameFromPath(process.identity.processPath);
+        process.pathState = PathState::Resolved;
+    } else {
+        process.pathState = PathState::IdentityFailure;
+    }
+    CloseHandle(handle);
+}
+
+bool ProcessHistory::Tick() {
+    if (!QuerySystemProcesses(m_buffer)) {
+        return false;
+    }
+
+    ULONGLONG tick = m_tickCount;
+    size_t slot = static_cast<size_t>(tick % kBackgroundHistoryTicks);
+
+    TickInfo& tickInfo = m_ticks[slot];
+    tickInfo = TickInfo{};
+    tickInfo.timestampMs = GetTickCount64();
+    FILETIME idle{}, kernel{}, user{};
+    if (GetSystemTimes(&idle, &kernel, &user)) {
+        tickInfo.systemCpu100ns =
+            FileTimeToUInt64(kernel) + FileTimeToUInt64(user);
+        tickInfo.systemCpuValid = true;
+    }
+
+    DWORD currentPid = GetCurrentProcessId();
+    const BYTE* cursor = m_buffer.data();
+    while (true) {
+        const auto* entry =
+            reinterpret_cast<const SystemProcessInformationEntry*>(cursor);
+        DWORD pid = static_cast<DWORD>(
+            reinterpret_cast<ULONG_PTR>(entry->UniqueProcessId));
+        tickInfo.enumerated++;
+
+        if (pid > 4 && pid != currentPid) {
+            ULONGLONG creationTime =
+                static_cast<ULONGLONG>(entry->CreateTime.QuadPart);
+            auto [it, inserted] = m_processes.try_emplace(pid);
+            TrackedProcess& process = it->second;
+            if (inserted || process.identity.creationTime100ns != creationTime) {
+                process = TrackedProcess{};
+                process.identity.pid = pid;
+                process.identity.creationTime100ns = creationTime;
+                process.identity.exeName.assign(
+                    entry->ImageName.Buffer,
+                    entry->ImageName.Length / sizeof(WCHAR));
+                process.firstTick = tick;
+
+                // Like the one-shot sampler, don't even open processes that
+                // are protected by name.
+                if (!IsProtectedName(process.identity.exeName)) {
+                    ResolvePath(process);
+                }
+            }
+
+            process.lastTick = tick;
+            Counters& counters = process.history[slot];
+            counters.cpuKernel100ns =
+                static_cast<ULONGLONG>(entry->KernelTime.QuadPart);
+            counters.cpuUser100ns =
+                static_cast<ULONGLONG>(entry->UserTime.QuadPart);
+            counters.ioReadBytes =
+                static_cast<ULONGLONG>(entry->ReadTransferCount.QuadPart);
+            counters.ioWriteBytes =
+                static_cast<ULONGLONG>(entry->WriteTransferCount.QuadPart);
+            counters.workingSetBytes = entry->WorkingSetSize;
+            counters.pageFaultCount = entry->PageFaultCount;
+        }
+
+        if (!entry->NextEntryOffset) {
+            break;
+        }
+        cursor += entry->NextEntryOffset;
+    }
+
+    for (auto it = m_processes.begin(); it != m_processes.end();) {
+        if (it->second.lastTick != tick) {
+            it = m_processes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    m_tickCount++;
+    return true;
+}
+
+// Takes a fresh tick and pairs it with the recorded tick that is closest to
+// `sampleMs` earlier. Returns false if no recorded tick is close enough, e.g.
+// right after the sampler started.
+bool ProcessHistory::BuildSamplePair(DWORD sampleMs, SamplePair& sample) {
+    if (!Tick()) {
+        return false;
+    }
+
+    ULONGLONG afterTick = m_tickCount - 1;
+    const TickInfo& after = m_ticks[afterTick % kBackgroundHistoryTicks];
+
+    ULONGLONG oldestTick = m_tickCount > kBackgroundHistoryTicks
+        ? m_tickCount - kBackgroundHistoryTicks
+        : 0;
+    ULONGLONG beforeTick = afterTick;
+    ULONGLONG bestDistance = kBackgroundTickMs + 1;
+    for (ULONGLONG tick = oldestTick; tick < afterTick; tick++) {
+        ULONGLONG elapsed =
+            after.timestampMs - m_ticks[tick % kBackgroundHistoryTicks].timestampMs;
+        ULONGLONG distance = elapsed > sampleMs ? elapsed - sampleMs
+                                                : sampleMs - elapsed;
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            beforeTick = tick;
+        }
+    }
+    if (beforeTick == afterTick) {
+        return false;
+    }
+
+    const TickInfo& before = m_ticks[beforeTick % kBackgroundHistoryTicks];
+    size_t beforeSlot = static_cast<size_t>(beforeTick % kBackgroundHistoryTicks);
+    size_t afterSlot = static_cast<size_t>(afterTick % kBackgroundHistoryTicks);
+
+    sample = SamplePair{};
+    sample.diagnostics.enumerated = after.enumerated;
+    sample.before.reserve(m_processes.size());
+    sample.after.reserve(m_processes.size());
+
+    for (auto& [pid, process] : m_processes) {
+        if (IsProtectedName(process.identity.exeName)) {
+            continue;
+        }
+
+        // The protection list may have changed since the process was seen.
+        if (process.pathState == PathState::Unresolved) {
+            ResolvePath(process);
+            if (process.pathState == PathState::Resolved &&
+                IsProtectedName(process.identity.exeName)) {
+                continue;
+            }
+        }
+
+        if (process.pathState == PathState::Inaccessible) {
+            sample.diagnostics.inaccessible++;
+            continue;
+        }
+        if (process.pathState == PathState::IdentityFailure) {
+            sample.diagnostics.identityFailures++;
+            continue;
+        }
+        if (process.firstTick > beforeTick) {
+            continue;
+        }
+
+        auto toSnapshot = [&process](const Counters& counters) {
+            ProcSnapshot snapshot;
+            snapshot.identity = process.identity;
+            snapshot.cpuValid = true;
+            snapshot.memoryValid = true;
+            snapshot.ioValid = true;
+            snapshot.cpuKernel100ns = counters.cpuKernel100ns;
+            snapshot.cpuUser100ns = counters.cpuUser100ns;
+            snapshot.pageFaultCount = counters.pageFaultCount;
+            snapshot.ioReadBytes = counters.ioReadBytes;
+            snapshot.ioWriteBytes = counters.ioWriteBytes;
+            snapshot.workingSetBytes = counters.workingSetBytes;
+            return snapshot;
+        };
+        sample.before.push_back(toSnapshot(process.history[beforeSlot]));
+        sample.after.push_back(toSnapshot(process.history[afterSlot]));
+    }
+
+    if (before.systemCpuValid && after.systemCpuValid &&
+        after.systemCpu100ns > before.systemCpu100ns) {
+        sample.systemCpuDelta = after.systemCpu100ns - before.systemCpu100ns;
+        sample.systemCpuValid = true;
+    }
+
+    sample.success = true;
+    return true;
+}
+
+std::mutex g_processHistoryMutex;
+std::unique_ptr<ProcessHistory> g_processHistory;
+HANDLE g_hSamplerThread = nullptr;
+HANDLE g_hSamplerStopEvent = nullptr;
+
+static DWORD WINAPI BackgroundSamplerThread(LPVOID) {
+    HANDLE events[] = {g_hStopEvent, g_hSamplerStopEvent};
+    do {
+        std::lock_guard<std::mutex> lock(g_processHistoryMutex);
+        if (g_processHistory) {
+            g_processHistory->Tick();
+        }
+    } while (WaitForMultipleObjects(ARRAYSIZE(events), events, FALSE,
+                                    kBackgroundTickMs) == WAIT_TIMEOUT);
+    return 0;
+}
+
+static void StartBackgroundSampler() {
+    if (g_hSamplerThread) {
+        return;
+    }
+
+    g_hSamplerStopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!g_hSamplerStopEvent) {
+        Wh_Log(L"Failed to create sampler stop event (error=%lu).",
+               GetLastError());
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_processHistoryMutex);
+        g_processHistory = std::make_unique<ProcessHistory>();
+    }
+
+    g_hSamplerThread = CreateThread(nullptr, 0, BackgroundSamplerThread,
+                                    nullptr, 0, nullptr);
+    if (!g_hSamplerThread) {
+        Wh_Log(L"Failed to create sampler thread (error=%lu).", GetLastError());
+        CloseHandle(g_hSamplerStopEvent);
+        g_hSamplerStopEvent = nullptr;
+        std::lock_guard<std::mutex> lock(g_processHistoryMutex);
+        g_processHistory.reset();
+    }
+}
+
+static void StopBackgroundSampler() {
+    if (!g_hSamplerThread) {
+        return;
+    }
+
+    SetEvent(g_hSamplerStopEvent);
+    DWORD wait = WaitForSingleObject(g_hSamplerThread, 5000);
+    if (wait == WAIT_TIMEOUT) {
+        Wh_Log(L"Sampler thread did not exit within shutdown timeout.");
+    }
+    CloseHandle(g_hSamplerThread);
+    g_hSamplerThread = nullptr;
+    CloseHandle(g_hSamplerStopEvent);
+    g_hSamplerStopEvent = nullptr;
+
+    std::lock_guard<std::mutex> lock(g_processHistoryMutex);
+    g_processHistory.reset();
+}
+
+// Uses the background history when it's available, so that the caller
+// doesn't have to wait for the sample window.
+static SamplePair AcquireSamplePair(DWORD sampleMs, HANDLE cancelEvent) {
+    {
+        std::lock_guard<std::mutex> lock(g_processHistoryMutex);
+        SamplePair sample;
+        if (g_processHistory &&
+            g_processHistory->BuildSamplePair(sampleMs, sample)) {
+            return sample;
+        }
+    }
+
+    return CaptureSamplePair(sampleMs, cancelEvent);
+}
+
 static bool SameSnapshotIdentity(const ProcSnapshot& before,
                                  const ProcSnapshot& after) {
     return SameProcessIdentity(before.identity, after.identity);
@@ -841,7 +1242,7 @@ static CandidateBuildResult BuildResourceCandidateDecisions(
     CandidateBuildResult result;
     limit = std::clamp(limit, 1, 10);
 
-    SamplePair sample = CaptureSamplePair(sampleMs, cancelEvent);
+    SamplePair sample = AcquireSamplePair(sampleMs, cancelEvent);
     result.diagnostics = sample.diagnostics;
     result.cancelled = sample.diagnostics.cancelled;
     if (!sample.success || result.cancelled) {
@@ -915,17 +1316,20 @@ static CandidateBuildResult BuildResourceCandidateDecisions(
     return result;
 }
 
-static CandidateBuildResult BuildAggregateSuperScoreCandidates(
-    DWORD sampleMs, int limit, HANDLE cancelEvent = nullptr) {
-    CandidateBuildResult result;
-    limit = std::clamp(limit, 1, 10);
+struct AggregateWeights {
+    int cpu{};
+    int pageFaults{};
+    int io{};
+    int memory{};
+};
 
-    SamplePair sample = CaptureSamplePair(sampleMs, cancelEvent);
-    result.diagnostics = sample.diagnostics;
-    result.cancelled = sample.diagnostics.cancelled;
-    if (!sample.success || result.cancelled) {
-        return result;
-    }
+// Groups the processes of a sample pair by executable path and ranks the groups
+// by the weighted aggregate score. Doesn't touch any global state.
+static std::vector<KillDecision> ScoreAggregateSuperScoreCandidates(
+    const SamplePair& sample, DWORD sampleMs, int limit,
+    AggregateWeights weights) {
+    std::vector<KillDecision> candidates;
+    limit = std::clamp(limit, 1, 10);
 
     std::unordered_map<DWORD, const ProcSnapshot*> beforeByPid;
     beforeByPid.reserve(sample.before.size());
@@ -965,14 +1369,14 @@ static CandidateBuildResult BuildAggregateSuperScoreCandidates(
             group.reason =
                 L"Aggregate mode grouped verified processes by executable path and combined CPU, page-fault, I/O, and memory activity.";
             group.metricName = L"Weighted aggregate score";
-            result.candidates.push_back(std::move(group));
-            groupIndex = result.candidates.size() - 1;
+            candidates.push_back(std::move(group));
+            groupIndex = candidates.size() - 1;
             groupByPath.emplace(std::move(key), groupIndex);
         } else {
             groupIndex = foundGroup->second;
         }
 
-        KillDecision& group = result.candidates[groupIndex];
+        KillDecision& group = candidates[groupIndex];
         group.targetIdentities.push_back(after.identity);
         if (processDecision.cpuValid) {
             group.cpuPercent += processDecision.cpuPercent;
@@ -997,24 +1401,17 @@ static CandidateBuildResult BuildAggregateSuperScoreCandidates(
     double maxFaults = 0.0;
     double maxIo = 0.0;
     double maxMemory = 0.0;
-    for (const auto& group : result.candidates) {
+    for (const auto& group : candidates) {
         maxCpu = std::max(maxCpu, group.cpuPercent);
         maxFaults = std::max(maxFaults, group.pageFaultDelta);
         maxIo = std::max(maxIo, group.ioBytes);
         maxMemory = std::max(maxMemory, group.memoryMb);
     }
 
-    int cpuWeight;
-    int faultWeight;
-    int ioWeight;
-    int memoryWeight;
-    {
-        std::lock_guard<std::mutex> lock(g_settingsMutex);
-        cpuWeight = g_superCpuWeight;
-        faultWeight = g_superPageFaultWeight;
-        ioWeight = g_superIoWeight;
-        memoryWeight = g_superMemoryWeight;
-    }
+    int cpuWeight = weights.cpu;
+    int faultWeight = weights.pageFaults;
+    int ioWeight = weights.io;
+    int memoryWeight = weights.memory;
 
     int totalWeight = 0;
     if (maxCpu > 0.0) totalWeight += cpuWeight;
@@ -1032,11 +1429,11 @@ static CandidateBuildResult BuildAggregateSuperScoreCandidates(
         if (maxMemory > 0.0) totalWeight += memoryWeight;
     }
     if (totalWeight <= 0) {
-        result.candidates.clear();
-        return result;
+        candidates.clear();
+        return candidates;
     }
 
-    for (auto& group : result.candidates) {
+    for (auto& group : candidates) {
         double score = 0.0;
         if (maxCpu > 0.0)
             score += cpuWeight * NormalizeMetric(group.cpuPercent, maxCpu);
@@ -1050,21 +1447,46 @@ static CandidateBuildResult BuildAggregateSuperScoreCandidates(
         group.metricValue = group.superScore;
     }
 
-    result.candidates.erase(
-        std::remove_if(result.candidates.begin(), result.candidates.end(),
+    candidates.erase(
+        std::remove_if(candidates.begin(), candidates.end(),
                        [](const KillDecision& decision) {
                            return decision.targetIdentities.empty() ||
                                   decision.metricValue <= 0.0;
                        }),
-        result.candidates.end());
+        candidates.end());
 
-    std::sort(result.candidates.begin(), result.candidates.end(),
+    std::sort(candidates.begin(), candidates.end(),
               [](const KillDecision& left, const KillDecision& right) {
                   return left.metricValue > right.metricValue;
               });
-    if (static_cast<int>(result.candidates.size()) > limit) {
-        result.candidates.resize(static_cast<size_t>(limit));
+    if (static_cast<int>(candidates.size()) > limit) {
+        candidates.resize(static_cast<size_t>(limit));
     }
+    return candidates;
+}
+
+static CandidateBuildResult BuildAggregateSuperScoreCandidates(
+    DWORD sampleMs, int limit, HANDLE cancelEvent = nullptr) {
+    CandidateBuildResult result;
+
+    SamplePair sample = AcquireSamplePair(sampleMs, cancelEvent);
+    result.diagnostics = sample.diagnostics;
+    result.cancelled = sample.diagnostics.cancelled;
+    if (!sample.success || result.cancelled) {
+        return result;
+    }
+
+    AggregateWeights weights;
+    {
+        std::lock_guard<std::mutex> lock(g_settingsMutex);
+        weights.cpu = g_superCpuWeight;
+        weights.pageFaults = g_superPageFaultWeight;
+        weights.io = g_superIoWeight;
+        weights.memory = g_superMemoryWeight;
+    }
+
+    result.candidates =
+        ScoreAggregateSuperScoreCandidates(sample, sampleMs, limit, weights);
     return result;
 }
 
@@ -2410,6 +2832,10 @@ BOOL WhTool_ModInit() {
         return FALSE;
     }
 
+    if (g_backgroundSampling) {
+        StartBackgroundSampler();
+    }
+
     Wh_Log(L"Tool hotkey host started. PID=%lu thread=%lu.",
            GetCurrentProcessId(), g_dwThreadId);
     return TRUE;
@@ -2470,6 +2896,8 @@ void WhTool_ModUninit() {
         g_dwThreadId = 0;
     }
 
+    StopBackgroundSampler();
+
     if (g_hStopEvent) {
         CloseHandle(g_hStopEvent);
         g_hStopEvent = nullptr;
@@ -2479,6 +2907,18 @@ void WhTool_ModUninit() {
 
 void WhTool_ModSettingsChanged() {
     LoadSettings();
+
+    bool backgroundSampling;
+    {
+        std::lock_guard<std::mutex> lock(g_settingsMutex);
+        backgroundSampling = g_backgroundSampling;
+    }
+    if (backgroundSampling) {
+        StartBackgroundSampler();
+    } else {
+        StopBackgroundSampler();
+    }
+
     if (g_dwThreadId) {
         PostThreadMessageW(g_dwThreadId, WM_RELOAD_HOTKEY, 0, 0);
     }
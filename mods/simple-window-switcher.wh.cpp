@@ -2,7 +2,7 @@
 // @id              simple-window-switcher
 // @name            Simple Window Switcher
 // @description     Replaces the default Alt+Tab with a lightweight window switcher inspired by ExplorerPatcher's Simple Window Switcher
-// @version         2.1
+// @version         2.2.1
 // @author          Lone
 // @github          https://github.com/Louis047
 // @include         windhawk.exe
@@ -41,6 +41,7 @@ Additional improvements made by [Asteski](https://github.com/Asteski) and [bropi
 - Rounded corners for switcher and task thumbnails (optional)
 - Dynamic UI adjustments (e.g., intelligent close button placement over thumbnails)
 - Highly reliable Explorer restart prompt handling without infinite loops
+- Window list kept up to date in the background in most-recently-used order, with icons resolved off the hotkey path, so the switcher opens without re-scanning every window
 
 ## Screenshots
 
@@ -545,6 +546,7 @@ Additional improvements made by [Asteski](https://github.com/Asteski) and [bropi
 #include <vector>
 #include <atomic>
 #include <map>
+#include <list>
 #include <string>
 #include <algorithm>
 #include <gdiplus.h>
@@ -589,6 +591,12 @@ Additional improvements made by [Asteski](https://github.com/Asteski) and [bropi
 // wndproc instead of on the synchronous raw-input path. WPARAM is the direction.
 #define WM_SWS_SCROLL           (WM_APP + 1)
 #define WM_SWS_SETTINGS_CHANGED (WM_APP + 2)
+// Switcher thread -> icon resolver thread: WPARAM is the HWND, LPARAM the size in px.
+#define WM_SWS_RESOLVE_ICON     (WM_APP + 3)
+// Icon resolver thread -> switcher: WPARAM is the HWND, LPARAM the (pinned) HICON.
+#define WM_SWS_ICON_READY       (WM_APP + 4)
+// Estimated bitmap bytes the shared icon cache may hold before evicting.
+#define SWS_ICON_CACHE_BUDGET   (8 * 1024 * 1024)
 
 typedef BOOL (WINAPI *IsShellWindow_t)(HWND);
 typedef HWND (WINAPI *GhostWindowFromHungWindow_t)(HWND);
@@ -717,7 +725,15 @@ static HANDLE g_explorerIpcThread = NULL;
 static DWORD g_explorerIpcThreadId = 0;
 static bool g_isPendingShow = false;
 static RECT g_pendingSwitcherRect = {0, 0, 0, 0};
+// Keypress-to-first-paint timing: stamped when a hotkey opens the switcher,
+// logged and cleared by the first PaintSwitcher that reaches the screen.
+static LARGE_INTEGER g_hotkeyQpc = {};
+static DWORD g_hotkeyQueuedMs = 0;
+static double g_listBuildMs = 0.0;
 static bool g_isWin11OrGreater = false;
+// Held shared by the icon resolver thread while it reads settings-derived state
+// (custom header rules, icon size), exclusively while LoadSettings rewrites it.
+static SRWLOCK g_settingsLock = SRWLOCK_INIT;
 
 // Forward declarations
 static void LoadSettings();
@@ -726,6 +742,7 @@ static void SWS_UnregisterHotkeys();
 static void ApplySwitcherRegion();
 static void CreateMirrorSwitchers();
 static void HideSwitcher();
+static void PaintSwitcher();
 
 // Helpers
 
@@ -1059,9 +1076,135 @@ static bool IsAltTabWindow(HWND h) {
 
 static HICON TryGetUwpIconFromExplorer(HWND hWnd, int desiredSizePx);
 
-// Cache of crisp icons extracted from exe files at a specific pixel size.
-// Owned here (DestroyIcon at unload); keyed by "<exePath>_<sizePx>".
-static std::map<std::wstring, HICON> g_exeIconCache;
+// === Icon cache ===
+
+// Every icon this mod creates (crisp exe frames, custom icon files, UWP icons)
+// is owned by one LRU keyed by "<source>:<path or AUMID>_<sizePx>". Inserting
+// past SWS_ICON_CACHE_BUDGET destroys the least recently used icons, skipping
+// any the window model still pins. Icons from WM_GETICON or the window class
+// belong to their window and never enter the cache.
+struct IconCacheEntry {
+    std::wstring key;     // empty once replaced, see IconCacheInsertCopy
+    HICON hIcon;
+    size_t bytes;
+    int pins;
+    HICON hSource;        // foreign icon hIcon was copied from, if any
+};
+static std::list<IconCacheEntry> g_iconLru;  // front = most recently used
+static std::map<std::wstring, std::list<IconCacheEntry>::iterator> g_iconByKey;
+static std::map<HICON, std::list<IconCacheEntry>::iterator> g_iconByHandle;
+static size_t g_iconCacheBytes = 0;
+// Shared by the switcher thread (pins) and the icon resolver thread (lookups).
+static SRWLOCK g_iconCacheLock = SRWLOCK_INIT;
+
+static HICON IconCacheFind(const std::wstring& key) {
+    AcquireSRWLockExclusive(&g_iconCacheLock);
+    HICON hIcon = NULL;
+    auto it = g_iconByKey.find(key);
+    if (it != g_iconByKey.end()) {
+        g_iconLru.splice(g_iconLru.begin(), g_iconLru, it->second);
+        hIcon = it->second->hIcon;
+    }
+    ReleaseSRWLockExclusive(&g_iconCacheLock);
+    return hIcon;
+}
+
+// Takes ownership of hIcon and returns the icon to use for the key. Eviction
+// only happens here, on the thread that resolves icons, so an icon it has just
+// looked up cannot disappear before it is pinned.
+static HICON IconCacheInsert(const std::wstring& key, HICON hIcon, int sizePx, HICON hSource = NULL) {
+    AcquireSRWLockExclusive(&g_iconCacheLock);
+    auto existing = g_iconByKey.find(key);
+    if (existing != g_iconByKey.end()) {
+        HICON hCached = existing->second->hIcon;
+        ReleaseSRWLockExclusive(&g_iconCacheLock);
+        if (hCached != hIcon) DestroyIcon(hIcon);
+        return hCached;
+    }
+
+    // 32bpp color bitmap plus 1bpp mask.
+    size_t bytes = (size_t)sizePx * sizePx * 4 + (size_t)sizePx * sizePx / 8;
+    g_iconLru.push_front({key, hIcon, bytes, 0, hSource});
+    g_iconByKey[key] = g_iconLru.begin();
+    g_iconByHandle[hIcon] = g_iconLru.begin();
+    g_iconCacheBytes += bytes;
+
+    auto it = g_iconLru.end();
+    while (g_iconCacheBytes > SWS_ICON_CACHE_BUDGET && it != g_iconLru.begin()) {
+        --it;
+        if (it->pins > 0 || it->hIcon == hIcon) continue;
+        g_iconCacheBytes -= it->bytes;
+        if (!it->key.empty()) g_iconByKey.erase(it->key);
+        g_iconByHandle.erase(it->hIcon);
+        DestroyIcon(it->hIcon);
+        it = g_iconLru.erase(it);
+    }
+    ReleaseSRWLockExclusive(&g_iconCacheLock);
+    return hIcon;
+}
+
+// For icons owned by another process (explorer's IPC cache): cache a local copy.
+// The copy is only reused while the owner hands out the same handle; a new one
+// (the real icon after a placeholder, or another app's icon for a reused window
+// handle) replaces it. A replaced copy still pinned by the window model loses
+// its key and is freed by eviction once unpinned.
+static HICON IconCacheInsertCopy(const std::wstring& key, HICON hForeign, int sizePx) {
+    AcquireSRWLockExclusive(&g_iconCacheLock);
+    auto existing = g_iconByKey.find(key);
+    if (existing != g_iconByKey.end()) {
+        auto entry = existing->second;
+        if (entry->hSource == hForeign) {
+            g_iconLru.splice(g_iconLru.begin(), g_iconLru, entry);
+            HICON hCached = entry->hIcon;
+            ReleaseSRWLockExclusive(&g_iconCacheLock);
+            return hCached;
+        }
+        g_iconByKey.erase(existing);
+        if (entry->pins > 0) {
+            entry->key.clear();
+        } else {
+            g_iconCacheBytes -= entry->bytes;
+            g_iconByHandle.erase(entry->hIcon);
+            DestroyIcon(entry->hIcon);
+            g_iconLru.erase(entry);
+        }
+    }
+    ReleaseSRWLockExclusive(&g_iconCacheLock);
+
+    HICON hCopy = CopyIcon(hForeign);
+    if (!hCopy) return hForeign;
+    return IconCacheInsert(key, hCopy, sizePx, hForeign);
+}
+
+// Pin/unpin an icon held by the window model. No-op for icons the cache
+// doesn't own.
+static void IconCachePin(HICON hIcon) {
+    if (!hIcon) return;
+    AcquireSRWLockExclusive(&g_iconCacheLock);
+    auto it = g_iconByHandle.find(hIcon);
+    if (it != g_iconByHandle.end()) it->second->pins++;
+    ReleaseSRWLockExclusive(&g_iconCacheLock);
+}
+
+static void IconCacheUnpin(HICON hIcon) {
+    if (!hIcon) return;
+    AcquireSRWLockExclusive(&g_iconCacheLock);
+    auto it = g_iconByHandle.find(hIcon);
+    if (it != g_iconByHandle.end() && it->second->pins > 0) it->second->pins--;
+    ReleaseSRWLockExclusive(&g_iconCacheLock);
+}
+
+static void IconCacheClear() {
+    AcquireSRWLockExclusive(&g_iconCacheLock);
+    for (auto& e : g_iconLru) {
+        if (e.hIcon) DestroyIcon(e.hIcon);
+    }
+    g_iconLru.clear();
+    g_iconByKey.clear();
+    g_iconByHandle.clear();
+    g_iconCacheBytes = 0;
+    ReleaseSRWLockExclusive(&g_iconCacheLock);
+}
 
 // WM_GETICON returns a fixed (usually 32px) icon that looks blurry when scaled
 // up to 48/64. PrivateExtractIconsW pulls the best-matching frame from the
@@ -1078,15 +1221,14 @@ static HICON TryGetCrispExeIcon(HWND hWnd, int desiredSizePx) {
     CloseHandle(hProc);
     if (!ok || !exePath[0]) return NULL;
 
-    std::wstring key = std::wstring(exePath) + L"_" + std::to_wstring(desiredSizePx);
-    auto it = g_exeIconCache.find(key);
-    if (it != g_exeIconCache.end()) return it->second;
+    std::wstring key = L"exe:" + std::wstring(exePath) + L"_" + std::to_wstring(desiredSizePx);
+    HICON hCached = IconCacheFind(key);
+    if (hCached) return hCached;
 
     HICON hIcon = NULL;
     if (PrivateExtractIconsW(exePath, 0, desiredSizePx, desiredSizePx,
                              &hIcon, NULL, 1, 0) == 1 && hIcon) {
-        g_exeIconCache[key] = hIcon;
-        return hIcon;
+        return IconCacheInsert(key, hIcon, desiredSizePx);
     }
     return NULL;
 }
@@ -1099,19 +1241,16 @@ struct CustomHeaderRule {
     std::wstring appName;   // custom display name overriding the detected one (optional)
 };
 static std::vector<CustomHeaderRule> g_customHeaderRules;
-// Owned cache of icons loaded from custom paths; keyed by "<path>_<sizePx>".
-static std::map<std::wstring, HICON> g_customIconCache;
 
 static HICON LoadCustomIconFromPath(const std::wstring& path, int sizePx) {
     if (path.empty() || sizePx <= 0) return NULL;
-    std::wstring key = path + L"_" + std::to_wstring(sizePx);
-    auto it = g_customIconCache.find(key);
-    if (it != g_customIconCache.end()) return it->second;
+    std::wstring key = L"custom:" + path + L"_" + std::to_wstring(sizePx);
+    HICON hCached = IconCacheFind(key);
+    if (hCached) return hCached;
     HICON hIcon = NULL;
     if (PrivateExtractIconsW(path.c_str(), 0, sizePx, sizePx,
                              &hIcon, NULL, 1, 0) == 1 && hIcon) {
-        g_customIconCache[key] = hIcon;
-        return hIcon;
+        return IconCacheInsert(key, hIcon, sizePx);
     }
     return NULL;
 }
@@ -1165,19 +1304,21 @@ static bool TryGetCustomAppName(HWND hWnd, WCHAR* out, size_t cch) {
     return false;
 }
 
-static HICON LoadWindowIcon(HWND hWnd) {
+// Runs on the icon resolver thread; sizePx is passed in because the layout
+// globals GetHeaderIconSizePx() reads belong to the switcher thread.
+static HICON LoadWindowIcon(HWND hWnd, int sizePx) {
     // User-assigned custom icon takes priority over everything else.
-    HICON hIcon = TryGetCustomIcon(hWnd, GetHeaderIconSizePx());
+    HICON hIcon = TryGetCustomIcon(hWnd, sizePx);
     if (hIcon) return hIcon;
     if (g_IsShellFrameWindow && g_IsShellFrameWindow(hWnd)) {
-        hIcon = TryGetUwpIconFromExplorer(hWnd, GetHeaderIconSizePx());
+        hIcon = TryGetUwpIconFromExplorer(hWnd, sizePx);
     }
     // A crisp exe icon extracted at the exact target size beats the WM_GETICON
     // result, which is a fixed ~32px frame: blurry when upscaled to 48/64 and
     // pixelated when downscaled to 16 (GDI does no smoothing in DrawIconEx).
     // PrivateExtractIconsW picks the best-matching frame at the requested size.
     if (!hIcon) {
-        hIcon = TryGetCrispExeIcon(hWnd, GetHeaderIconSizePx());
+        hIcon = TryGetCrispExeIcon(hWnd, sizePx);
     }
     if (!hIcon) SendMessageTimeoutW(hWnd, WM_GETICON, ICON_BIG, 0, SMTO_ABORTIFHUNG | SMTO_BLOCK, 100, (DWORD_PTR*)&hIcon);
     if (!hIcon) SendMessageTimeoutW(hWnd, WM_GETICON, ICON_SMALL2, 0, SMTO_ABORTIFHUNG | SMTO_BLOCK, 100, (DWORD_PTR*)&hIcon);
@@ -1188,62 +1329,9 @@ static HICON LoadWindowIcon(HWND hWnd) {
     return hIcon;
 }
 
-static BOOL CALLBACK EnumWindowsProc(HWND hWnd, LPARAM lParam) {
-    auto* list = reinterpret_cast<std::vector<WindowEntry>*>(lParam);
-    if (hWnd == g_hSwitcher) return TRUE;
-    if (!IsAltTabWindow(hWnd)) return TRUE;
-    BOOL cloaked = FALSE;
-    DwmGetWindowAttribute(hWnd, DWMWA_CLOAKED, &cloaked, sizeof(cloaked));
-    if (cloaked) {
-        if (wcscmp(g_settings.virtualDesktopBehavior, L"allDesktops") == 0 && g_pVirtualDesktopManager) {
-            BOOL onCurrent = FALSE;
-            if (SUCCEEDED(g_pVirtualDesktopManager->IsWindowOnCurrentVirtualDesktop(hWnd, &onCurrent)) && !onCurrent) {
-                // allow cloaked window since it's just on another virtual desktop
-            } else return TRUE;
-        } else return TRUE;
-    }
-    bool isPrimaryOnly = (wcscmp(g_settings.switcherDisplayBehavior, L"primaryOnly") == 0);
-    if (g_settings.perMonitorWindows && !g_showAllMonitors && g_hCurrentMonitor && !isPrimaryOnly) {
-        if (MonitorFromWindow(hWnd, MONITOR_DEFAULTTONULL) != g_hCurrentMonitor) return TRUE;
-    }
-    WindowEntry e = {};
-    e.hWnd = hWnd;
-    GetWindowTextW(hWnd, e.title, 256);
-    if (!e.title[0]) InternalGetWindowText(hWnd, e.title, 256);
-    
-    bool excluded = false;
-    for (const auto& pat : g_excludeTitlePatterns) {
-        if (PathMatchSpecW(e.title, pat.c_str())) { excluded = true; break; }
-    }
-    if (!excluded && !g_excludeExePatterns.empty()) {
-        DWORD pid = 0;
-        GetWindowThreadProcessId(hWnd, &pid);
-        if (pid) {
-            HANDLE hProc = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
-            if (hProc) {
-                WCHAR exePath[MAX_PATH] = {0};
-                DWORD size = MAX_PATH;
-                if (QueryFullProcessImageNameW(hProc, 0, exePath, &size)) {
-                    WCHAR* filename = PathFindFileNameW(exePath);
-                    for (const auto& pat : g_excludeExePatterns) {
-                        if (PathMatchSpecW(filename, pat.c_str())) { excluded = true; break; }
-                    }
-                }
-                CloseHandle(hProc);
-            }
-        }
-    }
-    if (excluded) return TRUE;
-
-    e.hIcon = LoadWindowIcon(hWnd);
-    list->push_back(e);
-    return TRUE;
-}
-
 // === UWP Icon Extraction (Explorer IPC) ===
 
 UINT g_WM_SWS_GET_UWP_ICON = 0;
-std::map<std::wstring, HICON> g_uwpIconCache;
 
 struct FindCoreWindowData { HWND coreHwnd; };
 
@@ -1416,9 +1504,10 @@ LRESULT CALLBACK ExplorerIpcWndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM
                         if (SHGetFileInfoW(exePath, FILE_ATTRIBUTE_NORMAL, &sfi, sizeof(sfi), flags)) {
                             if (sfi.hIcon) {
                                 Wh_Log(L"Explorer IPC: Returning exe icon %p as Win10 fallback", sfi.hIcon);
-                                g_uwpIconCache[std::wstring(exePath) + L"_" + std::to_wstring(desiredSizePx)] = sfi.hIcon;
+                                HICON hExeIcon = IconCacheInsert(L"uwpexe:" + std::wstring(exePath) + L"_" + std::to_wstring(desiredSizePx),
+                                                                 sfi.hIcon, desiredSizePx);
                                 CloseHandle(hProc2);
-                                return (LRESULT)sfi.hIcon;
+                                return (LRESULT)hExeIcon;
                             }
                         }
                     } else {
@@ -1432,17 +1521,17 @@ LRESULT CALLBACK ExplorerIpcWndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM
         if (!aumid.empty()) {
             Wh_Log(L"Explorer IPC: Got AUMID = %s", aumid.c_str());
             
-            std::wstring cacheKey = aumid + L"_" + std::to_wstring(desiredSizePx);
-            if (g_uwpIconCache.find(cacheKey) != g_uwpIconCache.end()) {
-                Wh_Log(L"Explorer IPC: Returning cached icon %p", g_uwpIconCache[cacheKey]);
-                return (LRESULT)g_uwpIconCache[cacheKey];
+            std::wstring cacheKey = L"uwp:" + aumid + L"_" + std::to_wstring(desiredSizePx);
+            HICON hCached = IconCacheFind(cacheKey);
+            if (hCached) {
+                Wh_Log(L"Explorer IPC: Returning cached icon %p", hCached);
+                return (LRESULT)hCached;
             }
             
             HICON hIcon = ResolveIconFromAumid(aumid.c_str(), desiredSizePx);
             if (hIcon) {
                 Wh_Log(L"Explorer IPC: Resolved new icon %p", hIcon);
-                g_uwpIconCache[cacheKey] = hIcon;
-                return (LRESULT)hIcon;
+                return (LRESULT)IconCacheInsert(cacheKey, hIcon, desiredSizePx);
             } else {
                 Wh_Log(L"Explorer IPC: ResolveIconFromAumid failed");
             }
@@ -1491,8 +1580,11 @@ static HICON TryGetUwpIconFromExplorer(HWND hWnd, int desiredSizePx) {
         if (res) {
             // On Windows 11 explorer returns usable icon handles via IPC in our environment.
             // Avoid attempting local AUMID->icon resolution on Win11 to preserve that behavior.
+            // Explorer's own cache may evict the handle later, so keep a copy
+            // owned by this process.
             if (g_isWin11OrGreater) {
-                return (HICON)res;
+                return IconCacheInsertCopy(L"uwpipc:" + std::to_wstring((ULONG_PTR)hWnd) + L"_" + std::to_wstring(desiredSizePx),
+                                           (HICON)res, desiredSizePx);
             }
             // We got an icon handle from Explorer, but HICON handles are process-local —
             // prefer resolving the AUMID locally and creating an icon in this process.
@@ -1510,19 +1602,19 @@ static HICON TryGetUwpIconFromExplorer(HWND hWnd, int desiredSizePx) {
                 ps->Release();
             }
             if (!aumidLocal.empty()) {
-                std::wstring cacheKey = aumidLocal + L"_" + std::to_wstring(desiredSizePx);
-                auto it = g_uwpIconCache.find(cacheKey);
-                if (it != g_uwpIconCache.end()) return it->second;
+                std::wstring cacheKey = L"uwp:" + aumidLocal + L"_" + std::to_wstring(desiredSizePx);
+                HICON hCached = IconCacheFind(cacheKey);
+                if (hCached) return hCached;
                 HICON hLocal = ResolveIconFromAumid(aumidLocal.c_str(), desiredSizePx);
                 if (hLocal) {
-                    g_uwpIconCache[cacheKey] = hLocal;
                     Wh_Log(L"TryGetUwpIconFromExplorer: Resolved local icon %p from AUMID", hLocal);
-                    return hLocal;
+                    return IconCacheInsert(cacheKey, hLocal, desiredSizePx);
                 }
                 Wh_Log(L"TryGetUwpIconFromExplorer: Local ResolveIconFromAumid failed for %s", aumidLocal.c_str());
             }
-            // As a last resort, return the handle from explorer (may not be valid across processes)
-            return (HICON)res;
+            // As a last resort, use the handle from explorer (may not be valid across processes)
+            return IconCacheInsertCopy(L"uwpipc:" + std::to_wstring((ULONG_PTR)hWnd) + L"_" + std::to_wstring(desiredSizePx),
+                                       (HICON)res, desiredSizePx);
         }
         return NULL;
     } else {
@@ -1531,6 +1623,288 @@ static HICON TryGetUwpIconFromExplorer(HWND hWnd, int desiredSizePx) {
     return NULL;
 }
 
+// === Window model ===
+
+// Visible top-level windows in most-recently-activated order, kept current by
+// WinEvent hooks on the switcher thread. Opening the switcher only filters this
+// list; titles, executable paths and icons are gathered when a window appears
+// or changes, never on the hotkey path.
+struct ModelWindow {
+    HWND hWnd;
+    HICON hIcon;          // NULL until resolved; pinned in the icon cache if owned by it
+    int iconSizePx;       // size hIcon was resolved at
+    int requestedSizePx;  // last size asked of the resolver thread, 0 = none
+    bool exePathRead;     // exePath was looked up (only done for Alt+Tab windows)
+    WCHAR title[256];
+    WCHAR exePath[MAX_PATH];
+};
+static std::vector<ModelWindow> g_model;  // front = most recently activated
+static HWINEVENTHOOK g_hWinEventHooks[3] = {};
+static HANDLE g_hIconThread = NULL;
+static DWORD g_dwIconThreadId = 0;
+
+static int ModelFind(HWND hWnd) {
+    for (int i = 0; i < (int)g_model.size(); i++) {
+        if (g_model[i].hWnd == hWnd) return i;
+    }
+    return -1;
+}
+
+static void ModelRequestIcon(ModelWindow& m, int sizePx) {
+    if (!g_dwIconThreadId || m.requestedSizePx == sizePx) return;
+    if (PostThreadMessageW(g_dwIconThreadId, WM_SWS_RESOLVE_ICON, (WPARAM)m.hWnd, sizePx)) {
+        m.requestedSizePx = sizePx;
+    }
+}
+
+static void ModelReadTitle(ModelWindow& m) {
+    GetWindowTextW(m.hWnd, m.title, 256);
+    if (!m.title[0]) InternalGetWindowText(m.hWnd, m.title, 256);
+}
+
+static void ModelReadExePath(ModelWindow& m) {
+    m.exePathRead = true;
+    m.exePath[0] = 0;
+    DWORD pid = 0;
+    GetWindowThreadProcessId(m.hWnd, &pid);
+    if (pid) {
+        HANDLE hProc = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+        if (hProc) {
+            DWORD size = MAX_PATH;
+            if (!QueryFullProcessImageNameW(hProc, 0, m.exePath, &size)) m.exePath[0] = 0;
+            CloseHandle(hProc);
+        }
+    }
+}
+
+// Tooltips, menus, drag images and other popups are shown on every hover, so
+// only windows that Alt+Tab would list get their process looked up and their
+// icon prefetched. Others are tracked by title only, and catch up in
+// AppendIfListed if they become listable later.
+static void ModelAdd(HWND hWnd, bool toFront) {
+    int idx = ModelFind(hWnd);
+    if (idx >= 0) {
+        if (toFront && idx > 0) {
+            std::rotate(g_model.begin(), g_model.begin() + idx, g_model.begin() + idx + 1);
+        }
+        return;
+    }
+    if (!IsWindowVisible(hWnd) || GetAncestor(hWnd, GA_PARENT) != GetDesktopWindow()) return;
+    if (hWnd == g_hSwitcher || hWnd == g_hCloseBtnWnd) return;
+
+    ModelWindow m = {};
+    m.hWnd = hWnd;
+    ModelReadTitle(m);
+    if (IsAltTabWindow(hWnd)) {
+        ModelReadExePath(m);
+        ModelRequestIcon(m, GetHeaderIconSizePx());
+    }
+    if (toFront) g_model.insert(g_model.begin(), m);
+    else g_model.push_back(m);
+}
+
+static void ModelRemove(HWND hWnd) {
+    int idx = ModelFind(hWnd);
+    if (idx < 0) return;
+    IconCacheUnpin(g_model[idx].hIcon);
+    g_model.erase(g_model.begin() + idx);
+}
+
+// Model icon for a window, or a cheap class icon while the resolver is busy.
+static HICON ModelIconFor(HWND hWnd) {
+    int idx = ModelFind(hWnd);
+    if (idx >= 0 && g_model[idx].hIcon) return g_model[idx].hIcon;
+    HICON hIcon = (HICON)GetClassLongPtrW(hWnd, GCLP_HICON);
+    if (!hIcon) hIcon = (HICON)GetClassLongPtrW(hWnd, GCLP_HICONSM);
+    if (!hIcon) hIcon = LoadIconW(NULL, IDI_APPLICATION);
+    return hIcon;
+}
+
+static void CALLBACK ModelWinEventProc(HWINEVENTHOOK, DWORD event, HWND hWnd, LONG idObject, LONG idChild, DWORD, DWORD) {
+    if (!hWnd || idObject != OBJID_WINDOW || idChild != CHILDID_SELF) return;
+    switch (event) {
+    case EVENT_OBJECT_CREATE:
+    case EVENT_OBJECT_SHOW:
+        ModelAdd(hWnd, false);
+        break;
+    case EVENT_OBJECT_DESTROY:
+    case EVENT_OBJECT_HIDE:
+        ModelRemove(hWnd);
+        break;
+    case EVENT_OBJECT_NAMECHANGE: {
+        int idx = ModelFind(hWnd);
+        if (idx < 0) break;
+        ModelReadTitle(g_model[idx]);
+        // Apps swap their icon along with the document/tab that renames them.
+        // Windows whose icon was never asked for are left to AppendIfListed.
+        int sizePx = g_model[idx].requestedSizePx;
+        if (!sizePx) break;
+        g_model[idx].requestedSizePx = 0;
+        ModelRequestIcon(g_model[idx], sizePx);
+        break;
+    }
+    case EVENT_SYSTEM_FOREGROUND: {
+        // Dialogs activate in place of their owner, which is what gets listed.
+        HWND hRootOwner = GetAncestor(hWnd, GA_ROOTOWNER);
+        if (hRootOwner && hRootOwner != hWnd) ModelAdd(hRootOwner, true);
+        ModelAdd(hWnd, true);
+        break;
+    }
+    }
+}
+
+static BOOL CALLBACK ModelSeedProc(HWND hWnd, LPARAM) {
+    ModelAdd(hWnd, false);
+    return TRUE;
+}
+
+// Z-order is the best available guess at MRU order for windows that existed
+// before the hooks; foreground events refine it from then on.
+static void ModelStart() {
+    DWORD flags = WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS;
+    g_hWinEventHooks[0] = SetWinEventHook(EVENT_OBJECT_CREATE, EVENT_OBJECT_HIDE, NULL, ModelWinEventProc, 0, 0, flags);
+    g_hWinEventHooks[1] = SetWinEventHook(EVENT_OBJECT_NAMECHANGE, EVENT_OBJECT_NAMECHANGE, NULL, ModelWinEventProc, 0, 0, flags);
+    g_hWinEventHooks[2] = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, NULL, ModelWinEventProc, 0, 0, flags);
+    EnumWindows(ModelSeedProc, 0);
+    Wh_Log(L"Window model: %d windows tracked", (int)g_model.size());
+}
+
+static void ModelStop() {
+    for (auto& h : g_hWinEventHooks) {
+        if (h) { UnhookWinEvent(h); h = NULL; }
+    }
+    for (auto& m : g_model) IconCacheUnpin(m.hIcon);
+    g_model.clear();
+}
+
+// Settings that affect icon resolution changed: re-resolve everything. The old
+// icons stay pinned until their replacements arrive.
+static void ModelRefreshIcons() {
+    int sizePx = GetHeaderIconSizePx();
+    for (auto& m : g_model) {
+        if (!m.requestedSizePx && !m.hIcon) continue;  // never listed
+        m.requestedSizePx = 0;
+        ModelRequestIcon(m, sizePx);
+    }
+}
+
+// WM_SWS_ICON_READY: adopt the resolver's pin and swap the icon into the
+// window's entries currently on screen before the old icon is unpinned. Other
+// windows sharing the old icon keep it, pinned by their own model entries.
+static void ModelOnIconResolved(HWND hWnd, HICON hIcon) {
+    int idx = ModelFind(hWnd);
+    if (idx < 0) {
+        IconCacheUnpin(hIcon);
+        return;
+    }
+    ModelWindow& m = g_model[idx];
+    HICON hOld = m.hIcon;
+    m.hIcon = hIcon;
+    m.iconSizePx = m.requestedSizePx;
+    if (hOld == hIcon) {
+        IconCacheUnpin(hIcon);
+        return;
+    }
+    bool onScreen = false;
+    for (auto* list : { &g_windows, &g_savedAppList }) {
+        for (auto& e : *list) {
+            if (e.hWnd == hWnd) {
+                e.hIcon = hIcon;
+                onScreen = true;
+            }
+        }
+    }
+    IconCacheUnpin(hOld);
+    if (onScreen && g_isVisible) PaintSwitcher();
+}
+
+// Resolves icons off the switcher thread: the sources below open processes,
+// extract resources, talk to explorer over IPC and send WM_GETICON with
+// timeouts, any of which can stall for hundreds of milliseconds.
+static DWORD WINAPI IconResolverThread(LPVOID lpParam) {
+    CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+    MSG msg;
+    PeekMessageW(&msg, NULL, WM_USER, WM_USER, PM_NOREMOVE);  // create the queue
+    SetEvent((HANDLE)lpParam);
+
+    while (GetMessageW(&msg, NULL, 0, 0) > 0) {
+        if (msg.message != WM_SWS_RESOLVE_ICON) continue;
+        HWND hWnd = (HWND)msg.wParam;
+        if (!IsWindow(hWnd)) continue;
+        AcquireSRWLockShared(&g_settingsLock);
+        HICON hIcon = LoadWindowIcon(hWnd, (int)msg.lParam);
+        ReleaseSRWLockShared(&g_settingsLock);
+        IconCachePin(hIcon);
+        if (!g_hSwitcher || !PostMessageW(g_hSwitcher, WM_SWS_ICON_READY, (WPARAM)hWnd, (LPARAM)hIcon)) {
+            IconCacheUnpin(hIcon);
+        }
+    }
+
+    CoUninitialize();
+    return 0;
+}
+
+static void StartIconResolver() {
+    HANDLE hReady = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!hReady) return;
+    g_hIconThread = CreateThread(NULL, 0, IconResolverThread, hReady, 0, &g_dwIconThreadId);
+    if (g_hIconThread) {
+        WaitForSingleObject(hReady, INFINITE);
+    } else {
+        g_dwIconThreadId = 0;
+    }
+    CloseHandle(hReady);
+}
+
+static void StopIconResolver() {
+    if (!g_hIconThread) return;
+    PostThreadMessageW(g_dwIconThreadId, WM_QUIT, 0, 0);
+    WaitForSingleObject(g_hIconThread, INFINITE);
+    CloseHandle(g_hIconThread);
+    g_hIconThread = NULL;
+    g_dwIconThreadId = 0;
+}
+
+// Appends the model window to `list` if it passes the Alt+Tab filters for the
+// current show (virtual desktop, monitor, exclusion patterns).
+static void AppendIfListed(ModelWindow& m, std::vector<WindowEntry>* list) {
+    HWND hWnd = m.hWnd;
+    if (hWnd == g_hSwitcher) return;
+    if (!IsAltTabWindow(hWnd)) return;
+    BOOL cloaked = FALSE;
+    DwmGetWindowAttribute(hWnd, DWMWA_CLOAKED, &cloaked, sizeof(cloaked));
+    if (cloaked) {
+        if (wcscmp(g_settings.virtualDesktopBehavior, L"allDesktops") == 0 && g_pVirtualDesktopManager) {
+            BOOL onCurrent = FALSE;
+            if (SUCCEEDED(g_pVirtualDesktopManager->IsWindowOnCurrentVirtualDesktop(hWnd, &onCurrent)) && !onCurrent) {
+                // allow cloaked window since it's just on another virtual desktop
+            } else return;
+        } else return;
+    }
+    bool isPrimaryOnly = (wcscmp(g_settings.switcherDisplayBehavior, L"primaryOnly") == 0);
+    if (g_settings.perMonitorWindows && !g_showAllMonitors && g_hCurrentMonitor && !isPrimaryOnly) {
+        if (MonitorFromWindow(hWnd, MONITOR_DEFAULTTONULL) != g_hCurrentMonitor) return;
+    }
+    WindowEntry e = {};
+    e.hWnd = hWnd;
+    wcscpy_s(e.title, m.title);
+    if (!m.exePathRead) ModelReadExePath(m);
+
+    for (const auto& pat : g_excludeTitlePatterns) {
+        if (PathMatchSpecW(e.title, pat.c_str())) return;
+    }
+    if (!g_excludeExePatterns.empty() && m.exePath[0]) {
+        WCHAR* filename = PathFindFileNameW(m.exePath);
+        for (const auto& pat : g_excludeExePatterns) {
+            if (PathMatchSpecW(filename, pat.c_str())) return;
+        }
+    }
+
+    ModelRequestIcon(m, GetHeaderIconSizePx());
+    e.hIcon = ModelIconFor(hWnd);
+    list->push_back(e);
+}
+
 // Identity key used to group windows by application. UWP/app-frame-host windows
 // all share a single host process, so keying them by executable would merge
 // unrelated apps; those are keyed per-window to avoid over-grouping.
@@ -1608,10 +1982,14 @@ static void BuildWindowList() {
         w.hThumbs.clear();
     }
     g_windows.clear();
-    EnumWindows(EnumWindowsProc, (LPARAM)&g_windows);
-    // App grouping: keep one entry per application. EnumWindows yields windows in
-    // Z-order (top to bottom), so the first window seen for each app is its most
-    // recently used one, which becomes the representative entry.
+    // Drop windows whose destroy event we never saw (e.g. hooks failed to install).
+    for (int i = (int)g_model.size() - 1; i >= 0; i--) {
+        if (!IsWindow(g_model[i].hWnd)) ModelRemove(g_model[i].hWnd);
+    }
+    for (auto& m : g_model) AppendIfListed(m, &g_windows);
+    // App grouping: keep one entry per application. The model is in MRU order,
+    // so the first window seen for each app is its most recently used one, which
+    // becomes the representative entry.
     if (g_settings.showApplications) {
         std::vector<WindowEntry> grouped;
         grouped.reserve(g_windows.size());
@@ -3386,6 +3764,21 @@ static void DrawSwitcherOverlay(HDC hdc, HWND hWnd) {
     }
 }
 
+static double QpcElapsedMs(LONGLONG fromQpc) {
+    static LARGE_INTEGER freq = {};
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (double)(now.QuadPart - fromQpc) * 1000.0 / (double)freq.QuadPart;
+}
+
+static void LogHotkeyToPaint() {
+    if (!g_hotkeyQpc.QuadPart) return;
+    Wh_Log(L"Alt+Tab: first paint %.2f ms after WM_HOTKEY (+%u ms queued), window list %.2f ms, %d entries",
+           QpcElapsedMs(g_hotkeyQpc.QuadPart), g_hotkeyQueuedMs, g_listBuildMs, (int)g_windows.size());
+    g_hotkeyQpc.QuadPart = 0;
+}
+
 static void PaintSwitcherOverlay() {
     if (!g_hCloseBtnWnd || !g_isVisible) return;
     HWND targetWnd = g_hoverWnd ? g_hoverWnd : g_hSwitcher;
@@ -3480,6 +3873,7 @@ static void PaintSwitcher() {
         SelectObject(hdcMem, hOld); DeleteObject(hBmp); DeleteDC(hdcMem);
         ReleaseDC(g_hSwitcher, hdcScreen);
         PaintSwitcherOverlay();
+        LogHotkeyToPaint();
     } else {
         // Acrylic: trigger WM_PAINT via InvalidateRect.
         // Use FALSE for the erase parameter: TRUE would send WM_ERASEBKGND which
@@ -3493,6 +3887,7 @@ static void PaintSwitcher() {
             }
         }
         PaintSwitcherOverlay();
+        LogHotkeyToPaint();
     }
 }
 
@@ -3717,7 +4112,10 @@ static void ShowSwitcher(bool sticky) {
                     MonitorFromPoint(pt, MONITOR_DEFAULTTONEAREST);
 
     g_hCurrentMonitor = hMon;
+    LARGE_INTEGER buildStart;
+    QueryPerformanceCounter(&buildStart);
     UnregisterThumbnails(); BuildWindowList();
+    g_listBuildMs = QpcElapsedMs(buildStart.QuadPart);
     
     if (g_isAltBacktickSameApp) {
         WCHAR activeKey[MAX_PATH] = {0};
@@ -3752,7 +4150,7 @@ static void ShowSwitcher(bool sticky) {
 
     RegisterThumbnailsEarly();
     ComputeLayout(hMon);
-    if (g_winW <= 0 || g_winH <= 0) return;
+    if (g_winW <= 0 || g_winH <= 0) { g_hotkeyQpc.QuadPart = 0; return; }
 
     // Recreate font for current DPI
     if (g_hFont) { DeleteObject(g_hFont); g_hFont = NULL; }
@@ -3811,6 +4209,7 @@ static void ShowSwitcher(bool sticky) {
 
 static void HideSwitcher() {
     g_showAllMonitors = false;
+    g_hotkeyQpc.QuadPart = 0;
     CancelPendingShow();
     if (g_hSwitcher) KillTimer(g_hSwitcher, SWS_ALT_POLL_TIMER_ID);
 
@@ -3944,7 +4343,7 @@ static void EnterAppGroup() {
         e.hWnd = hw;
         GetWindowTextW(hw, e.title, 256);
         if (!e.title[0]) InternalGetWindowText(hw, e.title, 256);
-        e.hIcon = LoadWindowIcon(hw);
+        e.hIcon = ModelIconFor(hw);
         g_windows.push_back(std::move(e));
     }
     if (g_windows.empty()) {  // every window closed in the meantime; abort
@@ -4349,7 +4748,7 @@ static void SWS_RegisterHotkeys();
 static void UpdateEntryForWindow(WindowEntry& e) {
     GetWindowTextW(e.hWnd, e.title, 256);
     if (!e.title[0]) InternalGetWindowText(e.hWnd, e.title, 256);
-    e.hIcon = LoadWindowIcon(e.hWnd);
+    e.hIcon = ModelIconFor(e.hWnd);
 
     if (g_settings.showApplications && wcscmp(g_settings.showTitles, L"windowTitle") != 0) {
         WCHAR appName[256] = {0};
@@ -4508,6 +4907,8 @@ static LRESULT CALLBACK SwitcherWndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPA
         }
 
         if (!g_isVisible && !g_isPendingShow) {
+            QueryPerformanceCounter(&g_hotkeyQpc);
+            g_hotkeyQueuedMs = GetTickCount() - (DWORD)GetMessageTime();
             if (isAltBacktickTrigger) g_isAltBacktickSameApp = true;
             ShowSwitcher(isCtrl);
 
@@ -4662,9 +5063,15 @@ static LRESULT CALLBACK SwitcherWndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPA
     case WM_SWS_SETTINGS_CHANGED:
         if (g_isVisible) HideSwitcher();
         SWS_UnregisterHotkeys();
+        AcquireSRWLockExclusive(&g_settingsLock);
         LoadSettings();
+        ReleaseSRWLockExclusive(&g_settingsLock);
+        ModelRefreshIcons();
         SWS_RegisterHotkeys();
         return 0;
+    case WM_SWS_ICON_READY:
+        ModelOnIconResolved((HWND)wParam, (HICON)lParam);
+        return 0;
     case WM_SETCURSOR:
         SetCursor(LoadCursor(NULL, IDC_ARROW));
         return TRUE;
@@ -5168,7 +5575,7 @@ static DWORD WINAPI SwitcherThread(LPVOID lpParam) {
     Wh_Log(L"SwitcherThread starting");
     CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
     // Create the virtual desktop manager on this thread so it lives in the same
-    // apartment that uses it (EnumWindowsProc runs here). An STA interface
+    // apartment that uses it (AppendIfListed runs here). An STA interface
     // pointer is only valid in the apartment that created it.
     CoCreateInstance(CLSID_VirtualDesktopManager, nullptr, CLSCTX_INPROC_SERVER,
                      IID_IVirtualDesktopManager, (void**)&g_pVirtualDesktopManager);
@@ -5211,6 +5618,9 @@ static DWORD WINAPI SwitcherThread(LPVOID lpParam) {
 
     g_hFont = CreateScaledFont(96);
 
+    StartIconResolver();
+    ModelStart();
+
     SWS_RegisterHotkeys();
 
     Wh_Log(L"Simple Window Switcher initialized, entering message loop");
@@ -5225,6 +5635,8 @@ static DWORD WINAPI SwitcherThread(LPVOID lpParam) {
     if (g_isVisible) HideSwitcher();
     UnregisterThumbnails();
     g_windows.clear();
+    StopIconResolver();
+    ModelStop();
     if (g_hCloseBtnWnd) { DestroyWindow(g_hCloseBtnWnd); g_hCloseBtnWnd = NULL; }
     if (g_hSwitcher) { DeregisterShellHookWindow(g_hSwitcher); DestroyWindow(g_hSwitcher); g_hSwitcher = NULL; }
     UnregisterClassW(SWS_CLASSNAME, GetModuleHandleW(NULL));
@@ -5266,18 +5678,7 @@ void WhTool_ModUninit() {
         g_hSwitcherThread = NULL;
         g_dwSwitcherThreadId = 0;
     }
-    for (auto& pair : g_uwpIconCache) {
-        if (pair.second) DestroyIcon(pair.second);
-    }
-    g_uwpIconCache.clear();
-    for (auto& pair : g_exeIconCache) {
-        if (pair.second) DestroyIcon(pair.second);
-    }
-    g_exeIconCache.clear();
-    for (auto& pair : g_customIconCache) {
-        if (pair.second) DestroyIcon(pair.second);
-    }
-    g_customIconCache.clear();
+    IconCacheClear();
 }
 
 void WhTool_ModSettingsChanged() {
@@ -5557,18 +5958,7 @@ void Wh_ModUninit() {
             g_explorerIpcThread = NULL;
             g_explorerIpcThreadId = 0;
         }
-        for (auto& pair : g_uwpIconCache) {
-            if (pair.second) DestroyIcon(pair.second);
-        }
-        g_uwpIconCache.clear();
-        for (auto& pair : g_exeIconCache) {
-            if (pair.second) DestroyIcon(pair.second);
-        }
-        g_exeIconCache.clear();
-        for (auto& pair : g_customIconCache) {
-            if (pair.second) DestroyIcon(pair.second);
-        }
-        g_customIconCache.clear();
+        IconCacheClear();
 
         if (g_isExplorer && IsMainExplorer()) {
             if (!GetSystemMetrics(SM_SHUTTINGDOWN)) {
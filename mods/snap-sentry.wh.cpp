@@ -2,7 +2,7 @@
 // @id              snap-sentry
 // @name            SnapSentry
 // @description     Watch your Screenshots folder or any folder you pick, then copy, rename, or delete each new screenshot, or choose from a notification.
-// @version         0.17.2
+// @version         0.18.1
 // @author          mario0318
 // @github          https://github.com/mario0318
 // @include         windhawk.exe
@@ -43,9 +43,10 @@ what it shows instead of Screenshot (1). The file stays in the same folder.
 
 By default this is your Windows Screenshots folder, wherever Windows keeps it. In
 the settings you can type the full path to any folder instead, and shortcuts like
-%USERPROFILE% are filled in for you. Every new image that arrives in the folder you
-choose is treated the same way, so pick one where screenshots land rather than one
-that collects downloads.
+%USERPROFILE% are filled in for you. To watch several folders, say the Screenshots
+folder and the one your capture tool saves to, separate them with a semicolon. Every
+new image that arrives in a folder you choose is treated the same way, so pick ones
+where screenshots land rather than ones that collect downloads.
 
 ## The notification
 
@@ -113,8 +114,8 @@ stored in clipboard history, cloud sync, backups, or other programs.
 
 # ---- Advanced ----
 - folder: ""
-  $name: Folder to watch (leave empty for Screenshots)
-  $description: Empty watches your Windows Screenshots folder, wherever it is. To watch somewhere else, paste the full path to that folder here, for example C:\Users\You\Pictures\Captures or %USERPROFILE%\Pictures\ShareX. Anything arriving in the folder you choose is handled the same way, so with deletion on, other images saved there are deleted too.
+  $name: Folders to watch (leave empty for Screenshots)
+  $description: Empty watches your Windows Screenshots folder, wherever it is. To watch somewhere else, paste the full path to that folder here, for example C:\Users\You\Pictures\Captures or %USERPROFILE%\Pictures\ShareX. Separate several folders with a semicolon, up to 8. Anything arriving in the folders you choose is handled the same way, so with deletion on, other images saved there are deleted too.
 - logDetails: false
   $name: Verbose logging (may include file paths)
   $description: Off keeps file paths out of the log. Turn this on only while troubleshooting.
@@ -164,9 +165,13 @@ DEFINE_GUID(IID_INotificationActivationCallback,
 #include <cstring>
 #include <cwchar>
 #include <deque>
+#include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 // ============================================================================
 // Settings and shared state
@@ -178,51 +183,77 @@ struct Settings {
     bool popup;
     std::wstring mode;
     std::wstring pathFormat;
-    std::wstring folder;
+    std::vector<std::wstring> folders;
     bool recycle;
     bool renameFromWindow;
     bool logDetails;
 };
 
-static CRITICAL_SECTION g_lock;       // Guards g_settings, g_queue, g_inflight, g_recent, g_preexisting.
+// A screenshot on its way through the worker. With the picture being copied, a
+// decode thread turns the file into a clipboard payload while the worker is
+// still busy with the screenshots ahead of it.
+struct Job {
+    std::wstring path;
+    bool decode = false;      // A decode thread should prepare the image.
+    bool claimed = false;     // A decode thread has taken it.
+    bool decoded = false;     // Decoding finished, whether or not it worked.
+    HGLOBAL image = nullptr;  // CF_DIBV5 payload, owned until published.
+
+    ~Job() {
+        if (image) {
+            GlobalFree(image);
+        }
+    }
+};
+
+static CRITICAL_SECTION g_lock;       // Guards g_settings, g_queue, g_inflight, g_recent.
 static Settings g_settings;
-static std::deque<std::wstring> g_queue;   // Full paths waiting to be processed.
-static std::set<std::wstring> g_inflight;  // Names queued or in progress (dedup).
-
-// Names already present when the watched folder was opened. They are never acted
-// on, which is the literal safety invariant "never touch files that were already
-// in the folder." This is what stops a flood when OneDrive Files On-Demand
-// hydrates a folder full of old screenshots: each download surfaces as an ADDED
-// or RENAMED event for a name in this set, so it is ignored. Refreshed every time
-// the folder is (re)opened.
-static std::set<std::wstring> g_preexisting;
-
-// Names finished processing recently, each with an expiry tick. Swallows a
+static std::deque<std::unique_ptr<Job>> g_queue;  // In arrival order.
+static std::unordered_set<std::wstring> g_inflight;  // Paths queued or in progress (dedup).
+
+// Paths finished processing recently, each with an expiry tick. Swallows a
 // duplicate filesystem event for an already-handled screenshot that arrives
-// after the name left g_inflight. The common case is OneDrive Files On-Demand
+// after the path left g_inflight. The common case is OneDrive Files On-Demand
 // rewriting the saved file into a placeholder, which fires a second ADDED or
 // RENAMED event for the same name seconds after the first notification closed;
 // an antivirus or a screenshot tool's temp-then-rename can do the same. A
 // screenshot name is unique per capture, so a same-name event inside the window
-// is always such a duplicate, never a distinct new shot.
+// is always such a duplicate, never a distinct new shot. The deque keeps expiry
+// order and the map answers lookups, so a burst of captures doesn't turn every
+// event into a scan over the last minute's names.
 static std::deque<std::pair<std::wstring, ULONGLONG>> g_recent;
+static std::unordered_map<std::wstring, ULONGLONG> g_recentExpiry;
 static constexpr ULONGLONG kDuplicateEventWindowMs = 60000;  // Measured from when handling finished.
 
-// Pre-seed the recent-name set so a file event we cause ourselves (the rename
+// Caller must hold g_lock.
+static void RememberRecent(const std::wstring& path, ULONGLONG now) {
+    ULONGLONG expiry = now + kDuplicateEventWindowMs;
+    g_recent.push_back({path, expiry});
+    g_recentExpiry[path] = expiry;
+}
+
+// Pre-seed the recent-path set so a file event we cause ourselves (the rename
 // below) is swallowed by the watcher instead of being handled as a brand-new
 // screenshot, which would rename it again in a loop.
-static void MarkNameRecent(const std::wstring& name) {
+static void MarkPathRecent(const std::wstring& path) {
     ULONGLONG now = GetTickCount64();
     EnterCriticalSection(&g_lock);
-    g_recent.push_back({name, now + kDuplicateEventWindowMs});
+    RememberRecent(path, now);
     LeaveCriticalSection(&g_lock);
 }
 
 static HANDLE g_stopEvent;   // Manual-reset: set once at shutdown.
-static HANDLE g_reloadEvent; // Auto-reset: settings changed, re-open the folder.
-static HANDLE g_workEvent;   // Auto-reset: queue has work.
+static HANDLE g_watchPort;   // Completion port for folder changes, reload and stop.
+static HANDLE g_workEvent;   // Auto-reset: queue has work, or a decode finished.
+static HANDLE g_decodeEvent; // Manual-reset: a job may be waiting to be decoded.
 static HANDLE g_watchThread;
 static HANDLE g_workerThread;
+
+// Decode threads. A few are enough to keep a burst's decoding off the worker
+// without holding many full-size bitmaps at once in this 32-bit process.
+static constexpr int kDecodeThreads = 3;
+static HANDLE g_decodeThreads[kDecodeThreads];
+static int g_decodeThreadCount;
 static std::atomic<HWND> g_dialog{nullptr};  // Open action dialog, for shutdown.
 
 // A popup with no countdown (delaySeconds 0) waits for an answer, but not
@@ -282,6 +313,49 @@ static std::wstring DefaultScreenshotsFolder() {
     return result;
 }
 
+static constexpr size_t kMaxFolders = 8;
+
+// Splits the folder setting on ';', expanding things like %USERPROFILE% so a
+// pasted path with env vars resolves. Empty entries, trailing separators and
+// repeats are dropped.
+static std::vector<std::wstring> ParseFolderList(const std::wstring& setting) {
+    std::vector<std::wstring> folders;
+    size_t start = 0;
+    while (start <= setting.size() && folders.size() < kMaxFolders) {
+        size_t end = setting.find(L';', start);
+        if (end == std::wstring::npos) {
+            end = setting.size();
+        }
+        std::wstring folder = setting.substr(start, end - start);
+        start = end + 1;
+
+        size_t b = folder.find_first_not_of(L" \t");
+        if (b == std::wstring::npos) {
+            continue;
+        }
+        folder = folder.substr(b, folder.find_last_not_of(L" \t") - b + 1);
+        WCHAR expanded[MAX_PATH * 2];
+        DWORD n = ExpandEnvironmentStringsW(folder.c_str(), expanded,
+                                            ARRAYSIZE(expanded));
+        if (n > 0 && n <= ARRAYSIZE(expanded)) {
+            folder = expanded;
+        }
+        while (folder.size() > 3 &&
+               (folder.back() == L'\\' || folder.back() == L'/')) {
+            folder.pop_back();  // Paths are built as folder + "\\" + name.
+        }
+        bool repeat = false;
+        for (const auto& f : folders) {
+            repeat = repeat || CompareStringOrdinal(f.c_str(), -1, folder.c_str(),
+                                                    -1, TRUE) == CSTR_EQUAL;
+        }
+        if (!repeat) {
+            folders.push_back(std::move(folder));
+        }
+    }
+    return folders;
+}
+
 static void LoadSettings() {
     Settings s{};
     s.delaySeconds = Wh_GetIntSetting(L"delaySeconds");
@@ -301,16 +375,12 @@ static void LoadSettings() {
 
     s.mode = WindhawkUtils::StringSetting::make(L"clipboardMode").get();
     s.pathFormat = WindhawkUtils::StringSetting::make(L"pathFormat").get();
-    s.folder = WindhawkUtils::StringSetting::make(L"folder").get();
-    if (s.folder.empty()) {
-        s.folder = DefaultScreenshotsFolder();
-    } else {
-        // Expand things like %USERPROFILE% so a pasted path with env vars resolves.
-        WCHAR expanded[MAX_PATH * 2];
-        DWORD n = ExpandEnvironmentStringsW(s.folder.c_str(), expanded,
-                                            ARRAYSIZE(expanded));
-        if (n > 0 && n <= ARRAYSIZE(expanded)) {
-            s.folder = expanded;
+    s.folders = ParseFolderList(
+        WindhawkUtils::StringSetting::make(L"folder").get());
+    if (s.folders.empty()) {
+        std::wstring folder = DefaultScreenshotsFolder();
+        if (!folder.empty()) {
+            s.folders.push_back(std::move(folder));
         }
     }
 
@@ -435,7 +505,7 @@ static std::wstring RenameByActiveWindow(const std::wstring& path) {
         }
         // Register the target before moving so the watcher ignores the event our
         // own rename fires, instead of re-processing (and re-renaming) the file.
-        MarkNameRecent(childName);
+        MarkPathRecent(candidate);
         if (MoveFileW(path.c_str(), candidate.c_str())) {
             return candidate;
         }
@@ -554,11 +624,13 @@ static void WriteBottomUp(BYTE* dest, const BYTE* topDown, UINT width,
 // what makes the copied image survive deletion of the source file. Windows
 // synthesizes CF_DIB and CF_BITMAP from CF_DIBV5 on demand, so publishing those too
 // would just be another full-size copy of the bitmap (it runs in a 32-bit process).
-static bool ClipboardImage(const std::wstring& path) {
+// Touches neither the clipboard nor any apartment-bound object, so it can run on a
+// decode thread. Returns nullptr if the file can't be decoded.
+static HGLOBAL DecodeImage(const std::wstring& path) {
     IWICImagingFactory* factory = nullptr;
     if (FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr,
                                 CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory)))) {
-        return false;
+        return nullptr;
     }
 
     IWICBitmapDecoder* decoder = nullptr;
@@ -622,21 +694,12 @@ static bool ClipboardImage(const std::wstring& path) {
         bv5->bV5CSType = LCS_WINDOWS_COLOR_SPACE;
         WriteBottomUp(v5 + sizeof(BITMAPV5HEADER), topDown, width, height);
         GlobalUnlock(hV5);
-
-        if (!OpenClipboard(nullptr)) {
-            break;
-        }
-        EmptyClipboard();
-        bool setV5 = SetClipboardData(CF_DIBV5, hV5) != nullptr;
-        if (setV5) {
-            hV5 = nullptr;  // Clipboard owns it now.
-        }
-        CloseClipboard();
-        ok = setV5;
+        ok = true;
     } while (false);
 
-    if (hV5) {
+    if (!ok && hV5) {
         GlobalFree(hV5);
+        hV5 = nullptr;
     }
     free(topDown);
     if (converter) {
@@ -649,6 +712,24 @@ static bool ClipboardImage(const std::wstring& path) {
         decoder->Release();
     }
     factory->Release();
+    return hV5;
+}
+
+// Publishes a payload from DecodeImage, taking ownership of it either way.
+static bool ClipboardImage(HGLOBAL image) {
+    if (!image) {
+        return false;
+    }
+    if (!OpenClipboard(nullptr)) {
+        GlobalFree(image);
+        return false;
+    }
+    EmptyClipboard();
+    bool ok = SetClipboardData(CF_DIBV5, image) != nullptr;
+    if (!ok) {
+        GlobalFree(image);  // Ownership stays with us on failure.
+    }
+    CloseClipboard();
     return ok;
 }
 
@@ -1505,54 +1586,11 @@ static void DeleteWatched(const std::wstring& path, const Settings& s) {
     }
 }
 
-// Waits until the screenshot has finished being written, or the mod stops.
-// Rather than waiting for Snipping Tool (or an antivirus scan) to release the
-// file, it watches the size stop changing and confirms the file can be opened
-// with full sharing. This reacts in about 50-100ms instead of stalling for
-// seconds behind another process's handle. A half-written file simply fails to
-// decode later, so acting slightly early is safe.
-static bool WaitForStableFile(const std::wstring& path) {
-    LONGLONG lastSize = -1;
-    for (int i = 0; i < 40; i++) {  // ~2s cap at 50ms steps.
-        WIN32_FILE_ATTRIBUTE_DATA info;
-        if (GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &info)) {
-            LONGLONG size =
-                ((LONGLONG)info.nFileSizeHigh << 32) | info.nFileSizeLow;
-            if (size > 0 && size == lastSize) {
-                HANDLE h = CreateFileW(
-                    path.c_str(), GENERIC_READ,
-                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
-                    nullptr, OPEN_EXISTING, 0, nullptr);
-                if (h != INVALID_HANDLE_VALUE) {
-                    CloseHandle(h);
-                    return true;
-                }
-            }
-            lastSize = size;
-        } else {
-            DWORD err = GetLastError();
-            if (err == ERROR_FILE_NOT_FOUND || err == ERROR_PATH_NOT_FOUND) {
-                return false;  // Deleted before we got to it.
-            }
-        }
-        if (WaitStop(50)) {
-            return false;
-        }
-    }
-    // Size never settled; proceed only if the file still exists.
-    return GetFileAttributesW(path.c_str()) != INVALID_FILE_ATTRIBUTES;
-}
-
-static void ProcessOne(std::wstring path) {
+// The watcher only queues a file once its writer is done with it, so processing
+// starts right away.
+static void ProcessOne(Job& job) {
     Settings s = SnapshotSettings();
-
-    DWORD t0 = GetTickCount();
-    if (!WaitForStableFile(path)) {
-        return;
-    }
-    if (s.logDetails) {
-        Wh_Log(L"stable in %lu ms: %s", GetTickCount() - t0, path.c_str());
-    }
+    std::wstring path = job.path;
 
     // Optional: rename to match the window in front, before anything downstream
     // (clipboard payloads and deletion) uses the path.
@@ -1589,7 +1627,11 @@ static void ProcessOne(std::wstring path) {
 
     bool copied;
     if (forceImage || s.mode == L"image") {
-        copied = ClipboardImage(path);
+        // Prefer the payload a decode thread prepared; decode here otherwise, such
+        // as when Copy and delete was picked with another clipboard mode.
+        HGLOBAL image = job.image;
+        job.image = nullptr;
+        copied = ClipboardImage(image ? image : DecodeImage(path));
     } else if (s.mode == L"file") {
         copied = ClipboardFile(path);
     } else if (s.mode == L"path") {
@@ -1625,38 +1667,100 @@ static void ProcessOne(std::wstring path) {
 // Worker: drains the queue on a dedicated COM (STA) thread
 // ============================================================================
 
-static bool DequeueOne(std::wstring& path) {
+// Takes the oldest job once it can be processed, meaning it isn't waiting on a
+// decode thread. Jobs run strictly in arrival order, so the clipboard always ends
+// up holding the newest screenshot and popups appear in the order shots were taken.
+static std::unique_ptr<Job> DequeueReady() {
+    std::unique_ptr<Job> job;
     EnterCriticalSection(&g_lock);
-    bool has = !g_queue.empty();
-    if (has) {
-        path = std::move(g_queue.front());
+    if (!g_queue.empty() &&
+        (!g_queue.front()->decode || g_queue.front()->decoded)) {
+        job = std::move(g_queue.front());
         g_queue.pop_front();
+        SetEvent(g_decodeEvent);  // Another job entered the decode window.
     }
     LeaveCriticalSection(&g_lock);
-    return has;
+    return job;
+}
+
+// Only the first few jobs are decoded ahead of the worker, which bounds how many
+// full-size bitmaps can sit in memory during a burst.
+static constexpr size_t kDecodeAhead = kDecodeThreads + 1;
+
+static Job* ClaimDecodeJob() {
+    Job* job = nullptr;
+    EnterCriticalSection(&g_lock);
+    size_t window = g_queue.size() < kDecodeAhead ? g_queue.size() : kDecodeAhead;
+    for (size_t i = 0; i < window; i++) {
+        if (g_queue[i]->decode && !g_queue[i]->claimed) {
+            job = g_queue[i].get();
+            job->claimed = true;
+            break;
+        }
+    }
+    if (!job) {
+        // Reset under the lock, so a job queued right after can't be missed.
+        ResetEvent(g_decodeEvent);
+    }
+    LeaveCriticalSection(&g_lock);
+    return job;
+}
+
+// Decodes queued screenshots in parallel. A claimed job stays at its place in the
+// queue, and the worker doesn't take it until it's decoded, so the pointer stays
+// valid until the result is handed over.
+static DWORD WINAPI DecodeThread(LPVOID) {
+    CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    HANDLE waits[] = {g_stopEvent, g_decodeEvent};
+    while (WaitForMultipleObjects(ARRAYSIZE(waits), waits, FALSE, INFINITE) ==
+           WAIT_OBJECT_0 + 1) {
+        Job* job = ClaimDecodeJob();
+        if (!job) {
+            continue;
+        }
+        HGLOBAL image = DecodeImage(job->path);
+        EnterCriticalSection(&g_lock);
+        job->image = image;
+        job->decoded = true;
+        LeaveCriticalSection(&g_lock);
+        SetEvent(g_workEvent);
+    }
+
+    CoUninitialize();
+    return 0;
 }
 
 // Caller must hold g_lock. Entries are appended in time order, so expired ones
-// are always at the front; drop them, then report whether the name is still
+// are always at the front; drop them, then report whether the path is still
 // inside its dedup window.
-static bool SeenRecently(const std::wstring& name, ULONGLONG now) {
+static bool SeenRecently(const std::wstring& path, ULONGLONG now) {
     while (!g_recent.empty() && g_recent.front().second <= now) {
-        g_recent.pop_front();
-    }
-    for (const auto& entry : g_recent) {
-        if (entry.first == name) {
-            return true;
+        auto it = g_recentExpiry.find(g_recent.front().first);
+        // A later entry for the same path extends the window; keep that one.
+        if (it != g_recentExpiry.end() && it->second <= now) {
+            g_recentExpiry.erase(it);
         }
+        g_recent.pop_front();
     }
-    return false;
+    auto it = g_recentExpiry.find(path);
+    return it != g_recentExpiry.end() && it->second > now;
 }
 
 static void ReleaseInflight(const std::wstring& path) {
-    std::wstring name = path.substr(path.find_last_of(L"\\/") + 1);
     ULONGLONG now = GetTickCount64();
     EnterCriticalSection(&g_lock);
-    g_inflight.erase(name);
-    g_recent.push_back({name, now + kDuplicateEventWindowMs});
+    g_inflight.erase(path);
+    RememberRecent(path, now);
+    LeaveCriticalSection(&g_lock);
+}
+
+// A pending file that went away before it was handled. Unlike ReleaseInflight,
+// the path isn't remembered as recent: a safe-save writer deletes the file and
+// renames a temp file into its place, and that final event is the screenshot.
+static void AbandonInflight(const std::wstring& path) {
+    EnterCriticalSection(&g_lock);
+    g_inflight.erase(path);
     LeaveCriticalSection(&g_lock);
 }
 
@@ -1759,10 +1863,10 @@ static DWORD WINAPI WorkerThread(LPVOID) {
             Settings s = SnapshotSettings();
             SyncToastRegistration(s.popup);
         }
-        std::wstring path;
-        while (!WaitStop(0) && DequeueOne(path)) {
-            ProcessOne(path);
-            ReleaseInflight(path);
+        std::unique_ptr<Job> job;
+        while (!WaitStop(0) && (job = DequeueReady())) {
+            ProcessOne(*job);
+            ReleaseInflight(job->path);
         }
     }
 
@@ -1814,40 +1918,184 @@ static bool JustCreated(const std::wstring& path) {
     return true;
 }
 
-static void Enqueue(const std::wstring& folder, const std::wstring& name) {
-    if (!IsSafeChildName(name) || !IsSupportedImage(name)) {
+// Hands a file whose writer is done to the worker. Its path is already in
+// g_inflight, which it was added to when the file was first seen.
+static void QueueJob(const std::wstring& path) {
+    auto job = std::make_unique<Job>();
+    job->path = path;
+    EnterCriticalSection(&g_lock);
+    job->decode = g_decodeThreadCount > 0 && g_settings.mode == L"image";
+    g_queue.push_back(std::move(job));
+    SetEvent(g_decodeEvent);
+    LeaveCriticalSection(&g_lock);
+    SetEvent(g_workEvent);
+}
+
+// ============================================================================
+// Watcher: ReadDirectoryChangesW for every folder on one completion port
+// ============================================================================
+
+// Posted to g_watchPort for a settings change and at shutdown; the watcher tells
+// them apart by checking g_stopEvent.
+static constexpr ULONG_PTR kWakeKey = 0;
+
+// ReadDirectoryChangesW can't deliver more than 64KB at once for a network
+// share, and a burst of captures fills a smaller buffer quickly.
+static constexpr DWORD kChangeBufferSize = 64 * 1024;
+
+struct FolderWatch {
+    std::wstring folder;
+    HANDLE dir = INVALID_HANDLE_VALUE;
+    OVERLAPPED ov{};
+    bool busy = false;      // A read is outstanding, so ov and buffers must stay put.
+    int current = 0;        // Buffer the outstanding read fills.
+    int openFailures = 0;
+    ULONGLONG retryAt = 0;  // When to try opening again after a failure.
+    // Names already present when the folder was opened. They are never acted on,
+    // which is the literal safety invariant "never touch files that were already
+    // in the folder." This is what stops a flood when OneDrive Files On-Demand
+    // hydrates a folder full of old screenshots: each download surfaces as an
+    // ADDED or RENAMED event for a name in this set, so it is ignored. Refreshed
+    // every time the folder is (re)opened.
+    std::set<std::wstring> preexisting;
+    // Two buffers, so the next read is armed before the last one is parsed.
+    alignas(DWORD) BYTE buffers[2][kChangeBufferSize];
+};
+
+// A new screenshot whose writer may still have it open. Watch thread only.
+struct PendingFile {
+    ULONGLONG detectedAt;
+    ULONGLONG nextPoll;  // Fallback recheck, for writers whose close fires no event.
+    LONGLONG lastSize;   // Size at the last fallback recheck.
+    bool dirty;          // A change event arrived since the last check.
+};
+static std::unordered_map<std::wstring, PendingFile> g_pending;
+
+// A file that's neither done nor gone within this is handed over anyway, as the
+// old size-polling wait did. A half-written file simply fails to decode later,
+// so acting slightly early is safe.
+static constexpr ULONGLONG kStableCapMs = 2000;
+static constexpr ULONGLONG kStablePollMs = 50;
+
+enum class WriterState { Done, Writing, Locked, Gone };
+
+// Whether anyone still has the file open for writing. Opening it while denying
+// write access only succeeds once every writer has closed its handle, so a
+// finished screenshot is noticed on the first change event after the writer lets
+// go, instead of after the size has been seen to stop changing. Readers, such as
+// an antivirus scan or Snipping Tool's preview, don't hold it up. The handle is
+// closed right away, so a writer is only ever refused during the open itself.
+static WriterState CheckWriter(const std::wstring& path, LONGLONG* size) {
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &info)) {
+        DWORD err = GetLastError();
+        return err == ERROR_FILE_NOT_FOUND || err == ERROR_PATH_NOT_FOUND
+                   ? WriterState::Gone
+                   : WriterState::Locked;
+    }
+    *size = ((LONGLONG)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+
+    HANDLE h = CreateFileW(path.c_str(), GENERIC_READ,
+                           FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                           OPEN_EXISTING, 0, nullptr);
+    if (h != INVALID_HANDLE_VALUE) {
+        CloseHandle(h);
+        return *size > 0 ? WriterState::Done : WriterState::Writing;
+    }
+    // Someone has write access. Whether it can be read at all decides if the
+    // fallback below may act on it.
+    h = CreateFileW(path.c_str(), GENERIC_READ,
+                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                    nullptr, OPEN_EXISTING, 0, nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        return WriterState::Locked;
+    }
+    CloseHandle(h);
+    return WriterState::Writing;
+}
+
+// Rechecks every pending file that saw a change event or is due for its fallback
+// recheck, queueing the ones that are ready. A writer that keeps its handle open
+// after the last write is caught by the fallback once the size has stopped
+// changing between two rechecks. Returns how long until the next recheck is due.
+static DWORD UpdatePendingFiles(ULONGLONG now, bool logDetails) {
+    DWORD timeout = INFINITE;
+    for (auto it = g_pending.begin(); it != g_pending.end();) {
+        PendingFile& p = it->second;
+        bool timed = now >= p.nextPoll;
+        if (!p.dirty && !timed) {
+            DWORD due = (DWORD)(p.nextPoll - now);
+            timeout = due < timeout ? due : timeout;
+            ++it;
+            continue;
+        }
+        p.dirty = false;
+
+        LONGLONG size = -1;
+        WriterState state = CheckWriter(it->first, &size);
+        if (state == WriterState::Gone) {
+            AbandonInflight(it->first);  // Deleted before we got to it.
+            it = g_pending.erase(it);
+            continue;
+        }
+        bool ready = state == WriterState::Done;
+        if (!ready && timed) {
+            ready = (state == WriterState::Writing && size > 0 &&
+                     size == p.lastSize) ||
+                    now - p.detectedAt >= kStableCapMs;
+            p.lastSize = size;
+            p.nextPoll = now + kStablePollMs;
+        }
+        if (!ready) {
+            DWORD due = (DWORD)(p.nextPoll - now);
+            timeout = due < timeout ? due : timeout;
+            ++it;
+            continue;
+        }
+        if (logDetails) {
+            Wh_Log(L"stable in %llu ms: %s", now - p.detectedAt,
+                   it->first.c_str());
+        }
+        QueueJob(it->first);
+        it = g_pending.erase(it);
+    }
+    return timeout;
+}
+
+// A new file turned up. Duplicate events for a file that's already pending,
+// queued or recently handled are coalesced into the first one.
+static void TrackNewFile(FolderWatch& w, const std::wstring& name,
+                         ULONGLONG now) {
+    if (w.preexisting.count(name) != 0) {
         return;
     }
-    if (!JustCreated(folder + L"\\" + name)) {
+    std::wstring path = w.folder + L"\\" + name;
+    auto it = g_pending.find(path);
+    if (it != g_pending.end()) {
+        it->second.dirty = true;
         return;
     }
-    ULONGLONG now = GetTickCount64();
-    EnterCriticalSection(&g_lock);
-    // Skip names present when watching started (g_preexisting), then dedup rapid
-    // duplicate events (g_inflight) and the delayed follow-up event for a name we
-    // just finished handling (g_recent), such as OneDrive rewriting the file as a
-    // placeholder after the first notification closed.
-    bool added = !SeenRecently(name, now) && g_preexisting.count(name) == 0 &&
-                 g_inflight.insert(name).second;
-    if (added) {
-        g_queue.push_back(folder + L"\\" + name);
+    if (!JustCreated(path)) {
+        return;
     }
+    EnterCriticalSection(&g_lock);
+    // Skip the delayed follow-up event for a path we just finished handling
+    // (g_recent), such as OneDrive rewriting the file as a placeholder after the
+    // first notification closed, and anything already queued (g_inflight).
+    bool added = !SeenRecently(path, now) && g_inflight.insert(path).second;
     bool logDetails = g_settings.logDetails;
     LeaveCriticalSection(&g_lock);
-    if (added) {
-        SetEvent(g_workEvent);
-        if (logDetails) {
-            Wh_Log(L"detected %s", name.c_str());
-        }
+    if (!added) {
+        return;
+    }
+    g_pending.emplace(path, PendingFile{now, now + kStablePollMs, -1, true});
+    if (logDetails) {
+        Wh_Log(L"detected %s", name.c_str());
     }
 }
 
-// ============================================================================
-// Watcher: overlapped ReadDirectoryChangesW with a clean stop/reload path
-// ============================================================================
-
-static void ParseNotifications(const std::wstring& folder, const BYTE* buffer,
-                               DWORD bytes) {
+static void ParseNotifications(FolderWatch& w, const BYTE* buffer, DWORD bytes,
+                               ULONGLONG now) {
     const BYTE* endp = buffer + bytes;
     for (auto* info = (const FILE_NOTIFY_INFORMATION*)buffer;;) {
         // Bound every field against the reported size, so a malformed record can't
@@ -1861,11 +2109,27 @@ static void ParseNotifications(const std::wstring& folder, const BYTE* buffer,
         if (nameEnd > endp) {
             break;
         }
-        if (info->Action == FILE_ACTION_ADDED ||
-            info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
-            std::wstring name(info->FileName,
-                              info->FileNameLength / sizeof(wchar_t));
-            Enqueue(folder, name);
+        std::wstring name(info->FileName,
+                          info->FileNameLength / sizeof(wchar_t));
+        if (IsSafeChildName(name) && IsSupportedImage(name)) {
+            if (info->Action == FILE_ACTION_ADDED ||
+                info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+                TrackNewFile(w, name, now);
+            } else if (info->Action == FILE_ACTION_MODIFIED) {
+                // Most often the writer finishing up; recheck it.
+                auto it = g_pending.find(w.folder + L"\\" + name);
+                if (it != g_pending.end()) {
+                    it->second.dirty = true;
+                }
+            } else if (info->Action == FILE_ACTION_REMOVED ||
+                       info->Action == FILE_ACTION_RENAMED_OLD_NAME) {
+                // A temp file renamed into place, or deleted before we got to it.
+                auto it = g_pending.find(w.folder + L"\\" + name);
+                if (it != g_pending.end()) {
+                    AbandonInflight(it->first);
+                    g_pending.erase(it);
+                }
+            }
         }
         if (!info->NextEntryOffset) {
             break;
@@ -1880,119 +2144,168 @@ static void ParseNotifications(const std::wstring& folder, const BYTE* buffer,
 // each time the directory is opened, before the first change notification is
 // armed. Placeholders are enumerated like any other entry, so dehydrated old
 // screenshots are captured too.
-static void SnapshotExistingNames(const std::wstring& folder) {
-    std::set<std::wstring> names;
+static void SnapshotExistingNames(FolderWatch& w) {
+    w.preexisting.clear();
     WIN32_FIND_DATAW fd;
-    HANDLE h = FindFirstFileW((folder + L"\\*").c_str(), &fd);
+    HANDLE h = FindFirstFileW((w.folder + L"\\*").c_str(), &fd);
     if (h != INVALID_HANDLE_VALUE) {
         do {
             if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-                names.insert(fd.cFileName);
+                w.preexisting.insert(fd.cFileName);
             }
         } while (FindNextFileW(h, &fd));
         FindClose(h);
     }
-    EnterCriticalSection(&g_lock);
-    g_preexisting = std::move(names);
-    LeaveCriticalSection(&g_lock);
 }
 
-static DWORD WINAPI WatchThread(LPVOID) {
-    OVERLAPPED ov{};
-    ov.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
-    if (!ov.hEvent) {
-        return 0;
-    }
-    HANDLE readyWaits[] = {g_stopEvent, g_reloadEvent, ov.hEvent};
+static bool ArmWatch(FolderWatch& w) {
+    ZeroMemory(&w.ov, sizeof(w.ov));
+    // Size and write-time changes are what report a writer finishing a file.
+    w.busy = ReadDirectoryChangesW(
+                 w.dir, w.buffers[w.current], kChangeBufferSize, FALSE,
+                 FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE |
+                     FILE_NOTIFY_CHANGE_LAST_WRITE,
+                 nullptr, &w.ov, nullptr) != FALSE;
+    return w.busy;
+}
 
-    int openFailures = 0;
-    while (!WaitStop(0)) {
-        Settings s = SnapshotSettings();
-        if (s.folder.empty()) {
-            // Wait indefinitely: a settings change signals g_reloadEvent, so there
-            // is nothing to poll for here.
-            HANDLE idle[] = {g_stopEvent, g_reloadEvent};
-            WaitForMultipleObjects(2, idle, FALSE, INFINITE);
-            continue;
-        }
+// Closes a folder whose watch stopped working and schedules another attempt.
+// The handle opened but change notifications don't work on this path (some
+// network redirectors and virtual/sync filesystems return ERROR_INVALID_FUNCTION),
+// or the volume went away. Back off like the open-failure path so a persistently
+// failing watch can't peg a core re-opening and re-enumerating in a spin.
+static void CloseWatch(FolderWatch& w, ULONGLONG now) {
+    CloseHandle(w.dir);
+    w.dir = INVALID_HANDLE_VALUE;
+    w.retryAt = now + 2000;
+}
 
-        HANDLE dir = CreateFileW(
-            s.folder.c_str(), FILE_LIST_DIRECTORY,
-            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
-            OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
-            nullptr);
-        if (dir == INVALID_HANDLE_VALUE) {
-            // The folder may appear later (Pictures\Screenshots isn't created until
-            // the first Win+PrintScreen). Back off from 2s to 30s after a few tries
-            // so a Snipping-Tool-only machine isn't polled twice a second forever.
-            DWORD wait = openFailures < 5 ? 2000 : 30000;
-            if (openFailures < 1000000) {
-                openFailures++;
-            }
-            HANDLE idle[] = {g_stopEvent, g_reloadEvent};
-            WaitForMultipleObjects(2, idle, FALSE, wait);
-            continue;
+static void OpenWatch(FolderWatch& w, ULONGLONG now) {
+    w.dir = CreateFileW(
+        w.folder.c_str(), FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+        nullptr);
+    if (w.dir == INVALID_HANDLE_VALUE) {
+        // The folder may appear later (Pictures\Screenshots isn't created until
+        // the first Win+PrintScreen). Back off from 2s to 30s after a few tries
+        // so a Snipping-Tool-only machine isn't polled twice a second forever.
+        w.retryAt = now + (w.openFailures < 5 ? 2000 : 30000);
+        if (w.openFailures < 1000000) {
+            w.openFailures++;
         }
-        openFailures = 0;
+        return;
+    }
+    w.openFailures = 0;
+    if (!CreateIoCompletionPort(w.dir, g_watchPort, (ULONG_PTR)&w, 0)) {
+        CloseWatch(w, now);
+        return;
+    }
 
-        // Snapshot existing names before arming notifications so downloads or
-        // sync churn on pre-existing files never look like new screenshots.
-        SnapshotExistingNames(s.folder);
+    // Snapshot existing names before arming notifications so downloads or
+    // sync churn on pre-existing files never look like new screenshots.
+    SnapshotExistingNames(w);
+    if (!ArmWatch(w)) {
+        CloseWatch(w, now);
+    }
+}
 
-        // ReadDirectoryChangesW writes FILE_NOTIFY_INFORMATION records that must
-        // be DWORD aligned; alignas guarantees it (a plain BYTE array need not be).
-        alignas(DWORD) BYTE buffer[16384];
-        bool reopen = false;
-        while (!reopen) {
-            ResetEvent(ov.hEvent);
-            DWORD bytes = 0;
-            if (!ReadDirectoryChangesW(
-                    dir, buffer, sizeof(buffer), FALSE,
-                    FILE_NOTIFY_CHANGE_FILE_NAME,
-                    &bytes, &ov, nullptr)) {
-                break;  // Re-open the directory.
+static void OnWatchCompleted(FolderWatch& w, bool ok, DWORD bytes,
+                             ULONGLONG now) {
+    w.busy = false;
+    if (!ok) {
+        CloseWatch(w, now);
+        return;
+    }
+    // Re-arm into the other buffer first, so changes that happen while this
+    // batch is parsed are already being collected.
+    const BYTE* filled = w.buffers[w.current];
+    w.current ^= 1;
+    bool armed = ArmWatch(w);
+    if (bytes == 0) {
+        // Buffer overflow: notifications were dropped. We can't tell which
+        // files are new, and rescanning could delete pre-existing files,
+        // so we deliberately skip rather than risk the safety invariant.
+        Wh_Log(L"Change buffer overflow; some screenshots may be skipped");
+    } else {
+        ParseNotifications(w, filled, bytes, now);
+    }
+    if (!armed) {
+        CloseWatch(w, now);
+    }
+}
+
+// Watches every configured folder from one thread. Change notifications,
+// settings reloads and the stop request all arrive on g_watchPort, and the wait
+// times out only when a pending file or a folder retry is due.
+static DWORD WINAPI WatchThread(LPVOID) {
+    bool stop = false;
+    while (!stop) {
+        Settings s = SnapshotSettings();
+        std::vector<std::unique_ptr<FolderWatch>> watches;
+        for (const auto& folder : s.folders) {
+            watches.push_back(std::make_unique<FolderWatch>());
+            watches.back()->folder = folder;
+        }
+
+        bool reload = false;
+        while (!stop && !reload) {
+            ULONGLONG now = GetTickCount64();
+            DWORD timeout = UpdatePendingFiles(now, s.logDetails);
+            for (auto& w : watches) {
+                if (w->dir == INVALID_HANDLE_VALUE && now >= w->retryAt) {
+                    OpenWatch(*w, now);
+                }
+                if (w->dir == INVALID_HANDLE_VALUE) {
+                    DWORD due = (DWORD)(w->retryAt - now);
+                    timeout = due < timeout ? due : timeout;
+                }
             }
 
-            DWORD w = WaitForMultipleObjects(3, readyWaits, FALSE, INFINITE);
-            if (w == WAIT_OBJECT_0) {  // Stop.
-                CancelIoEx(dir, &ov);
-                GetOverlappedResult(dir, &ov, &bytes, TRUE);
-                CloseHandle(dir);
-                CloseHandle(ov.hEvent);
-                return 0;
+            DWORD bytes = 0;
+            ULONG_PTR key = 0;
+            OVERLAPPED* ov = nullptr;
+            BOOL ok = GetQueuedCompletionStatus(g_watchPort, &bytes, &key, &ov,
+                                                timeout);
+            if (ov) {
+                OnWatchCompleted(*(FolderWatch*)key, ok != FALSE, bytes,
+                                 GetTickCount64());
+            } else if (ok && key == kWakeKey) {
+                stop = WaitStop(0);
+                reload = !stop;
+            } else if (GetLastError() != WAIT_TIMEOUT) {
+                stop = true;  // The port itself failed; nothing more will arrive.
             }
-            if (w == WAIT_OBJECT_0 + 1) {  // Settings changed.
-                CancelIoEx(dir, &ov);
-                GetOverlappedResult(dir, &ov, &bytes, TRUE);
-                reopen = true;
-                break;
+        }
+
+        // Cancel every outstanding read and wait for it to complete, since the
+        // kernel writes into the watch's OVERLAPPED and buffers until then.
+        for (auto& w : watches) {
+            if (w->busy) {
+                CancelIoEx(w->dir, &w->ov);
             }
-            // I/O completed.
-            if (!GetOverlappedResult(dir, &ov, &bytes, FALSE)) {
-                break;
+        }
+        for (auto& w : watches) {
+            while (w->busy) {
+                DWORD bytes = 0;
+                ULONG_PTR key = 0;
+                OVERLAPPED* ov = nullptr;
+                if (!GetQueuedCompletionStatus(g_watchPort, &bytes, &key, &ov,
+                                               INFINITE) &&
+                    !ov) {
+                    break;
+                }
+                if (ov) {
+                    ((FolderWatch*)key)->busy = false;
+                } else if (key == kWakeKey) {
+                    stop = stop || WaitStop(0);
+                }
             }
-            if (bytes == 0) {
-                // Buffer overflow: notifications were dropped. We can't tell which
-                // files are new, and rescanning could delete pre-existing files,
-                // so we deliberately skip rather than risk the safety invariant.
-                Wh_Log(L"Change buffer overflow; some screenshots may be skipped");
-                continue;
+            if (w->dir != INVALID_HANDLE_VALUE) {
+                CloseHandle(w->dir);
             }
-            ParseNotifications(s.folder, buffer, bytes);
-        }
-        CloseHandle(dir);
-        if (!reopen) {
-            // The inner loop ended on an error, not a reload: the handle opened but
-            // change notifications don't work on this path (some network redirectors
-            // and virtual/sync filesystems return ERROR_INVALID_FUNCTION), or the
-            // volume went away. Back off like the open-failure path so a persistently
-            // failing watch can't peg a core re-opening and re-enumerating in a spin.
-            HANDLE idle[] = {g_stopEvent, g_reloadEvent};
-            WaitForMultipleObjects(2, idle, FALSE, 2000);
         }
     }
-
-    CloseHandle(ov.hEvent);
     return 0;
 }
 
@@ -2000,43 +2313,78 @@ static DWORD WINAPI WatchThread(LPVOID) {
 // Tool-mod entry points
 // ============================================================================
 
+// Stops and closes whatever WhTool_ModInit got as far as starting. Every thread
+// observes g_stopEvent and must be gone before the events, the queued jobs and
+// the critical sections are destroyed.
+static void ShutDown() {
+    SetEvent(g_stopEvent);
+    if (g_watchPort) {
+        PostQueuedCompletionStatus(g_watchPort, 0, kWakeKey, nullptr);
+    }
+    SetEvent(g_workEvent);
+
+    HANDLE threads[2 + kDecodeThreads];
+    DWORD count = 0;
+    for (HANDLE h : {g_watchThread, g_workerThread}) {
+        if (h) {
+            threads[count++] = h;
+        }
+    }
+    for (int i = 0; i < g_decodeThreadCount; i++) {
+        threads[count++] = g_decodeThreads[i];
+    }
+    if (count) {
+        WaitForMultipleObjects(count, threads, TRUE, INFINITE);
+    }
+    for (DWORD i = 0; i < count; i++) {
+        CloseHandle(threads[i]);
+    }
+    g_watchThread = g_workerThread = nullptr;
+    g_decodeThreadCount = 0;
+
+    g_queue.clear();
+    g_pending.clear();
+    for (HANDLE* h : {&g_stopEvent, &g_watchPort, &g_workEvent, &g_decodeEvent,
+                      &g_toastActionEvent}) {
+        if (*h) {
+            CloseHandle(*h);
+            *h = nullptr;
+        }
+    }
+    DeleteCriticalSection(&g_lock);
+    DeleteCriticalSection(&g_toastLock);
+}
+
 BOOL WhTool_ModInit() {
     InitializeCriticalSection(&g_lock);
     InitializeCriticalSection(&g_toastLock);
     LoadSettings();
 
     g_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);   // Manual reset.
-    g_reloadEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);  // Auto reset.
+    g_watchPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
     g_workEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);    // Auto reset.
+    g_decodeEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);   // Manual reset.
     g_toastActionEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);  // Auto reset.
-    if (!g_stopEvent || !g_reloadEvent || !g_workEvent || !g_toastActionEvent) {
-        if (g_stopEvent) CloseHandle(g_stopEvent);
-        if (g_reloadEvent) CloseHandle(g_reloadEvent);
-        if (g_workEvent) CloseHandle(g_workEvent);
-        if (g_toastActionEvent) CloseHandle(g_toastActionEvent);
-        g_stopEvent = g_reloadEvent = g_workEvent = g_toastActionEvent = nullptr;
-        DeleteCriticalSection(&g_lock);
-        DeleteCriticalSection(&g_toastLock);
+    if (!g_stopEvent || !g_watchPort || !g_workEvent || !g_decodeEvent ||
+        !g_toastActionEvent) {
+        ShutDown();
         return FALSE;
     }
 
+    // The decode threads only speed things up, so running with fewer than asked
+    // for (or none, decoding on the worker instead) is fine. They must exist
+    // before the watcher queues anything, since a job's decode flag depends on it.
+    for (int i = 0; i < kDecodeThreads; i++) {
+        HANDLE h = CreateThread(nullptr, 0, DecodeThread, nullptr, 0, nullptr);
+        if (h) {
+            g_decodeThreads[g_decodeThreadCount++] = h;
+        }
+    }
+
     g_workerThread = CreateThread(nullptr, 0, WorkerThread, nullptr, 0, nullptr);
     g_watchThread = CreateThread(nullptr, 0, WatchThread, nullptr, 0, nullptr);
     if (!g_workerThread || !g_watchThread) {
-        SetEvent(g_stopEvent);
-        SetEvent(g_workEvent);
-        if (g_watchThread) WaitForSingleObject(g_watchThread, INFINITE);
-        if (g_workerThread) WaitForSingleObject(g_workerThread, INFINITE);
-        if (g_watchThread) CloseHandle(g_watchThread);
-        if (g_workerThread) CloseHandle(g_workerThread);
-        CloseHandle(g_stopEvent);
-        CloseHandle(g_reloadEvent);
-        CloseHandle(g_workEvent);
-        CloseHandle(g_toastActionEvent);
-        g_watchThread = g_workerThread = nullptr;
-        g_stopEvent = g_reloadEvent = g_workEvent = g_toastActionEvent = nullptr;
-        DeleteCriticalSection(&g_lock);
-        DeleteCriticalSection(&g_toastLock);
+        ShutDown();
         return FALSE;
     }
     return TRUE;
@@ -2044,7 +2392,8 @@ BOOL WhTool_ModInit() {
 
 void WhTool_ModSettingsChanged() {
     LoadSettings();
-    SetEvent(g_reloadEvent);  // Re-open the folder in case the path changed.
+    // Re-open the folders in case the paths changed.
+    PostQueuedCompletionStatus(g_watchPort, 0, kWakeKey, nullptr);
     SetEvent(g_workEvent);    // Wake the worker so it can follow the popup setting.
 }
 
@@ -2056,32 +2405,7 @@ void WhTool_ModUninit() {
     if (dlg) {
         SendMessageW(dlg, TDM_CLICK_BUTTON, ACTION_KEEP, 0);
     }
-    SetEvent(g_workEvent);
-
-    HANDLE threads[] = {g_watchThread, g_workerThread};
-    // Both threads observe g_stopEvent and must be gone before their events and
-    // critical sections are destroyed.
-    WaitForMultipleObjects(2, threads, TRUE, INFINITE);
-    if (g_watchThread) {
-        CloseHandle(g_watchThread);
-    }
-    if (g_workerThread) {
-        CloseHandle(g_workerThread);
-    }
-    if (g_stopEvent) {
-        CloseHandle(g_stopEvent);
-    }
-    if (g_reloadEvent) {
-        CloseHandle(g_reloadEvent);
-    }
-    if (g_workEvent) {
-        CloseHandle(g_workEvent);
-    }
-    if (g_toastActionEvent) {
-        CloseHandle(g_toastActionEvent);
-    }
-    DeleteCriticalSection(&g_lock);
-    DeleteCriticalSection(&g_toastLock);
+    ShutDown();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
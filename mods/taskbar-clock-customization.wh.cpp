@@ -2,7 +2,7 @@
 // @id              taskbar-clock-customization
 // @name            Taskbar Clock Customization
 // @description     Custom date/time format, news feed, weather, performance metrics (upload/download speed, CPU, RAM, GPU, battery), media player info, custom fonts and colors, and more
-// @version         1.8
+// @version         1.8.2
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -258,6 +258,11 @@ styles, such as the font color and size.
     $name: Update interval
     $description: >-
       The update interval, in seconds, of the system performance metrics.
+  - HistoryLength: 1
+    $name: History length
+    $description: >-
+      The number of recent samples to average the system performance metrics
+      over, for a smoother display. Set to 1 to show the latest sample.
   - NetworkAdapterName: ""
     $name: Network adapter name
     $description: >-
@@ -524,12 +529,15 @@ using WindhawkUtils::StringSetting;
 
 #include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <functional>
+#include <limits>
 #include <mutex>
 #include <optional>
 #include <regex>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -594,6 +602,7 @@ struct DataCollectionSettings {
     int diskMetricsFixedDecimals;
     PercentageFormat percentageFormat;
     int updateInterval;
+    int historyLength;
     StringSetting networkAdapterName;
     StringSetting gpuAdapterName;
 };
@@ -826,78 +835,166 @@ GetDateFormatW_t GetDateFormatW_Original;
 using SendMessageW_t = decltype(&SendMessageW);
 SendMessageW_t SendMessageW_Original;
 
-std::optional<std::wstring> GetUrlContent(PCWSTR lpUrl,
-                                          bool failIfNot200 = true) {
+// HTTP validators of a previous response, used to make conditional requests.
+struct UrlValidators {
+    std::wstring etag;
+    std::wstring lastModified;
+};
+
+enum class UrlFetchResult {
+    failed,
+    notModified,
+    ok,
+};
+
+std::wstring QueryHttpHeader(HINTERNET hUrlHandle, DWORD dwInfoLevel) {
+    WCHAR buffer[256];
+    DWORD bufferSize = sizeof(buffer);
+    if (!HttpQueryInfo(hUrlHandle, dwInfoLevel, buffer, &bufferSize,
+                       nullptr)) {
+        return std::wstring();
+    }
+
+    return std::wstring(buffer, bufferSize / sizeof(WCHAR));
+}
+
+// Downloads the URL as raw (assumed UTF-8) bytes. `onData` is called after
+// each received chunk with all the content received so far, and can return
+// false to stop the download early. If `validators` is set, a conditional
+// request is made with the validators of the previous response, and the
+// validators of the new response are stored back.
+UrlFetchResult FetchUrl(
+    PCWSTR lpUrl,
+    bool failIfNot200,
+    UrlValidators* validators,
+    std::string* content,
+    const std::function<bool(std::string_view content, bool complete)>&
+        onData) {
     HINTERNET hOpenHandle = InternetOpen(
         L"WindhawkMod", INTERNET_OPEN_TYPE_PRECONFIG, nullptr, nullptr, 0);
     if (!hOpenHandle) {
-        return std::nullopt;
+        return UrlFetchResult::failed;
     }
 
-    HINTERNET hUrlHandle =
-        InternetOpenUrl(hOpenHandle, lpUrl, nullptr, 0,
-                        INTERNET_FLAG_NO_AUTH | INTERNET_FLAG_NO_CACHE_WRITE |
-                            INTERNET_FLAG_NO_COOKIES | INTERNET_FLAG_NO_UI |
-                            INTERNET_FLAG_PRAGMA_NOCACHE | INTERNET_FLAG_RELOAD,
-                        0);
+    std::wstring headers;
+    if (validators) {
+        if (!validators->etag.empty()) {
+            headers += L"If-None-Match: " + validators->etag + L"\r\n";
+        }
+        if (!validators->lastModified.empty()) {
+            headers +=
+                L"If-Modified-Since: " + validators->lastModified + L"\r\n";
+        }
+    }
+
+    HINTERNET hUrlHandle = InternetOpenUrl(
+        hOpenHandle, lpUrl, headers.empty() ? nullptr : headers.c_str(),
+        headers.empty() ? 0 : (DWORD)-1,
+        INTERNET_FLAG_NO_AUTH | INTERNET_FLAG_NO_CACHE_WRITE |
+            INTERNET_FLAG_NO_COOKIES | INTERNET_FLAG_NO_UI |
+            INTERNET_FLAG_PRAGMA_NOCACHE | INTERNET_FLAG_RELOAD,
+        0);
     if (!hUrlHandle) {
         InternetCloseHandle(hOpenHandle);
-        return std::nullopt;
+        return UrlFetchResult::failed;
     }
 
-    if (failIfNot200) {
-        DWORD dwStatusCode = 0;
-        DWORD dwStatusCodeSize = sizeof(dwStatusCode);
-        if (!HttpQueryInfo(hUrlHandle,
-                           HTTP_QUERY_STATUS_CODE | HTTP_QUERY_FLAG_NUMBER,
-                           &dwStatusCode, &dwStatusCodeSize, nullptr) ||
-            dwStatusCode != 200) {
-            InternetCloseHandle(hUrlHandle);
-            InternetCloseHandle(hOpenHandle);
-            return std::nullopt;
-        }
+    DWORD dwStatusCode = 0;
+    DWORD dwStatusCodeSize = sizeof(dwStatusCode);
+    if (!HttpQueryInfo(hUrlHandle,
+                       HTTP_QUERY_STATUS_CODE | HTTP_QUERY_FLAG_NUMBER,
+                       &dwStatusCode, &dwStatusCodeSize, nullptr)) {
+        dwStatusCode = 0;
     }
 
-    LPBYTE pUrlContent = (LPBYTE)HeapAlloc(GetProcessHeap(), 0, 0x400);
-    if (!pUrlContent) {
+    if (dwStatusCode == HTTP_STATUS_NOT_MODIFIED && !headers.empty()) {
         InternetCloseHandle(hUrlHandle);
         InternetCloseHandle(hOpenHandle);
-        return std::nullopt;
+        return UrlFetchResult::notModified;
     }
 
-    DWORD dwNumberOfBytesRead;
-    InternetReadFile(hUrlHandle, pUrlContent, 0x400, &dwNumberOfBytesRead);
-    DWORD dwLength = dwNumberOfBytesRead;
+    if (failIfNot200 && dwStatusCode != HTTP_STATUS_OK) {
+        InternetCloseHandle(hUrlHandle);
+        InternetCloseHandle(hOpenHandle);
+        return UrlFetchResult::failed;
+    }
 
-    while (dwNumberOfBytesRead) {
-        LPBYTE pNewUrlContent = (LPBYTE)HeapReAlloc(
-            GetProcessHeap(), 0, pUrlContent, dwLength + 0x400);
-        if (!pNewUrlContent) {
-            InternetCloseHandle(hUrlHandle);
-            InternetCloseHandle(hOpenHandle);
-            HeapFree(GetProcessHeap(), 0, pUrlContent);
-            return std::nullopt;
+    if (validators) {
+        if (dwStatusCode == HTTP_STATUS_OK) {
+            validators->etag = QueryHttpHeader(hUrlHandle, HTTP_QUERY_ETAG);
+            validators->lastModified =
+                QueryHttpHeader(hUrlHandle, HTTP_QUERY_LAST_MODIFIED);
+        } else {
+            *validators = {};
         }
+    }
 
-        pUrlContent = pNewUrlContent;
-        InternetReadFile(hUrlHandle, pUrlContent + dwLength, 0x400,
-                         &dwNumberOfBytesRead);
-        dwLength += dwNumberOfBytesRead;
+    constexpr DWORD kChunkSize = 0x4000;
+
+    content->clear();
+    bool readFailed = false;
+    while (true) {
+        size_t length = content->size();
+        content->resize(length + kChunkSize);
+
+        DWORD dwNumberOfBytesRead = 0;
+        if (!InternetReadFile(hUrlHandle, content->data() + length, kChunkSize,
+                              &dwNumberOfBytesRead)) {
+            readFailed = true;
+            dwNumberOfBytesRead = 0;
+        }
+
+        content->resize(length + dwNumberOfBytesRead);
+        bool complete = dwNumberOfBytesRead == 0;
+
+        // Stopping early is fine for validation: what was extracted is the
+        // same for the whole content of this version.
+        if (!onData(*content, complete) || complete) {
+            break;
+        }
     }
 
     InternetCloseHandle(hUrlHandle);
     InternetCloseHandle(hOpenHandle);
 
-    // Assume UTF-8.
-    int charsNeeded = MultiByteToWideChar(CP_UTF8, 0, (PCSTR)pUrlContent,
-                                          dwLength, nullptr, 0);
-    std::wstring unicodeContent(charsNeeded, L'\0');
-    MultiByteToWideChar(CP_UTF8, 0, (PCSTR)pUrlContent, dwLength,
-                        unicodeContent.data(), unicodeContent.size());
+    // Truncated content must not be reused as the content of this version.
+    if (validators && readFailed) {
+        *validators = {};
+    }
+
+    return UrlFetchResult::ok;
+}
+
+std::wstring Utf8ToWide(std::string_view utf8) {
+    int charsNeeded = MultiByteToWideChar(CP_UTF8, 0, utf8.data(),
+                                          (int)utf8.size(), nullptr, 0);
+    std::wstring result(charsNeeded, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, utf8.data(), (int)utf8.size(),
+                        result.data(), result.size());
+    return result;
+}
+
+std::string WideToUtf8(std::wstring_view wide) {
+    int bytesNeeded = WideCharToMultiByte(CP_UTF8, 0, wide.data(),
+                                          (int)wide.size(), nullptr, 0,
+                                          nullptr, nullptr);
+    std::string result(bytesNeeded, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, wide.data(), (int)wide.size(),
+                        result.data(), result.size(), nullptr, nullptr);
+    return result;
+}
 
-    HeapFree(GetProcessHeap(), 0, pUrlContent);
+std::optional<std::wstring> GetUrlContent(PCWSTR lpUrl,
+                                          bool failIfNot200 = true) {
+    std::string content;
+    if (FetchUrl(lpUrl, failIfNot200, nullptr, &content,
+                 [](std::string_view, bool) { return true; }) !=
+        UrlFetchResult::ok) {
+        return std::nullopt;
+    }
 
-    return unicodeContent;
+    // Assume UTF-8.
+    return Utf8ToWide(content);
 }
 
 // https://stackoverflow.com/a/29752943
@@ -982,32 +1079,97 @@ int StringCopyTruncatedWithEllipsis(PWSTR dest, size_t destSize, PCWSTR src) {
     return i;
 }
 
-std::wstring ExtractWebContent(std::wstring_view webContent,
-                               PCWSTR webContentsBlockStart,
-                               PCWSTR webContentsStart,
-                               PCWSTR webContentsEnd) {
-    auto block = webContent.find(webContentsBlockStart);
-    if (block == webContent.npos) {
-        return std::wstring();
-    }
+// Extracts the text between `start` and `end` which follows `blockStart`,
+// like a sequence of find() calls on the whole document, but works on the raw
+// UTF-8 bytes while they're being downloaded. Each byte is scanned once, and
+// the result is known as soon as the end marker arrives.
+class WebContentExtractor {
+   public:
+    WebContentExtractor(PCWSTR blockStart, PCWSTR start, PCWSTR end)
+        : m_markers{WideToUtf8(blockStart), WideToUtf8(start),
+                    WideToUtf8(end)} {}
+
+    // Continues scanning `content`, which must begin with the data passed to
+    // previous calls. Returns true once the result is known.
+    bool Scan(std::string_view content, bool complete) {
+        while (m_stage != Stage::done) {
+            const std::string& marker = m_markers[(int)m_stage];
+
+            if (m_stage == Stage::end && marker.empty()) {
+                // No end marker, the content continues to the end.
+                if (!complete) {
+                    break;
+                }
+                m_contentEnd = content.size();
+                m_found = true;
+                m_stage = Stage::done;
+                break;
+            }
 
-    auto start = webContent.find(webContentsStart, block);
-    if (start == webContent.npos) {
-        return std::wstring();
-    }
+            size_t pos = content.find(marker, m_searchPos);
+            if (pos == content.npos) {
+                if (complete) {
+                    m_stage = Stage::done;
+                } else if (content.size() >= marker.size()) {
+                    // The marker might be split between chunks.
+                    m_searchPos = std::max(
+                        m_searchPos, content.size() - marker.size() + 1);
+                }
+                break;
+            }
 
-    start += wcslen(webContentsStart);
+            switch (m_stage) {
+                case Stage::blockStart:
+                    // The start marker is searched from the block position.
+                    m_searchPos = pos;
+                    m_stage = Stage::start;
+                    break;
 
-    auto end = *webContentsEnd ? webContent.find(webContentsEnd, start)
-                               : webContent.length();
-    if (end == webContent.npos) {
-        return std::wstring();
+                case Stage::start:
+                    m_contentStart = pos + marker.size();
+                    m_searchPos = m_contentStart;
+                    m_stage = Stage::end;
+                    break;
+
+                case Stage::end:
+                    m_contentEnd = pos;
+                    m_found = true;
+                    m_stage = Stage::done;
+                    break;
+
+                case Stage::done:
+                    break;
+            }
+        }
+
+        if (m_found && m_result.empty() && m_contentEnd > m_contentStart) {
+            m_result = Utf8ToWide(content.substr(
+                m_contentStart, m_contentEnd - m_contentStart));
+        }
+
+        return m_stage == Stage::done;
     }
 
-    return std::wstring(webContent.substr(start, end - start));
-}
+    const std::wstring& Result() const { return m_result; }
+
+   private:
+    enum class Stage {
+        blockStart,
+        start,
+        end,
+        done,
+    };
+
+    std::string m_markers[3];
+    Stage m_stage = Stage::blockStart;
+    size_t m_searchPos = 0;
+    size_t m_contentStart = 0;
+    size_t m_contentEnd = 0;
+    bool m_found = false;
+    std::wstring m_result;
+};
 
-std::wstring ExtractTextFromHtml(std::wstring html) {
+std::wstring ExtractTextFromHtml(std::wstring_view html) {
     winrt::com_ptr<IHTMLDocument2> doc;
     winrt::check_hresult(CoCreateInstance(CLSID_HTMLDocument, nullptr,
                                           CLSCTX_INPROC_SERVER,
@@ -1054,10 +1216,18 @@ std::wstring ExtractTextFromHtml(std::wstring html) {
     return std::wstring(text, text.length());
 }
 
-std::wstring ExtractTextFromXml(std::wstring xml) {
-    xml = L"<root>" + xml + L"</root>";
+std::wstring ExtractTextFromXml(std::wstring_view xml) {
+    constexpr std::wstring_view kRootStart = L"<root>";
+    constexpr std::wstring_view kRootEnd = L"</root>";
+
+    std::wstring rootXml;
+    rootXml.reserve(kRootStart.size() + xml.size() + kRootEnd.size());
+    rootXml += kRootStart;
+    rootXml += xml;
+    rootXml += kRootEnd;
+
     winrt::Windows::Data::Xml::Dom::XmlDocument xmlDoc;
-    xmlDoc.LoadXml(winrt::hstring(xml));
+    xmlDoc.LoadXml(winrt::hstring(rootXml));
     return std::wstring(xmlDoc.InnerText());
 }
 
@@ -1179,42 +1349,158 @@ bool UpdateWeatherWebContent() {
     return true;
 }
 
-void UpdateWebContent() {
-    int failed = 0;
+// Post-processes the extracted content of a web content item and publishes it.
+// Index -1 is the web content kept for compatibility with old settings.
+void UpdateWebContentItem(int i, std::wstring extracted) {
+    if (i == -1) {
+        std::lock_guard<std::mutex> guard(g_webContentMutex);
 
-    std::wstring lastUrl;
-    std::optional<std::wstring> urlContent;
+        int maxLen = ARRAYSIZE(g_webContent) - 1;
+        if (g_settings.webContentsMaxLength > 0 &&
+            g_settings.webContentsMaxLength < maxLen) {
+            maxLen = g_settings.webContentsMaxLength;
+        }
 
-    // Kept for compatibility with old settings:
-    if (g_settings.webContentsUrl && g_settings.webContentsBlockStart &&
-        g_settings.webContentsStart && g_settings.webContentsEnd) {
-        lastUrl = g_settings.webContentsUrl;
-        urlContent =
-            GetUrlContent(g_settings.webContentsUrl, /*failIfNot200=*/false);
-
-        std::wstring extracted;
-        if (urlContent) {
-            extracted = ExtractWebContent(
-                *urlContent, g_settings.webContentsBlockStart,
-                g_settings.webContentsStart, g_settings.webContentsEnd);
-
-            std::lock_guard<std::mutex> guard(g_webContentMutex);
-
-            int maxLen = ARRAYSIZE(g_webContent) - 1;
-            if (g_settings.webContentsMaxLength > 0 &&
-                g_settings.webContentsMaxLength < maxLen) {
-                maxLen = g_settings.webContentsMaxLength;
+        StringCopyTruncatedWithEllipsis(g_webContent, maxLen + 1,
+                                        extracted.c_str());
+
+        StringCopyTruncatedWithEllipsis(g_webContentFull,
+                                        ARRAYSIZE(g_webContentFull),
+                                        extracted.c_str());
+        return;
+    }
+
+    const auto& item = g_settings.webContentsItems[i];
+
+    try {
+        switch (item.contentMode) {
+            case ContentMode::plainText:
+                break;
+
+            case ContentMode::html:
+                extracted = ExtractTextFromHtml(extracted);
+                break;
+
+            case ContentMode::xml:
+                extracted = ExtractTextFromXml(extracted);
+                break;
+
+            case ContentMode::xmlHtml:
+                extracted = ExtractTextFromHtml(ExtractTextFromXml(extracted));
+                break;
+        }
+    } catch (const winrt::hresult_error& ex) {
+        WCHAR buffer[256];
+        _snwprintf_s(buffer, _TRUNCATE, L"Content error %08X: %s",
+                     ex.code().value, ex.message().c_str());
+        extracted = buffer;
+    } catch (const std::exception& ex) {
+        WCHAR buffer[256];
+        _snwprintf_s(buffer, _TRUNCATE, L"Content error: %S", ex.what());
+        extracted = buffer;
+    }
+
+    for (const auto& [s, r] : item.searchReplace) {
+        try {
+            extracted = std::regex_replace(extracted, s, r);
+        } catch (const std::regex_error& ex) {
+            Wh_Log(L"Search/replace error %08X: %S",
+                   static_cast<DWORD>(ex.code()), ex.what());
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(g_webContentMutex);
+
+    if (item.maxLength <= 0 || extracted.length() <= (size_t)item.maxLength) {
+        g_webContentStrings[i] = extracted;
+    } else {
+        std::wstring truncated(extracted.begin(),
+                               extracted.begin() + item.maxLength);
+        if (truncated.length() >= 3) {
+            truncated[truncated.length() - 1] = L'.';
+            truncated[truncated.length() - 2] = L'.';
+            truncated[truncated.length() - 3] = L'.';
+        }
+
+        g_webContentStrings[i] = std::move(truncated);
+    }
+
+    g_webContentStringsFull[i] = std::move(extracted);
+}
+
+// Validators and extracted contents of the last download of each URL. Only
+// used by the web content update thread.
+struct WebContentUrlCache {
+    UrlValidators validators;
+    std::vector<std::wstring> results;
+};
+
+std::unordered_map<std::wstring, WebContentUrlCache> g_webContentUrlCache;
+
+// Downloads the URL once for all extractors, and stops as soon as all of their
+// results are known. If the content didn't change since the last download, the
+// previous results are reused.
+std::optional<std::vector<std::wstring>> FetchWebContents(
+    PCWSTR url,
+    std::vector<WebContentExtractor>& extractors) {
+    WebContentUrlCache& cache = g_webContentUrlCache[url];
+    if (cache.results.size() != extractors.size()) {
+        cache = {};
+    }
+
+    std::string content;
+    UrlFetchResult result = FetchUrl(
+        url, /*failIfNot200=*/false, &cache.validators, &content,
+        [&extractors](std::string_view content, bool complete) {
+            bool allDone = true;
+            for (auto& extractor : extractors) {
+                if (!extractor.Scan(content, complete)) {
+                    allDone = false;
+                }
             }
+            return !allDone;
+        });
+
+    switch (result) {
+        case UrlFetchResult::failed:
+            cache = {};
+            return std::nullopt;
 
-            StringCopyTruncatedWithEllipsis(g_webContent, maxLen + 1,
-                                            extracted.c_str());
+        case UrlFetchResult::notModified:
+            Wh_Log(L"Not modified: %s", url);
+            return cache.results;
 
-            StringCopyTruncatedWithEllipsis(g_webContentFull,
-                                            ARRAYSIZE(g_webContentFull),
-                                            extracted.c_str());
-        } else {
-            failed++;
+        case UrlFetchResult::ok:
+            break;
+    }
+
+    cache.results.clear();
+    for (const auto& extractor : extractors) {
+        cache.results.push_back(extractor.Result());
+    }
+
+    return cache.results;
+}
+
+void UpdateWebContent() {
+    int failed = 0;
+
+    // Items which use the same URL are extracted from a single download.
+    // Index -1 is the web content kept for compatibility with old settings.
+    std::vector<std::pair<PCWSTR, std::vector<int>>> urlItems;
+    auto addUrlItem = [&urlItems](PCWSTR url, int index) {
+        for (auto& [itemsUrl, items] : urlItems) {
+            if (wcscmp(itemsUrl, url) == 0) {
+                items.push_back(index);
+                return;
+            }
         }
+        urlItems.push_back({url, {index}});
+    };
+
+    if (g_settings.webContentsUrl && g_settings.webContentsBlockStart &&
+        g_settings.webContentsStart && g_settings.webContentsEnd) {
+        addUrlItem(g_settings.webContentsUrl, -1);
     }
 
     for (size_t i = 0; i < g_settings.webContentsItems.size(); i++) {
@@ -1229,77 +1515,33 @@ void UpdateWebContent() {
             continue;
         }
 
-        const auto& item = g_settings.webContentsItems[i];
+        addUrlItem(g_settings.webContentsItems[i].url, (int)i);
+    }
 
-        if (item.url.get() != lastUrl) {
-            lastUrl = item.url;
-            urlContent = GetUrlContent(item.url, /*failIfNot200=*/false);
+    for (const auto& [url, items] : urlItems) {
+        std::vector<WebContentExtractor> extractors;
+        extractors.reserve(items.size());
+        for (int index : items) {
+            if (index == -1) {
+                extractors.emplace_back(g_settings.webContentsBlockStart,
+                                        g_settings.webContentsStart,
+                                        g_settings.webContentsEnd);
+            } else {
+                const auto& item = g_settings.webContentsItems[index];
+                extractors.emplace_back(item.blockStart, item.start,
+                                        item.end);
+            }
         }
 
-        if (!urlContent) {
-            failed++;
+        auto results = FetchWebContents(url, extractors);
+        if (!results) {
+            failed += items.size();
             continue;
         }
 
-        std::wstring extracted = ExtractWebContent(*urlContent, item.blockStart,
-                                                   item.start, item.end);
-
-        try {
-            switch (item.contentMode) {
-                case ContentMode::plainText:
-                    break;
-
-                case ContentMode::html:
-                    extracted = ExtractTextFromHtml(extracted);
-                    break;
-
-                case ContentMode::xml:
-                    extracted = ExtractTextFromXml(extracted);
-                    break;
-
-                case ContentMode::xmlHtml:
-                    extracted =
-                        ExtractTextFromHtml(ExtractTextFromXml(extracted));
-                    break;
-            }
-        } catch (const winrt::hresult_error& ex) {
-            WCHAR buffer[256];
-            _snwprintf_s(buffer, _TRUNCATE, L"Content error %08X: %s",
-                         ex.code().value, ex.message().c_str());
-            extracted = buffer;
-        } catch (const std::exception& ex) {
-            WCHAR buffer[256];
-            _snwprintf_s(buffer, _TRUNCATE, L"Content error: %S", ex.what());
-            extracted = buffer;
-        }
-
-        for (const auto& [s, r] : item.searchReplace) {
-            try {
-                extracted = std::regex_replace(extracted, s, r);
-            } catch (const std::regex_error& ex) {
-                Wh_Log(L"Search/replace error %08X: %S",
-                       static_cast<DWORD>(ex.code()), ex.what());
-            }
+        for (size_t j = 0; j < items.size(); j++) {
+            UpdateWebContentItem(items[j], std::move((*results)[j]));
         }
-
-        std::lock_guard<std::mutex> guard(g_webContentMutex);
-
-        if (item.maxLength <= 0 ||
-            extracted.length() <= (size_t)item.maxLength) {
-            g_webContentStrings[i] = extracted;
-        } else {
-            std::wstring truncated(extracted.begin(),
-                                   extracted.begin() + item.maxLength);
-            if (truncated.length() >= 3) {
-                truncated[truncated.length() - 1] = L'.';
-                truncated[truncated.length() - 2] = L'.';
-                truncated[truncated.length() - 3] = L'.';
-            }
-
-            g_webContentStrings[i] = std::move(truncated);
-        }
-
-        g_webContentStringsFull[i] = std::move(extracted);
     }
 
     if (IsStrInDateTimePatternSettings(L"%weather%") &&
@@ -1349,6 +1591,7 @@ void WebContentUpdateThreadInit() {
 
     g_webContentStrings.resize(g_settings.webContentsItems.size());
     g_webContentStringsFull.resize(g_settings.webContentsItems.size());
+    g_webContentUrlCache.clear();
 
     // A fuzzy check to see if any of the lines contain the web content pattern.
     // If not, no need to fire up the thread.
@@ -2543,8 +2786,137 @@ QueryDataCollectionSession::FilterGpuPathsByAdapterName(
     return filtered;
 }
 
+// A fixed-size ring buffer of timestamped samples of a single metric. There's a
+// single writer, the data collection thread, and the readers are the clock
+// formatters, which never block it. Each sample is published with a seqlock
+// style counter: it's odd while a slot is being written, and a reader re-checks
+// it after copying the samples to drop slots that might have been overwritten
+// in the meantime.
+class MetricHistory {
+   public:
+    static constexpr size_t kCapacity = 64;
+
+    struct Stats {
+        double min;
+        double avg;
+        double max;
+        double latest;
+        size_t count;
+    };
+
+    // Must not be called while the writer is running.
+    void Clear() { sequence_.store(0, std::memory_order_relaxed); }
+
+    // A NaN value records a failed sample.
+    void Push(ULONGLONG timestamp, double value) {
+        uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        auto& slot = slots_[(sequence / 2) % kCapacity];
+        slot.timestamp.store(timestamp, std::memory_order_relaxed);
+        slot.value.store(value, std::memory_order_relaxed);
+
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Aggregates up to `maxSamples` of the newest samples which are at most
+    // `maxAge` milliseconds old. Failed samples are skipped, but if the newest
+    // sample failed, nothing is returned, same as for an empty window.
+    std::optional<Stats> GetStats(size_t maxSamples,
+                                  ULONGLONG maxAge,
+                                  ULONGLONG now) const {
+        maxSamples = std::min(maxSamples, kCapacity);
+
+        uint64_t sequenceBefore = sequence_.load(std::memory_order_acquire);
+        uint64_t published = sequenceBefore / 2;
+        size_t available =
+            static_cast<size_t>(std::min<uint64_t>(published, maxSamples));
+
+        Sample samples[kCapacity];
+        for (size_t i = 0; i < available; i++) {
+            const auto& slot = slots_[(published - 1 - i) % kCapacity];
+            samples[i].timestamp =
+                slot.timestamp.load(std::memory_order_relaxed);
+            samples[i].value = slot.value.load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t sequenceAfter = sequence_.load(std::memory_order_relaxed);
+
+        // Samples older than the oldest one that a writer might have started
+        // overwriting since are dropped.
+        uint64_t started = (sequenceAfter + 1) / 2;
+        if (started > kCapacity) {
+            uint64_t oldestIntact = started - kCapacity;
+            if (published <= oldestIntact) {
+                available = 0;
+            } else {
+                available = static_cast<size_t>(
+                    std::min<uint64_t>(available, published - oldestIntact));
+            }
+        }
+
+        // The writer might have pushed a sample after `now` was taken.
+        auto isExpired = [now, maxAge](ULONGLONG timestamp) {
+            return now > timestamp && now - timestamp > maxAge;
+        };
+
+        if (available == 0 || isExpired(samples[0].timestamp) ||
+            std::isnan(samples[0].value)) {
+            return std::nullopt;
+        }
+
+        Stats stats{
+            .min = samples[0].value,
+            .avg = 0,
+            .max = samples[0].value,
+            .latest = samples[0].value,
+            .count = 0,
+        };
+        double sum = 0;
+        for (size_t i = 0; i < available; i++) {
+            if (isExpired(samples[i].timestamp)) {
+                break;
+            }
+
+            double value = samples[i].value;
+            if (std::isnan(value)) {
+                continue;
+            }
+
+            stats.min = std::min(stats.min, value);
+            stats.max = std::max(stats.max, value);
+            sum += value;
+            stats.count++;
+        }
+
+        stats.avg = sum / stats.count;
+        return stats;
+    }
+
+   private:
+    struct Sample {
+        ULONGLONG timestamp;
+        double value;
+    };
+
+    struct Slot {
+        std::atomic<ULONGLONG> timestamp;
+        std::atomic<double> value;
+    };
+
+    std::atomic<uint64_t> sequence_{0};
+    Slot slots_[kCapacity]{};
+};
+
+// Owned by the data collection thread while it's running.
 std::optional<QueryDataCollectionSession> g_dataCollectionSession;
-DWORD g_dataCollectionLastFormatIndex;
+bool g_dataCollectionMetrics[static_cast<int>(MetricType::kCount)];
+std::atomic<HANDLE> g_dataCollectionThread;
+HANDLE g_dataCollectionStopEvent;
+
+MetricHistory g_metricHistory[static_cast<int>(MetricType::kCount)];
 
 // Media player helper functions
 
@@ -2780,6 +3152,86 @@ void RefreshMediaData() {
     g_mediaDataDirty = false;
 }
 
+ULONGLONG GetDataCollectionInterval() {
+    constexpr ULONGLONG kSecondIn100Ns = 10000000ULL;
+    return kSecondIn100Ns *
+           std::max(g_settings.dataCollection.updateInterval, 1);
+}
+
+// Milliseconds until shortly before the next update interval, so that a fresh
+// sample is ready by the time the clocks format the new interval.
+DWORD GetDataCollectionSampleDelay() {
+    constexpr ULONGLONG kLeadTime100Ns = 1000000ULL;  // 100 ms
+
+    SYSTEMTIME time;
+    GetLocalTime(&time);
+    FILETIME timeFt{};
+    SystemTimeToFileTime(&time, &timeFt);
+    ULARGE_INTEGER timeInt{
+        .LowPart = timeFt.dwLowDateTime,
+        .HighPart = timeFt.dwHighDateTime,
+    };
+
+    ULONGLONG interval = GetDataCollectionInterval();
+    ULONGLONG remaining = interval - timeInt.QuadPart % interval;
+    if (remaining <= kLeadTime100Ns) {
+        remaining += interval;
+    }
+
+    return static_cast<DWORD>((remaining - kLeadTime100Ns) / 10000);
+}
+
+void DataCollectionSampleAll() {
+    g_dataCollectionSession->UpdateAllMetrics();
+    bool sampled = g_dataCollectionSession->SampleData();
+
+    ULONGLONG timestamp = GetTickCount64();
+    for (int i = 0; i < static_cast<int>(MetricType::kCount); i++) {
+        if (!g_dataCollectionMetrics[i]) {
+            continue;
+        }
+
+        MetricType type = static_cast<MetricType>(i);
+        std::optional<double> value;
+        if (sampled) {
+            // Temperatures are averaged over all thermal zones, other metrics
+            // are summed over their instances.
+            value = type == MetricType::kCpuTemp
+                        ? g_dataCollectionSession->QueryDataAvg(type)
+                        : g_dataCollectionSession->QueryData(type);
+        }
+
+        g_metricHistory[i].Push(
+            timestamp,
+            value.value_or(std::numeric_limits<double>::quiet_NaN()));
+    }
+}
+
+// Samples all metrics once per update interval, regardless of the number of
+// clocks that display them. The clocks only read the collected history.
+DWORD WINAPI DataCollectionThread(LPVOID lpThreadParameter) {
+    // Rate counters need a previous sample to compare to.
+    g_dataCollectionSession->SampleData();
+
+    while (true) {
+        DWORD dwWaitResult = WaitForSingleObject(
+            g_dataCollectionStopEvent, GetDataCollectionSampleDelay());
+
+        if (dwWaitResult == WAIT_FAILED) {
+            Wh_Log(L"WAIT_FAILED");
+            break;
+        }
+
+        if (dwWaitResult == WAIT_OBJECT_0) {
+            break;
+        }
+
+        DataCollectionSampleAll();
+    }
+
+    return 0;
+}
+
 void DataCollectionSessionInit() {
     bool metrics[static_cast<int>(MetricType::kCount)]{};
     metrics[static_cast<int>(MetricType::kUploadSpeed)] =
@@ -2836,18 +3288,44 @@ void DataCollectionSessionInit() {
     }
 
     for (size_t i = 0; i < ARRAYSIZE(metrics); i++) {
+        g_dataCollectionMetrics[i] = metrics[i];
         if (metrics[i]) {
             MetricType metric = static_cast<MetricType>(i);
             g_dataCollectionSession->AddMetric(metric);
         }
     }
 
-    g_dataCollectionSession->SampleData();
+    for (auto& history : g_metricHistory) {
+        history.Clear();
+    }
+
+    g_dataCollectionStopEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    g_dataCollectionThread =
+        CreateThread(nullptr, 0, DataCollectionThread, nullptr, 0, nullptr);
+    if (!g_dataCollectionThread) {
+        Wh_Log(L"CreateThread failed: %u", GetLastError());
+        CloseHandle(g_dataCollectionStopEvent);
+        g_dataCollectionStopEvent = nullptr;
+        g_dataCollectionSession.reset();
+    }
 }
 
 void DataCollectionSessionUninit() {
+    HANDLE thread = g_dataCollectionThread;
+    if (thread) {
+        SetEvent(g_dataCollectionStopEvent);
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+        CloseHandle(g_dataCollectionStopEvent);
+        g_dataCollectionThread = nullptr;
+        g_dataCollectionStopEvent = nullptr;
+    }
+
     g_dataCollectionSession.reset();
-    g_dataCollectionLastFormatIndex = 0;
+
+    for (auto& history : g_metricHistory) {
+        history.Clear();
+    }
 }
 
 bool IsMediaPatternUsed() {
@@ -2954,22 +3432,29 @@ DWORD GetDataCollectionFormatIndex() {
         .HighPart = formatTimeFt.dwHighDateTime,
     };
 
-    constexpr ULONGLONG kSecondIn100Ns = 10000000ULL;
-    ULONGLONG interval =
-        kSecondIn100Ns * std::max(g_settings.dataCollection.updateInterval, 1);
-    return static_cast<DWORD>(formatTimeInt.QuadPart / interval);
+    return static_cast<DWORD>(formatTimeInt.QuadPart /
+                              GetDataCollectionInterval());
 }
 
-void DataCollectionSampleIfNeeded() {
-    DWORD dataCollectionFormatIndex = GetDataCollectionFormatIndex();
-    if (g_dataCollectionLastFormatIndex != dataCollectionFormatIndex) {
-        if (g_dataCollectionSession) {
-            g_dataCollectionSession->UpdateAllMetrics();
-            g_dataCollectionSession->SampleData();
-        }
+// The displayed value of a metric: the average of the samples collected during
+// the configured history length, or nothing if the latest sample is missing.
+std::optional<double> GetMetricValue(MetricType type) {
+    int historyLength =
+        std::clamp(g_settings.dataCollection.historyLength, 1,
+                   static_cast<int>(MetricHistory::kCapacity));
+
+    // Allow for one more interval so that the latest sample doesn't expire
+    // right before the next one is collected.
+    ULONGLONG maxAge =
+        GetDataCollectionInterval() / 10000 * (historyLength + 1);
 
-        g_dataCollectionLastFormatIndex = dataCollectionFormatIndex;
+    auto stats = g_metricHistory[static_cast<int>(type)].GetStats(
+        historyLength, maxAge, GetTickCount64());
+    if (!stats) {
+        return std::nullopt;
     }
+
+    return stats->avg;
 }
 
 // System memory status, sampled at most once per update interval. Empty if the
@@ -3174,14 +3659,10 @@ PCWSTR GetMetricFormatted(FormattedString<N>& formattedString,
 }
 
 PCWSTR GetUploadSpeedFormatted() {
-    DataCollectionSampleIfNeeded();
     return GetMetricFormatted(
         g_uploadSpeedFormatted, [](PWSTR buffer, size_t bufferSize) {
-            if (!g_dataCollectionSession) {
-                return false;
-            }
             std::optional<double> val =
-                g_dataCollectionSession->QueryData(MetricType::kUploadSpeed);
+                GetMetricValue(MetricType::kUploadSpeed);
             if (!val) {
                 return false;
             }
@@ -3191,14 +3672,10 @@ PCWSTR GetUploadSpeedFormatted() {
 }
 
 PCWSTR GetDownloadSpeedFormatted() {
-    DataCollectionSampleIfNeeded();
     return GetMetricFormatted(
         g_downloadSpeedFormatted, [](PWSTR buffer, size_t bufferSize) {
-            if (!g_dataCollectionSession) {
-                return false;
-            }
             std::optional<double> val =
-                g_dataCollectionSession->QueryData(MetricType::kDownloadSpeed);
+                GetMetricValue(MetricType::kDownloadSpeed);
             if (!val) {
                 return false;
             }
@@ -3208,16 +3685,12 @@ PCWSTR GetDownloadSpeedFormatted() {
 }
 
 PCWSTR GetTotalSpeedFormatted() {
-    DataCollectionSampleIfNeeded();
     return GetMetricFormatted(
         g_totalSpeedFormatted, [](PWSTR buffer, size_t bufferSize) {
-            if (!g_dataCollectionSession) {
-                return false;
-            }
             std::optional<double> uploadSpeed =
-                g_dataCollectionSession->QueryData(MetricType::kUploadSpeed);
+                GetMetricValue(MetricType::kUploadSpeed);
             std::optional<double> downloadSpeed =
-                g_dataCollectionSession->QueryData(MetricType::kDownloadSpeed);
+                GetMetricValue(MetricType::kDownloadSpeed);
             if (!uploadSpeed || !downloadSpeed) {
                 return false;
             }
@@ -3228,14 +3701,10 @@ PCWSTR GetTotalSpeedFormatted() {
 }
 
 PCWSTR GetDiskReadSpeedFormatted() {
-    DataCollectionSampleIfNeeded();
     return GetMetricFormatted(
         g_diskReadSpeedFormatted, [](PWSTR buffer, size_t bufferSize) {
-            if (!g_dataCollectionSession) {
-                return false;
-            }
             std::optional<double> val =
-                g_dataCollectionSession->QueryData(MetricType::kDiskReadSpeed);
+                GetMetricValue(MetricType::kDiskReadSpeed);
             if (!val) {
                 return false;
             }
@@ -3245,14 +3714,10 @@ PCWSTR GetDiskReadSpeedFormatted() {
 }
 
 PCWSTR GetDiskWriteSpeedFormatted() {
-    DataCollectionSampleIfNeeded();
     return GetMetricFormatted(
         g_diskWriteSpeedFormatted, [](PWSTR buffer, size_t bufferSize) {
-            if (!g_dataCollectionSession) {
-                return false;
-            }
             std::optional<double> val =
-                g_dataCollectionSession->QueryData(MetricType::kDiskWriteSpeed);
+                GetMetricValue(MetricType::kDiskWriteSpeed);
             if (!val) {
                 return false;
             }
@@ -3262,16 +3727,12 @@ PCWSTR GetDiskWriteSpeedFormatted() {
 }
 
 PCWSTR GetDiskTotalSpeedFormatted() {
-    DataCollectionSampleIfNeeded();
     return GetMetricFormatted(
         g_diskTotalSpeedFormatted, [](PWSTR buffer, size_t bufferSize) {
-            if (!g_dataCollectionSession) {
-                return false;
-            }
             std::optional<double> readSpeed =
-                g_dataCollectionSession->QueryData(MetricType::kDiskReadSpeed);
+                GetMetricValue(MetricType::kDiskReadSpeed);
             std::optional<double> writeSpeed =
-                g_dataCollectionSession->QueryData(MetricType::kDiskWriteSpeed);
+                GetMetricValue(MetricType::kDiskWriteSpeed);
             if (!readSpeed || !writeSpeed) {
                 return false;
             }
@@ -3282,14 +3743,9 @@ PCWSTR GetDiskTotalSpeedFormatted() {
 }
 
 PCWSTR GetCpuFormatted() {
-    DataCollectionSampleIfNeeded();
     return GetMetricFormatted(g_cpuFormatted, [](PWSTR buffer,
                                                  size_t bufferSize) {
-        if (!g_dataCollectionSession) {
-            return false;
-        }
-        std::optional<double> val =
-            g_dataCollectionSession->QueryData(MetricType::kCpu);
+        std::optional<double> val = GetMetricValue(MetricType::kCpu);
         if (!val) {
             return false;
         }
@@ -3387,14 +3843,9 @@ PCWSTR GetRamCommittedTotalFormatted() {
 }
 
 PCWSTR GetGpuFormatted() {
-    DataCollectionSampleIfNeeded();
     return GetMetricFormatted(g_gpuFormatted, [](PWSTR buffer,
                                                  size_t bufferSize) {
-        if (!g_dataCollectionSession) {
-            return false;
-        }
-        std::optional<double> val =
-            g_dataCollectionSession->QueryData(MetricType::kGpuUsage);
+        std::optional<double> val = GetMetricValue(MetricType::kGpuUsage);
         if (!val) {
             return false;
         }
@@ -3406,14 +3857,10 @@ PCWSTR GetGpuFormatted() {
 }
 
 PCWSTR GetVramFormatted() {
-    DataCollectionSampleIfNeeded();
     return GetMetricFormatted(
         g_vramFormatted, [](PWSTR buffer, size_t bufferSize) {
-            if (!g_dataCollectionSession) {
-                return false;
-            }
             std::optional<double> usedBytes =
-                g_dataCollectionSession->QueryData(MetricType::kVramUsed);
+                GetMetricValue(MetricType::kVramUsed);
             std::optional<double> totalGb = GetDedicatedVramTotalGb();
             if (!usedBytes || !totalGb || *totalGb <= 0) {
                 return false;
@@ -3428,14 +3875,9 @@ PCWSTR GetVramFormatted() {
 }
 
 PCWSTR GetVramUsedFormatted() {
-    DataCollectionSampleIfNeeded();
     return GetMetricFormatted(
         g_vramUsedFormatted, [](PWSTR buffer, size_t bufferSize) {
-            if (!g_dataCollectionSession) {
-                return false;
-            }
-            std::optional<double> val =
-                g_dataCollectionSession->QueryData(MetricType::kVramUsed);
+            std::optional<double> val = GetMetricValue(MetricType::kVramUsed);
             if (!val) {
                 return false;
             }
@@ -3457,14 +3899,10 @@ PCWSTR GetVramTotalFormatted() {
 }
 
 PCWSTR GetVramSharedFormatted() {
-    DataCollectionSampleIfNeeded();
     return GetMetricFormatted(
         g_vramSharedFormatted, [](PWSTR buffer, size_t bufferSize) {
-            if (!g_dataCollectionSession) {
-                return false;
-            }
             std::optional<double> usedBytes =
-                g_dataCollectionSession->QueryData(MetricType::kVramSharedUsed);
+                GetMetricValue(MetricType::kVramSharedUsed);
             std::optional<double> totalGb = GetSharedVramTotalGb();
             if (!usedBytes || !totalGb || *totalGb <= 0) {
                 return false;
@@ -3479,14 +3917,10 @@ PCWSTR GetVramSharedFormatted() {
 }
 
 PCWSTR GetVramSharedUsedFormatted() {
-    DataCollectionSampleIfNeeded();
     return GetMetricFormatted(
         g_vramSharedUsedFormatted, [](PWSTR buffer, size_t bufferSize) {
-            if (!g_dataCollectionSession) {
-                return false;
-            }
             std::optional<double> val =
-                g_dataCollectionSession->QueryData(MetricType::kVramSharedUsed);
+                GetMetricValue(MetricType::kVramSharedUsed);
             if (!val) {
                 return false;
             }
@@ -3508,14 +3942,9 @@ PCWSTR GetVramSharedTotalFormatted() {
 }
 
 PCWSTR GetCpuTempFormatted() {
-    DataCollectionSampleIfNeeded();
     return GetMetricFormatted(
         g_cpuTempFormatted, [](PWSTR buffer, size_t bufferSize) {
-            if (!g_dataCollectionSession) {
-                return false;
-            }
-            auto kelvin =
-                g_dataCollectionSession->QueryDataAvg(MetricType::kCpuTemp);
+            auto kelvin = GetMetricValue(MetricType::kCpuTemp);
             if (!kelvin) {
                 return false;
             }
@@ -3526,14 +3955,9 @@ PCWSTR GetCpuTempFormatted() {
 }
 
 PCWSTR GetCpuTempFFormatted() {
-    DataCollectionSampleIfNeeded();
     return GetMetricFormatted(
         g_cpuTempFFormatted, [](PWSTR buffer, size_t bufferSize) {
-            if (!g_dataCollectionSession) {
-                return false;
-            }
-            auto kelvin =
-                g_dataCollectionSession->QueryDataAvg(MetricType::kCpuTemp);
+            auto kelvin = GetMetricValue(MetricType::kCpuTemp);
             if (!kelvin) {
                 return false;
             }
@@ -4020,7 +4444,7 @@ void ClockSystemTrayIconDataModel_RefreshIcon_Hook_Impl(
     g_refreshIconThreadId = GetCurrentThreadId();
     bool webContentPending = g_webContentUpdateThread && !g_webContentLoaded;
     g_refreshIconNeedToAdjustTimer =
-        g_settings.showSeconds || g_dataCollectionSession || webContentPending;
+        g_settings.showSeconds || g_dataCollectionThread || webContentPending;
 
     original(pThis, param1);
 
@@ -4844,7 +5268,7 @@ ClockButton_UpdateTextStringsIfNecessary_Hook(LPVOID pThis, bool* param1) {
     g_updateTextStringThreadId = 0;
 
     bool webContentPending = g_webContentUpdateThread && !g_webContentLoaded;
-    if (g_settings.showSeconds || g_dataCollectionSession ||
+    if (g_settings.showSeconds || g_dataCollectionThread ||
         webContentPending) {
         // Return the time-out value for the time of the next update.
         SYSTEMTIME time;
@@ -5434,6 +5858,9 @@ void LoadSettings() {
     g_settings.dataCollection.updateInterval =
         Wh_GetIntSetting(L"DataCollection.UpdateInterval");
 
+    g_settings.dataCollection.historyLength =
+        Wh_GetIntSetting(L"DataCollection.HistoryLength");
+
     g_settings.dataCollection.networkAdapterName =
         StringSetting::make(L"DataCollection.NetworkAdapterName");
 
@@ -2,7 +2,7 @@
 // @id              text-replace
 // @name            Text Replace
 // @description     Replace any text with any other text in any program
-// @version         1.1.1
+// @version         1.1.3
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -27,6 +27,20 @@ Replace any text with any other text in any program. The mod is able to
 replace some texts in some programs, while some other programs and
 elements are not supported. The replacement works best in native elements,
 and usually doesn't work in custom ones.
+
+## Multiple rules
+
+When a program has several rules, they are all applied in a single pass over
+the text, from left to right:
+
+* Replaced text is not searched again. For example, with the rules `A` -> `B`
+  and `B` -> `C`, the text `A` becomes `B`, not `C`.
+* If the search strings of several rules match at the same position, the rule
+  listed first wins. A match that overlaps a replacement to its left is
+  skipped.
+
+Versions before 1.1.2 applied the rules one after another, each to the output
+of the previous one, so in the example above `A` became `C`.
 */
 // ==/WindhawkModReadme==
 
@@ -49,7 +63,10 @@ and usually doesn't work in custom ones.
 */
 // ==/WindhawkModSettings==
 
+#include <algorithm>
+#include <limits>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include <d2d1.h>
@@ -107,53 +124,286 @@ struct ReplacementItem {
 
 std::vector<ReplacementItem> g_replacementItems;
 
-template<typename T>
-T ReplaceAll(T str, const T& from, const T& to)
-{
-    size_t start_pos = 0;
-    while((start_pos = str.find(from, start_pos)) != T::npos) {
-        str.replace(start_pos, from.length(), to);
-        start_pos += to.length(); // Handles case where 'to' is a substring of 'from'
+// An Aho-Corasick automaton over all search strings, compiled once when the
+// settings are loaded, so that each hooked call scans the text only once
+// regardless of the number of replacement rules.
+//
+// Matches are leftmost-first: of all matches, the one which starts first
+// wins, and if several matches start at the same position, the rule which
+// appears first in the settings wins. Replaced text isn't scanned again.
+template <typename T>
+class ReplacementMatcher {
+public:
+    struct Match {
+        size_t start;
+        size_t length;
+        size_t item;
+    };
+
+    void Build(const std::vector<std::basic_string<T>>& patterns) {
+        Clear();
+
+        // Build the trie.
+        std::vector<std::vector<Edge>> children(1);
+        m_nodes.push_back({});
+        for (size_t i = 0; i < patterns.size(); i++) {
+            const auto& pattern = patterns[i];
+            if (pattern.empty()) {
+                continue;
+            }
+
+            uint32_t node = 0;
+            for (T ch : pattern) {
+                uint32_t next = 0;
+                for (const auto& edge : children[node]) {
+                    if (edge.ch == ch) {
+                        next = edge.next;
+                        break;
+                    }
+                }
+
+                if (!next) {
+                    next = static_cast<uint32_t>(m_nodes.size());
+                    m_nodes.push_back({});
+                    m_nodes.back().depth = m_nodes[node].depth + 1;
+                    children.emplace_back();
+                    children[node].push_back({ch, next});
+                }
+
+                node = next;
+            }
+
+            // For duplicate search strings, the first rule wins.
+            if (m_nodes[node].item == kNoItem) {
+                m_nodes[node].item = static_cast<uint32_t>(i);
+            }
+
+            T first = pattern[0];
+            size_t firstIndex = static_cast<std::make_unsigned_t<T>>(first);
+            m_firstChars[firstIndex / 64] |= 1ull << (firstIndex % 64);
+        }
+
+        // Flatten the edges, sorted per node for binary search.
+        for (size_t i = 0; i < m_nodes.size(); i++) {
+            auto& nodeChildren = children[i];
+            std::sort(nodeChildren.begin(), nodeChildren.end(),
+                      [](const Edge& a, const Edge& b) { return a.ch < b.ch; });
+            m_nodes[i].edgesBegin = static_cast<uint32_t>(m_edges.size());
+            m_nodes[i].edgesCount = static_cast<uint32_t>(nodeChildren.size());
+            m_edges.insert(m_edges.end(), nodeChildren.begin(),
+                           nodeChildren.end());
+        }
+
+        // Compute failure and output links in BFS order.
+        std::vector<uint32_t> queue;
+        queue.reserve(m_nodes.size());
+        for (const auto& edge : children[0]) {
+            queue.push_back(edge.next);
+        }
+
+        for (size_t i = 0; i < queue.size(); i++) {
+            uint32_t node = queue[i];
+            for (const auto& edge : children[node]) {
+                uint32_t fail = m_nodes[node].fail;
+                uint32_t failNext;
+                while ((failNext = FindEdge(fail, edge.ch)) == 0 && fail) {
+                    fail = m_nodes[fail].fail;
+                }
+
+                Node& child = m_nodes[edge.next];
+                child.fail = failNext;
+                child.output = m_nodes[failNext].item != kNoItem
+                                   ? failNext
+                                   : m_nodes[failNext].output;
+                queue.push_back(edge.next);
+            }
+        }
     }
-    return str;
-}
 
-std::string ReplaceStringA(PCSTR string, size_t len = -1)
-{
-    if (len == (size_t)-1) {
-        len = strlen(string);
+    void Clear() {
+        m_nodes.clear();
+        m_edges.clear();
+        m_firstChars.assign(kFirstCharsWords, 0);
     }
 
-    std::string result(string, len);
+    bool Empty() const { return m_nodes.size() <= 1; }
 
-    for (const auto& item : g_replacementItems) {
-        result = ReplaceAll<std::string>(std::move(result), item.searchA, item.replaceA);
+    // Calls `onMatch` for each non-overlapping match, in order. Returns the
+    // number of matches.
+    template <typename F>
+    size_t Scan(const T* text, size_t len, F&& onMatch) const {
+        if (Empty()) {
+            return 0;
+        }
+
+        size_t count = 0;
+        size_t pos = 0;
+        uint32_t state = 0;
+        bool hasCandidate = false;
+        Match candidate{};
+
+        while (true) {
+            if (pos == len) {
+                if (!hasCandidate) {
+                    break;
+                }
+            } else {
+                T ch = text[pos++];
+
+                if (state == 0) {
+                    size_t chIndex = static_cast<std::make_unsigned_t<T>>(ch);
+                    if (!(m_firstChars[chIndex / 64] &
+                          (1ull << (chIndex % 64)))) {
+                        continue;
+                    }
+                }
+
+                state = Step(state, ch);
+
+                uint32_t out = m_nodes[state].item != kNoItem
+                                   ? state
+                                   : m_nodes[state].output;
+                for (; out; out = m_nodes[out].output) {
+                    const Node& node = m_nodes[out];
+                    size_t start = pos - node.depth;
+                    if (!hasCandidate || start < candidate.start ||
+                        (start == candidate.start &&
+                         node.item < candidate.item)) {
+                        candidate = {start, node.depth, node.item};
+                        hasCandidate = true;
+                    }
+                }
+
+                // The candidate is final once no partial match which is
+                // still alive can start at or before it.
+                if (!hasCandidate ||
+                    pos - m_nodes[state].depth <= candidate.start) {
+                    continue;
+                }
+            }
+
+            onMatch(candidate);
+            count++;
+
+            pos = candidate.start + candidate.length;
+            state = 0;
+            hasCandidate = false;
+        }
+
+        return count;
     }
 
-    return result;
-}
+private:
+    static constexpr uint32_t kNoItem = 0xFFFFFFFF;
+    static constexpr size_t kFirstCharsWords =
+        ((size_t)std::numeric_limits<std::make_unsigned_t<T>>::max() + 1) /
+        64;
+
+    struct Edge {
+        T ch;
+        uint32_t next;
+    };
+
+    struct Node {
+        uint32_t edgesBegin = 0;
+        uint32_t edgesCount = 0;
+        uint32_t fail = 0;
+        // The nearest node in the failure chain which ends a search string.
+        uint32_t output = 0;
+        uint32_t item = kNoItem;
+        uint32_t depth = 0;
+    };
+
+    uint32_t FindEdge(uint32_t node, T ch) const {
+        const Node& n = m_nodes[node];
+        const Edge* begin = m_edges.data() + n.edgesBegin;
+        const Edge* end = begin + n.edgesCount;
+        if (n.edgesCount <= 8) {
+            for (const Edge* e = begin; e != end; e++) {
+                if (e->ch == ch) {
+                    return e->next;
+                }
+            }
+            return 0;
+        }
 
-std::wstring ReplaceStringW(PCWSTR string, size_t len = -1)
-{
+        const Edge* e = std::lower_bound(
+            begin, end, ch, [](const Edge& a, T b) { return a.ch < b; });
+        return e != end && e->ch == ch ? e->next : 0;
+    }
+
+    uint32_t Step(uint32_t state, T ch) const {
+        while (true) {
+            uint32_t next = FindEdge(state, ch);
+            if (next || !state) {
+                return next;
+            }
+            state = m_nodes[state].fail;
+        }
+    }
+
+    std::vector<Node> m_nodes;
+    std::vector<Edge> m_edges;
+    std::vector<uint64_t> m_firstChars =
+        std::vector<uint64_t>(kFirstCharsWords, 0);
+};
+
+ReplacementMatcher<char> g_matcherA;
+ReplacementMatcher<WCHAR> g_matcherW;
+
+// Returns true and fills `result` if at least one replacement was made.
+// Otherwise, returns false without allocating, and the original string
+// should be used as is.
+template <typename T>
+bool ReplaceString(const ReplacementMatcher<T>& matcher,
+                   std::basic_string<T> ReplacementItem::*replace,
+                   const T* string,
+                   size_t len,
+                   std::basic_string<T>* result) {
     if (len == (size_t)-1) {
-        len = wcslen(string);
+        len = std::char_traits<T>::length(string);
     }
 
-    std::wstring result(string, len);
+    size_t copied = 0;
+    size_t count = matcher.Scan(
+        string, len, [&](const typename ReplacementMatcher<T>::Match& match) {
+            if (copied == 0) {
+                result->clear();
+                result->reserve(len);
+            }
 
-    for (const auto& item : g_replacementItems) {
-        result = ReplaceAll<std::wstring>(std::move(result), item.searchW, item.replaceW);
+            result->append(string + copied, match.start - copied);
+            result->append(g_replacementItems[match.item].*replace);
+            copied = match.start + match.length;
+        });
+
+    if (!count) {
+        return false;
     }
 
-    return result;
+    result->append(string + copied, len - copied);
+    return true;
+}
+
+bool ReplaceStringA(PCSTR string, size_t len, std::string* result)
+{
+    return ReplaceString(g_matcherA, &ReplacementItem::replaceA, string, len,
+                         result);
+}
+
+bool ReplaceStringW(PCWSTR string, size_t len, std::wstring* result)
+{
+    return ReplaceString(g_matcherW, &ReplacementItem::replaceW, string, len,
+                         result);
 }
 
 using SetWindowTextA_t = decltype(&SetWindowTextA);
 SetWindowTextA_t pOriginalSetWindowTextA;
 BOOL WINAPI SetWindowTextAHook(HWND hWnd, LPCSTR lpString)
 {
-    if (lpString) {
-        std::string str = ReplaceStringA(lpString);
+    std::string str;
+    if (lpString &&
+        ReplaceStringA(lpString, -1, &str)) {
         return pOriginalSetWindowTextA(hWnd, str.c_str());
     }
 
@@ -164,8 +414,9 @@ using SetWindowTextW_t = decltype(&SetWindowTextW);
 SetWindowTextW_t pOriginalSetWindowTextW;
 BOOL WINAPI SetWindowTextWHook(HWND hWnd, LPCWSTR lpString)
 {
-    if (lpString) {
-        std::wstring str = ReplaceStringW(lpString);
+    std::wstring str;
+    if (lpString &&
+        ReplaceStringW(lpString, -1, &str)) {
         return pOriginalSetWindowTextW(hWnd, str.c_str());
     }
 
@@ -176,8 +427,9 @@ using InsertMenuA_t = decltype(&InsertMenuA);
 InsertMenuA_t pOriginalInsertMenuA;
 BOOL WINAPI InsertMenuAHook(HMENU hMenu,UINT uPosition,UINT uFlags,UINT_PTR uIDNewItem,LPCSTR lpNewItem)
 {
-    if (!(uFlags & (MF_BITMAP | MF_OWNERDRAW)) && lpNewItem) {
-        std::string str = ReplaceStringA(lpNewItem);
+    std::string str;
+    if (!(uFlags & (MF_BITMAP | MF_OWNERDRAW)) && lpNewItem &&
+        ReplaceStringA(lpNewItem, -1, &str)) {
         return pOriginalInsertMenuA(hMenu,uPosition,uFlags,uIDNewItem,str.c_str());
     }
 
@@ -188,8 +440,9 @@ using InsertMenuW_t = decltype(&InsertMenuW);
 InsertMenuW_t pOriginalInsertMenuW;
 BOOL WINAPI InsertMenuWHook(HMENU hMenu,UINT uPosition,UINT uFlags,UINT_PTR uIDNewItem,LPCWSTR lpNewItem)
 {
-    if (!(uFlags & (MF_BITMAP | MF_OWNERDRAW)) && lpNewItem) {
-        std::wstring str = ReplaceStringW(lpNewItem);
+    std::wstring str;
+    if (!(uFlags & (MF_BITMAP | MF_OWNERDRAW)) && lpNewItem &&
+        ReplaceStringW(lpNewItem, -1, &str)) {
         return pOriginalInsertMenuW(hMenu,uPosition,uFlags,uIDNewItem,str.c_str());
     }
 
@@ -200,8 +453,9 @@ using AppendMenuA_t = decltype(&AppendMenuA);
 AppendMenuA_t pOriginalAppendMenuA;
 BOOL WINAPI AppendMenuAHook(HMENU hMenu,UINT uFlags,UINT_PTR uIDNewItem,LPCSTR lpNewItem)
 {
-    if (!(uFlags & (MF_BITMAP | MF_OWNERDRAW)) && lpNewItem) {
-        std::string str = ReplaceStringA(lpNewItem);
+    std::string str;
+    if (!(uFlags & (MF_BITMAP | MF_OWNERDRAW)) && lpNewItem &&
+        ReplaceStringA(lpNewItem, -1, &str)) {
         return pOriginalAppendMenuA(hMenu,uFlags,uIDNewItem,str.c_str());
     }
 
@@ -212,8 +466,9 @@ using AppendMenuW_t = decltype(&AppendMenuW);
 AppendMenuW_t pOriginalAppendMenuW;
 BOOL WINAPI AppendMenuWHook(HMENU hMenu,UINT uFlags,UINT_PTR uIDNewItem,LPCWSTR lpNewItem)
 {
-    if (!(uFlags & (MF_BITMAP | MF_OWNERDRAW)) && lpNewItem) {
-        std::wstring str = ReplaceStringW(lpNewItem);
+    std::wstring str;
+    if (!(uFlags & (MF_BITMAP | MF_OWNERDRAW)) && lpNewItem &&
+        ReplaceStringW(lpNewItem, -1, &str)) {
         return pOriginalAppendMenuW(hMenu,uFlags,uIDNewItem,str.c_str());
     }
 
@@ -224,8 +479,9 @@ using ModifyMenuA_t = decltype(&ModifyMenuA);
 ModifyMenuA_t pOriginalModifyMenuA;
 BOOL WINAPI ModifyMenuAHook(HMENU hMenu,UINT uPosition,UINT uFlags,UINT_PTR uIDNewItem,LPCSTR lpNewItem)
 {
-    if (!(uFlags & (MF_BITMAP | MF_OWNERDRAW)) && lpNewItem) {
-        std::string str = ReplaceStringA(lpNewItem);
+    std::string str;
+    if (!(uFlags & (MF_BITMAP | MF_OWNERDRAW)) && lpNewItem &&
+        ReplaceStringA(lpNewItem, -1, &str)) {
         return pOriginalModifyMenuA(hMenu,uPosition,uFlags,uIDNewItem,str.c_str());
     }
 
@@ -236,8 +492,9 @@ using ModifyMenuW_t = decltype(&ModifyMenuW);
 ModifyMenuW_t pOriginalModifyMenuW;
 BOOL WINAPI ModifyMenuWHook(HMENU hMenu,UINT uPosition,UINT uFlags,UINT_PTR uIDNewItem,LPCWSTR lpNewItem)
 {
-    if (!(uFlags & (MF_BITMAP | MF_OWNERDRAW)) && lpNewItem) {
-        std::wstring str = ReplaceStringW(lpNewItem);
+    std::wstring str;
+    if (!(uFlags & (MF_BITMAP | MF_OWNERDRAW)) && lpNewItem &&
+        ReplaceStringW(lpNewItem, -1, &str)) {
         return pOriginalModifyMenuW(hMenu,uPosition,uFlags,uIDNewItem,str.c_str());
     }
 
@@ -248,11 +505,12 @@ using InsertMenuItemA_t = decltype(&InsertMenuItemA);
 InsertMenuItemA_t pOriginalInsertMenuItemA;
 BOOL WINAPI InsertMenuItemAHook(HMENU hmenu,UINT item,BOOL fByPosition,LPCMENUITEMINFOA lpmi)
 {
+    std::string str;
     if ((
         (lpmi->fMask & MIIM_STRING) ||
         ((lpmi->fMask & MIIM_TYPE) && (lpmi->fType & MFT_STRING))
-    ) && lpmi->dwTypeData) {
-        std::string str = ReplaceStringA(lpmi->dwTypeData);
+    ) && lpmi->dwTypeData &&
+        ReplaceStringA(lpmi->dwTypeData, -1, &str)) {
         MENUITEMINFOA mi = *lpmi;
         mi.dwTypeData = str.data();
         return pOriginalInsertMenuItemA(hmenu,item,fByPosition,&mi);
@@ -265,11 +523,12 @@ using InsertMenuItemW_t = decltype(&InsertMenuItemW);
 InsertMenuItemW_t pOriginalInsertMenuItemW;
 BOOL WINAPI InsertMenuItemWHook(HMENU hmenu,UINT item,BOOL fByPosition,LPCMENUITEMINFOW lpmi)
 {
+    std::wstring str;
     if ((
         (lpmi->fMask & MIIM_STRING) ||
         ((lpmi->fMask & MIIM_TYPE) && (lpmi->fType & MFT_STRING))
-    ) && lpmi->dwTypeData) {
-        std::wstring str = ReplaceStringW(lpmi->dwTypeData);
+    ) && lpmi->dwTypeData &&
+        ReplaceStringW(lpmi->dwTypeData, -1, &str)) {
         MENUITEMINFOW mi = *lpmi;
         mi.dwTypeData = str.data();
         return pOriginalInsertMenuItemW(hmenu,item,fByPosition,&mi);
@@ -282,11 +541,12 @@ using SetMenuItemInfoA_t = decltype(&SetMenuItemInfoA);
 SetMenuItemInfoA_t pOriginalSetMenuItemInfoA;
 BOOL WINAPI SetMenuItemInfoAHook(HMENU hmenu,UINT item,BOOL fByPosition,LPCMENUITEMINFOA lpmi)
 {
+    std::string str;
     if ((
         (lpmi->fMask & MIIM_STRING) ||
         ((lpmi->fMask & MIIM_TYPE) && (lpmi->fType & MFT_STRING))
-    ) && lpmi->dwTypeData) {
-        std::string str = ReplaceStringA(lpmi->dwTypeData);
+    ) && lpmi->dwTypeData &&
+        ReplaceStringA(lpmi->dwTypeData, -1, &str)) {
         MENUITEMINFOA mi = *lpmi;
         mi.dwTypeData = str.data();
         return pOriginalSetMenuItemInfoA(hmenu,item,fByPosition,&mi);
@@ -299,11 +559,12 @@ using SetMenuItemInfoW_t = decltype(&SetMenuItemInfoW);
 SetMenuItemInfoW_t pOriginalSetMenuItemInfoW;
 BOOL WINAPI SetMenuItemInfoWHook(HMENU hmenu,UINT item,BOOL fByPosition,LPCMENUITEMINFOW lpmi)
 {
+    std::wstring str;
     if ((
         (lpmi->fMask & MIIM_STRING) ||
         ((lpmi->fMask & MIIM_TYPE) && (lpmi->fType & MFT_STRING))
-    ) && lpmi->dwTypeData) {
-        std::wstring str = ReplaceStringW(lpmi->dwTypeData);
+    ) && lpmi->dwTypeData &&
+        ReplaceStringW(lpmi->dwTypeData, -1, &str)) {
         MENUITEMINFOW mi = *lpmi;
         mi.dwTypeData = str.data();
         return pOriginalSetMenuItemInfoW(hmenu,item,fByPosition,&mi);
@@ -316,8 +577,9 @@ using TextOutA_t = decltype(&TextOutA);
 TextOutA_t pOriginalTextOutA;
 BOOL WINAPI TextOutAHook(HDC hdc,int x,int y,LPCSTR lpString,int c)
 {
-    if (lpString) {
-        std::string str = ReplaceStringA(lpString, c);
+    std::string str;
+    if (lpString &&
+        ReplaceStringA(lpString, c, &str)) {
         return pOriginalTextOutA(hdc,x,y,str.c_str(),str.length());
     }
 
@@ -328,8 +590,9 @@ using TextOutW_t = decltype(&TextOutW);
 TextOutW_t pOriginalTextOutW;
 BOOL WINAPI TextOutWHook(HDC hdc,int x,int y,LPCWSTR lpString,int c)
 {
-    if (lpString) {
-        std::wstring str = ReplaceStringW(lpString, c);
+    std::wstring str;
+    if (lpString &&
+        ReplaceStringW(lpString, c, &str)) {
         return pOriginalTextOutW(hdc,x,y,str.c_str(),str.length());
     }
 
@@ -340,8 +603,9 @@ using ExtTextOutA_t = decltype(&ExtTextOutA);
 ExtTextOutA_t pOriginalExtTextOutA;
 BOOL WINAPI ExtTextOutAHook(HDC hdc,int x,int y,UINT options,CONST RECT *lprect,LPCSTR lpString,UINT c,CONST INT *lpDx)
 {
-    if (!(options & ETO_GLYPH_INDEX) && lpString) {
-        std::string str = ReplaceStringA(lpString, c);
+    std::string str;
+    if (!(options & ETO_GLYPH_INDEX) && lpString &&
+        ReplaceStringA(lpString, c, &str)) {
         return pOriginalExtTextOutA(hdc,x,y,options,lprect,str.c_str(),str.length(),str.length() != c ? nullptr : lpDx);
     }
 
@@ -352,8 +616,9 @@ using ExtTextOutW_t = decltype(&ExtTextOutW);
 ExtTextOutW_t pOriginalExtTextOutW;
 BOOL WINAPI ExtTextOutWHook(HDC hdc,int x,int y,UINT options,CONST RECT *lprect,LPCWSTR lpString,UINT c,CONST INT *lpDx)
 {
-    if (!(options & ETO_GLYPH_INDEX) && lpString) {
-        std::wstring str = ReplaceStringW(lpString, c);
+    std::wstring str;
+    if (!(options & ETO_GLYPH_INDEX) && lpString &&
+        ReplaceStringW(lpString, c, &str)) {
         return pOriginalExtTextOutW(hdc,x,y,options,lprect,str.c_str(),str.length(),str.length() != c ? nullptr : lpDx);
     }
 
@@ -368,8 +633,8 @@ BOOL WINAPI PolyTextOutAHook(HDC hdc,CONST POLYTEXTA *pptxt,int cStrings)
     std::vector<std::string> strs(cStrings);
 
     for (int i = 0; i < cStrings; i++) {
-        if (!(items[i].uiFlags & ETO_GLYPH_INDEX) && items[i].lpstr) {
-            strs[i] = ReplaceStringA(items[i].lpstr, items[i].n);
+        if (!(items[i].uiFlags & ETO_GLYPH_INDEX) && items[i].lpstr &&
+            ReplaceStringA(items[i].lpstr, items[i].n, &strs[i])) {
             if (strs[i].length() != items[i].n) {
                 items[i].pdx = nullptr;
             }
@@ -389,8 +654,8 @@ BOOL WINAPI PolyTextOutWHook(HDC hdc,CONST POLYTEXTW *pptxt,int cStrings)
     std::vector<std::wstring> strs(cStrings);
 
     for (int i = 0; i < cStrings; i++) {
-        if (!(items[i].uiFlags & ETO_GLYPH_INDEX) && items[i].lpstr) {
-            strs[i] = ReplaceStringW(items[i].lpstr, items[i].n);
+        if (!(items[i].uiFlags & ETO_GLYPH_INDEX) && items[i].lpstr &&
+            ReplaceStringW(items[i].lpstr, items[i].n, &strs[i])) {
             if (strs[i].length() != items[i].n) {
                 items[i].pdx = nullptr;
             }
@@ -406,8 +671,9 @@ using DrawTextA_t = decltype(&DrawTextA);
 DrawTextA_t pOriginalDrawTextA;
 int WINAPI DrawTextAHook(HDC hdc,LPCSTR lpchText,int cchText,LPRECT lprc,UINT format)
 {
-    if (lpchText) {
-        std::string str = ReplaceStringA(lpchText, cchText);
+    std::string str;
+    if (lpchText &&
+        ReplaceStringA(lpchText, cchText, &str)) {
         int len = str.length();
         if (format & DT_MODIFYSTRING) {
             str.resize(len + 4);
@@ -422,8 +688,9 @@ using DrawTextW_t = decltype(&DrawTextW);
 DrawTextW_t pOriginalDrawTextW;
 int WINAPI DrawTextWHook(HDC hdc,LPCWSTR lpchText,int cchText,LPRECT lprc,UINT format)
 {
-    if (lpchText) {
-        std::wstring str = ReplaceStringW(lpchText, cchText);
+    std::wstring str;
+    if (lpchText &&
+        ReplaceStringW(lpchText, cchText, &str)) {
         int len = str.length();
         if (format & DT_MODIFYSTRING) {
             str.resize(len + 4);
@@ -438,8 +705,9 @@ using DrawTextExA_t = decltype(&DrawTextExA);
 DrawTextExA_t pOriginalDrawTextExA;
 int WINAPI DrawTextExAHook(HDC hdc,LPSTR lpchText,int cchText,LPRECT lprc,UINT format,LPDRAWTEXTPARAMS lpdtp)
 {
-    if (lpchText) {
-        std::string str = ReplaceStringA(lpchText, cchText);
+    std::string str;
+    if (lpchText &&
+        ReplaceStringA(lpchText, cchText, &str)) {
         int len = str.length();
         if (format & DT_MODIFYSTRING) {
             str.resize(len + 4);
@@ -454,8 +722,9 @@ using DrawTextExW_t = decltype(&DrawTextExW);
 DrawTextExW_t pOriginalDrawTextExW;
 int WINAPI DrawTextExWHook(HDC hdc,LPWSTR lpchText,int cchText,LPRECT lprc,UINT format,LPDRAWTEXTPARAMS lpdtp)
 {
-    if (lpchText) {
-        std::wstring str = ReplaceStringW(lpchText, cchText);
+    std::wstring str;
+    if (lpchText &&
+        ReplaceStringW(lpchText, cchText, &str)) {
         int len = str.length();
         if (format & DT_MODIFYSTRING) {
             str.resize(len + 4);
@@ -470,8 +739,9 @@ using CreateWindowExA_t = decltype(&CreateWindowExA);
 CreateWindowExA_t pOriginalCreateWindowExA;
 HWND WINAPI CreateWindowExAHook(DWORD dwExStyle,LPCSTR lpClassName,LPCSTR lpWindowName,DWORD dwStyle,int X,int Y,int nWidth,int nHeight,HWND hWndParent,HMENU hMenu,HINSTANCE hInstance,LPVOID lpParam)
 {
-    if (lpWindowName) {
-        std::string str = ReplaceStringA(lpWindowName);
+    std::string str;
+    if (lpWindowName &&
+        ReplaceStringA(lpWindowName, -1, &str)) {
         return pOriginalCreateWindowExA(dwExStyle,lpClassName,str.c_str(),dwStyle,X,Y,nWidth,nHeight,hWndParent,hMenu,hInstance,lpParam);
     }
 
@@ -482,8 +752,9 @@ using CreateWindowExW_t = decltype(&CreateWindowExW);
 CreateWindowExW_t pOriginalCreateWindowExW;
 HWND WINAPI CreateWindowExWHook(DWORD dwExStyle,LPCWSTR lpClassName,LPCWSTR lpWindowName,DWORD dwStyle,int X,int Y,int nWidth,int nHeight,HWND hWndParent,HMENU hMenu,HINSTANCE hInstance,LPVOID lpParam)
 {
-    if (lpWindowName) {
-        std::wstring str = ReplaceStringW(lpWindowName);
+    std::wstring str;
+    if (lpWindowName &&
+        ReplaceStringW(lpWindowName, -1, &str)) {
         return pOriginalCreateWindowExW(dwExStyle,lpClassName,str.c_str(),dwStyle,X,Y,nWidth,nHeight,hWndParent,hMenu,hInstance,lpParam);
     }
 
@@ -494,8 +765,9 @@ using SendMessageA_t = decltype(&SendMessageA);
 SendMessageA_t pOriginalSendMessageA;
 LRESULT WINAPI SendMessageAHook(HWND hWnd,UINT Msg,WPARAM wParam,LPARAM lParam)
 {
-    if (Msg == WM_SETTEXT && lParam) {
-        std::string str = ReplaceStringA((PCSTR)lParam);
+    std::string str;
+    if (Msg == WM_SETTEXT && lParam &&
+        ReplaceStringA((PCSTR)lParam, -1, &str)) {
         return pOriginalSendMessageA(hWnd,Msg,wParam,(LPARAM)str.c_str());
     }
 
@@ -506,8 +778,9 @@ using SendMessageW_t = decltype(&SendMessageW);
 SendMessageW_t pOriginalSendMessageW;
 LRESULT WINAPI SendMessageWHook(HWND hWnd,UINT Msg,WPARAM wParam,LPARAM lParam)
 {
-    if (Msg == WM_SETTEXT && lParam) {
-        std::wstring str = ReplaceStringW((PCWSTR)lParam);
+    std::wstring str;
+    if (Msg == WM_SETTEXT && lParam &&
+        ReplaceStringW((PCWSTR)lParam, -1, &str)) {
         return pOriginalSendMessageW(hWnd,Msg,wParam,(LPARAM)str.c_str());
     }
 
@@ -535,8 +808,9 @@ void STDMETHODCALLTYPE ID2D1RenderTarget_DrawTextHook(
     D2D1_DRAW_TEXT_OPTIONS options,
     DWRITE_MEASURING_MODE measuringMode)
 {
-    if (string) {
-        std::wstring str = ReplaceStringW(string, stringLength);
+    std::wstring str;
+    if (string &&
+        ReplaceStringW(string, stringLength, &str)) {
         pOriginalID2D1RenderTarget_DrawText(pThis,str.c_str(),str.length(),textFormat,layoutRect,defaultFillBrush,options,measuringMode);
         return;
     }
@@ -563,8 +837,9 @@ HRESULT STDMETHODCALLTYPE IDWriteFactory_CreateTextLayoutHook(
     FLOAT maxHeight,
     IDWriteTextLayout **textLayout)
 {
-    if (string) {
-        std::wstring str = ReplaceStringW(string, stringLength);
+    std::wstring str;
+    if (string &&
+        ReplaceStringW(string, stringLength, &str)) {
         return pOriginalIDWriteFactory_CreateTextLayout(pThis,str.c_str(),str.length(),textFormat,maxWidth,maxHeight,textLayout);
     }
 
@@ -596,8 +871,9 @@ HRESULT STDMETHODCALLTYPE IDWriteFactory_CreateGdiCompatibleTextLayoutHook(
     BOOL useGdiNatural,
     IDWriteTextLayout **textLayout)
 {
-    if (string) {
-        std::wstring str = ReplaceStringW(string, stringLength);
+    std::wstring str;
+    if (string &&
+        ReplaceStringW(string, stringLength, &str)) {
         return pOriginalIDWriteFactory_CreateGdiCompatibleTextLayout(pThis,str.c_str(),str.length(),textFormat,layoutWidth,layoutHeight,pixelsPerDip,transform,useGdiNatural,textLayout);
     }
 
@@ -683,8 +959,9 @@ int WINAPI GdipDrawStringHook(
     const void *stringFormat,
     const void *brush)
 {
-    if (string) {
-        std::wstring str = ReplaceStringW(string, length);
+    std::wstring str;
+    if (string &&
+        ReplaceStringW(string, length, &str)) {
         return pOriginalGdipDrawString(graphics,str.c_str(),str.length(),font,layoutRect,stringFormat,brush);
     }
 
@@ -706,6 +983,8 @@ void HookGdiplus()
 void LoadSettings()
 {
     g_replacementItems.clear();
+    g_matcherA.Clear();
+    g_matcherW.Clear();
 
     WCHAR programPath[1024];
     DWORD dwSize = ARRAYSIZE(programPath);
@@ -776,6 +1055,18 @@ void LoadSettings()
             Wh_FreeStringSetting(replace);
         }
     }
+
+    std::vector<std::string> searchA;
+    std::vector<std::wstring> searchW;
+    searchA.reserve(g_replacementItems.size());
+    searchW.reserve(g_replacementItems.size());
+    for (const auto& item : g_replacementItems) {
+        searchA.push_back(item.searchA);
+        searchW.push_back(item.searchW);
+    }
+
+    g_matcherA.Build(searchA);
+    g_matcherW.Build(searchW);
 }
 
 BOOL Wh_ModInit()
@@ -2,7 +2,7 @@
 // @id              translucent-windows
 // @name            Translucent Windows
 // @description     Enables native translucent effects in Windows 11
-// @version         1.8.0
+// @version         1.8.1
 // @author          Undisputed00x
 // @github          https://github.com/Undisputed00x
 // @include         *
@@ -175,6 +175,12 @@ This is caused by default by the AccentBlur API.❕
 #include <cmath>
 #include <string>
 #include <array>
+#ifndef _M_ARM64
+#include <immintrin.h>
+#endif
+#ifndef PF_AVX2_INSTRUCTIONS_AVAILABLE
+#define PF_AVX2_INSTRUCTIONS_AVAILABLE 40
+#endif
 #include <d2d1.h>
 #include <wrl.h>
 #include <ShellScalingApi.h>
@@ -851,6 +857,156 @@ std::wstring GetThemeClass(HTHEME hTheme)
 // Closely matches DrawTextWithGlow's CGamma table behavior
 // Requires no RGB linearization — operates on alpha only
 static std::array<BYTE, 256> g_textAlphaGammaLUT = {0};
+// Same table widened to 32 bits for AVX2 gathers.
+static std::array<INT, 256> g_textAlphaGammaLUT32 = {0};
+
+// Colors of a text run being composited by HookedExtTextOutW.
+struct TextAlphaComposite
+{
+    COLORREF txtClr;
+    COLORREF bkClr;
+    BOOL highlighted; // Blend the background color in, for selected text
+    BOOL opaque;      // ETO_OPAQUE, fully transparent pixels are cleared too
+};
+
+// Turns a row of the white text mask into premultiplied text color.
+// Reference implementation, the SIMD kernels below must match it exactly.
+VOID CompositeTextAlphaRow(RGBQUAD* row, INT width, const TextAlphaComposite& tac)
+{
+    for (INT cx = 0; cx < width; ++cx) {
+        RGBQUAD& p = row[cx];
+        // Alpha extraction + gamma correction
+        BYTE luma = (BYTE)((p.rgbBlue + (p.rgbGreen << 1) + p.rgbRed) >> 2);
+        BYTE txtA = g_textAlphaGammaLUT[luma];
+        if (txtA == 0 && !tac.opaque)
+            continue;
+        // handle background transparency only for selected text
+        BYTE bgWeight = tac.highlighted ? (255 - txtA) : 0;
+        p.rgbBlue     = (((GetBValue(tac.txtClr) * txtA) + (GetBValue(tac.bkClr) * bgWeight)) >> 8);
+        p.rgbGreen    = (((GetGValue(tac.txtClr) * txtA) + (GetGValue(tac.bkClr) * bgWeight)) >> 8);
+        p.rgbRed      = (((GetRValue(tac.txtClr) * txtA) + (GetRValue(tac.bkClr) * bgWeight)) >> 8);
+        p.rgbReserved = bgWeight ? 255 : txtA;
+    }
+}
+
+#ifndef _M_ARM64
+// The SIMD kernels compute each channel in 16-bit lanes as
+// (txt * txtA + bk * (255 - txtA)) >> 8, with bk zeroed unless the text is
+// highlighted. Neither sum exceeds 255 * 256, so nothing overflows. The alpha
+// lane uses 256 for both colors, which yields txtA, or 255 when highlighted,
+// as in the scalar code. Fully transparent pixels keep their value unless the
+// run is opaque, and blocks whose RGB is all zero (the erased background) are
+// skipped without a table lookup when the table maps 0 to 0.
+
+__attribute__((target("sse2")))
+VOID CompositeTextAlphaRowSSE2(RGBQUAD* row, INT width, const TextAlphaComposite& tac)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i alphaMax = _mm_set1_epi16(255);
+    const __m128i txtClr = _mm_set_epi16(
+        256, GetRValue(tac.txtClr), GetGValue(tac.txtClr), GetBValue(tac.txtClr),
+        256, GetRValue(tac.txtClr), GetGValue(tac.txtClr), GetBValue(tac.txtClr));
+    const __m128i bkClr = _mm_set_epi16(
+        256, GetRValue(tac.bkClr), GetGValue(tac.bkClr), GetBValue(tac.bkClr),
+        256, GetRValue(tac.bkClr), GetGValue(tac.bkClr), GetBValue(tac.bkClr));
+    const BOOL keepTransparent = !tac.opaque;
+    const BOOL skipEmpty = keepTransparent && g_textAlphaGammaLUT[0] == 0;
+
+    INT cx = 0;
+    for (; cx + 4 <= width; cx += 4) {
+        __m128i px = _mm_loadu_si128((const __m128i*)(row + cx));
+        if (skipEmpty && _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(px, rgbMask), zero)) == 0xFFFF)
+            continue;
+
+        __m128i b = _mm_and_si128(px, byteMask);
+        __m128i g = _mm_and_si128(_mm_srli_epi32(px, 8), byteMask);
+        __m128i r = _mm_and_si128(_mm_srli_epi32(px, 16), byteMask);
+        __m128i luma = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(b, r), _mm_add_epi32(g, g)), 2);
+
+        alignas(16) UINT32 lumas[4];
+        _mm_store_si128((__m128i*)lumas, luma);
+        __m128i txtA = _mm_setr_epi32(
+            g_textAlphaGammaLUT[lumas[0]], g_textAlphaGammaLUT[lumas[1]],
+            g_textAlphaGammaLUT[lumas[2]], g_textAlphaGammaLUT[lumas[3]]);
+
+        // Spread each pixel's txtA over its four 16-bit channel lanes.
+        __m128i txtA16 = _mm_or_si128(txtA, _mm_slli_epi32(txtA, 16));
+        __m128i txtALo = _mm_unpacklo_epi32(txtA16, txtA16);
+        __m128i txtAHi = _mm_unpackhi_epi32(txtA16, txtA16);
+
+        __m128i lo = _mm_mullo_epi16(txtClr, txtALo);
+        __m128i hi = _mm_mullo_epi16(txtClr, txtAHi);
+        if (tac.highlighted) {
+            lo = _mm_add_epi16(lo, _mm_mullo_epi16(bkClr, _mm_sub_epi16(alphaMax, txtALo)));
+            hi = _mm_add_epi16(hi, _mm_mullo_epi16(bkClr, _mm_sub_epi16(alphaMax, txtAHi)));
+        }
+        __m128i out = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+
+        if (keepTransparent) {
+            __m128i keep = _mm_cmpeq_epi32(txtA, zero);
+            out = _mm_or_si128(_mm_and_si128(keep, px), _mm_andnot_si128(keep, out));
+        }
+        _mm_storeu_si128((__m128i*)(row + cx), out);
+    }
+
+    CompositeTextAlphaRow(row + cx, width - cx, tac);
+}
+
+__attribute__((target("avx2")))
+VOID CompositeTextAlphaRowAVX2(RGBQUAD* row, INT width, const TextAlphaComposite& tac)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i rgbMask = _mm256_set1_epi32(0x00FFFFFF);
+    const __m256i alphaMax = _mm256_set1_epi16(255);
+    const __m256i txtClr = _mm256_set1_epi64x(
+        (256LL << 48) | ((LONGLONG)GetRValue(tac.txtClr) << 32) |
+        ((LONGLONG)GetGValue(tac.txtClr) << 16) | GetBValue(tac.txtClr));
+    const __m256i bkClr = _mm256_set1_epi64x(
+        (256LL << 48) | ((LONGLONG)GetRValue(tac.bkClr) << 32) |
+        ((LONGLONG)GetGValue(tac.bkClr) << 16) | GetBValue(tac.bkClr));
+    const BOOL keepTransparent = !tac.opaque;
+    const BOOL skipEmpty = keepTransparent && g_textAlphaGammaLUT[0] == 0;
+
+    INT cx = 0;
+    for (; cx + 8 <= width; cx += 8) {
+        __m256i px = _mm256_loadu_si256((const __m256i*)(row + cx));
+        if (skipEmpty && _mm256_testz_si256(px, rgbMask))
+            continue;
+
+        __m256i b = _mm256_and_si256(px, byteMask);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi32(px, 8), byteMask);
+        __m256i r = _mm256_and_si256(_mm256_srli_epi32(px, 16), byteMask);
+        __m256i luma = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(b, r), _mm256_add_epi32(g, g)), 2);
+        __m256i txtA = _mm256_i32gather_epi32(g_textAlphaGammaLUT32.data(), luma, 4);
+
+        // Unpacking works within 128-bit halves, matching the pixel order
+        // that _mm256_packus_epi16 restores below.
+        __m256i txtA16 = _mm256_or_si256(txtA, _mm256_slli_epi32(txtA, 16));
+        __m256i txtALo = _mm256_unpacklo_epi32(txtA16, txtA16);
+        __m256i txtAHi = _mm256_unpackhi_epi32(txtA16, txtA16);
+
+        __m256i lo = _mm256_mullo_epi16(txtClr, txtALo);
+        __m256i hi = _mm256_mullo_epi16(txtClr, txtAHi);
+        if (tac.highlighted) {
+            lo = _mm256_add_epi16(lo, _mm256_mullo_epi16(bkClr, _mm256_sub_epi16(alphaMax, txtALo)));
+            hi = _mm256_add_epi16(hi, _mm256_mullo_epi16(bkClr, _mm256_sub_epi16(alphaMax, txtAHi)));
+        }
+        __m256i out = _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8));
+
+        if (keepTransparent)
+            out = _mm256_blendv_epi8(out, px, _mm256_cmpeq_epi32(txtA, zero));
+        _mm256_storeu_si256((__m256i*)(row + cx), out);
+    }
+
+    CompositeTextAlphaRowSSE2(row + cx, width - cx, tac);
+}
+#endif
+
+static decltype(&CompositeTextAlphaRow) g_compositeTextAlphaRow = CompositeTextAlphaRow;
+
 VOID GenerateTextAlphaGammaLUT()
 {
     for (INT i = 0; i < 256; ++i) 
@@ -858,7 +1014,15 @@ VOID GenerateTextAlphaGammaLUT()
         float a = i * (1.0f / 255.0f);
         float g = powf(a, 1.0f / 1.4f);
         g_textAlphaGammaLUT[i] = (BYTE)(g * 255.0f + 0.5f);
+        g_textAlphaGammaLUT32[i] = g_textAlphaGammaLUT[i];
     }
+
+    #ifndef _M_ARM64
+        if (IsProcessorFeaturePresent(PF_AVX2_INSTRUCTIONS_AVAILABLE))
+            g_compositeTextAlphaRow = CompositeTextAlphaRowAVX2;
+        else if (IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE))
+            g_compositeTextAlphaRow = CompositeTextAlphaRowSSE2;
+    #endif
 }
 
 // BufferedPaintInit must be called once per thread before any BeginBufferedPaint
@@ -963,23 +1127,9 @@ BOOL WINAPI HookedExtTextOutW(
     WINBOOL res = ExtTextOutW_orig(memDC, x, y, options & ~ETO_OPAQUE, lprect, lpString, c, lpDx);
 
     // Compositing
-    for (INT cy = 0; cy < textRectHeight; ++cy) {
-        RGBQUAD* row = pPixels + (cy * rowWidth);
-        for (INT cx = 0; cx < textRectWidth; ++cx) {
-            RGBQUAD& p = row[cx];
-            // Alpha extraction + gamma correction
-            BYTE luma = (BYTE)((p.rgbBlue + (p.rgbGreen << 1) + p.rgbRed) >> 2);
-            BYTE txtA = g_textAlphaGammaLUT[luma];
-            if (txtA == 0 && !(options & ETO_OPAQUE))
-                continue;
-            // handle background transparency only for selected text
-            BYTE bgWeight = HighlightedText ? (255 - txtA) : 0;
-            p.rgbBlue     = (((GetBValue(origTxtClr) * txtA) + (GetBValue(origBkClr) * bgWeight)) >> 8);
-            p.rgbGreen    = (((GetGValue(origTxtClr) * txtA) + (GetGValue(origBkClr) * bgWeight)) >> 8);
-            p.rgbRed      = (((GetRValue(origTxtClr) * txtA) + (GetRValue(origBkClr) * bgWeight)) >> 8);
-            p.rgbReserved = bgWeight ? 255 : txtA;
-        }
-    }
+    TextAlphaComposite tac = {origTxtClr, origBkClr, HighlightedText, (options & ETO_OPAQUE) != 0};
+    for (INT cy = 0; cy < textRectHeight; ++cy)
+        g_compositeTextAlphaRow(pPixels + (cy * rowWidth), textRectWidth, tac);
 
     BLENDFUNCTION blend = {AC_SRC_OVER, 0, 255, AC_SRC_ALPHA};
     AlphaBlend(hdc, textRect.left, textRect.top, textRectWidth, textRectHeight,
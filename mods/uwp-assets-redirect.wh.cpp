@@ -2,7 +2,7 @@
 // @id              uwp-assets-redirect
 // @name            UWP Assets Redirect
 // @description     Replace UWP app assets (such as icons) without worrying about updates or modifying system files permissions.
-// @version         1.1
+// @version         1.1.1
 // @author          ferrys
 // @github          https://github.com/atferrys
 // @license         GPL-3.0
@@ -247,6 +247,7 @@ You can contribute to the mod development by opening a pull request [here](https
 #include <comutil.h>
 #include <shldisp.h>
 #include <gdiplus.h>
+#include <algorithm>
 #include <format>
 #include <string>
 #include <unordered_map>
@@ -337,6 +338,159 @@ bool match(const T* pattern, size_t pattern_length, const T* str, size_t string_
     return pattern_index == pattern_length;
 }
 
+// Redirection patterns indexed by their literal prefix (the part before the
+// first wildcard) in a case-insensitive trie. A lookup walks the path once,
+// and paths which don't share a prefix with any pattern are rejected within a
+// few characters without any allocation.
+class RedirectionTrie {
+public:
+    using Redirection = std::pair<const std::wstring, std::wstring>;
+
+    void Build(const std::unordered_map<std::wstring, std::wstring>& redirections) {
+        m_nodes.assign(1, {});
+        m_edges.clear();
+        m_redirections.clear();
+
+        std::vector<std::vector<Edge>> children(1);
+        std::vector<std::vector<const Redirection*>> nodeRedirections(1);
+
+        for(const auto& pair : redirections) {
+            const std::wstring& pattern = pair.first;
+            size_t prefixLength = pattern.find(L'*');
+            if(prefixLength == std::wstring::npos) {
+                prefixLength = pattern.length();
+            }
+
+            uint32_t node = 0;
+            for(size_t i = 0; i < prefixLength; i++) {
+                WCHAR c = ToLowerAscii(pattern[i]);
+
+                uint32_t next = 0;
+                for(const auto& edge : children[node]) {
+                    if(edge.c == c) {
+                        next = edge.next;
+                        break;
+                    }
+                }
+
+                if(!next) {
+                    next = (uint32_t)m_nodes.size();
+                    m_nodes.push_back({});
+                    children.emplace_back();
+                    nodeRedirections.emplace_back();
+                    children[node].push_back({c, next});
+                }
+
+                node = next;
+            }
+
+            nodeRedirections[node].push_back(&pair);
+        }
+
+        for(size_t i = 0; i < m_nodes.size(); i++) {
+            auto& nodeChildren = children[i];
+            std::sort(nodeChildren.begin(), nodeChildren.end(), [](const Edge& a, const Edge& b) {
+                return a.c < b.c;
+            });
+
+            m_nodes[i].edgesBegin = (uint32_t)m_edges.size();
+            m_nodes[i].edgesCount = (uint32_t)nodeChildren.size();
+            m_edges.insert(m_edges.end(), nodeChildren.begin(), nodeChildren.end());
+
+            // Patterns sharing a prefix are tried from the most specific
+            // (longest) one, so that the result doesn't depend on the hash
+            // map's iteration order.
+            auto& redirectionsAtNode = nodeRedirections[i];
+            std::sort(redirectionsAtNode.begin(), redirectionsAtNode.end(), [](const Redirection* a, const Redirection* b) {
+                if(a->first.length() != b->first.length()) {
+                    return a->first.length() > b->first.length();
+                }
+                return a->first < b->first;
+            });
+
+            m_nodes[i].redirectionsBegin = (uint32_t)m_redirections.size();
+            m_nodes[i].redirectionsCount = (uint32_t)redirectionsAtNode.size();
+            m_redirections.insert(m_redirections.end(), redirectionsAtNode.begin(), redirectionsAtNode.end());
+        }
+    }
+
+    // Returns the redirection with the longest matching literal prefix, or
+    // nullptr if there's none.
+    const Redirection* Find(const WCHAR* path, size_t pathLength, size_t& after_match_index) const {
+        if(m_nodes.empty()) {
+            return nullptr;
+        }
+
+        const Redirection* found = nullptr;
+        uint32_t node = 0;
+        size_t depth = 0;
+
+        while(true) {
+            const Node& n = m_nodes[node];
+            for(uint32_t i = 0; i < n.redirectionsCount; i++) {
+                const Redirection* redirection = m_redirections[n.redirectionsBegin + i];
+                const std::wstring& pattern = redirection->first;
+
+                // If there are no wildcards in pattern, simply
+                // use the end of the pattern as the match_end_index
+                size_t match_end_index = pattern.length();
+
+                if(depth == pattern.length() ||
+                   match(pattern.c_str() + depth, pattern.length() - depth, path + depth, pathLength - depth, match_end_index)) {
+                    if(depth < pattern.length()) {
+                        match_end_index += depth;
+                    }
+
+                    found = redirection;
+                    after_match_index = match_end_index;
+                    break;
+                }
+            }
+
+            if(depth == pathLength) {
+                break;
+            }
+
+            node = FindChild(n, ToLowerAscii(path[depth]));
+            if(!node) {
+                break;
+            }
+
+            depth++;
+        }
+
+        return found;
+    }
+
+private:
+    struct Node {
+        uint32_t edgesBegin = 0;
+        uint32_t edgesCount = 0;
+        uint32_t redirectionsBegin = 0;
+        uint32_t redirectionsCount = 0;
+    };
+
+    struct Edge {
+        WCHAR c;
+        uint32_t next;
+    };
+
+    uint32_t FindChild(const Node& n, WCHAR c) const {
+        const Edge* begin = m_edges.data() + n.edgesBegin;
+        const Edge* end = begin + n.edgesCount;
+        const Edge* edge = std::lower_bound(begin, end, c, [](const Edge& a, WCHAR b) {
+            return a.c < b;
+        });
+        return edge != end && edge->c == c ? edge->next : 0;
+    }
+
+    std::vector<Node> m_nodes;
+    std::vector<Edge> m_edges;
+    std::vector<const Redirection*> m_redirections;
+};
+
+RedirectionTrie g_redirectionTrie;
+
 using NtCreateFile_t = decltype(&NtCreateFile);
 NtCreateFile_t NtCreateFile_Original;
 
@@ -354,36 +508,19 @@ NTSTATUS NTAPI NtCreateFile_Hook(
     ULONG EaLength
 ) {
 
-    std::wstring originalPath;
-
-    if(ObjectAttributes && ObjectAttributes->ObjectName) {
-        UNICODE_STRING* ObjectName = ObjectAttributes->ObjectName;
-        originalPath.assign(ObjectName->Buffer, ObjectName->Length / sizeof(WCHAR));
-    }
+    const UNICODE_STRING* ObjectName = ObjectAttributes ? ObjectAttributes->ObjectName : nullptr;
 
     // Check if we should redirect
-    if(!originalPath.empty()) {
-
-        std::wstring redirectPath;
-
-        const wchar_t* path = originalPath.c_str();
-        size_t pathLength = originalPath.length();
-
-        for(const auto& pair : g_redirections) {
-
-            const wchar_t* pattern = pair.first.c_str();
-            size_t patternLength = pair.first.length();
+    size_t match_end_index = 0;
+    const RedirectionTrie::Redirection* redirection = nullptr;
+    if(ObjectName && ObjectName->Buffer && ObjectName->Length > 0) {
+        redirection = g_redirectionTrie.Find(ObjectName->Buffer, ObjectName->Length / sizeof(WCHAR), match_end_index);
+    }
 
-            // If there are no wildcards in pattern, simply
-            // use the end of the pattern as the match_end_index
-            size_t match_end_index = patternLength;
+    if(redirection) {
 
-            if(match(pattern, patternLength, path, pathLength, match_end_index)) {
-                redirectPath = pair.second + originalPath.substr(match_end_index);
-                break;
-            }
-
-        }
+        std::wstring originalPath(ObjectName->Buffer, ObjectName->Length / sizeof(WCHAR));
+        std::wstring redirectPath = redirection->second + originalPath.substr(match_end_index);
 
         if(!redirectPath.empty()) {
 
@@ -393,13 +530,13 @@ NTSTATUS NTAPI NtCreateFile_Hook(
             memcpy(buffer, ObjectAttributes, ObjectAttributes->Length);
             auto* RedirectedObjectAttributes = reinterpret_cast<POBJECT_ATTRIBUTES>(buffer);
 
-            UNICODE_STRING ObjectName = {
+            UNICODE_STRING RedirectedObjectName = {
                 .Length = (USHORT) (redirectPath.length() * sizeof(WCHAR)),
-                .MaximumLength = ObjectName.Length,
+                .MaximumLength = RedirectedObjectName.Length,
                 .Buffer = (PWSTR) redirectPath.c_str()
             };
 
-            RedirectedObjectAttributes->ObjectName = &ObjectName;
+            RedirectedObjectAttributes->ObjectName = &RedirectedObjectName;
 
             NTSTATUS result = NtCreateFile_Original(
                 FileHandle,
@@ -2486,6 +2623,7 @@ void LoadSettings() {
 
         Wh_Log(L"Loaded %i redirections and stored them to shared cache.", redirections.size());
         g_redirections = std::move(redirections);
+        g_redirectionTrie.Build(g_redirections);
 
     } else {
 
@@ -2503,6 +2641,7 @@ void LoadSettings() {
 
         Wh_Log(L"Loaded %i redirections from shared cache.", redirections.size());
         g_redirections = std::move(redirections);
+        g_redirectionTrie.Build(g_redirections);
 
     }
 
@@ -2,7 +2,7 @@
 // @id              windows-11-start-menu-styler
 // @name            Windows 11 Start Menu Styler
 // @description     Customize the Start menu with themes contributed by others or create your own
-// @version         1.7
+// @version         1.7.1
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -8797,6 +8797,128 @@ winrt::Windows::Storage::Streams::IRandomAccessStream CreateNoiseStream(
     return cachedStream.CloneStream();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Shared blur effect resources
+//
+// Every XamlBlurBrush with the same graph shape reuses one effect factory, and
+// every brush with the same noise density reuses one noise surface. Blur
+// amount and tint color are animatable properties of the factory and are set
+// per brush, so the common case of one blur applied to many elements compiles
+// a single effect. The cache belongs to the thread's compositor and is cleared
+// when the mod uninitializes the thread.
+
+// The parts of the effect graph that are baked into the factory. Optional
+// stages that are disabled are empty, so that equivalent graphs compare equal.
+struct BlurEffectFactoryKey {
+    std::optional<float> saturation;
+    std::optional<float> luminosityOpacity;
+    float tintLuminance = 0.0f;  // Only used by the luminosity stage
+    std::optional<float> noiseOpacity;
+
+    bool operator==(const BlurEffectFactoryKey&) const = default;
+};
+
+struct BlurEffectResourceCache {
+    wuc::Compositor compositor{nullptr};
+    std::vector<std::pair<BlurEffectFactoryKey, wuc::CompositionEffectFactory>>
+        effectFactories;
+    std::vector<std::pair<float, Media::LoadedImageSurface>> noiseSurfaces;
+    size_t brushesCreated = 0;
+    size_t effectFactoryReuses = 0;
+};
+
+// Themes only produce a few distinct graphs; the limits guard against theme
+// color changes feeding new tint luminance values into the key indefinitely.
+constexpr size_t kMaxCachedBlurEffectFactories = 32;
+constexpr size_t kMaxCachedNoiseSurfaces = 8;
+
+thread_local BlurEffectResourceCache g_blurEffectResourceCache;
+
+void LogBlurEffectResourceCounts() {
+    const auto& cache = g_blurEffectResourceCache;
+    Wh_Log(L"Blur effect resources: %zu effect factories, %zu noise surfaces, "
+           L"%zu brushes created (%zu reused a factory)",
+           cache.effectFactories.size(), cache.noiseSurfaces.size(),
+           cache.brushesCreated, cache.effectFactoryReuses);
+}
+
+BlurEffectResourceCache& GetBlurEffectResourceCache(
+    const wuc::Compositor& compositor) {
+    auto& cache = g_blurEffectResourceCache;
+    if (cache.compositor != compositor) {
+        if (cache.compositor) {
+            Wh_Log(L"Compositor changed, dropping shared blur resources");
+        }
+
+        cache = {};
+        cache.compositor = compositor;
+    }
+
+    return cache;
+}
+
+template <typename CreateEffectGraph>
+wuc::CompositionEffectBrush CreateSharedBlurEffectBrush(
+    const wuc::Compositor& compositor,
+    const BlurEffectFactoryKey& key,
+    CreateEffectGraph&& createEffectGraph) {
+    auto& cache = GetBlurEffectResourceCache(compositor);
+    auto& factories = cache.effectFactories;
+
+    auto it =
+        std::find_if(factories.begin(), factories.end(),
+                     [&](const auto& entry) { return entry.first == key; });
+    if (it != factories.end()) {
+        cache.effectFactoryReuses++;
+    } else {
+        if (factories.size() >= kMaxCachedBlurEffectFactories) {
+            factories.erase(factories.begin());
+        }
+
+        factories.emplace_back(
+            key, compositor.CreateEffectFactory(
+                     createEffectGraph(),
+                     {L"BlurEffect.BlurAmount", L"FloodEffect.Color"}));
+        it = std::prev(factories.end());
+        LogBlurEffectResourceCounts();
+    }
+
+    cache.brushesCreated++;
+    return it->second.CreateBrush();
+}
+
+Media::LoadedImageSurface GetSharedNoiseSurface(
+    const wuc::Compositor& compositor,
+    float density) {
+    auto& surfaces = GetBlurEffectResourceCache(compositor).noiseSurfaces;
+
+    auto it =
+        std::find_if(surfaces.begin(), surfaces.end(),
+                     [&](const auto& entry) { return entry.first == density; });
+    if (it != surfaces.end()) {
+        return it->second;
+    }
+
+    if (surfaces.size() >= kMaxCachedNoiseSurfaces) {
+        surfaces.erase(surfaces.begin());
+    }
+
+    auto surface = Media::LoadedImageSurface::StartLoadFromStream(
+        CreateNoiseStream(density));
+    surfaces.emplace_back(density, surface);
+    LogBlurEffectResourceCounts();
+
+    return surface;
+}
+
+void ClearSharedBlurEffectResources() {
+    if (g_blurEffectResourceCache.compositor) {
+        LogBlurEffectResourceCounts();
+    }
+
+    g_blurEffectResourceCache = {};
+}
+
 // Blur background implementation, copied from TranslucentTB.
 ////////////////////////////////////////////////////////////////////////////////
 // clang-format off
@@ -9997,122 +10119,147 @@ wuc::CompositionBrush XamlBlurBrush::CreateFallbackBrush()
 
 wuc::CompositionBrush XamlBlurBrush::CreateEffectBrush()
 {
-    auto backdropBrush = m_compositor.CreateBackdropBrush();
-
     // Rec. 709 luma coefficients, used for saturation and luminosity.
     constexpr float kLumaR = 0.2126f;
     constexpr float kLumaG = 0.7152f;
     constexpr float kLumaB = 0.0722f;
 
-    // 1. Blur
-    auto blurEffect = winrt::make_self<GaussianBlurEffect>();
-    blurEffect->Source = wuc::CompositionEffectSourceParameter(L"backdrop");
-    blurEffect->BlurAmount = m_blurAmount;
-    blurEffect->Name(L"BlurEffect");
-
-    wge::IGraphicsEffectSource topOfStack = *blurEffect;
+    BlurEffectFactoryKey key;
 
-    // 2. Saturation (optional)
     if (m_tintSaturation && *m_tintSaturation != 1.0f)
     {
-        float s = std::max(*m_tintSaturation, 0.0f);
-        float invS = 1.0f - s;
-
-        auto satMatrix = winrt::make_self<ColorMatrixEffect>();
-        satMatrix->Source = topOfStack;
+        key.saturation = std::max(*m_tintSaturation, 0.0f);
+    }
 
-        // Standard saturation matrix: lerp between luminance and identity.
-        auto& m = satMatrix->Matrix;
-        m[0]  = invS * kLumaR + s; m[1]  = invS * kLumaR;     m[2]  = invS * kLumaR;     m[3]  = 0.0f;
-        m[4]  = invS * kLumaG;     m[5]  = invS * kLumaG + s; m[6]  = invS * kLumaG;     m[7]  = 0.0f;
-        m[8]  = invS * kLumaB;     m[9]  = invS * kLumaB;     m[10] = invS * kLumaB + s; m[11] = 0.0f;
-        m[12] = 0.0f;              m[13] = 0.0f;              m[14] = 0.0f;              m[15] = 1.0f;
+    if (m_tintLuminosityOpacity && *m_tintLuminosityOpacity > 0.0f)
+    {
+        key.luminosityOpacity = std::clamp(*m_tintLuminosityOpacity, 0.0f, 1.0f);
+        key.tintLuminance = (m_tint.R / 255.0f) * kLumaR +
+                            (m_tint.G / 255.0f) * kLumaG +
+                            (m_tint.B / 255.0f) * kLumaB;
+    }
 
-        satMatrix->Name(L"SaturationEffect");
-        topOfStack = *satMatrix;
+    if (m_noiseOpacity && *m_noiseOpacity > 0.0f)
+    {
+        key.noiseOpacity = std::clamp(*m_noiseOpacity, 0.0f, 1.0f);
     }
 
-    // 3. Luminosity (optional) - shifts pixel luminance towards the tint's
-    // luminance, blended by the opacity factor.
-    if (m_tintLuminosityOpacity && *m_tintLuminosityOpacity > 0.0f)
+    // Only called when no brush with the same key was created yet. BlurAmount
+    // and the flood color are set per brush below.
+    auto createEffectGraph = [&]() -> wge::IGraphicsEffect
     {
-        float op = std::clamp(*m_tintLuminosityOpacity, 0.0f, 1.0f);
+        // 1. Blur
+        auto blurEffect = winrt::make_self<GaussianBlurEffect>();
+        blurEffect->Source = wuc::CompositionEffectSourceParameter(L"backdrop");
+        blurEffect->BlurAmount = m_blurAmount;
+        blurEffect->Name(L"BlurEffect");
 
-        float tintLum = (m_tint.R / 255.0f) * kLumaR +
-                        (m_tint.G / 255.0f) * kLumaG +
-                        (m_tint.B / 255.0f) * kLumaB;
+        wge::IGraphicsEffectSource topOfStack = *blurEffect;
 
-        auto lumMatrix = winrt::make_self<ColorMatrixEffect>();
-        lumMatrix->Source = topOfStack;
+        // 2. Saturation (optional)
+        if (key.saturation)
+        {
+            float s = *key.saturation;
+            float invS = 1.0f - s;
 
-        auto& m = lumMatrix->Matrix;
-        m[0]  = 1.0f - (kLumaR * op); m[1]  = -(kLumaR * op);       m[2]  = -(kLumaR * op);       m[3]  = 0.0f;
-        m[4]  = -(kLumaG * op);       m[5]  = 1.0f - (kLumaG * op); m[6]  = -(kLumaG * op);       m[7]  = 0.0f;
-        m[8]  = -(kLumaB * op);       m[9]  = -(kLumaB * op);       m[10] = 1.0f - (kLumaB * op); m[11] = 0.0f;
-        m[12] = 0.0f;                 m[13] = 0.0f;                 m[14] = 0.0f;                 m[15] = 1.0f;
-        m[16] = tintLum * op;         m[17] = tintLum * op;         m[18] = tintLum * op;         m[19] = 0.0f;
+            auto satMatrix = winrt::make_self<ColorMatrixEffect>();
+            satMatrix->Source = topOfStack;
 
-        lumMatrix->Name(L"LuminosityBlend");
-        topOfStack = *lumMatrix;
-    }
+            // Standard saturation matrix: lerp between luminance and identity.
+            auto& m = satMatrix->Matrix;
+            m[0]  = invS * kLumaR + s; m[1]  = invS * kLumaR;     m[2]  = invS * kLumaR;     m[3]  = 0.0f;
+            m[4]  = invS * kLumaG;     m[5]  = invS * kLumaG + s; m[6]  = invS * kLumaG;     m[7]  = 0.0f;
+            m[8]  = invS * kLumaB;     m[9]  = invS * kLumaB;     m[10] = invS * kLumaB + s; m[11] = 0.0f;
+            m[12] = 0.0f;              m[13] = 0.0f;              m[14] = 0.0f;              m[15] = 1.0f;
 
-    // 4. Noise overlay (optional) - procedural tiled noise with adjustable
-    // density and opacity.
-    wuc::CompositionSurfaceBrush noiseBrush{nullptr};
-    if (m_noiseOpacity && *m_noiseOpacity > 0.0f)
-    {
-        float density = m_noiseDensity.value_or(1.0f);
+            satMatrix->Name(L"SaturationEffect");
+            topOfStack = *satMatrix;
+        }
 
-        auto stream = CreateNoiseStream(density);
-        auto surface =
-            Media::LoadedImageSurface::StartLoadFromStream(stream);
-        noiseBrush = m_compositor.CreateSurfaceBrush(surface);
-        noiseBrush.Stretch(wuc::CompositionStretch::None);
+        // 3. Luminosity (optional) - shifts pixel luminance towards the tint's
+        // luminance, blended by the opacity factor.
+        if (key.luminosityOpacity)
+        {
+            float op = *key.luminosityOpacity;
+            float tintLum = key.tintLuminance;
+
+            auto lumMatrix = winrt::make_self<ColorMatrixEffect>();
+            lumMatrix->Source = topOfStack;
+
+            auto& m = lumMatrix->Matrix;
+            m[0]  = 1.0f - (kLumaR * op); m[1]  = -(kLumaR * op);       m[2]  = -(kLumaR * op);       m[3]  = 0.0f;
+            m[4]  = -(kLumaG * op);       m[5]  = 1.0f - (kLumaG * op); m[6]  = -(kLumaG * op);       m[7]  = 0.0f;
+            m[8]  = -(kLumaB * op);       m[9]  = -(kLumaB * op);       m[10] = 1.0f - (kLumaB * op); m[11] = 0.0f;
+            m[12] = 0.0f;                 m[13] = 0.0f;                 m[14] = 0.0f;                 m[15] = 1.0f;
+            m[16] = tintLum * op;         m[17] = tintLum * op;         m[18] = tintLum * op;         m[19] = 0.0f;
+
+            lumMatrix->Name(L"LuminosityBlend");
+            topOfStack = *lumMatrix;
+        }
 
-        // Tile via border effect (wrap mode).
-        auto borderEffect = winrt::make_self<BorderEffect>();
-        borderEffect->Source =
-            wuc::CompositionEffectSourceParameter(L"NoiseSource");
-
-        // Scale all channels by opacity for premultiplied blending.
-        float nOp = std::clamp(*m_noiseOpacity, 0.0f, 1.0f);
-
-        auto opacityEffect = winrt::make_self<ColorMatrixEffect>();
-        opacityEffect->Source = *borderEffect;
-        // Matrix: Scale all channels by opacity (for premultiplied blending).
-        opacityEffect->Matrix[0] = nOp;
-        opacityEffect->Matrix[5] = nOp;
-        opacityEffect->Matrix[10] = nOp;
-        opacityEffect->Matrix[15] = nOp;
-        opacityEffect->Name(L"NoiseOpacityEffect");
-
-        // Composite noise over the current stack.
-        auto noiseComposite = winrt::make_self<CompositeEffect>();
-        noiseComposite->Mode = D2D1_COMPOSITE_MODE_SOURCE_OVER;
-        noiseComposite->Sources.push_back(topOfStack);
-        noiseComposite->Sources.push_back(*opacityEffect);
-        noiseComposite->Name(L"NoiseComposite");
-        topOfStack = *noiseComposite;
-    }
-
-    // 5. Tint (flood color composited over the stack).
-    auto floodEffect = winrt::make_self<FloodEffect>();
-    floodEffect->Color = m_tint;
-    floodEffect->Name(L"FloodEffect");
-
-    auto compositeEffect = winrt::make_self<CompositeEffect>();
-    compositeEffect->Mode = D2D1_COMPOSITE_MODE_SOURCE_OVER;
-    compositeEffect->Sources.push_back(topOfStack);
-    compositeEffect->Sources.push_back(*floodEffect);
-
-    auto factory = m_compositor.CreateEffectFactory(*compositeEffect);
-    auto brush = factory.CreateBrush();
-
-    brush.SetSourceParameter(L"backdrop", backdropBrush);
-
-    // Bind the noise brush if we created one.
-    if (noiseBrush)
+        // 4. Noise overlay (optional) - procedural tiled noise with adjustable
+        // density and opacity.
+        if (key.noiseOpacity)
+        {
+            // Tile via border effect (wrap mode).
+            auto borderEffect = winrt::make_self<BorderEffect>();
+            borderEffect->Source =
+                wuc::CompositionEffectSourceParameter(L"NoiseSource");
+
+            // Scale all channels by opacity for premultiplied blending.
+            float nOp = *key.noiseOpacity;
+
+            auto opacityEffect = winrt::make_self<ColorMatrixEffect>();
+            opacityEffect->Source = *borderEffect;
+            // Matrix: Scale all channels by opacity (for premultiplied blending).
+            opacityEffect->Matrix[0] = nOp;
+            opacityEffect->Matrix[5] = nOp;
+            opacityEffect->Matrix[10] = nOp;
+            opacityEffect->Matrix[15] = nOp;
+            opacityEffect->Name(L"NoiseOpacityEffect");
+
+            // Composite noise over the current stack.
+            auto noiseComposite = winrt::make_self<CompositeEffect>();
+            noiseComposite->Mode = D2D1_COMPOSITE_MODE_SOURCE_OVER;
+            noiseComposite->Sources.push_back(topOfStack);
+            noiseComposite->Sources.push_back(*opacityEffect);
+            noiseComposite->Name(L"NoiseComposite");
+            topOfStack = *noiseComposite;
+        }
+
+        // 5. Tint (flood color composited over the stack).
+        auto floodEffect = winrt::make_self<FloodEffect>();
+        floodEffect->Color = m_tint;
+        floodEffect->Name(L"FloodEffect");
+
+        auto compositeEffect = winrt::make_self<CompositeEffect>();
+        compositeEffect->Mode = D2D1_COMPOSITE_MODE_SOURCE_OVER;
+        compositeEffect->Sources.push_back(topOfStack);
+        compositeEffect->Sources.push_back(*floodEffect);
+
+        return *compositeEffect;
+    };
+
+    auto brush =
+        CreateSharedBlurEffectBrush(m_compositor, key, createEffectGraph);
+
+    // FloodEffect exposes its color as straight-alpha RGBA floats.
+    auto properties = brush.Properties();
+    properties.InsertScalar(L"BlurEffect.BlurAmount", m_blurAmount);
+    properties.InsertVector4(L"FloodEffect.Color",
+                             wf::Numerics::float4{m_tint.R / 255.0f,
+                                                  m_tint.G / 255.0f,
+                                                  m_tint.B / 255.0f,
+                                                  m_tint.A / 255.0f});
+
+    brush.SetSourceParameter(L"backdrop", m_compositor.CreateBackdropBrush());
+
+    // Bind a noise brush over the shared surface if the graph has a noise stage.
+    if (key.noiseOpacity)
     {
+        auto noiseBrush = m_compositor.CreateSurfaceBrush(GetSharedNoiseSurface(
+            m_compositor, m_noiseDensity.value_or(1.0f)));
+        noiseBrush.Stretch(wuc::CompositionStretch::None);
         brush.SetSourceParameter(L"NoiseSource", noiseBrush);
     }
 
@@ -15415,6 +15562,8 @@ void UninitializeSettingsAndTap() {
 
     g_elementsCustomizationRules.clear();
 
+    ClearSharedBlurEffectResources();
+
     UninitializeResourceVariables();
 
     for (const auto& [handle, webViewCustomizationState] :
@@ -2,7 +2,7 @@
 // @id              windows-11-taskbar-styler
 // @name            Windows 11 Taskbar Styler
 // @description     Customize the taskbar with themes contributed by others or create your own
-// @version         1.8
+// @version         1.8.6
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -579,6 +579,11 @@ from the **TranslucentTB** project.
   - alert: Alert (prompt before blocking)
   - block: Block other consumers
   - allow: Allow other consumers
+- verboseLogging: false
+  $name: Verbose logging
+  $description: >-
+    Log the generated XAML of every parsed style. Useful for debugging styles,
+    but slows down loading large themes.
 */
 // ==/WindhawkModSettings==
 
@@ -8417,9 +8422,17 @@ void PromptToRestartExplorer(HRESULT statusCode) {
         nullptr);
 }
 
-void ApplyCustomizations(InstanceHandle handle,
-                         winrt::Windows::UI::Xaml::FrameworkElement element,
-                         PCWSTR fallbackClassName);
+enum class ApplyCustomizationsResult {
+    kNotMatched,
+    kUnchanged,  // Already customized by the same rules
+    kApplied,
+    kReverted,  // Customized before, but no rules match anymore
+};
+
+ApplyCustomizationsResult ApplyCustomizations(
+    InstanceHandle handle,
+    winrt::Windows::UI::Xaml::FrameworkElement element,
+    PCWSTR fallbackClassName);
 void CleanupCustomizations(InstanceHandle handle);
 
 void HandleClickThroughIslandRoot(
@@ -8807,8 +8820,10 @@ HRESULT InjectWindhawkTAP() noexcept
 #include <algorithm>
 #include <charconv>
 #include <cmath>
+#include <functional>
 #include <limits>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <random>
@@ -8867,6 +8882,7 @@ enum class XamlDiagnosticsHandling {
 struct {
     bool clickThroughTaskbar;
     XamlDiagnosticsHandling xamlDiagnosticsHandling;
+    bool verboseLogging;
 } g_settings;
 
 // https://stackoverflow.com/a/51274008
@@ -8944,15 +8960,23 @@ struct XamlBlurBrushParams {
     std::wstring fallbackThemeResourceKey;  // Empty if not from ThemeResource
 };
 
+struct CompiledStyleTemplate;
+
+std::shared_ptr<const CompiledStyleTemplate> CompileStyleTemplate(
+    std::wstring_view input);
+
 // Holds the raw rule body for a style whose value depends on `{{...}}`
 // substitutions. Re-resolved on every apply and on every variable change.
 // `propertyName` is kept alongside the value because Windows.UI.Xaml's
 // DependencyProperty does not expose its name, and the re-resolution path needs
-// to feed the name back to the XAML parser.
+// to feed the name back to the XAML parser. `compiled` is the parsed form of
+// `rawValue`, shared by all copies of the template; null if the value can only
+// be expanded by re-scanning the text (see CompileStyleTemplate).
 struct DynamicStyleTemplate {
     std::wstring propertyName;
     std::wstring rawValue;
     bool isXamlValue = false;
+    std::shared_ptr<const CompiledStyleTemplate> compiled;
 };
 
 // Tagged value for one (property, visualState) cell of PropertyOverrides.
@@ -8999,11 +9023,24 @@ struct ElementCustomizationRules {
     ElementMatcher elementMatcher;
     std::vector<ElementMatcher> parentElementMatchers;
     PropertyOverridesMaybeUnresolved propertyOverrides;
+    // The target and styles the rules were parsed from, after applying style
+    // constants. Identifies the rules across settings reloads, see
+    // ReloadStylesForCurrentThread.
+    std::shared_ptr<const std::wstring> source;
 };
 
 thread_local std::vector<ElementCustomizationRules>
     g_elementsCustomizationRules;
 
+// Indexes into g_elementsCustomizationRules, bucketed by the type and the name
+// of each rule's element matcher (empty if not restricted), so that an element
+// is only tested against rules which can match it. Indexes in each bucket are
+// in ascending order. Rebuilt by ProcessAllStylesFromSettings.
+thread_local std::unordered_map<
+    std::wstring,
+    std::unordered_map<std::wstring, std::vector<size_t>>>
+    g_elementsCustomizationRulesIndex;
+
 struct ElementPropertyCustomizationState {
     std::optional<winrt::Windows::Foundation::IInspectable> originalValue;
     // The most recently applied value, re-pushed by the per-DP property-
@@ -9024,6 +9061,10 @@ struct ElementPropertyCustomizationState {
     // Names of style variables this property's value depends on. Populated
     // alongside `dynamicTemplate`; empty for static styles.
     std::vector<std::wstring> variableDependencies;
+    // The expanded text `customValue` was resolved from, so that propagation
+    // can skip the XAML re-parse when a variable change doesn't change the
+    // expansion.
+    std::optional<std::wstring> lastExpandedValue;
 };
 
 struct CapturePropertyCustomizationState {
@@ -9066,6 +9107,17 @@ struct ElementCustomizationState {
     std::list<std::pair<std::optional<winrt::weak_ref<VisualStateGroup>>,
                         ElementCustomizationStateForVisualStateGroup>>
         perVisualStateGroup;
+
+    // The sources of the rules the customizations above were built from, with
+    // the visual state group each one matched, in match order. A settings
+    // reload leaves the element alone if the same rules still match.
+    std::vector<std::pair<std::shared_ptr<const std::wstring>,
+                          std::optional<winrt::weak_ref<VisualStateGroup>>>>
+        appliedRules;
+
+    // The type name the element was reported with, used as the fallback class
+    // name when matching it again on a settings reload.
+    std::wstring fallbackClassName;
 };
 
 thread_local std::unordered_map<InstanceHandle, ElementCustomizationState>
@@ -9206,6 +9258,8 @@ struct ResourceVariableEntry {
     std::wstring value;
     ResourceVariableTheme theme;
     ResourceVariableType type;
+
+    bool operator==(const ResourceVariableEntry&) const = default;
 };
 
 thread_local std::vector<ResourceVariableEntry> g_resourceVariables;
@@ -9422,6 +9476,128 @@ winrt::Windows::Storage::Streams::IRandomAccessStream CreateNoiseStream(
     return cachedStream.CloneStream();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Shared blur effect resources
+//
+// Every XamlBlurBrush with the same graph shape reuses one effect factory, and
+// every brush with the same noise density reuses one noise surface. Blur
+// amount and tint color are animatable properties of the factory and are set
+// per brush, so the common case of one blur applied to many elements compiles
+// a single effect. The cache belongs to the thread's compositor and is cleared
+// when the mod uninitializes the thread.
+
+// The parts of the effect graph that are baked into the factory. Optional
+// stages that are disabled are empty, so that equivalent graphs compare equal.
+struct BlurEffectFactoryKey {
+    std::optional<float> saturation;
+    std::optional<float> luminosityOpacity;
+    float tintLuminance = 0.0f;  // Only used by the luminosity stage
+    std::optional<float> noiseOpacity;
+
+    bool operator==(const BlurEffectFactoryKey&) const = default;
+};
+
+struct BlurEffectResourceCache {
+    wuc::Compositor compositor{nullptr};
+    std::vector<std::pair<BlurEffectFactoryKey, wuc::CompositionEffectFactory>>
+        effectFactories;
+    std::vector<std::pair<float, Media::LoadedImageSurface>> noiseSurfaces;
+    size_t brushesCreated = 0;
+    size_t effectFactoryReuses = 0;
+};
+
+// Themes only produce a few distinct graphs; the limits guard against theme
+// color changes feeding new tint luminance values into the key indefinitely.
+constexpr size_t kMaxCachedBlurEffectFactories = 32;
+constexpr size_t kMaxCachedNoiseSurfaces = 8;
+
+thread_local BlurEffectResourceCache g_blurEffectResourceCache;
+
+void LogBlurEffectResourceCounts() {
+    const auto& cache = g_blurEffectResourceCache;
+    Wh_Log(L"Blur effect resources: %zu effect factories, %zu noise surfaces, "
+           L"%zu brushes created (%zu reused a factory)",
+           cache.effectFactories.size(), cache.noiseSurfaces.size(),
+           cache.brushesCreated, cache.effectFactoryReuses);
+}
+
+BlurEffectResourceCache& GetBlurEffectResourceCache(
+    const wuc::Compositor& compositor) {
+    auto& cache = g_blurEffectResourceCache;
+    if (cache.compositor != compositor) {
+        if (cache.compositor) {
+            Wh_Log(L"Compositor changed, dropping shared blur resources");
+        }
+
+        cache = {};
+        cache.compositor = compositor;
+    }
+
+    return cache;
+}
+
+template <typename CreateEffectGraph>
+wuc::CompositionEffectBrush CreateSharedBlurEffectBrush(
+    const wuc::Compositor& compositor,
+    const BlurEffectFactoryKey& key,
+    CreateEffectGraph&& createEffectGraph) {
+    auto& cache = GetBlurEffectResourceCache(compositor);
+    auto& factories = cache.effectFactories;
+
+    auto it =
+        std::find_if(factories.begin(), factories.end(),
+                     [&](const auto& entry) { return entry.first == key; });
+    if (it != factories.end()) {
+        cache.effectFactoryReuses++;
+    } else {
+        if (factories.size() >= kMaxCachedBlurEffectFactories) {
+            factories.erase(factories.begin());
+        }
+
+        factories.emplace_back(
+            key, compositor.CreateEffectFactory(
+                     createEffectGraph(),
+                     {L"BlurEffect.BlurAmount", L"FloodEffect.Color"}));
+        it = std::prev(factories.end());
+        LogBlurEffectResourceCounts();
+    }
+
+    cache.brushesCreated++;
+    return it->second.CreateBrush();
+}
+
+Media::LoadedImageSurface GetSharedNoiseSurface(
+    const wuc::Compositor& compositor,
+    float density) {
+    auto& surfaces = GetBlurEffectResourceCache(compositor).noiseSurfaces;
+
+    auto it =
+        std::find_if(surfaces.begin(), surfaces.end(),
+                     [&](const auto& entry) { return entry.first == density; });
+    if (it != surfaces.end()) {
+        return it->second;
+    }
+
+    if (surfaces.size() >= kMaxCachedNoiseSurfaces) {
+        surfaces.erase(surfaces.begin());
+    }
+
+    auto surface = Media::LoadedImageSurface::StartLoadFromStream(
+        CreateNoiseStream(density));
+    surfaces.emplace_back(density, surface);
+    LogBlurEffectResourceCounts();
+
+    return surface;
+}
+
+void ClearSharedBlurEffectResources() {
+    if (g_blurEffectResourceCache.compositor) {
+        LogBlurEffectResourceCounts();
+    }
+
+    g_blurEffectResourceCache = {};
+}
+
 // Blur background implementation, copied from TranslucentTB.
 ////////////////////////////////////////////////////////////////////////////////
 // clang-format off
@@ -10622,122 +10798,147 @@ wuc::CompositionBrush XamlBlurBrush::CreateFallbackBrush()
 
 wuc::CompositionBrush XamlBlurBrush::CreateEffectBrush()
 {
-    auto backdropBrush = m_compositor.CreateBackdropBrush();
-
     // Rec. 709 luma coefficients, used for saturation and luminosity.
     constexpr float kLumaR = 0.2126f;
     constexpr float kLumaG = 0.7152f;
     constexpr float kLumaB = 0.0722f;
 
-    // 1. Blur
-    auto blurEffect = winrt::make_self<GaussianBlurEffect>();
-    blurEffect->Source = wuc::CompositionEffectSourceParameter(L"backdrop");
-    blurEffect->BlurAmount = m_blurAmount;
-    blurEffect->Name(L"BlurEffect");
+    BlurEffectFactoryKey key;
 
-    wge::IGraphicsEffectSource topOfStack = *blurEffect;
-
-    // 2. Saturation (optional)
     if (m_tintSaturation && *m_tintSaturation != 1.0f)
     {
-        float s = std::max(*m_tintSaturation, 0.0f);
-        float invS = 1.0f - s;
-
-        auto satMatrix = winrt::make_self<ColorMatrixEffect>();
-        satMatrix->Source = topOfStack;
+        key.saturation = std::max(*m_tintSaturation, 0.0f);
+    }
 
-        // Standard saturation matrix: lerp between luminance and identity.
-        auto& m = satMatrix->Matrix;
-        m[0]  = invS * kLumaR + s; m[1]  = invS * kLumaR;     m[2]  = invS * kLumaR;     m[3]  = 0.0f;
-        m[4]  = invS * kLumaG;     m[5]  = invS * kLumaG + s; m[6]  = invS * kLumaG;     m[7]  = 0.0f;
-        m[8]  = invS * kLumaB;     m[9]  = invS * kLumaB;     m[10] = invS * kLumaB + s; m[11] = 0.0f;
-        m[12] = 0.0f;              m[13] = 0.0f;              m[14] = 0.0f;              m[15] = 1.0f;
+    if (m_tintLuminosityOpacity && *m_tintLuminosityOpacity > 0.0f)
+    {
+        key.luminosityOpacity = std::clamp(*m_tintLuminosityOpacity, 0.0f, 1.0f);
+        key.tintLuminance = (m_tint.R / 255.0f) * kLumaR +
+                            (m_tint.G / 255.0f) * kLumaG +
+                            (m_tint.B / 255.0f) * kLumaB;
+    }
 
-        satMatrix->Name(L"SaturationEffect");
-        topOfStack = *satMatrix;
+    if (m_noiseOpacity && *m_noiseOpacity > 0.0f)
+    {
+        key.noiseOpacity = std::clamp(*m_noiseOpacity, 0.0f, 1.0f);
     }
 
-    // 3. Luminosity (optional) - shifts pixel luminance towards the tint's
-    // luminance, blended by the opacity factor.
-    if (m_tintLuminosityOpacity && *m_tintLuminosityOpacity > 0.0f)
+    // Only called when no brush with the same key was created yet. BlurAmount
+    // and the flood color are set per brush below.
+    auto createEffectGraph = [&]() -> wge::IGraphicsEffect
     {
-        float op = std::clamp(*m_tintLuminosityOpacity, 0.0f, 1.0f);
+        // 1. Blur
+        auto blurEffect = winrt::make_self<GaussianBlurEffect>();
+        blurEffect->Source = wuc::CompositionEffectSourceParameter(L"backdrop");
+        blurEffect->BlurAmount = m_blurAmount;
+        blurEffect->Name(L"BlurEffect");
 
-        float tintLum = (m_tint.R / 255.0f) * kLumaR +
-                        (m_tint.G / 255.0f) * kLumaG +
-                        (m_tint.B / 255.0f) * kLumaB;
+        wge::IGraphicsEffectSource topOfStack = *blurEffect;
 
-        auto lumMatrix = winrt::make_self<ColorMatrixEffect>();
-        lumMatrix->Source = topOfStack;
+        // 2. Saturation (optional)
+        if (key.saturation)
+        {
+            float s = *key.saturation;
+            float invS = 1.0f - s;
 
-        auto& m = lumMatrix->Matrix;
-        m[0]  = 1.0f - (kLumaR * op); m[1]  = -(kLumaR * op);       m[2]  = -(kLumaR * op);       m[3]  = 0.0f;
-        m[4]  = -(kLumaG * op);       m[5]  = 1.0f - (kLumaG * op); m[6]  = -(kLumaG * op);       m[7]  = 0.0f;
-        m[8]  = -(kLumaB * op);       m[9]  = -(kLumaB * op);       m[10] = 1.0f - (kLumaB * op); m[11] = 0.0f;
-        m[12] = 0.0f;                 m[13] = 0.0f;                 m[14] = 0.0f;                 m[15] = 1.0f;
-        m[16] = tintLum * op;         m[17] = tintLum * op;         m[18] = tintLum * op;         m[19] = 0.0f;
+            auto satMatrix = winrt::make_self<ColorMatrixEffect>();
+            satMatrix->Source = topOfStack;
 
-        lumMatrix->Name(L"LuminosityBlend");
-        topOfStack = *lumMatrix;
-    }
+            // Standard saturation matrix: lerp between luminance and identity.
+            auto& m = satMatrix->Matrix;
+            m[0]  = invS * kLumaR + s; m[1]  = invS * kLumaR;     m[2]  = invS * kLumaR;     m[3]  = 0.0f;
+            m[4]  = invS * kLumaG;     m[5]  = invS * kLumaG + s; m[6]  = invS * kLumaG;     m[7]  = 0.0f;
+            m[8]  = invS * kLumaB;     m[9]  = invS * kLumaB;     m[10] = invS * kLumaB + s; m[11] = 0.0f;
+            m[12] = 0.0f;              m[13] = 0.0f;              m[14] = 0.0f;              m[15] = 1.0f;
 
-    // 4. Noise overlay (optional) - procedural tiled noise with adjustable
-    // density and opacity.
-    wuc::CompositionSurfaceBrush noiseBrush{nullptr};
-    if (m_noiseOpacity && *m_noiseOpacity > 0.0f)
-    {
-        float density = m_noiseDensity.value_or(1.0f);
+            satMatrix->Name(L"SaturationEffect");
+            topOfStack = *satMatrix;
+        }
 
-        auto stream = CreateNoiseStream(density);
-        auto surface =
-            Media::LoadedImageSurface::StartLoadFromStream(stream);
-        noiseBrush = m_compositor.CreateSurfaceBrush(surface);
-        noiseBrush.Stretch(wuc::CompositionStretch::None);
+        // 3. Luminosity (optional) - shifts pixel luminance towards the tint's
+        // luminance, blended by the opacity factor.
+        if (key.luminosityOpacity)
+        {
+            float op = *key.luminosityOpacity;
+            float tintLum = key.tintLuminance;
+
+            auto lumMatrix = winrt::make_self<ColorMatrixEffect>();
+            lumMatrix->Source = topOfStack;
+
+            auto& m = lumMatrix->Matrix;
+            m[0]  = 1.0f - (kLumaR * op); m[1]  = -(kLumaR * op);       m[2]  = -(kLumaR * op);       m[3]  = 0.0f;
+            m[4]  = -(kLumaG * op);       m[5]  = 1.0f - (kLumaG * op); m[6]  = -(kLumaG * op);       m[7]  = 0.0f;
+            m[8]  = -(kLumaB * op);       m[9]  = -(kLumaB * op);       m[10] = 1.0f - (kLumaB * op); m[11] = 0.0f;
+            m[12] = 0.0f;                 m[13] = 0.0f;                 m[14] = 0.0f;                 m[15] = 1.0f;
+            m[16] = tintLum * op;         m[17] = tintLum * op;         m[18] = tintLum * op;         m[19] = 0.0f;
+
+            lumMatrix->Name(L"LuminosityBlend");
+            topOfStack = *lumMatrix;
+        }
+
+        // 4. Noise overlay (optional) - procedural tiled noise with adjustable
+        // density and opacity.
+        if (key.noiseOpacity)
+        {
+            // Tile via border effect (wrap mode).
+            auto borderEffect = winrt::make_self<BorderEffect>();
+            borderEffect->Source =
+                wuc::CompositionEffectSourceParameter(L"NoiseSource");
+
+            // Scale all channels by opacity for premultiplied blending.
+            float nOp = *key.noiseOpacity;
+
+            auto opacityEffect = winrt::make_self<ColorMatrixEffect>();
+            opacityEffect->Source = *borderEffect;
+            // Matrix: Scale all channels by opacity (for premultiplied blending).
+            opacityEffect->Matrix[0] = nOp;
+            opacityEffect->Matrix[5] = nOp;
+            opacityEffect->Matrix[10] = nOp;
+            opacityEffect->Matrix[15] = nOp;
+            opacityEffect->Name(L"NoiseOpacityEffect");
+
+            // Composite noise over the current stack.
+            auto noiseComposite = winrt::make_self<CompositeEffect>();
+            noiseComposite->Mode = D2D1_COMPOSITE_MODE_SOURCE_OVER;
+            noiseComposite->Sources.push_back(topOfStack);
+            noiseComposite->Sources.push_back(*opacityEffect);
+            noiseComposite->Name(L"NoiseComposite");
+            topOfStack = *noiseComposite;
+        }
+
+        // 5. Tint (flood color composited over the stack).
+        auto floodEffect = winrt::make_self<FloodEffect>();
+        floodEffect->Color = m_tint;
+        floodEffect->Name(L"FloodEffect");
+
+        auto compositeEffect = winrt::make_self<CompositeEffect>();
+        compositeEffect->Mode = D2D1_COMPOSITE_MODE_SOURCE_OVER;
+        compositeEffect->Sources.push_back(topOfStack);
+        compositeEffect->Sources.push_back(*floodEffect);
+
+        return *compositeEffect;
+    };
+
+    auto brush =
+        CreateSharedBlurEffectBrush(m_compositor, key, createEffectGraph);
+
+    // FloodEffect exposes its color as straight-alpha RGBA floats.
+    auto properties = brush.Properties();
+    properties.InsertScalar(L"BlurEffect.BlurAmount", m_blurAmount);
+    properties.InsertVector4(L"FloodEffect.Color",
+                             wf::Numerics::float4{m_tint.R / 255.0f,
+                                                  m_tint.G / 255.0f,
+                                                  m_tint.B / 255.0f,
+                                                  m_tint.A / 255.0f});
+
+    brush.SetSourceParameter(L"backdrop", m_compositor.CreateBackdropBrush());
 
-        // Tile via border effect (wrap mode).
-        auto borderEffect = winrt::make_self<BorderEffect>();
-        borderEffect->Source =
-            wuc::CompositionEffectSourceParameter(L"NoiseSource");
-
-        // Scale all channels by opacity for premultiplied blending.
-        float nOp = std::clamp(*m_noiseOpacity, 0.0f, 1.0f);
-
-        auto opacityEffect = winrt::make_self<ColorMatrixEffect>();
-        opacityEffect->Source = *borderEffect;
-        // Matrix: Scale all channels by opacity (for premultiplied blending).
-        opacityEffect->Matrix[0] = nOp;
-        opacityEffect->Matrix[5] = nOp;
-        opacityEffect->Matrix[10] = nOp;
-        opacityEffect->Matrix[15] = nOp;
-        opacityEffect->Name(L"NoiseOpacityEffect");
-
-        // Composite noise over the current stack.
-        auto noiseComposite = winrt::make_self<CompositeEffect>();
-        noiseComposite->Mode = D2D1_COMPOSITE_MODE_SOURCE_OVER;
-        noiseComposite->Sources.push_back(topOfStack);
-        noiseComposite->Sources.push_back(*opacityEffect);
-        noiseComposite->Name(L"NoiseComposite");
-        topOfStack = *noiseComposite;
-    }
-
-    // 5. Tint (flood color composited over the stack).
-    auto floodEffect = winrt::make_self<FloodEffect>();
-    floodEffect->Color = m_tint;
-    floodEffect->Name(L"FloodEffect");
-
-    auto compositeEffect = winrt::make_self<CompositeEffect>();
-    compositeEffect->Mode = D2D1_COMPOSITE_MODE_SOURCE_OVER;
-    compositeEffect->Sources.push_back(topOfStack);
-    compositeEffect->Sources.push_back(*floodEffect);
-
-    auto factory = m_compositor.CreateEffectFactory(*compositeEffect);
-    auto brush = factory.CreateBrush();
-
-    brush.SetSourceParameter(L"backdrop", backdropBrush);
-
-    // Bind the noise brush if we created one.
-    if (noiseBrush)
+    // Bind a noise brush over the shared surface if the graph has a noise stage.
+    if (key.noiseOpacity)
     {
+        auto noiseBrush = m_compositor.CreateSurfaceBrush(GetSharedNoiseSurface(
+            m_compositor, m_noiseDensity.value_or(1.0f)));
+        noiseBrush.Stretch(wuc::CompositionStretch::None);
         brush.SetSourceParameter(L"NoiseSource", noiseBrush);
     }
 
@@ -11503,40 +11704,112 @@ std::optional<PropertyOverrideValue> ParseNonXamlPropertyOverrideValue(
     };
 }
 
-Style GetStyleFromXamlSetters(const std::wstring_view type,
-                              const std::wstring_view xamlStyleSetters) {
-    std::wstring xaml =
-        LR"(<ResourceDictionary
+constexpr WCHAR kStyleResourceDictionaryHeader[] =
+    LR"(<ResourceDictionary
     xmlns="http://schemas.microsoft.com/winfx/2006/xaml/presentation"
     xmlns:x="http://schemas.microsoft.com/winfx/2006/xaml"
     xmlns:d="http://schemas.microsoft.com/expression/blend/2008"
     xmlns:mc="http://schemas.openxmlformats.org/markup-compatibility/2006"
-    xmlns:muxc="using:Microsoft.UI.Xaml.Controls")";
+    xmlns:muxc="using:Microsoft.UI.Xaml.Controls">
+)";
+
+constexpr WCHAR kStyleResourceDictionaryFooter[] = L"</ResourceDictionary>";
+
+// Style resolution cost on the current thread, reported after the startup
+// batch and when the thread is uninitialized.
+struct StyleResolutionStats {
+    LONGLONG ticks = 0;
+    size_t xamlLoads = 0;
+    size_t cacheHits = 0;
+};
+
+thread_local StyleResolutionStats g_styleResolutionStats;
+
+// Parsed styles keyed by their target type and setters text (see
+// StyleCacheKey), so that equal setter blocks share a single Style and parsing
+// happens once per thread. Filled in bulk by ResolveAllStylesInBatch, kept
+// across in-place settings reloads so that unchanged styles aren't parsed
+// again, and cleared on uninitialization.
+thread_local std::unordered_map<std::wstring, Style> g_parsedStyleCache;
+
+// Set when the rules were (re)built, so that the next ApplyCustomizations call
+// parses their styles in a batch. Parsing is deferred until the resource
+// variables are merged, since {StaticResource} and {ThemeResource} references
+// are resolved when a style is parsed.
+thread_local bool g_styleBatchPending;
+
+class StyleResolutionTimer {
+   public:
+    StyleResolutionTimer() { QueryPerformanceCounter(&m_start); }
+
+    ~StyleResolutionTimer() {
+        LARGE_INTEGER end;
+        QueryPerformanceCounter(&end);
+        g_styleResolutionStats.ticks += end.QuadPart - m_start.QuadPart;
+    }
+
+    StyleResolutionTimer(const StyleResolutionTimer&) = delete;
+    StyleResolutionTimer& operator=(const StyleResolutionTimer&) = delete;
+
+   private:
+    LARGE_INTEGER m_start;
+};
+
+double StyleResolutionMilliseconds() {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return g_styleResolutionStats.ticks * 1000.0 / frequency.QuadPart;
+}
+
+std::wstring StyleCacheKey(std::wstring_view type,
+                           std::wstring_view xamlStyleSetters) {
+    std::wstring key;
+    key.reserve(type.size() + 1 + xamlStyleSetters.size());
+    key += type;
+    key += L'\n';
+    key += xamlStyleSetters;
+    return key;
+}
+
+// Appends a <Style> element for the given type. The type's namespace is
+// declared on the element itself, so that styles for types from different
+// namespaces can share one document.
+void AppendStyleXaml(std::wstring& xaml,
+                     std::wstring_view type,
+                     std::wstring_view xamlStyleSetters,
+                     std::wstring_view key) {
+    xaml += L"    <Style";
+
+    if (!key.empty()) {
+        xaml += L" x:Key=\"";
+        xaml += key;
+        xaml += L"\"";
+    }
 
     if (auto pos = type.rfind('.'); pos != type.npos) {
-        auto typeNamespace = std::wstring_view(type).substr(0, pos);
-        auto typeName = std::wstring_view(type).substr(pos + 1);
+        auto typeNamespace = type.substr(0, pos);
+        auto typeName = type.substr(pos + 1);
 
-        xaml += L"\n    xmlns:windhawkstyler=\"using:";
+        xaml += L" xmlns:windhawkstyler=\"using:";
         xaml += EscapeXmlAttribute(typeNamespace);
-        xaml +=
-            L"\">\n"
-            L"    <Style TargetType=\"windhawkstyler:";
+        xaml += L"\" TargetType=\"windhawkstyler:";
         xaml += EscapeXmlAttribute(typeName);
         xaml += L"\">\n";
     } else {
-        xaml +=
-            L">\n"
-            L"    <Style TargetType=\"";
+        xaml += L" TargetType=\"";
         xaml += EscapeXmlAttribute(type);
         xaml += L"\">\n";
     }
 
     xaml += xamlStyleSetters;
 
-    xaml +=
-        L"    </Style>\n"
-        L"</ResourceDictionary>";
+    xaml += L"    </Style>\n";
+}
+
+void LogXaml(const std::wstring& xaml) {
+    if (!g_settings.verboseLogging) {
+        return;
+    }
 
     Wh_Log(L"======================================== XAML:");
     std::wstringstream ss(xaml);
@@ -11545,7 +11818,17 @@ Style GetStyleFromXamlSetters(const std::wstring_view type,
         Wh_Log(L"%s", line.c_str());
     }
     Wh_Log(L"========================================");
+}
+
+Style GetStyleFromXamlSetters(const std::wstring_view type,
+                              const std::wstring_view xamlStyleSetters) {
+    std::wstring xaml = kStyleResourceDictionaryHeader;
+    AppendStyleXaml(xaml, type, xamlStyleSetters, {});
+    xaml += kStyleResourceDictionaryFooter;
 
+    LogXaml(xaml);
+
+    g_styleResolutionStats.xamlLoads++;
     auto resourceDictionary =
         Markup::XamlReader::Load(xaml).as<ResourceDictionary>();
 
@@ -11580,6 +11863,207 @@ Style GetStyleFromXamlSettersWithFallbackType(
     }
 }
 
+// Same as GetStyleFromXamlSettersWithFallbackType, but goes through the parsed
+// style cache. The cache entry is keyed by the requested type, which maps to
+// the same fallback type for all elements of that type.
+Style GetCachedStyleFromXamlSetters(const std::wstring_view type,
+                                    const std::wstring_view fallbackType,
+                                    const std::wstring_view xamlStyleSetters) {
+    auto key = StyleCacheKey(type, xamlStyleSetters);
+    if (auto it = g_parsedStyleCache.find(key);
+        it != g_parsedStyleCache.end()) {
+        g_styleResolutionStats.cacheHits++;
+        return it->second;
+    }
+
+    auto style = GetStyleFromXamlSettersWithFallbackType(type, fallbackType,
+                                                         xamlStyleSetters);
+    g_parsedStyleCache.try_emplace(std::move(key), style);
+    return style;
+}
+
+// Builds the setters of a single <Style> with one <Setter> per rule. Setters
+// for value rules come first, followed by one per capture rule. Dynamic /
+// capture rules emit a placeholder `{x:Null}` value -- we only need the
+// resolved DependencyProperty from those setters; the value is computed
+// elsewhere (per apply for dynamic, never for captures).
+std::wstring BuildPropertyOverridesXamlSetters(
+    const UnresolvedRules& unresolved,
+    std::vector<std::optional<PropertyOverrideValue>>* propertyOverrideValues) {
+    std::wstring xaml;
+
+    propertyOverrideValues->reserve(unresolved.valueRules.size());
+
+    for (const auto& rule : unresolved.valueRules) {
+        const bool isDynamic = rule.isDynamic();
+
+        propertyOverrideValues->push_back(
+            !isDynamic && rule.isXamlValue
+                ? ParseNonXamlPropertyOverrideValue(rule.value)
+                : std::nullopt);
+
+        xaml += L"        <Setter Property=\"";
+        xaml += EscapeXmlAttribute(rule.propertyName);
+        xaml += L"\"";
+        if (isDynamic || propertyOverrideValues->back() ||
+            (rule.isXamlValue && rule.value.empty())) {
+            xaml += L" Value=\"{x:Null}\" />\n";
+        } else if (!rule.isXamlValue) {
+            xaml += L" Value=\"";
+            xaml += EscapeXmlAttribute(rule.value);
+            xaml += L"\" />\n";
+        } else {
+            xaml +=
+                L">\n"
+                L"            <Setter.Value>\n";
+            xaml += rule.value;
+            xaml +=
+                L"\n"
+                L"            </Setter.Value>\n"
+                L"        </Setter>\n";
+        }
+    }
+
+    for (const auto& rule : unresolved.captureRules) {
+        xaml += L"        <Setter Property=\"";
+        xaml += EscapeXmlAttribute(rule.propertyName);
+        xaml += L"\" Value=\"{x:Null}\" />\n";
+    }
+
+    return xaml;
+}
+
+std::wstring BuildPropertyValuesXamlSetters(
+    const PropertyValuesUnresolved& propertyValuesStr) {
+    std::wstring xaml;
+
+    for (const auto& [property, value] : propertyValuesStr) {
+        xaml += L"        <Setter Property=\"";
+        xaml += EscapeXmlAttribute(property);
+        xaml += L"\" Value=\"";
+        xaml += EscapeXmlAttribute(value);
+        xaml += L"\" />\n";
+    }
+
+    return xaml;
+}
+
+struct StyleBatchEntry {
+    std::wstring_view type;
+    std::wstring setters;
+    std::wstring cacheKey;
+};
+
+// Parses entries [begin, end) as keyed styles of a single ResourceDictionary.
+// One bad style fails the whole document, so on failure the range is split in
+// halves until the failing styles are isolated. Those are left out of the
+// cache and go through the lazy path, which retries with a fallback type and
+// reports the error.
+void LoadStyleBatch(const std::vector<StyleBatchEntry>& entries,
+                    size_t begin,
+                    size_t end) {
+    std::wstring xaml = kStyleResourceDictionaryHeader;
+    for (size_t i = begin; i < end; i++) {
+        AppendStyleXaml(xaml, entries[i].type, entries[i].setters,
+                        L"s" + std::to_wstring(i));
+    }
+    xaml += kStyleResourceDictionaryFooter;
+
+    LogXaml(xaml);
+
+    try {
+        g_styleResolutionStats.xamlLoads++;
+        auto resourceDictionary =
+            Markup::XamlReader::Load(xaml).as<ResourceDictionary>();
+
+        for (size_t i = begin; i < end; i++) {
+            auto style = resourceDictionary
+                             .Lookup(winrt::box_value(L"s" + std::to_wstring(i)))
+                             .as<Style>();
+            g_parsedStyleCache.try_emplace(entries[i].cacheKey, style);
+        }
+    } catch (winrt::hresult_error const& ex) {
+        if (end - begin > 1) {
+            size_t middle = begin + (end - begin) / 2;
+            LoadStyleBatch(entries, begin, middle);
+            LoadStyleBatch(entries, middle, end);
+        } else if (g_settings.verboseLogging) {
+            Wh_Log(L"Batched style for %.*s failed with error %08X",
+                   static_cast<int>(entries[begin].type.length()),
+                   entries[begin].type.data(), ex.code());
+        }
+    }
+}
+
+// Parses the styles of all rules of the current thread with a single
+// XamlReader::Load call, instead of one call per rule the first time a
+// matching element is seen. The rules themselves stay unresolved; resolving
+// them later only looks up the cache.
+void ResolveAllStylesInBatch() {
+    std::optional<StyleResolutionTimer> timer;
+    timer.emplace();
+
+    std::vector<StyleBatchEntry> entries;
+    std::unordered_set<std::wstring> cacheKeys;
+
+    auto addEntry = [&](std::wstring_view type, std::wstring setters) {
+        if (setters.empty()) {
+            return;
+        }
+
+        auto cacheKey = StyleCacheKey(type, setters);
+        if (g_parsedStyleCache.contains(cacheKey) ||
+            !cacheKeys.insert(cacheKey).second) {
+            return;
+        }
+
+        entries.push_back({type, std::move(setters), std::move(cacheKey)});
+    };
+
+    auto addMatcherEntry = [&](const ElementMatcher& matcher) {
+        if (const auto* propertyValuesStr =
+                std::get_if<PropertyValuesUnresolved>(
+                    &matcher.propertyValues)) {
+            addEntry(matcher.type,
+                     BuildPropertyValuesXamlSetters(*propertyValuesStr));
+        }
+    };
+
+    for (const auto& rules : g_elementsCustomizationRules) {
+        addMatcherEntry(rules.elementMatcher);
+        for (const auto& matcher : rules.parentElementMatchers) {
+            addMatcherEntry(matcher);
+        }
+
+        const auto* unresolved =
+            std::get_if<UnresolvedRules>(&rules.propertyOverrides);
+        if (!unresolved) {
+            continue;
+        }
+
+        try {
+            std::vector<std::optional<PropertyOverrideValue>>
+                propertyOverrideValues;
+            addEntry(rules.elementMatcher.type,
+                     BuildPropertyOverridesXamlSetters(
+                         *unresolved, &propertyOverrideValues));
+        } catch (...) {
+            // Malformed rule values are reported by
+            // GetResolvedPropertyOverrides when the rule is first used.
+        }
+    }
+
+    if (!entries.empty()) {
+        LoadStyleBatch(entries, 0, entries.size());
+    }
+
+    timer.reset();
+
+    Wh_Log(L"Parsed %zu unique styles in %zu XamlReader loads, %.1f ms",
+           entries.size(), g_styleResolutionStats.xamlLoads,
+           StyleResolutionMilliseconds());
+}
+
 const ResolvedRules& GetResolvedPropertyOverrides(
     const std::wstring_view type,
     const std::wstring_view fallbackType,
@@ -11589,6 +12073,8 @@ const ResolvedRules& GetResolvedPropertyOverrides(
         return *resolved;
     }
 
+    StyleResolutionTimer timer;
+
     ResolvedRules resolved;
 
     try {
@@ -11598,56 +12084,13 @@ const ResolvedRules& GetResolvedPropertyOverrides(
         const auto& captureRules = unresolved.captureRules;
 
         if (!valueRules.empty() || !captureRules.empty()) {
-            // Build a single XAML <Style> with one <Setter> per rule. Setters
-            // for value rules come first, followed by one per capture rule.
-            // Dynamic / capture rules emit a placeholder `{x:Null}` value -- we
-            // only need the resolved DependencyProperty from those setters; the
-            // value is computed elsewhere (per apply for dynamic, never for
-            // captures).
-            std::wstring xaml;
-
             std::vector<std::optional<PropertyOverrideValue>>
                 propertyOverrideValues;
-            propertyOverrideValues.reserve(valueRules.size());
-
-            for (const auto& rule : valueRules) {
-                const bool isDynamic = rule.isDynamic();
-
-                propertyOverrideValues.push_back(
-                    !isDynamic && rule.isXamlValue
-                        ? ParseNonXamlPropertyOverrideValue(rule.value)
-                        : std::nullopt);
-
-                xaml += L"        <Setter Property=\"";
-                xaml += EscapeXmlAttribute(rule.propertyName);
-                xaml += L"\"";
-                if (isDynamic || propertyOverrideValues.back() ||
-                    (rule.isXamlValue && rule.value.empty())) {
-                    xaml += L" Value=\"{x:Null}\" />\n";
-                } else if (!rule.isXamlValue) {
-                    xaml += L" Value=\"";
-                    xaml += EscapeXmlAttribute(rule.value);
-                    xaml += L"\" />\n";
-                } else {
-                    xaml +=
-                        L">\n"
-                        L"            <Setter.Value>\n";
-                    xaml += rule.value;
-                    xaml +=
-                        L"\n"
-                        L"            </Setter.Value>\n"
-                        L"        </Setter>\n";
-                }
-            }
-
-            for (const auto& rule : captureRules) {
-                xaml += L"        <Setter Property=\"";
-                xaml += EscapeXmlAttribute(rule.propertyName);
-                xaml += L"\" Value=\"{x:Null}\" />\n";
-            }
+            std::wstring xaml = BuildPropertyOverridesXamlSetters(
+                unresolved, &propertyOverrideValues);
 
-            auto style = GetStyleFromXamlSettersWithFallbackType(
-                type, fallbackType, xaml);
+            auto style =
+                GetCachedStyleFromXamlSetters(type, fallbackType, xaml);
 
             uint32_t setterIndex = 0;
             for (size_t i = 0; i < valueRules.size(); i++, setterIndex++) {
@@ -11658,7 +12101,8 @@ const ResolvedRules& GetResolvedPropertyOverrides(
                 if (rule.isDynamic()) {
                     resolved.propertyOverrides[property][rule.visualState] =
                         DynamicStyleTemplate{rule.propertyName, rule.value,
-                                             rule.isXamlValue};
+                                             rule.isXamlValue,
+                                             CompileStyleTemplate(rule.value)};
                 } else {
                     resolved.propertyOverrides[property][rule.visualState] =
                         propertyOverrideValues[i].value_or(
@@ -11750,24 +12194,17 @@ const PropertyValues& GetResolvedPropertyValues(
         return *resolved;
     }
 
+    StyleResolutionTimer timer;
+
     PropertyValues propertyValues;
 
     try {
         const auto& propertyValuesStr =
             std::get<PropertyValuesUnresolved>(*propertyValuesMaybeUnresolved);
         if (!propertyValuesStr.empty()) {
-            std::wstring xaml;
-
-            for (const auto& [property, value] : propertyValuesStr) {
-                xaml += L"        <Setter Property=\"";
-                xaml += EscapeXmlAttribute(property);
-                xaml += L"\" Value=\"";
-                xaml += EscapeXmlAttribute(value);
-                xaml += L"\" />\n";
-            }
-
-            auto style = GetStyleFromXamlSettersWithFallbackType(
-                type, fallbackType, xaml);
+            auto style = GetCachedStyleFromXamlSetters(
+                type, fallbackType,
+                BuildPropertyValuesXamlSetters(propertyValuesStr));
 
             for (size_t i = 0; i < propertyValuesStr.size(); i++) {
                 const auto setter = style.Setters().GetAt(i).as<Setter>();
@@ -12037,15 +12474,85 @@ struct ElementResolvedRules {
     std::vector<CaptureSpec> captures;
 };
 
-ElementResolvedRules FindElementPropertyOverrides(FrameworkElement element,
-                                                  PCWSTR fallbackClassName) {
-    ElementResolvedRules result;
-    std::unordered_set<DependencyProperty> propertiesAdded;
-    std::unordered_set<std::wstring> capturesAdded;
+void BuildElementCustomizationRulesIndex() {
+    g_elementsCustomizationRulesIndex.clear();
 
-    for (auto it = g_elementsCustomizationRules.rbegin();
-         it != g_elementsCustomizationRules.rend(); ++it) {
-        auto& override = *it;
+    for (size_t i = 0; i < g_elementsCustomizationRules.size(); i++) {
+        const auto& matcher = g_elementsCustomizationRules[i].elementMatcher;
+        g_elementsCustomizationRulesIndex[matcher.type][matcher.name].push_back(
+            i);
+    }
+}
+
+// Returns the indexes of the rules which can match the element by its type and
+// name, in descending order, i.e. later rules first.
+std::vector<size_t> FindElementCustomizationRulesCandidates(
+    FrameworkElement element,
+    PCWSTR fallbackClassName) {
+    std::vector<size_t> candidates;
+    std::optional<std::wstring> elementName;
+
+    auto addCandidatesForType = [&](const std::wstring& type) {
+        auto typeIt = g_elementsCustomizationRulesIndex.find(type);
+        if (typeIt == g_elementsCustomizationRulesIndex.end()) {
+            return;
+        }
+
+        const auto& rulesByName = typeIt->second;
+        size_t namedBuckets = rulesByName.size();
+
+        if (auto it = rulesByName.find(L""); it != rulesByName.end()) {
+            candidates.insert(candidates.end(), it->second.begin(),
+                              it->second.end());
+            namedBuckets--;
+        }
+
+        if (namedBuckets == 0) {
+            return;
+        }
+
+        if (!elementName) {
+            elementName = element.Name();
+        }
+
+        if (elementName->empty()) {
+            return;
+        }
+
+        if (auto it = rulesByName.find(*elementName); it != rulesByName.end()) {
+            candidates.insert(candidates.end(), it->second.begin(),
+                              it->second.end());
+        }
+    };
+
+    std::wstring className{winrt::get_class_name(element)};
+
+    addCandidatesForType(L"");
+    addCandidatesForType(className);
+    if (fallbackClassName && className != fallbackClassName) {
+        addCandidatesForType(fallbackClassName);
+    }
+
+    std::sort(candidates.begin(), candidates.end(), std::greater<>());
+
+    return candidates;
+}
+
+struct ElementRuleMatch {
+    size_t ruleIndex;
+    VisualStateGroup visualStateGroup;
+};
+
+// Returns the rules which match the element, in descending order, i.e. later
+// rules first, along with the visual state group each rule matched.
+std::vector<ElementRuleMatch> FindElementMatchingRules(
+    FrameworkElement element,
+    PCWSTR fallbackClassName) {
+    std::vector<ElementRuleMatch> matches;
+
+    for (size_t ruleIndex :
+         FindElementCustomizationRulesCandidates(element, fallbackClassName)) {
+        auto& override = g_elementsCustomizationRules[ruleIndex];
 
         VisualStateGroup visualStateGroup = nullptr;
 
@@ -12117,6 +12624,22 @@ ElementResolvedRules FindElementPropertyOverrides(FrameworkElement element,
             continue;
         }
 
+        matches.push_back({ruleIndex, visualStateGroup});
+    }
+
+    return matches;
+}
+
+ElementResolvedRules FindElementPropertyOverrides(
+    PCWSTR fallbackClassName,
+    const std::vector<ElementRuleMatch>& matches) {
+    ElementResolvedRules result;
+    std::unordered_set<DependencyProperty> propertiesAdded;
+    std::unordered_set<std::wstring> capturesAdded;
+
+    for (const auto& [ruleIndex, visualStateGroup] : matches) {
+        auto& override = g_elementsCustomizationRules[ruleIndex];
+
         const auto& resolvedRules = GetResolvedPropertyOverrides(
             override.elementMatcher.type,
             fallbackClassName ? fallbackClassName
@@ -12191,52 +12714,108 @@ struct StyleExpressionValue {
     bool IsNumber() const { return number.has_value(); }
 };
 
-// Recursive-descent evaluator for `{{ ... }}` expressions. Operands: number
+// A `{{ ... }}` expression parsed once into a flat tree (children are indexes
+// into `nodes`), so that it can be evaluated repeatedly without re-parsing.
+struct CompiledStyleExpression {
+    enum class Op : uint8_t {
+        Number,    // number
+        String,    // text
+        Variable,  // text = variable name
+        Plus,      // +a
+        Negate,    // -a
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        Equal,
+        NotEqual,
+        Conditional,  // a ? b : c
+        Min,
+        Max,
+        UnknownCall,  // text = function name, fails after evaluating a, b
+    };
+
+    struct Node {
+        Op op;
+        uint32_t a = 0;
+        uint32_t b = 0;
+        uint32_t c = 0;
+        double number = 0.0;
+        std::wstring text;
+    };
+
+    std::wstring source;  // trimmed expression text, for diagnostics
+    // A bare identifier is substituted verbatim (see
+    // EvaluateCompiledStyleExpression) and has no nodes.
+    bool bareIdentifier = false;
+    std::vector<Node> nodes;
+    uint32_t root = 0;
+};
+
+// A dynamic style value with all of its `{{ ... }}` substitutions compiled:
+// literals[0] expressions[0] literals[1] ... expressions[n-1] literals[n].
+// `dependencies` lists every variable referenced anywhere in the template,
+// including in conditional branches that a given evaluation doesn't take, so
+// consumers can register once instead of after every evaluation.
+struct CompiledStyleTemplate {
+    std::vector<std::wstring> literals;
+    std::vector<CompiledStyleExpression> expressions;
+    std::vector<std::wstring> dependencies;
+};
+
+// Adds `name` to the dependency list, unless it's already there.
+void AddStyleVariableDependency(std::vector<std::wstring>* outDeps,
+                                const std::wstring& name) {
+    if (outDeps && std::find(outDeps->begin(), outDeps->end(), name) ==
+                       outDeps->end()) {
+        outDeps->push_back(name);
+    }
+}
+
+// Recursive-descent parser for `{{ ... }}` expressions. Operands: number
 // literals, backtick-delimited string literals, style variable references, and
 // parenthesized subexpressions. Operators: binary + - * /, unary - / +, the
 // comparisons < <= == >= > !=, the conditional operator cond ? a : b, and the
 // two-arg functions min(a, b) and max(a, b). Standard math precedence.
-// Arithmetic, relational, unary-sign, and min/max operators require numeric
-// operands; == and != compare two numbers or two strings; the conditional
-// selects one of its (possibly string) branches. Evaluate() formats the result
-// to text.
 //
-// Variable references pushed into outDeps so the dependent style can be
-// re-evaluated when those variables change.
-class StyleVariableExpressionEvaluator {
+// Produces nodes rather than values; CompiledStyleExpressionEvaluator gives
+// them their meaning. Every variable reference is added to outDeps (once), so
+// the dependent style can be re-evaluated when those variables change. Throws
+// std::runtime_error on syntax errors.
+class StyleVariableExpressionCompiler {
    public:
-    StyleVariableExpressionEvaluator(std::wstring_view text,
-                                     std::vector<std::wstring>* outDeps,
-                                     StyleVariableState* state)
-        : m_text(text), m_outDeps(outDeps), m_state(state) {}
+    using Op = CompiledStyleExpression::Op;
 
-    // Returns the text form of the result: numeric results are formatted with
-    // FormatDoubleInvariant, string results are returned verbatim. Throws
-    // std::runtime_error on parse / evaluation failure (including when a value
-    // is used where the grammar requires a number, or when a numeric result is
-    // non-finite -- NaN/Inf can't be formatted into XAML attributes
-    // meaningfully and would also break the consumer-equality check in
-    // SetStyleVariableIfChangedAndPropagate, since NaN != NaN).
-    std::wstring Evaluate() {
+    StyleVariableExpressionCompiler(std::wstring_view text,
+                                    CompiledStyleExpression* out,
+                                    std::vector<std::wstring>* outDeps)
+        : m_text(text), m_out(out), m_outDeps(outDeps) {}
+
+    void Compile() {
         m_pos = 0;
         SkipWhitespace();
-        StyleExpressionValue v = ParseExpression();
+        m_out->root = ParseExpression();
         SkipWhitespace();
         if (m_pos != m_text.size()) {
             throw std::runtime_error(
                 "Unexpected trailing characters in style variable expression");
         }
-        if (v.IsNumber()) {
-            if (!std::isfinite(*v.number)) {
-                throw std::runtime_error(
-                    "Style variable expression produced a non-finite result");
-            }
-            return FormatDoubleInvariant(*v.number);
-        }
-        return v.text;
     }
 
    private:
+    uint32_t AddNode(CompiledStyleExpression::Node node) {
+        m_out->nodes.push_back(std::move(node));
+        return static_cast<uint32_t>(m_out->nodes.size() - 1);
+    }
+
+    uint32_t AddBinary(Op op, uint32_t a, uint32_t b) {
+        return AddNode({.op = op, .a = a, .b = b});
+    }
+
     void SkipWhitespace() {
         while (m_pos < m_text.size() &&
                (m_text[m_pos] == L' ' || m_text[m_pos] == L'\t' ||
@@ -12267,78 +12846,31 @@ class StyleVariableExpressionEvaluator {
         return false;
     }
 
-    // Unwraps a numeric operand. In a dead ternary branch (m_live == false) the
-    // value is discarded, so a string operand is tolerated (reported as 0)
-    // rather than aborting the whole expression.
-    double RequireNumber(const StyleExpressionValue& v) {
-        if (v.IsNumber()) {
-            return *v.number;
-        }
-        if (m_live) {
-            throw std::runtime_error(
-                "Non-numeric value used where a number is required in style "
-                "variable expression");
-        }
-        return 0.0;
-    }
-
-    // Equality test for == / !=. Two numbers compare numerically, two strings
-    // compare by content. A number/string mismatch is always unequal rather
-    // than an error, so `{{var == `` ? default : var}}` can supply a fallback
-    // for an undefined variable (which reads as the empty string) without
-    // failing when the variable is instead a captured number.
-    bool ValuesEqual(const StyleExpressionValue& a,
-                     const StyleExpressionValue& b) {
-        if (a.IsNumber() && b.IsNumber()) {
-            return *a.number == *b.number;
-        }
-        if (!a.IsNumber() && !b.IsNumber()) {
-            return a.text == b.text;
-        }
-        return false;
-    }
-
-    StyleExpressionValue ParseExpression() { return ParseTernary(); }
+    uint32_t ParseExpression() { return ParseTernary(); }
 
     // Conditional operator `cond ? thenVal : elseVal`, right-associative.
-    // Short-circuit: only the taken branch is evaluated. The untaken branch is
-    // still parsed (to advance the position and enforce syntax) with m_live
-    // cleared, which suppresses value-level errors (division by zero, a
-    // non-numeric / undefined variable, an unknown function) and dependency
-    // capture for that branch.
-    StyleExpressionValue ParseTernary() {
-        StyleExpressionValue cond = ParseEquality();
+    uint32_t ParseTernary() {
+        uint32_t cond = ParseEquality();
         if (!ConsumeChar(L'?')) {
             return cond;
         }
-        bool condTrue = RequireNumber(cond) != 0.0;
-        bool prevLive = m_live;
-
-        m_live = prevLive && condTrue;
-        StyleExpressionValue thenVal = ParseExpression();
-        m_live = prevLive;
-
+        uint32_t thenVal = ParseExpression();
         if (!ConsumeChar(L':')) {
             throw std::runtime_error(
                 "Missing ':' for '?' in style variable expression");
         }
-
-        m_live = prevLive && !condTrue;
-        StyleExpressionValue elseVal = ParseTernary();
-        m_live = prevLive;
-
-        return condTrue ? thenVal : elseVal;
+        uint32_t elseVal = ParseTernary();
+        return AddNode(
+            {.op = Op::Conditional, .a = cond, .b = thenVal, .c = elseVal});
     }
 
-    StyleExpressionValue ParseEquality() {
-        StyleExpressionValue v = ParseRelational();
+    uint32_t ParseEquality() {
+        uint32_t v = ParseRelational();
         while (true) {
             if (ConsumeOperator(L"==")) {
-                v = StyleExpressionValue::Number(
-                    ValuesEqual(v, ParseRelational()) ? 1.0 : 0.0);
+                v = AddBinary(Op::Equal, v, ParseRelational());
             } else if (ConsumeOperator(L"!=")) {
-                v = StyleExpressionValue::Number(
-                    ValuesEqual(v, ParseRelational()) ? 0.0 : 1.0);
+                v = AddBinary(Op::NotEqual, v, ParseRelational());
             } else {
                 break;
             }
@@ -12346,26 +12878,18 @@ class StyleVariableExpressionEvaluator {
         return v;
     }
 
-    StyleExpressionValue ParseRelational() {
-        StyleExpressionValue v = ParseAdditive();
+    uint32_t ParseRelational() {
+        uint32_t v = ParseAdditive();
         while (true) {
             // Match the two-char operators before their single-char prefixes.
             if (ConsumeOperator(L"<=")) {
-                double lhs = RequireNumber(v);
-                v = StyleExpressionValue::Number(
-                    lhs <= RequireNumber(ParseAdditive()) ? 1.0 : 0.0);
+                v = AddBinary(Op::LessEqual, v, ParseAdditive());
             } else if (ConsumeOperator(L">=")) {
-                double lhs = RequireNumber(v);
-                v = StyleExpressionValue::Number(
-                    lhs >= RequireNumber(ParseAdditive()) ? 1.0 : 0.0);
+                v = AddBinary(Op::GreaterEqual, v, ParseAdditive());
             } else if (ConsumeOperator(L"<")) {
-                double lhs = RequireNumber(v);
-                v = StyleExpressionValue::Number(
-                    lhs < RequireNumber(ParseAdditive()) ? 1.0 : 0.0);
+                v = AddBinary(Op::Less, v, ParseAdditive());
             } else if (ConsumeOperator(L">")) {
-                double lhs = RequireNumber(v);
-                v = StyleExpressionValue::Number(
-                    lhs > RequireNumber(ParseAdditive()) ? 1.0 : 0.0);
+                v = AddBinary(Op::Greater, v, ParseAdditive());
             } else {
                 break;
             }
@@ -12373,18 +12897,13 @@ class StyleVariableExpressionEvaluator {
         return v;
     }
 
-    StyleExpressionValue ParseAdditive() {
-        StyleExpressionValue v = ParseTerm();
+    uint32_t ParseAdditive() {
+        uint32_t v = ParseTerm();
         while (true) {
-            SkipWhitespace();
             if (ConsumeChar(L'+')) {
-                double lhs = RequireNumber(v);
-                v = StyleExpressionValue::Number(lhs +
-                                                 RequireNumber(ParseTerm()));
+                v = AddBinary(Op::Add, v, ParseTerm());
             } else if (ConsumeChar(L'-')) {
-                double lhs = RequireNumber(v);
-                v = StyleExpressionValue::Number(lhs -
-                                                 RequireNumber(ParseTerm()));
+                v = AddBinary(Op::Subtract, v, ParseTerm());
             } else {
                 break;
             }
@@ -12392,28 +12911,13 @@ class StyleVariableExpressionEvaluator {
         return v;
     }
 
-    StyleExpressionValue ParseTerm() {
-        StyleExpressionValue v = ParseFactor();
+    uint32_t ParseTerm() {
+        uint32_t v = ParseFactor();
         while (true) {
-            SkipWhitespace();
             if (ConsumeChar(L'*')) {
-                double lhs = RequireNumber(v);
-                v = StyleExpressionValue::Number(lhs *
-                                                 RequireNumber(ParseFactor()));
+                v = AddBinary(Op::Multiply, v, ParseFactor());
             } else if (ConsumeChar(L'/')) {
-                double lhs = RequireNumber(v);
-                double rhs = RequireNumber(ParseFactor());
-                if (rhs == 0.0) {
-                    if (m_live) {
-                        throw std::runtime_error(
-                            "Division by zero in style variable expression");
-                    }
-                    // Dead ternary branch: the result is discarded, so skip the
-                    // divide instead of throwing or producing inf/nan.
-                    v = StyleExpressionValue::Number(lhs);
-                } else {
-                    v = StyleExpressionValue::Number(lhs / rhs);
-                }
+                v = AddBinary(Op::Divide, v, ParseFactor());
             } else {
                 break;
             }
@@ -12421,18 +12925,17 @@ class StyleVariableExpressionEvaluator {
         return v;
     }
 
-    StyleExpressionValue ParseFactor() {
-        SkipWhitespace();
+    uint32_t ParseFactor() {
         if (ConsumeChar(L'+')) {
-            return StyleExpressionValue::Number(RequireNumber(ParseFactor()));
+            return AddNode({.op = Op::Plus, .a = ParseFactor()});
         }
         if (ConsumeChar(L'-')) {
-            return StyleExpressionValue::Number(-RequireNumber(ParseFactor()));
+            return AddNode({.op = Op::Negate, .a = ParseFactor()});
         }
         return ParsePrimary();
     }
 
-    StyleExpressionValue ParsePrimary() {
+    uint32_t ParsePrimary() {
         SkipWhitespace();
         if (m_pos >= m_text.size()) {
             throw std::runtime_error(
@@ -12442,8 +12945,7 @@ class StyleVariableExpressionEvaluator {
         wchar_t c = m_text[m_pos];
         if (c == L'(') {
             m_pos++;
-            StyleExpressionValue v = ParseExpression();
-            SkipWhitespace();
+            uint32_t v = ParseExpression();
             if (!ConsumeChar(L')')) {
                 throw std::runtime_error(
                     "Missing ')' in style variable expression");
@@ -12456,7 +12958,7 @@ class StyleVariableExpressionEvaluator {
         }
 
         if ((c >= L'0' && c <= L'9') || c == L'.') {
-            return StyleExpressionValue::Number(ParseNumberLiteral());
+            return ParseNumberLiteral();
         }
 
         if ((c >= L'A' && c <= L'Z') || (c >= L'a' && c <= L'z') || c == L'_') {
@@ -12473,7 +12975,7 @@ class StyleVariableExpressionEvaluator {
     // quoting of YAML settings or with the double quotes of XAML attributes,
     // inside which these expressions often appear. The literal must be closed
     // before the end of the expression.
-    StyleExpressionValue ParseStringLiteral() {
+    uint32_t ParseStringLiteral() {
         m_pos++;  // Skip the opening backtick.
         std::wstring out;
         while (m_pos < m_text.size()) {
@@ -12485,7 +12987,7 @@ class StyleVariableExpressionEvaluator {
                     continue;
                 }
                 m_pos++;
-                return StyleExpressionValue::String(std::move(out));
+                return AddNode({.op = Op::String, .text = std::move(out)});
             }
             out.push_back(c);
             m_pos++;
@@ -12494,7 +12996,7 @@ class StyleVariableExpressionEvaluator {
             "Unterminated string literal in style variable expression");
     }
 
-    double ParseNumberLiteral() {
+    uint32_t ParseNumberLiteral() {
         size_t start = m_pos;
         bool sawDigit = false;
         bool sawDot = false;
@@ -12531,10 +13033,10 @@ class StyleVariableExpressionEvaluator {
             throw std::runtime_error(
                 "Bad number literal in style variable expression");
         }
-        return *parsed;
+        return AddNode({.op = Op::Number, .number = *parsed});
     }
 
-    StyleExpressionValue ParseIdentifierOrCall() {
+    uint32_t ParseIdentifierOrCall() {
         size_t start = m_pos;
         while (m_pos < m_text.size()) {
             wchar_t c = m_text[m_pos];
@@ -12545,51 +13047,183 @@ class StyleVariableExpressionEvaluator {
                 break;
             }
         }
-        std::wstring_view ident = m_text.substr(start, m_pos - start);
+        std::wstring ident(m_text.substr(start, m_pos - start));
         SkipWhitespace();
         if (m_pos < m_text.size() && m_text[m_pos] == L'(') {
             m_pos++;
-            double a = RequireNumber(ParseExpression());
+            uint32_t a = ParseExpression();
             if (!ConsumeChar(L',')) {
                 throw std::runtime_error(
                     "Expected ',' in min/max style variable call");
             }
-            double b = RequireNumber(ParseExpression());
+            uint32_t b = ParseExpression();
             if (!ConsumeChar(L')')) {
                 throw std::runtime_error(
                     "Missing ')' after min/max style variable call");
             }
-            if (ident == L"min") {
-                return StyleExpressionValue::Number((a < b) ? a : b);
-            }
-            if (ident == L"max") {
-                return StyleExpressionValue::Number((a > b) ? a : b);
+            Op op = ident == L"min"   ? Op::Min
+                    : ident == L"max" ? Op::Max
+                                      : Op::UnknownCall;
+            return AddNode(
+                {.op = op, .a = a, .b = b, .text = std::move(ident)});
+        }
+        AddStyleVariableDependency(m_outDeps, ident);
+        return AddNode({.op = Op::Variable, .text = std::move(ident)});
+    }
+
+    std::wstring_view m_text;
+    CompiledStyleExpression* m_out;
+    std::vector<std::wstring>* m_outDeps;
+    size_t m_pos = 0;
+};
+
+// Compiles a single, already trimmed, non-empty expression body (the text
+// between `{{` and `}}`). A bare identifier is only recorded as such; anything
+// else goes through StyleVariableExpressionCompiler, which throws
+// std::runtime_error on syntax errors.
+CompiledStyleExpression CompileStyleExpression(
+    std::wstring_view trimmed,
+    std::vector<std::wstring>* outDeps) {
+    CompiledStyleExpression expr;
+    expr.source = trimmed;
+    if (IsValidStyleVariableIdentifier(trimmed)) {
+        expr.bareIdentifier = true;
+        AddStyleVariableDependency(outDeps, expr.source);
+    } else {
+        StyleVariableExpressionCompiler(trimmed, &expr, outDeps).Compile();
+    }
+    return expr;
+}
+
+// Evaluates a compiled expression against the current variables.
+// Arithmetic, relational, unary-sign, and min/max operators require numeric
+// operands; == and != compare two numbers or two strings; the conditional
+// selects one of its (possibly string) branches. Only the taken branch of a
+// conditional is evaluated, so value-level errors in the other one (division
+// by zero, a non-numeric / undefined variable, an unknown function) don't
+// abort the expression. Evaluate() formats the result to text.
+class CompiledStyleExpressionEvaluator {
+   public:
+    using Op = CompiledStyleExpression::Op;
+
+    CompiledStyleExpressionEvaluator(
+        const CompiledStyleExpression& expr,
+        const std::unordered_map<std::wstring, StyleVariableValue>& variables)
+        : m_expr(expr), m_variables(variables) {}
+
+    // Returns the text form of the result: numeric results are formatted with
+    // FormatDoubleInvariant, string results are returned verbatim. Throws
+    // std::runtime_error on evaluation failure (including when a value is used
+    // where the grammar requires a number, or when a numeric result is
+    // non-finite -- NaN/Inf can't be formatted into XAML attributes
+    // meaningfully and would also break the consumer-equality check in
+    // SetStyleVariableIfChangedAndPropagate, since NaN != NaN).
+    std::wstring Evaluate() {
+        StyleExpressionValue v = Eval(m_expr.root);
+        if (v.IsNumber()) {
+            if (!std::isfinite(*v.number)) {
+                throw std::runtime_error(
+                    "Style variable expression produced a non-finite result");
             }
-            if (m_live) {
+            return FormatDoubleInvariant(*v.number);
+        }
+        return v.text;
+    }
+
+   private:
+    static double RequireNumber(const StyleExpressionValue& v) {
+        if (!v.IsNumber()) {
+            throw std::runtime_error(
+                "Non-numeric value used where a number is required in style "
+                "variable expression");
+        }
+        return *v.number;
+    }
+
+    // Equality test for == / !=. Two numbers compare numerically, two strings
+    // compare by content. A number/string mismatch is always unequal rather
+    // than an error, so `{{var == `` ? default : var}}` can supply a fallback
+    // for an undefined variable (which reads as the empty string) without
+    // failing when the variable is instead a captured number.
+    static bool ValuesEqual(const StyleExpressionValue& a,
+                            const StyleExpressionValue& b) {
+        if (a.IsNumber() && b.IsNumber()) {
+            return *a.number == *b.number;
+        }
+        if (!a.IsNumber() && !b.IsNumber()) {
+            return a.text == b.text;
+        }
+        return false;
+    }
+
+    static StyleExpressionValue Bool(bool b) {
+        return StyleExpressionValue::Number(b ? 1.0 : 0.0);
+    }
+
+    StyleExpressionValue Eval(uint32_t index) {
+        const auto& node = m_expr.nodes[index];
+        switch (node.op) {
+            case Op::Number:
+                return StyleExpressionValue::Number(node.number);
+            case Op::String:
+                return StyleExpressionValue::String(node.text);
+            case Op::Variable:
+                return LookupVariable(node.text);
+            case Op::Plus:
+                return StyleExpressionValue::Number(RequireNumber(Eval(node.a)));
+            case Op::Negate:
+                return StyleExpressionValue::Number(
+                    -RequireNumber(Eval(node.a)));
+            case Op::Equal:
+                return Bool(ValuesEqual(Eval(node.a), Eval(node.b)));
+            case Op::NotEqual:
+                return Bool(!ValuesEqual(Eval(node.a), Eval(node.b)));
+            case Op::Conditional:
+                return Eval(RequireNumber(Eval(node.a)) != 0.0 ? node.b
+                                                               : node.c);
+            default:
+                break;
+        }
+
+        double lhs = RequireNumber(Eval(node.a));
+        double rhs = RequireNumber(Eval(node.b));
+        switch (node.op) {
+            case Op::Add:
+                return StyleExpressionValue::Number(lhs + rhs);
+            case Op::Subtract:
+                return StyleExpressionValue::Number(lhs - rhs);
+            case Op::Multiply:
+                return StyleExpressionValue::Number(lhs * rhs);
+            case Op::Divide:
+                if (rhs == 0.0) {
+                    throw std::runtime_error(
+                        "Division by zero in style variable expression");
+                }
+                return StyleExpressionValue::Number(lhs / rhs);
+            case Op::Less:
+                return Bool(lhs < rhs);
+            case Op::LessEqual:
+                return Bool(lhs <= rhs);
+            case Op::Greater:
+                return Bool(lhs > rhs);
+            case Op::GreaterEqual:
+                return Bool(lhs >= rhs);
+            case Op::Min:
+                return StyleExpressionValue::Number((lhs < rhs) ? lhs : rhs);
+            case Op::Max:
+                return StyleExpressionValue::Number((lhs > rhs) ? lhs : rhs);
+            default:
                 throw std::runtime_error(
                     "Unknown function in style variable expression");
-            }
-            // Dead ternary branch: value discarded, don't fail on the name.
-            return StyleExpressionValue::Number(0.0);
         }
-        return LookupVariable(std::wstring(ident));
     }
 
     StyleExpressionValue LookupVariable(const std::wstring& name) {
-        // In a dead ternary branch (m_live == false) the value is discarded, so
-        // suppress dependency capture and the value-level errors below; the
-        // branch must not abort the whole expression.
-        if (m_live && m_outDeps) {
-            m_outDeps->push_back(name);
-        }
-        auto it = m_state->variables.find(name);
-        if (it == m_state->variables.end()) {
-            if (m_live) {
-                Wh_Log(
-                    L"Style variable '%s' not defined; treating as empty "
-                    L"string",
-                    name.c_str());
-            }
+        auto it = m_variables.find(name);
+        if (it == m_variables.end()) {
+            Wh_Log(
+                L"Style variable '%s' not defined; treating as empty string",
+                name.c_str());
             // Undefined reads as the empty string sentinel, so `{{var == `` ?
             // default : var}}` can detect the undefined state and substitute a
             // fallback. Arithmetic on an undefined variable then fails
@@ -12606,69 +13240,74 @@ class StyleVariableExpressionEvaluator {
         }
         // Opaque capture (brush, thickness, etc.): no value form usable in an
         // expression.
-        if (m_live) {
-            throw std::runtime_error(
-                "Style variable used in expression is not a primitive value");
-        }
-        return StyleExpressionValue::Number(0.0);
+        throw std::runtime_error(
+            "Style variable used in expression is not a primitive value");
     }
 
-    std::wstring_view m_text;
-    std::vector<std::wstring>* m_outDeps;
-    StyleVariableState* m_state;
-    size_t m_pos = 0;
-    // When false, we're parsing (but discarding) the untaken branch of a
-    // ternary; value-level errors and dependency capture are suppressed.
-    bool m_live = true;
+    const CompiledStyleExpression& m_expr;
+    const std::unordered_map<std::wstring, StyleVariableValue>& m_variables;
 };
 
-// Evaluate a single expression body (the text between `{{` and `}}`). If the
-// body is a bare identifier, returns the variable's `stringForm` directly --
-// but only when the captured value is a primitive type flagged `substitutable`
-// (numeric, boolean, or string). Missing variables and opaque-type captures
-// both cause this function to return std::nullopt, at which point
-// ExpandStyleVariables aborts the whole expansion and the consuming style is
-// skipped. This matches the arithmetic path's behaviour of failing closed
-// rather than substituting a value that won't parse.
-std::optional<std::wstring> EvaluateStyleVariableExpression(
-    std::wstring_view exprText,
-    std::vector<std::wstring>* outDeps,
-    StyleVariableState* state) {
-    auto trimmed = TrimStringView(exprText);
-    if (trimmed.empty()) {
-        Wh_Log(L"Empty style variable expression");
-        return std::nullopt;
-    }
-
-    if (IsValidStyleVariableIdentifier(trimmed)) {
-        std::wstring name(trimmed);
-        if (outDeps) {
-            outDeps->push_back(name);
-        }
-        auto it = state->variables.find(name);
-        if (it == state->variables.end()) {
+// Evaluates a compiled expression body. If the body is a bare identifier,
+// returns the variable's `stringForm` directly -- but only when the captured
+// value is a primitive type flagged `substitutable` (numeric, boolean, or
+// string). Missing variables and opaque-type captures both cause this function
+// to return std::nullopt, at which point the template expansion is aborted and
+// the consuming style is skipped. This matches the arithmetic path's behaviour
+// of failing closed rather than substituting a value that won't parse.
+std::optional<std::wstring> EvaluateCompiledStyleExpression(
+    const CompiledStyleExpression& expr,
+    const std::unordered_map<std::wstring, StyleVariableValue>& variables) {
+    if (expr.bareIdentifier) {
+        auto it = variables.find(expr.source);
+        if (it == variables.end()) {
             Wh_Log(L"Style variable '%s' not yet defined; skipping style",
-                   name.c_str());
+                   expr.source.c_str());
             return std::nullopt;
         }
         if (!it->second.substitutable) {
             Wh_Log(
                 L"Style variable '%s' is not substitutable (captured type "
                 L"'%s'); skipping style",
-                name.c_str(), it->second.stringForm.c_str());
+                expr.source.c_str(), it->second.stringForm.c_str());
             return std::nullopt;
         }
         return it->second.stringForm;
     }
 
     try {
-        StyleVariableExpressionEvaluator eval(trimmed, outDeps, state);
-        return eval.Evaluate();
+        return CompiledStyleExpressionEvaluator(expr, variables).Evaluate();
+    } catch (std::exception const& ex) {
+        Wh_Log(L"Style variable expression failed: %S (in '%s')", ex.what(),
+               expr.source.c_str());
+        return std::nullopt;
+    }
+}
+
+// Evaluate a single expression body (the text between `{{` and `}}`) by
+// compiling it and evaluating the result once. Every variable the expression
+// references is added to outDeps, including in conditional branches that this
+// evaluation doesn't take.
+std::optional<std::wstring> EvaluateStyleVariableExpression(
+    std::wstring_view exprText,
+    std::vector<std::wstring>* outDeps,
+    StyleVariableState* state) {
+    auto trimmed = TrimStringView(exprText);
+    if (trimmed.empty()) {
+        Wh_Log(L"Empty style variable expression");
+        return std::nullopt;
+    }
+
+    CompiledStyleExpression expr;
+    try {
+        expr = CompileStyleExpression(trimmed, outDeps);
     } catch (std::exception const& ex) {
         Wh_Log(L"Style variable expression failed: %S (in '%.*s')", ex.what(),
                static_cast<int>(trimmed.size()), trimmed.data());
         return std::nullopt;
     }
+
+    return EvaluateCompiledStyleExpression(expr, state->variables);
 }
 
 // Walks the input text, repeatedly expanding the innermost `{{ ... }}`
@@ -12679,6 +13318,9 @@ std::optional<std::wstring> EvaluateStyleVariableExpression(
 //
 // Substituted text is treated as literal (no further `{{...}}` expansion of the
 // substituted output) to keep behavior predictable.
+//
+// Dynamic styles normally go through ExpandCompiledStyleTemplate; this is the
+// fallback for templates which CompileStyleTemplate can't compile.
 std::optional<std::wstring> ExpandStyleVariables(
     std::wstring_view input,
     std::vector<std::wstring>* outDeps,
@@ -12734,6 +13376,104 @@ std::optional<std::wstring> ExpandStyleVariables(
     return result;
 }
 
+// Compiles a dynamic style value. The `{{`/`}}` pairing is decided by
+// replaying ExpandStyleVariables on the source text with every substitution
+// replaced by an opaque placeholder cell. Returns nullptr when the result
+// can't be decided statically -- a `}}` whose opening `{{` would have to be
+// searched for inside substituted text, an unmatched `}}`, or an expression
+// with a syntax error -- in which case the caller keeps using
+// ExpandStyleVariables, which also reports the error.
+std::shared_ptr<const CompiledStyleTemplate> CompileStyleTemplate(
+    std::wstring_view input) {
+    auto compiled = std::make_shared<CompiledStyleTemplate>();
+
+    std::wstring text(input);
+    // -1 for source characters, otherwise the index of the expression whose
+    // result takes this cell.
+    std::vector<int> cells(text.size(), -1);
+    size_t scanFrom = 0;
+
+    while (true) {
+        size_t closePos = std::wstring::npos;
+        for (size_t i = scanFrom; i + 1 < text.size(); i++) {
+            if (text[i] == L'}' && text[i + 1] == L'}') {
+                closePos = i;
+                break;
+            }
+        }
+        if (closePos == std::wstring::npos) {
+            break;
+        }
+
+        size_t openPos = std::wstring::npos;
+        for (size_t j = closePos - 1; closePos >= 2 && j >= 1; j--) {
+            if (cells[j - 1] != -1 || cells[j] != -1) {
+                return nullptr;
+            }
+            if (text[j - 1] == L'{' && text[j] == L'{') {
+                openPos = j - 1;
+                break;
+            }
+        }
+        if (openPos == std::wstring::npos) {
+            return nullptr;
+        }
+
+        auto trimmed = TrimStringView(std::wstring_view(text).substr(
+            openPos + 2, closePos - openPos - 2));
+        if (trimmed.empty()) {
+            return nullptr;
+        }
+
+        CompiledStyleExpression expr;
+        try {
+            expr = CompileStyleExpression(trimmed, &compiled->dependencies);
+        } catch (std::exception const&) {
+            return nullptr;
+        }
+
+        int exprIndex = static_cast<int>(compiled->expressions.size());
+        compiled->expressions.push_back(std::move(expr));
+
+        size_t spanLen = closePos + 2 - openPos;
+        text.replace(openPos, spanLen, 1, L'\0');
+        cells.erase(cells.begin() + openPos + 1,
+                    cells.begin() + openPos + spanLen);
+        cells[openPos] = exprIndex;
+        scanFrom = openPos + 1;
+    }
+
+    // Expressions were created left to right, so the placeholders appear in
+    // index order.
+    compiled->literals.emplace_back();
+    for (size_t i = 0; i < text.size(); i++) {
+        if (cells[i] == -1) {
+            compiled->literals.back().push_back(text[i]);
+        } else {
+            compiled->literals.emplace_back();
+        }
+    }
+
+    return compiled;
+}
+
+// Compiled counterpart of ExpandStyleVariables.
+std::optional<std::wstring> ExpandCompiledStyleTemplate(
+    const CompiledStyleTemplate& compiled,
+    const std::unordered_map<std::wstring, StyleVariableValue>& variables) {
+    std::wstring result = compiled.literals[0];
+    for (size_t i = 0; i < compiled.expressions.size(); i++) {
+        auto expanded =
+            EvaluateCompiledStyleExpression(compiled.expressions[i], variables);
+        if (!expanded) {
+            return std::nullopt;
+        }
+        result += *expanded;
+        result += compiled.literals[i + 1];
+    }
+    return result;
+}
+
 // Read a property's current effective value and convert it to a
 // StyleVariableValue suitable for `{{Var}}` substitution. Numeric primitives
 // produce both string + numeric forms and are flagged substitutable; boolean
@@ -12849,33 +13589,60 @@ void UpdateStyleVariableConsumers(StyleVariableState* state,
 // StyleVariableConsumer entry so subsequent propagations route through this
 // same context.
 //
-// Returns std::nullopt if the state has no template, expansion failed, or XAML
-// resolution failed.
+// Compiled templates register their full static dependency list, which
+// doesn't change between evaluations, so the registry is only touched on the
+// first resolution.
+//
+// With `skipIfUnchanged`, returns std::nullopt without re-parsing when the
+// expansion equals the one the current `customValue` was resolved from.
+//
+// Returns std::nullopt if the state has no template, expansion failed, XAML
+// resolution failed, or the value was skipped as unchanged.
 std::optional<PropertyOverrideValue> ResolveDynamicStyleValue(
     StyleVariableState* state,
     InstanceHandle handle,
     FrameworkElement element,
     DependencyProperty property,
     PCWSTR fallbackClassName,
-    ElementPropertyCustomizationState* propertyCustomizationState) {
+    ElementPropertyCustomizationState* propertyCustomizationState,
+    bool skipIfUnchanged = false) {
     if (!propertyCustomizationState->dynamicTemplate) {
         return std::nullopt;
     }
 
     const auto& tmpl = *propertyCustomizationState->dynamicTemplate;
 
-    std::vector<std::wstring> newDeps;
-    auto expanded = ExpandStyleVariables(tmpl.rawValue, &newDeps, state);
+    std::optional<std::wstring> expanded;
+    if (tmpl.compiled) {
+        expanded = ExpandCompiledStyleTemplate(*tmpl.compiled, state->variables);
+        if (propertyCustomizationState->variableDependencies !=
+            tmpl.compiled->dependencies) {
+            UpdateStyleVariableConsumers(
+                state, handle, property, fallbackClassName,
+                propertyCustomizationState->variableDependencies,
+                tmpl.compiled->dependencies);
+            propertyCustomizationState->variableDependencies =
+                tmpl.compiled->dependencies;
+        }
+    } else {
+        std::vector<std::wstring> newDeps;
+        expanded = ExpandStyleVariables(tmpl.rawValue, &newDeps, state);
 
-    UpdateStyleVariableConsumers(
-        state, handle, property, fallbackClassName,
-        propertyCustomizationState->variableDependencies, newDeps);
-    propertyCustomizationState->variableDependencies = std::move(newDeps);
+        UpdateStyleVariableConsumers(
+            state, handle, property, fallbackClassName,
+            propertyCustomizationState->variableDependencies, newDeps);
+        propertyCustomizationState->variableDependencies = std::move(newDeps);
+    }
 
     if (!expanded) {
         return std::nullopt;
     }
 
+    if (skipIfUnchanged && propertyCustomizationState->customValue &&
+        propertyCustomizationState->lastExpandedValue == *expanded) {
+        return std::nullopt;
+    }
+
     auto typeName = winrt::get_class_name(element);
     auto resolved = ResolveExpandedSinglePropertyValue(
         std::wstring_view(typeName),
@@ -12887,24 +13654,46 @@ std::optional<PropertyOverrideValue> ResolveDynamicStyleValue(
             L"Dynamic style resolution failed for '%s' on %s; keeping "
             L"previously applied value",
             tmpl.propertyName.c_str(), typeName.c_str());
+        propertyCustomizationState->lastExpandedValue.reset();
+    } else {
+        propertyCustomizationState->lastExpandedValue = std::move(*expanded);
     }
     return resolved;
 }
 
-// Re-evaluate every dependent style for the named variable. Driven by capture
+// Re-evaluate every dependent style for the named variables. Driven by capture
 // callbacks when the source property changes, and by the initial capture when a
 // target is first matched. Each consumer carries its own fallbackClassName
 // (recorded when the consumer was registered), so propagation correctly uses
 // the consumer's own match-site context to re-parse the rule body, even when
 // the capturer was matched against a different type/fallback class.
-void PropagateStyleVariableChange(StyleVariableState* state,
-                                  const std::wstring& varName) {
-    auto consumersIt = state->consumers.find(varName);
-    if (consumersIt == state->consumers.end()) {
-        return;
+//
+// The consumers of all variables are merged first, so that a consumer which
+// depends on several of them (e.g. both captured width and height) is
+// re-evaluated once. Consumers whose expansion didn't change are skipped
+// without re-parsing or re-applying the value.
+void PropagateStyleVariableChanges(StyleVariableState* state,
+                                   const std::vector<std::wstring>& varNames) {
+    std::vector<StyleVariableConsumer> consumersCopy;
+    for (const auto& varName : varNames) {
+        auto consumersIt = state->consumers.find(varName);
+        if (consumersIt == state->consumers.end()) {
+            continue;
+        }
+
+        for (const auto& consumer : consumersIt->second) {
+            bool already = std::any_of(
+                consumersCopy.begin(), consumersCopy.end(),
+                [&](const StyleVariableConsumer& c) {
+                    return c.elementHandle == consumer.elementHandle &&
+                           c.property == consumer.property;
+                });
+            if (!already) {
+                consumersCopy.push_back(consumer);
+            }
+        }
     }
 
-    auto consumersCopy = consumersIt->second;
     for (const auto& consumer : consumersCopy) {
         auto stateIt =
             g_elementsCustomizationState.find(consumer.elementHandle);
@@ -12934,7 +13723,8 @@ void PropagateStyleVariableChange(StyleVariableState* state,
 
             auto resolved = ResolveDynamicStyleValue(
                 state, consumer.elementHandle, element, consumer.property,
-                consumerFallbackClassName, &propState);
+                consumerFallbackClassName, &propState,
+                /*skipIfUnchanged=*/true);
             if (!resolved) {
                 continue;
             }
@@ -12954,16 +13744,19 @@ void PropagateStyleVariableChange(StyleVariableState* state,
     }
 }
 
+void PropagateStyleVariableChange(StyleVariableState* state,
+                                  const std::wstring& varName) {
+    PropagateStyleVariableChanges(state, {varName});
+}
+
 // Compare a captured value to whatever's currently in state->variables for the
-// same name; if different, store and notify dependents. Each consumer's own
-// fallbackClassName lives on the consumer entry, so this function does not need
-// to be told the capturer's context. Used by every path that wants to publish a
-// captured value -- the per-property capture callback, the SizeChanged
-// catch-all, and the initial seeding loop -- so the no-op fast path applies
-// uniformly.
-void SetStyleVariableIfChangedAndPropagate(StyleVariableState* state,
-                                           const std::wstring& varName,
-                                           StyleVariableValue value) {
+// same name; if different, store it and return true. Used by every path that
+// wants to publish a captured value -- the per-property capture callback, the
+// SizeChanged catch-all, and the initial seeding loop -- so the no-op fast path
+// applies uniformly.
+bool SetStyleVariableIfChanged(StyleVariableState* state,
+                               const std::wstring& varName,
+                               StyleVariableValue value) {
     auto it = state->variables.find(varName);
     if (it != state->variables.end() &&
         it->second.stringForm == value.stringForm &&
@@ -12971,7 +13764,7 @@ void SetStyleVariableIfChangedAndPropagate(StyleVariableState* state,
         it->second.substitutable == value.substitutable) {
         Wh_Log(L"Style variable '%s' unchanged at '%s'", varName.c_str(),
                value.stringForm.c_str());
-        return;
+        return false;
     }
 
     Wh_Log(L"Style variable '%s' changed: '%s' -> '%s'", varName.c_str(),
@@ -12979,7 +13772,18 @@ void SetStyleVariableIfChangedAndPropagate(StyleVariableState* state,
                                         : L"(unset)",
            value.stringForm.c_str());
     state->variables[varName] = std::move(value);
-    PropagateStyleVariableChange(state, varName);
+    return true;
+}
+
+// Same as SetStyleVariableIfChanged, and notifies dependents on change. Each
+// consumer's own fallbackClassName lives on the consumer entry, so this
+// function does not need to be told the capturer's context.
+void SetStyleVariableIfChangedAndPropagate(StyleVariableState* state,
+                                           const std::wstring& varName,
+                                           StyleVariableValue value) {
+    if (SetStyleVariableIfChanged(state, varName, std::move(value))) {
+        PropagateStyleVariableChange(state, varName);
+    }
 }
 
 // True for layout-driven DPs whose updates do not fire
@@ -13111,21 +13915,26 @@ void SetUpCapturesForElement(StyleVariableState* state,
                 Wh_Log(L"SizeChanged on %s: %.3fx%.3f",
                        winrt::get_class_name(element).c_str(),
                        e.NewSize().Width, e.NewSize().Height);
+                // Store all sizes before propagating, so that consumers of
+                // both width and height are re-evaluated once, with both new
+                // values.
+                std::vector<std::wstring> changedVarNames;
                 for (const auto& [property, varName] : sizeChangedCaptures) {
                     auto value =
                         ReadCapturedStyleVariableValue(element, property);
-                    SetStyleVariableIfChangedAndPropagate(state, varName,
-                                                          std::move(value));
+                    if (SetStyleVariableIfChanged(state, varName,
+                                                  std::move(value))) {
+                        changedVarNames.push_back(varName);
+                    }
                 }
+                PropagateStyleVariableChanges(state, changedVarNames);
             });
     }
 
     // Propagate the freshly seeded values to any consumers that were already
     // registered before this element was matched. Variables whose value did not
     // actually change are skipped, matching the per-callback fast path.
-    for (const auto& varName : changedVarNames) {
-        PropagateStyleVariableChange(state, varName);
-    }
+    PropagateStyleVariableChanges(state, changedVarNames);
 }
 
 // Tear down capture subscriptions for an element. Called from
@@ -13736,9 +14545,41 @@ void ClearClickThroughRegions() {
 
 void MergeResourceVariables();
 
-void ApplyCustomizations(InstanceHandle handle,
-                         FrameworkElement element,
-                         PCWSTR fallbackClassName) {
+// Whether the element's customizations were built from the given matches.
+// Rules are compared by source, so that rules rebuilt by a settings reload
+// compare equal to the ones they replaced.
+bool AppliedRulesMatch(
+    const ElementCustomizationState& elementCustomizationState,
+    const std::vector<ElementRuleMatch>& matches) {
+    const auto& appliedRules = elementCustomizationState.appliedRules;
+    if (appliedRules.size() != matches.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < matches.size(); i++) {
+        const auto& [source, visualStateGroupOptionalWeakPtr] =
+            appliedRules[i];
+        const auto& matchSource =
+            g_elementsCustomizationRules[matches[i].ruleIndex].source;
+        if (source != matchSource && *source != *matchSource) {
+            return false;
+        }
+
+        VisualStateGroup visualStateGroup =
+            visualStateGroupOptionalWeakPtr
+                ? visualStateGroupOptionalWeakPtr->get()
+                : nullptr;
+        if (visualStateGroup != matches[i].visualStateGroup) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+ApplyCustomizationsResult ApplyCustomizations(InstanceHandle handle,
+                                              FrameworkElement element,
+                                              PCWSTR fallbackClassName) {
     // Merge resource dictionary on first element add. Merging it earlier on
     // window creation doesn't work, perhaps merged dictionaries are reset
     // during initialization.
@@ -13746,6 +14587,11 @@ void ApplyCustomizations(InstanceHandle handle,
         MergeResourceVariables();
     }
 
+    if (g_styleBatchPending) {
+        g_styleBatchPending = false;
+        ResolveAllStylesInBatch();
+    }
+
     // Handle click-through before the no-customizations early return below,
     // since it must run for the taskbar elements even with no styles
     // configured.
@@ -13757,29 +14603,61 @@ void ApplyCustomizations(InstanceHandle handle,
     if (!state) {
         Wh_Log(L"No XamlRoot for %s, skipping",
                winrt::get_class_name(element).c_str());
-        return;
+        return ApplyCustomizationsResult::kNotMatched;
+    }
+
+    auto matches = FindElementMatchingRules(element, fallbackClassName);
+
+    // An element is seen again when the visual tree is replayed after a
+    // settings reload. Keep its customizations if its rules didn't change.
+    auto stateIt = g_elementsCustomizationState.find(handle);
+    if (stateIt != g_elementsCustomizationState.end() &&
+        AppliedRulesMatch(stateIt->second, matches)) {
+        return ApplyCustomizationsResult::kUnchanged;
     }
 
-    auto resolved = FindElementPropertyOverrides(element, fallbackClassName);
+    auto resolved = FindElementPropertyOverrides(fallbackClassName, matches);
     if (resolved.overridesPerVSG.empty() && resolved.captures.empty()) {
-        return;
+        if (stateIt != g_elementsCustomizationState.end()) {
+            Wh_Log(L"Reverting styles of %s",
+                   winrt::get_class_name(element).c_str());
+            CleanupCustomizations(handle);
+            return ApplyCustomizationsResult::kReverted;
+        }
+
+        return ApplyCustomizationsResult::kNotMatched;
+    }
+
+    // The element's rules changed. Revert it as if it was removed, including
+    // its captures, and apply the new rules from scratch.
+    if (stateIt != g_elementsCustomizationState.end()) {
+        CleanupCustomizations(handle);
     }
 
     Wh_Log(L"Applying styles to %s", winrt::get_class_name(element).c_str());
 
     auto& elementCustomizationState = g_elementsCustomizationState[handle];
 
-    for (const auto& [visualStateGroupOptionalWeakPtrIter, stateIter] :
-         elementCustomizationState.perVisualStateGroup) {
-        RestoreCustomizationsForVisualStateGroup(
-            state, handle, element, visualStateGroupOptionalWeakPtrIter,
-            stateIter);
-    }
-
     elementCustomizationState.element = element;
     elementCustomizationState.xamlRoot = state->xamlRoot;
     elementCustomizationState.perVisualStateGroup.clear();
 
+    elementCustomizationState.appliedRules.clear();
+    for (const auto& [ruleIndex, visualStateGroup] : matches) {
+        std::optional<winrt::weak_ref<VisualStateGroup>>
+            visualStateGroupOptionalWeakPtr;
+        if (visualStateGroup) {
+            visualStateGroupOptionalWeakPtr = visualStateGroup;
+        }
+
+        elementCustomizationState.appliedRules.push_back(
+            {g_elementsCustomizationRules[ruleIndex].source,
+             std::move(visualStateGroupOptionalWeakPtr)});
+    }
+
+    elementCustomizationState.fallbackClassName =
+        fallbackClassName ? fallbackClassName : L"";
+
     // Wire up captures first so any variables they define are visible to
     // dynamic value-rules applied below. Note: SetUpCapturesForElement does not
     // need this element's fallbackClassName -- propagation routes through each
@@ -13805,6 +14683,8 @@ void ApplyCustomizations(InstanceHandle handle,
             std::move(overridesForVisualStateGroup),
             elementCustomizationStateForVisualStateGroup);
     }
+
+    return ApplyCustomizationsResult::kApplied;
 }
 
 void CleanupCustomizations(InstanceHandle handle) {
@@ -14141,6 +15021,16 @@ void AddElementCustomizationRules(std::wstring_view target,
                                   std::vector<std::wstring> styles) {
     ElementCustomizationRules elementCustomizationRules;
 
+    // Null-separated, as the setting strings can't contain null characters.
+    std::wstring source{target};
+    for (const auto& style : styles) {
+        source += L'\0';
+        source += style;
+    }
+
+    elementCustomizationRules.source =
+        std::make_shared<const std::wstring>(std::move(source));
+
     auto targetParts = SplitStringView(target, L" > ");
 
     bool first = true;
@@ -14769,6 +15659,10 @@ void ProcessAllStylesFromSettings() {
         }
     }
 
+    BuildElementCustomizationRulesIndex();
+
+    g_styleBatchPending = true;
+
     g_resourceVariables = ProcessResourceVariablesFromSettings(
         styleConstants,
         theme ? theme->themeResourceVariables : std::vector<PCWSTR>{});
@@ -14847,6 +15741,16 @@ void UninitializeForCurrentThread() {
     g_styleVariableState.clear();
 
     g_elementsCustomizationRules.clear();
+    g_elementsCustomizationRulesIndex.clear();
+
+    Wh_Log(L"Style resolution: %.1f ms, %zu XamlReader loads, %zu cache hits",
+           StyleResolutionMilliseconds(), g_styleResolutionStats.xamlLoads,
+           g_styleResolutionStats.cacheHits);
+    g_parsedStyleCache.clear();
+    g_styleBatchPending = false;
+    g_styleResolutionStats = {};
+
+    ClearSharedBlurEffectResources();
 
     UninitializeResourceVariables();
 
@@ -14872,6 +15776,104 @@ void InitializeForCurrentThread() {
     g_initializedForThread = true;
 }
 
+// Rebuilds the rules from the current settings and updates only the elements
+// whose matching rules changed, reverting the ones that no longer match any
+// rule. Returns true if the visual tree has to be replayed, which is the case
+// when rules were added, since elements that weren't customized before may
+// match them.
+bool ReloadStylesForCurrentThread() {
+    if (!g_initializedForThread) {
+        InitializeForCurrentThread();
+        return true;
+    }
+
+    LARGE_INTEGER start;
+    QueryPerformanceCounter(&start);
+
+    auto previousRules = std::move(g_elementsCustomizationRules);
+    auto previousResourceVariables = std::move(g_resourceVariables);
+    g_elementsCustomizationRules.clear();
+    g_resourceVariables.clear();
+
+    ProcessAllStylesFromSettings();
+
+    // Styles might have been parsed with the previous resource values, so
+    // start over.
+    if (g_resourceVariables != previousResourceVariables) {
+        Wh_Log(L"Resource variables changed, reinitializing");
+        UninitializeForCurrentThread();
+        InitializeForCurrentThread();
+        return true;
+    }
+
+    std::unordered_set<std::wstring_view> previousSources;
+    for (const auto& rules : previousRules) {
+        previousSources.insert(*rules.source);
+    }
+
+    size_t rulesAdded = 0;
+    for (const auto& rules : g_elementsCustomizationRules) {
+        if (!previousSources.contains(*rules.source)) {
+            rulesAdded++;
+        }
+    }
+
+    // Customizing an element can't add or remove other elements, but collect
+    // the handles first anyway, as reverting one erases it from the map.
+    std::vector<InstanceHandle> handles;
+    handles.reserve(g_elementsCustomizationState.size());
+    for (const auto& [handle, elementCustomizationState] :
+         g_elementsCustomizationState) {
+        handles.push_back(handle);
+    }
+
+    size_t elementsUpdated = 0;
+    size_t elementsReverted = 0;
+    size_t elementsUnchanged = 0;
+    for (InstanceHandle handle : handles) {
+        auto it = g_elementsCustomizationState.find(handle);
+        if (it == g_elementsCustomizationState.end()) {
+            continue;
+        }
+
+        auto element = it->second.element.get();
+        if (!element) {
+            continue;
+        }
+
+        std::wstring fallbackClassName = it->second.fallbackClassName;
+        auto result = ApplyCustomizations(
+            handle, element,
+            fallbackClassName.empty() ? nullptr : fallbackClassName.c_str());
+        switch (result) {
+            case ApplyCustomizationsResult::kApplied:
+                elementsUpdated++;
+                break;
+            case ApplyCustomizationsResult::kReverted:
+                elementsReverted++;
+                break;
+            case ApplyCustomizationsResult::kUnchanged:
+                elementsUnchanged++;
+                break;
+            case ApplyCustomizationsResult::kNotMatched:
+                break;
+        }
+    }
+
+    LARGE_INTEGER end;
+    QueryPerformanceCounter(&end);
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    Wh_Log(L"Reloaded styles in %.1f ms: %zu of %zu rules added, %zu elements "
+           L"updated, %zu reverted, %zu unchanged",
+           (end.QuadPart - start.QuadPart) * 1000.0 / frequency.QuadPart,
+           rulesAdded, g_elementsCustomizationRules.size(), elementsUpdated,
+           elementsReverted, elementsUnchanged);
+
+    return rulesAdded > 0;
+}
+
 void InitializeSettingsAndTap() {
     if (g_initialized.exchange(true)) {
         return;
@@ -15393,6 +16395,8 @@ void LoadSettings() {
         g_settings.xamlDiagnosticsHandling = XamlDiagnosticsHandling::kAllow;
     }
     Wh_FreeStringSetting(xamlDiagnosticsHandling);
+
+    g_settings.verboseLogging = Wh_GetIntSetting(L"verboseLogging");
 }
 
 BOOL Wh_ModInit() {
@@ -15520,38 +16524,59 @@ void Wh_ModUninit() {
 void Wh_ModSettingsChanged() {
     Wh_Log(L">");
 
-    UninitializeSettingsAndTap();
+    auto previousSettings = g_settings;
 
     LoadSettings();
 
+    // Style changes are applied in place, without restoring and re-applying
+    // the elements they don't affect. The other settings change how elements
+    // are tracked, so start over for them.
+    bool reloadInPlace =
+        g_initialized &&
+        g_settings.clickThroughTaskbar ==
+            previousSettings.clickThroughTaskbar &&
+        g_settings.xamlDiagnosticsHandling ==
+            previousSettings.xamlDiagnosticsHandling;
+
+    RunFromWindowThreadProc_t reinitialize;
+    if (reloadInPlace) {
+        reinitialize = [](PVOID param) {
+            if (ReloadStylesForCurrentThread()) {
+                *static_cast<bool*>(param) = true;
+            }
+        };
+    } else {
+        UninitializeSettingsAndTap();
+
+        reinitialize = [](PVOID) {
+            UninitializeForCurrentThread();
+            InitializeForCurrentThread();
+        };
+    }
+
+    bool replayVisualTree = !reloadInPlace;
     bool initialize = false;
 
     HWND hTaskbarUiWnd = GetTaskbarUiWnd();
     if (hTaskbarUiWnd) {
         Wh_Log(L"Reinitializing - Found DesktopWindowContentBridge window");
-        RunFromWindowThread(
-            hTaskbarUiWnd,
-            [](PVOID) {
-                UninitializeForCurrentThread();
-                InitializeForCurrentThread();
-            },
-            nullptr);
+        RunFromWindowThread(hTaskbarUiWnd, reinitialize, &replayVisualTree);
         initialize = true;
     }
 
     for (auto hXamlHostWnd : GetXamlHostWnds()) {
         Wh_Log(L"Reinitializing for %08X", (DWORD)(ULONG_PTR)hXamlHostWnd);
-        RunFromWindowThread(
-            hXamlHostWnd,
-            [](PVOID) {
-                UninitializeForCurrentThread();
-                InitializeForCurrentThread();
-            },
-            nullptr);
+        RunFromWindowThread(hXamlHostWnd, reinitialize, &replayVisualTree);
         initialize = true;
     }
 
-    if (initialize) {
+    // Re-injecting the TAP reports every element in the tree again. Elements
+    // customized by unchanged rules are skipped by ApplyCustomizations.
+    if (initialize && replayVisualTree) {
+        if (reloadInPlace) {
+            UninitializeSettingsAndTap();
+        }
+
         InitializeSettingsAndTap();
     }
 }
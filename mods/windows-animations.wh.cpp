@@ -2,7 +2,7 @@
 // @id              windows-animations
 // @name            Windows Animations
 // @description     Smooth minimize, restore, close, switch animations for windows.
-// @version         1.2.0
+// @version         1.3.0
 // @author          ReDrag
 // @github          https://github.com/redrag2105
 // @include         *
@@ -227,6 +227,7 @@ You can deeply customize the feel and pacing of every animation via the Windhawk
 #include <cstdint>
 #include <cstring>
 #include <atomic>
+#include <condition_variable>
 #include <unordered_map>
 #include <unordered_set>
 #include <mutex>
@@ -423,6 +424,13 @@ namespace AnimConstants {
     constexpr int Win10MinRestoreMs = 280;
     constexpr size_t SnapshotCacheMaxEntries = 3;
     constexpr size_t SnapshotCacheMaxBytes = 64ull * 1024ull * 1024ull;
+    constexpr int SurfaceBucketPx = 64;
+    constexpr size_t SurfacePoolMaxBytes = 64ull * 1024ull * 1024ull;
+    constexpr int FrameTickWaitMs = 100;
+    // The scheduler thread (and the idle surface pool with it) is released
+    // once no animation has run for this long.
+    constexpr int FrameSchedulerLingerMs = 3000;
+    constexpr double FrameLateFactor = 1.5;
 }
 static constexpr std::wstring_view kGdiExcludedClasses[] = {
     L"CoreWindow",
@@ -634,6 +642,169 @@ static LONG NonZeroTick() {
 static void FlushDwmOrYield() {
     if (FAILED(DwmFlush())) Sleep(1);
 }
+static void TrimSurfacePool();
+static void LogSurfacePoolStats();
+// Concurrent animations (Win+D, closing a group) share one vblank clock: the
+// scheduler thread waits on DWM composition and publishes a frame number, and
+// each animation renders once per new number instead of racing its own
+// DwmFlush. The thread starts with the first animation and exits after
+// FrameSchedulerLingerMs without one.
+struct FrameSchedulerStats {
+    uint32_t ticks = 0;
+    uint32_t lateTicks = 0;
+    double totalPeriodMs = 0.0;
+    double maxPeriodMs = 0.0;
+    int peakClients = 0;
+};
+std::mutex g_FrameSchedulerMutex;
+std::condition_variable g_FrameSchedulerCv;
+uint64_t g_FrameSchedulerTick = 0;
+int g_FrameSchedulerClients = 0;
+bool g_FrameSchedulerRunning = false;
+FrameSchedulerStats g_FrameSchedulerStats;
+static void LogFrameSchedulerStatsLocked() {
+    FrameSchedulerStats& stats = g_FrameSchedulerStats;
+    if (!stats.ticks) return;
+    Wh_Log(L"Frame scheduler idle ticks=%u avg=%.2fms max=%.2fms late=%u peakAnims=%d",
+           stats.ticks, stats.totalPeriodMs / stats.ticks, stats.maxPeriodMs,
+           stats.lateTicks, stats.peakClients);
+    stats = FrameSchedulerStats{};
+}
+DWORD WINAPI FrameSchedulerThread(LPVOID) {
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+    LARGE_INTEGER qpcFreq, qpcLast, qpcNow;
+    QueryPerformanceFrequency(&qpcFreq);
+    QueryPerformanceCounter(&qpcLast);
+    double smoothedPeriodMs = 0.0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(g_FrameSchedulerMutex);
+            if (!g_FrameSchedulerClients && !g_unloading.load(std::memory_order_relaxed)) {
+                LogFrameSchedulerStatsLocked();
+                g_FrameSchedulerCv.wait_for(
+                    lock, std::chrono::milliseconds(AnimConstants::FrameSchedulerLingerMs), [] {
+                        return g_FrameSchedulerClients > 0 ||
+                               g_unloading.load(std::memory_order_relaxed);
+                    });
+                QueryPerformanceCounter(&qpcLast);
+                smoothedPeriodMs = 0.0;
+            }
+            if (!g_FrameSchedulerClients || g_unloading.load(std::memory_order_relaxed)) {
+                LogFrameSchedulerStatsLocked();
+                g_FrameSchedulerRunning = false;
+                g_FrameSchedulerCv.notify_all();
+                break;
+            }
+        }
+        FlushDwmOrYield();
+        QueryPerformanceCounter(&qpcNow);
+        const double periodMs =
+            (qpcNow.QuadPart - qpcLast.QuadPart) * 1000.0 / qpcFreq.QuadPart;
+        qpcLast = qpcNow;
+        {
+            std::lock_guard<std::mutex> lock(g_FrameSchedulerMutex);
+            ++g_FrameSchedulerTick;
+            FrameSchedulerStats& stats = g_FrameSchedulerStats;
+            ++stats.ticks;
+            stats.totalPeriodMs += periodMs;
+            if (periodMs > stats.maxPeriodMs) stats.maxPeriodMs = periodMs;
+            if (smoothedPeriodMs > 0.0 &&
+                periodMs > smoothedPeriodMs * AnimConstants::FrameLateFactor) {
+                ++stats.lateTicks;
+            } else {
+                smoothedPeriodMs = smoothedPeriodMs > 0.0
+                                       ? smoothedPeriodMs * 0.9 + periodMs * 0.1
+                                       : periodMs;
+            }
+        }
+        g_FrameSchedulerCv.notify_all();
+    }
+    LogSurfacePoolStats();
+    TrimSurfacePool();
+    return 0;
+}
+static bool AttachFrameScheduler(uint64_t* tickOut) {
+    std::lock_guard<std::mutex> lock(g_FrameSchedulerMutex);
+    ++g_FrameSchedulerClients;
+    if (!g_FrameSchedulerRunning) {
+        g_FrameSchedulerRunning = StartWorkerThread(FrameSchedulerThread, nullptr);
+    } else {
+        g_FrameSchedulerCv.notify_all();
+    }
+    if (!g_FrameSchedulerRunning) {
+        --g_FrameSchedulerClients;
+        return false;
+    }
+    if (g_FrameSchedulerClients > g_FrameSchedulerStats.peakClients) {
+        g_FrameSchedulerStats.peakClients = g_FrameSchedulerClients;
+    }
+    *tickOut = g_FrameSchedulerTick;
+    return true;
+}
+static void DetachFrameScheduler() {
+    std::lock_guard<std::mutex> lock(g_FrameSchedulerMutex);
+    if (g_FrameSchedulerClients > 0) --g_FrameSchedulerClients;
+    if (!g_FrameSchedulerClients) g_FrameSchedulerCv.notify_all();
+}
+// Returns the first frame number after lastTick, or 0 if the scheduler is
+// gone or stalled and the caller should pace itself.
+static uint64_t WaitForFrameTick(uint64_t lastTick) {
+    std::unique_lock<std::mutex> lock(g_FrameSchedulerMutex);
+    const bool ticked = g_FrameSchedulerCv.wait_for(
+        lock, std::chrono::milliseconds(AnimConstants::FrameTickWaitMs), [&] {
+            return g_FrameSchedulerTick != lastTick || !g_FrameSchedulerRunning;
+        });
+    if (!ticked || g_FrameSchedulerTick == lastTick) return 0;
+    return g_FrameSchedulerTick;
+}
+static void WakeFrameScheduler() {
+    std::lock_guard<std::mutex> lock(g_FrameSchedulerMutex);
+    g_FrameSchedulerCv.notify_all();
+}
+// One animation's attachment to the scheduler, plus its frame statistics. A
+// vblank that passes while the animation is still rendering counts as missed.
+class FramePacer {
+public:
+    FramePacer() { attached = AttachFrameScheduler(&lastTick); }
+    ~FramePacer() {
+        if (attached) DetachFrameScheduler();
+    }
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+    void BeginFrame() { QueryPerformanceCounter(&frameStart); }
+    void EndFrame() {
+        LARGE_INTEGER qpcNow, qpcFreq;
+        QueryPerformanceCounter(&qpcNow);
+        QueryPerformanceFrequency(&qpcFreq);
+        const double ms = (qpcNow.QuadPart - frameStart.QuadPart) * 1000.0 / qpcFreq.QuadPart;
+        renderMsTotal += ms;
+        if (ms > renderMsMax) renderMsMax = ms;
+        ++frames;
+    }
+    void WaitNextFrame() {
+        const uint64_t tick = attached ? WaitForFrameTick(lastTick) : 0;
+        if (!tick) {
+            FlushDwmOrYield();
+            return;
+        }
+        if (tick > lastTick + 1) missed += (uint32_t)(tick - lastTick - 1);
+        lastTick = tick;
+    }
+    void Log(HWND hWnd, PCWSTR kind) const {
+        if (!frames) return;
+        Wh_Log(L"Anim frames hwnd=%p kind=%s frames=%u missed=%u render avg=%.2fms max=%.2fms%s",
+               hWnd, kind, frames, missed, renderMsTotal / frames, renderMsMax,
+               attached ? L"" : L" (self-paced)");
+    }
+private:
+    bool attached = false;
+    uint64_t lastTick = 0;
+    LARGE_INTEGER frameStart{};
+    uint32_t frames = 0;
+    uint32_t missed = 0;
+    double renderMsTotal = 0.0;
+    double renderMsMax = 0.0;
+};
 static void PulseSharedHeartbeatLocked() {
     if (!g_pSharedState || !g_sharedStateWritable) return;
     InterlockedExchange(&g_pSharedState->heartbeatTick, NonZeroTick());
@@ -873,6 +1044,92 @@ static HBITMAP CreateDib32(HDC dc, int width, int height, void** bits) {
     bmi.bmiHeader.biCompression = BI_RGB;
     return CreateDIBSection(dc, &bmi, DIB_RGB_COLORS, bits, nullptr, 0);
 }
+// Engine source/canvas surfaces are recycled instead of allocated per
+// animation. Sizes are rounded up to SurfaceBucketPx so neighbouring window
+// sizes share a bucket; rows are always width * 4 bytes of the bucket size.
+struct PooledSurface {
+    HBITMAP hBitmap{};
+    void* bits{};
+    int width{};
+    int height{};
+};
+std::mutex g_SurfacePoolMutex;
+std::vector<PooledSurface> g_SurfacePool;  // idle surfaces, oldest first
+size_t g_SurfacePoolBytes = 0;
+uint32_t g_SurfacePoolReused = 0;
+uint32_t g_SurfacePoolAllocated = 0;
+static size_t SurfaceBytes(const PooledSurface& surface) {
+    return (size_t)surface.width * (size_t)surface.height * 4u;
+}
+static int SurfaceBucket(int px) {
+    const int bucket = AnimConstants::SurfaceBucketPx;
+    return (std::max(px, 1) + bucket - 1) / bucket * bucket;
+}
+static bool AcquireSurface(HDC dc, int width, int height, PooledSurface* out) {
+    const int bucketW = SurfaceBucket(width);
+    const int bucketH = SurfaceBucket(height);
+    {
+        std::lock_guard<std::mutex> lock(g_SurfacePoolMutex);
+        for (size_t i = g_SurfacePool.size(); i-- > 0;) {
+            if (g_SurfacePool[i].width == bucketW && g_SurfacePool[i].height == bucketH) {
+                *out = g_SurfacePool[i];
+                g_SurfacePool.erase(g_SurfacePool.begin() + i);
+                g_SurfacePoolBytes -= SurfaceBytes(*out);
+                ++g_SurfacePoolReused;
+                return true;
+            }
+        }
+        ++g_SurfacePoolAllocated;
+    }
+    PooledSurface surface{nullptr, nullptr, bucketW, bucketH};
+    surface.hBitmap = CreateDib32(dc, bucketW, bucketH, &surface.bits);
+    if (!surface.hBitmap || !surface.bits) {
+        if (surface.hBitmap) DeleteObject(surface.hBitmap);
+        return false;
+    }
+    *out = surface;
+    return true;
+}
+// The surface must no longer be selected into a DC.
+static void ReleaseSurface(PooledSurface* surface) {
+    if (!surface->hBitmap) return;
+    const size_t bytes = SurfaceBytes(*surface);
+    bool pooled = false;
+    if (!g_unloading.load(std::memory_order_relaxed) &&
+        bytes <= AnimConstants::SurfacePoolMaxBytes) {
+        std::lock_guard<std::mutex> lock(g_SurfacePoolMutex);
+        while (!g_SurfacePool.empty() &&
+               g_SurfacePoolBytes > AnimConstants::SurfacePoolMaxBytes - bytes) {
+            g_SurfacePoolBytes -= SurfaceBytes(g_SurfacePool.front());
+            DeleteObject(g_SurfacePool.front().hBitmap);
+            g_SurfacePool.erase(g_SurfacePool.begin());
+        }
+        try {
+            g_SurfacePool.push_back(*surface);
+            g_SurfacePoolBytes += bytes;
+            pooled = true;
+        } catch (const std::exception&) {
+        }
+    }
+    if (!pooled) DeleteObject(surface->hBitmap);
+    *surface = PooledSurface{};
+}
+static void TrimSurfacePool() {
+    std::vector<PooledSurface> surfaces;
+    {
+        std::lock_guard<std::mutex> lock(g_SurfacePoolMutex);
+        surfaces.swap(g_SurfacePool);
+        g_SurfacePoolBytes = 0;
+    }
+    for (const PooledSurface& surface : surfaces) DeleteObject(surface.hBitmap);
+}
+static void LogSurfacePoolStats() {
+    std::lock_guard<std::mutex> lock(g_SurfacePoolMutex);
+    if (!g_SurfacePoolReused && !g_SurfacePoolAllocated) return;
+    Wh_Log(L"Surface pool reused=%u allocated=%u idle=%zu (%zu KB)", g_SurfacePoolReused,
+           g_SurfacePoolAllocated, g_SurfacePool.size(), g_SurfacePoolBytes / 1024);
+    g_SurfacePoolReused = g_SurfacePoolAllocated = 0;
+}
 static bool IsAnimating(HWND hWnd) {
     std::lock_guard<std::mutex> lock(g_StateMutex);
     return g_AnimActive.count(hWnd) != 0;
@@ -2735,12 +2992,14 @@ DWORD WINAPI SwitchingAnimThread(LPVOID lpParam) {
     int H = extRect.bottom - extRect.top;
     int offsetX = extRect.left - winRect.left;
     int offsetY = extRect.top - winRect.top;
+    FramePacer pacer;
     for (;;) {
         MSG msg;
         while (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE)) {
             TranslateMessage(&msg);
             DispatchMessageW(&msg);
         }
+        pacer.BeginFrame();
         QueryPerformanceCounter(&qpcNow);
         double elapsedMs = (qpcNow.QuadPart - qpcStart.QuadPart) * 1000.0 / qpcFreq.QuadPart;
         BOOL lastFrame = (elapsedMs >= totalMs);
@@ -2762,9 +3021,11 @@ DWORD WINAPI SwitchingAnimThread(LPVOID lpParam) {
         props.rcDestination.right = thumbX + thumbW;
         props.rcDestination.bottom = thumbY + thumbH;
         DwmUpdateThumbnailProperties(hThumb, &props);
+        pacer.EndFrame();
         if (lastFrame || g_unloading.load(std::memory_order_relaxed)) break;
-        FlushDwmOrYield();
+        pacer.WaitNextFrame();
     }
+    pacer.Log(hWnd, L"switch");
     if (IsWindow(hWnd)) {
         SetWindowCloak(hWnd, FALSE);
         guard.uncloaked = true;
@@ -2968,7 +3229,8 @@ private:
     int boundLeft = 0, boundTop = 0, boundW = 0, boundH = 0;
     HWND hGhost = NULL;
     HDC hScreenDC = NULL, hSrcDC = NULL, hSrcDibDC = NULL, hCanvasDC = NULL;
-    HBITMAP hOldSrc = NULL, hSrcDib = NULL, hOldSrcDib = NULL, hCanvas = NULL, hOldCanvas = NULL;
+    HBITMAP hOldSrc = NULL, hOldSrcDib = NULL, hOldCanvas = NULL;
+    PooledSurface srcSurface, canvasSurface;
     BYTE* srcBits = nullptr;
     BYTE* pBits = nullptr;
     int srcStride = 0, canvasStride = 0;
@@ -3721,23 +3983,25 @@ public:
         if (!hSrcDC) return false;
         hOldSrc = (HBITMAP)SelectObject(hSrcDC, data->hBitmap);
         if (!hOldSrc || hOldSrc == HGDI_ERROR) return false;
-        hSrcDib = CreateDib32(hScreenDC, W, H, (void**)&srcBits);
-        if (!hSrcDib || !srcBits) return false;
+        if (!AcquireSurface(hScreenDC, W, H, &srcSurface)) return false;
+        srcBits = (BYTE*)srcSurface.bits;
         hSrcDibDC = CreateCompatibleDC(hScreenDC);
         if (!hSrcDibDC) return false;
-        hOldSrcDib = (HBITMAP)SelectObject(hSrcDibDC, hSrcDib);
+        hOldSrcDib = (HBITMAP)SelectObject(hSrcDibDC, srcSurface.hBitmap);
         if (!hOldSrcDib || hOldSrcDib == HGDI_ERROR) return false;
         BitBlt(hSrcDibDC, 0, 0, W, H, hSrcDC, 0, 0, SRCCOPY);
         GdiFlush();
-        srcStride = W * 4;
-        hCanvas = CreateDib32(hScreenDC, boundW, boundH, (void**)&pBits);
-        if (!hCanvas || !pBits) return false;
+        srcStride = srcSurface.width * 4;
+        // A recycled canvas holds the previous animation's pixels; every
+        // frame clears the boundW x boundH region it presents.
+        if (!AcquireSurface(hScreenDC, boundW, boundH, &canvasSurface)) return false;
+        pBits = (BYTE*)canvasSurface.bits;
         hCanvasDC = CreateCompatibleDC(hScreenDC);
         if (!hCanvasDC) return false;
-        hOldCanvas = (HBITMAP)SelectObject(hCanvasDC, hCanvas);
+        hOldCanvas = (HBITMAP)SelectObject(hCanvasDC, canvasSurface.hBitmap);
         if (!hOldCanvas || hOldCanvas == HGDI_ERROR) return false;
-        canvasStride = boundW * 4;
-        canvasBytes = (size_t)boundW * 4 * boundH;
+        canvasStride = canvasSurface.width * 4;
+        canvasBytes = (size_t)canvasStride * boundH;
         if (!data->isClosing && minRestoreEffect == 0) yb.resize(H + 1);
         return true;
     }
@@ -4339,6 +4603,7 @@ public:
         LARGE_INTEGER qpcFreq, qpcStart, qpcNow;
         QueryPerformanceFrequency(&qpcFreq);
         QueryPerformanceCounter(&qpcStart);
+        FramePacer pacer;
         for (;;) {
             if (!data->isClosing) TryReverseToWantedDirection(qpcFreq, qpcStart);
             MSG msg;
@@ -4347,6 +4612,7 @@ public:
                 DispatchMessageW(&msg);
             }
             if (!data->isClosing) TryReverseToWantedDirection(qpcFreq, qpcStart);
+            pacer.BeginFrame();
             QueryPerformanceCounter(&qpcNow);
             double elapsedMs = (qpcNow.QuadPart - qpcStart.QuadPart) * 1000.0 / qpcFreq.QuadPart;
             BOOL lastFrame = (elapsedMs >= totalMs);
@@ -4378,13 +4644,16 @@ public:
                 RenderMinimizeRestore(progress, fade);
             }
             PresentCanvas(fade);
+            pacer.EndFrame();
             if (g_unloading.load(std::memory_order_relaxed)) break;
             if (lastFrame) {
                 if (!data->isClosing && TryReverseToWantedDirection(qpcFreq, qpcStart)) continue;
                 break;
             }
-            FlushDwmOrYield();
+            pacer.WaitNextFrame();
         }
+        pacer.Log(data->hRealWnd,
+                  data->isClosing ? L"close" : (data->isRising ? L"restore" : L"minimize"));
     }
     bool FinishRising() {
         if (data->isClosing || !data->isRising) return true;
@@ -4728,13 +4997,14 @@ public:
         if (hCanvasDC && hOldCanvas && hOldCanvas != HGDI_ERROR) SelectObject(hCanvasDC, hOldCanvas);
         if (hSrcDibDC && hOldSrcDib && hOldSrcDib != HGDI_ERROR) SelectObject(hSrcDibDC, hOldSrcDib);
         if (hSrcDC && hOldSrc && hOldSrc != HGDI_ERROR) SelectObject(hSrcDC, hOldSrc);
-        if (hCanvas) DeleteObject(hCanvas);
-        if (hSrcDib) DeleteObject(hSrcDib);
         if (data->hBitmap) DeleteObject(data->hBitmap);
         if (hCanvasDC) DeleteDC(hCanvasDC);
         if (hSrcDibDC) DeleteDC(hSrcDibDC);
         if (hSrcDC) DeleteDC(hSrcDC);
-        hCanvas = hSrcDib = data->hBitmap = nullptr;
+        ReleaseSurface(&canvasSurface);
+        ReleaseSurface(&srcSurface);
+        srcBits = pBits = nullptr;
+        data->hBitmap = nullptr;
         hCanvasDC = hSrcDibDC = hSrcDC = nullptr;
     }
     void Teardown() {
@@ -6283,6 +6553,9 @@ void Wh_ModSettingsChanged() {
 void Wh_ModBeforeUninit() {
     Wh_Log(L"BeforeUninit: joining workers");
     g_unloading.store(true, std::memory_order_relaxed);
+    // A lingering frame scheduler is a registered worker too; wake it so the
+    // join below doesn't wait out its idle timeout.
+    WakeFrameScheduler();
     // The ownership probe is a registered worker and is the only worker that
     // can request the separately-owned Explorer foreground thread. Join it
     // before detaching that thread, in addition to the start-side lock/check.
@@ -6328,5 +6601,6 @@ void Wh_ModUninit() {
         g_seenTaskbarLayoutEpoch = 0;
         g_seenTaskbarExplorerPid = 0;
     }
+    TrimSurfacePool();
     CloseSharedState();
 }